@@ -5,10 +5,35 @@ Window {
     id: dialog
     modality: Qt.ApplicationModal
     title: "Dane archiwalne"
-    width: 600
-    height: 400
+    width: 900
+    height: 550
+    minimumWidth: 600
+    minimumHeight: 400
     visible: false
 
+    property int sensorId: -1
+    property var windowEnd: new Date()
+    property var spans: [24, 168, 720, 8760, 87600]
+    property int spanHours: spans[spanSelector.currentIndex]
+    property var archiveData: []
+
+    // Wczytuje okno czasowe wybranego czujnika z archiwum
+    function reload() {
+        if (sensorId < 0) {
+            archiveData = []
+        } else {
+            var from = new Date(windowEnd.getTime() - spanHours * 3600000)
+            archiveData = mainWindow.archiveSeries(sensorId, from, windowEnd, resolutionSelector.currentIndex - 1, chartCanvas.width)
+        }
+        chartCanvas.requestPaint()
+    }
+
+    // Przesuwa okno o podaną część jego długości
+    function shift(fraction) {
+        windowEnd = new Date(windowEnd.getTime() + fraction * spanHours * 3600000)
+        reload()
+    }
+
     Rectangle {
         id: header
         width: parent.width
@@ -17,81 +42,246 @@ Window {
 
         Text {
             anchors.centerIn: parent
-            text: "Wybierz zapisane dane"
+            text: "Przeglądanie archiwum pomiarów"
             color: "white"
             font.pixelSize: 20
             font.bold: true
         }
     }
 
-    ListView {
-        id: archivedList
+    Row {
         anchors.top: header.bottom
         anchors.left: parent.left
         anchors.right: parent.right
         anchors.bottom: parent.bottom
         anchors.margins: 10
         spacing: 10
-        clip: true
-        model: mainWindow.archivedStations
-
-        delegate: Rectangle {
-            width: parent.width
-            height: 80
-            color: mouseArea.containsMouse ? "#e0e0e0" : "#f0f0f0"
-            radius: 5
-
-            MouseArea {
-                id: mouseArea
-                anchors.fill: parent
-                hoverEnabled: true
-                onClicked: {
-                    mainWindow.loadArchivedStationData(modelData.stationId, modelData.saveDate)
-                    var component = Qt.createComponent("qrc:/StationDialog.qml")
-                    if (component.status === Component.Ready) {
-                        var address = modelData.address ? modelData.address : "Brak danych"
-                        var street = address === "Brak danych" ? "Brak danych" : address.split(" ")[0]
-                        var number = address === "Brak danych" ? "" : (address.split(" ").length > 1 ? address.split(" ")[1] : "")
-                        var dialog = component.createObject(root, {
-                            "stationId": modelData.stationId,
-                            "cityName": modelData.cityName,
-                            "street": street,
-                            "number": number,
-                            "saveDate": modelData.saveDate
-                        })
-                        dialog.open()
+
+        ListView {
+            id: archivedList
+            width: parent.width * 0.3
+            height: parent.height
+            spacing: 10
+            clip: true
+            model: []
+
+            delegate: Rectangle {
+                width: archivedList.width
+                height: 60
+                color: modelData.sensorId === sensorId ? "#C8E6C9" : (mouseArea.containsMouse ? "#e0e0e0" : "#f0f0f0")
+                radius: 5
+
+                MouseArea {
+                    id: mouseArea
+                    anchors.fill: parent
+                    hoverEnabled: true
+                    onClicked: {
+                        sensorId = modelData.sensorId
+                        reload()
+                    }
+                }
+
+                Column {
+                    anchors.fill: parent
+                    anchors.margins: 10
+                    spacing: 5
+
+                    Text {
+                        text: "<b>" + (modelData.paramCode ? modelData.paramCode : "Czujnik") + "</b> nr " + modelData.sensorId
+                        font.pixelSize: 14
+                    }
+                    Text {
+                        width: parent.width
+                        text: modelData.stationName ? modelData.stationName : (modelData.stationId > 0 ? "Stacja nr " + modelData.stationId : "Brak danych")
+                        font.pixelSize: 12
+                        elide: Text.ElideRight
                     }
-                    dialog.close()
                 }
             }
+        }
+
+        Column {
+            width: parent.width - archivedList.width - parent.spacing
+            height: parent.height
+            spacing: 10
 
-            Column {
-                anchors.fill: parent
-                anchors.margins: 10
-                spacing: 5
+            Row {
+                id: controls
+                spacing: 10
 
-                Text {
-                    text: "<b>ID stacji:</b> " + modelData.stationId
+                Button {
+                    text: "◀"
+                    height: 40
                     font.pixelSize: 14
+                    onClicked: shift(-1)
                 }
-                Text {
-                    text: "<b>Miasto:</b> " + modelData.cityName
+
+                Button {
+                    text: "▶"
+                    height: 40
                     font.pixelSize: 14
+                    onClicked: shift(1)
+                }
+
+                ComboBox {
+                    id: spanSelector
+                    width: 120
+                    height: 40
+                    font.pixelSize: 14
+                    model: ["1 dzień", "7 dni", "30 dni", "1 rok", "10 lat"]
+                    currentIndex: 1
+                    onActivated: reload()
+                }
+
+                ComboBox {
+                    id: resolutionSelector
+                    width: 150
+                    height: 40
+                    font.pixelSize: 14
+                    model: ["Automatyczna", "Godzinowa", "Dobowa", "Miesięczna"]
+                    onActivated: reload()
+                }
+
+                Button {
+                    text: "Teraz"
+                    height: 40
+                    font.pixelSize: 14
+                    onClicked: {
+                        windowEnd = new Date()
+                        reload()
+                    }
                 }
-                Text {
-                    text: "<b>Adres:</b> " + (modelData.address ? modelData.address : "Brak danych")
+            }
+
+            // Import rocznych plików banku danych GIOŚ zapisanych jako CSV
+            Row {
+                id: importControls
+                spacing: 10
+
+                TextField {
+                    id: dataBankPath
+                    width: 300
+                    height: 40
                     font.pixelSize: 14
+                    placeholderText: "Katalog banku danych GIOŚ (CSV)"
                 }
-                Text {
-                    text: "<b>Data zapisu:</b> " + modelData.saveDate
+
+                Button {
+                    text: "Importuj"
+                    height: 40
                     font.pixelSize: 14
+                    enabled: dataBankPath.text.length > 0
+                    onClicked: mainWindow.importDataBank(dataBankPath.text)
                 }
             }
+
+            Text {
+                id: rangeText
+                text: Qt.formatDateTime(new Date(windowEnd.getTime() - spanHours * 3600000), "yyyy-MM-dd HH:mm")
+                      + " – " + Qt.formatDateTime(windowEnd, "yyyy-MM-dd HH:mm")
+                      + " (" + archiveData.length + " punktów)"
+                font.pixelSize: 14
+                color: "#333"
+            }
+
+            Canvas {
+                id: chartCanvas
+                width: parent.width
+                height: parent.height - controls.height - importControls.height - rangeText.height - 3 * parent.spacing
+
+                onWidthChanged: requestPaint()
+
+                onPaint: {
+                    var ctx = getContext("2d")
+                    ctx.clearRect(0, 0, width, height)
+                    ctx.fillStyle = "#ffffff"
+                    ctx.fillRect(0, 0, width, height)
+
+                    if (archiveData.length === 0) {
+                        ctx.fillStyle = "#666"
+                        ctx.font = "14px sans-serif"
+                        ctx.fillText(sensorId < 0 ? "Wybierz czujnik z listy" : "Brak danych w wybranym okresie", 20, 30)
+                        return
+                    }
+
+                    var margin = 40
+                    var end = windowEnd.getTime()
+                    var start = end - spanHours * 3600000
+                    var minValue = Infinity
+                    var maxValue = -Infinity
+                    for (var i = 0; i < archiveData.length; ++i) {
+                        minValue = Math.min(minValue, archiveData[i].min)
+                        maxValue = Math.max(maxValue, archiveData[i].max)
+                    }
+                    if (maxValue === minValue) {
+                        maxValue = minValue + 1
+                    }
+
+                    function xOf(date) {
+                        var t = new Date(date.replace(" ", "T")).getTime()
+                        return margin + (t - start) / (end - start) * (width - 2 * margin)
+                    }
+                    function yOf(value) {
+                        return height - margin - (value - minValue) / (maxValue - minValue) * (height - 2 * margin)
+                    }
+
+                    // Osie i wartości skrajne
+                    ctx.strokeStyle = "#999"
+                    ctx.lineWidth = 1
+                    ctx.beginPath()
+                    ctx.moveTo(margin, margin)
+                    ctx.lineTo(margin, height - margin)
+                    ctx.lineTo(width - margin, height - margin)
+                    ctx.stroke()
+                    ctx.fillStyle = "#333"
+                    ctx.font = "12px sans-serif"
+                    ctx.fillText(maxValue.toFixed(1), 2, margin)
+                    ctx.fillText(minValue.toFixed(1), 2, height - margin)
+
+                    // Zakres min–max agregatów, dane od najnowszych
+                    if (archiveData[0].count > 1) {
+                        ctx.fillStyle = "rgba(33, 150, 243, 0.15)"
+                        ctx.beginPath()
+                        for (var j = archiveData.length - 1; j >= 0; --j) {
+                            var px = xOf(archiveData[j].date)
+                            if (j === archiveData.length - 1) ctx.moveTo(px, yOf(archiveData[j].max))
+                            else ctx.lineTo(px, yOf(archiveData[j].max))
+                        }
+                        for (var k = 0; k < archiveData.length; ++k) {
+                            ctx.lineTo(xOf(archiveData[k].date), yOf(archiveData[k].min))
+                        }
+                        ctx.closePath()
+                        ctx.fill()
+                    }
+
+                    ctx.strokeStyle = "#2196F3"
+                    ctx.lineWidth = 2
+                    ctx.beginPath()
+                    for (var m = archiveData.length - 1; m >= 0; --m) {
+                        var x = xOf(archiveData[m].date)
+                        var y = yOf(archiveData[m].value)
+                        if (m === archiveData.length - 1) ctx.moveTo(x, y)
+                        else ctx.lineTo(x, y)
+                    }
+                    ctx.stroke()
+                }
+            }
+        }
+    }
+
+    Connections {
+        target: mainWindow
+        function onDataBankImportFinished() {
+            archivedList.model = mainWindow.archivedSensors()
+            reload()
         }
     }
 
     function open() {
+        archivedList.model = mainWindow.archivedSensors()
+        windowEnd = new Date()
         visible = true
+        reload()
     }
 
     function close() {
@@ -0,0 +1,122 @@
+import QtQuick 2.15
+import QtQuick.Controls 2.15
+import AirApi 1.0
+
+Window {
+    id: dialog
+    modality: Qt.ApplicationModal
+    title: "Wyszukiwanie zbiorcze"
+    width: 800
+    height: 600
+    minimumWidth: 500
+    minimumHeight: 400
+    visible: false
+
+    property var stateNames: ["oczekuje", "znane stacje", "geokodowane", "nie znaleziono", "błąd"]
+
+    Rectangle {
+        id: header
+        width: parent.width
+        height: 50
+        color: "#4CAF50"
+
+        Text {
+            anchors.centerIn: parent
+            text: "Stacje w wielu miastach"
+            color: "white"
+            font.pixelSize: 20
+            font.bold: true
+        }
+    }
+
+    Row {
+        anchors.top: header.bottom
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.bottom: parent.bottom
+        anchors.margins: 10
+        spacing: 10
+
+        Column {
+            id: inputColumn
+            width: parent.width * 0.3
+            height: parent.height
+            spacing: 10
+
+            ScrollView {
+                width: parent.width
+                height: parent.height - searchButton.height - parent.spacing
+
+                TextArea {
+                    id: citiesInput
+                    placeholderText: "Jedno miasto w wierszu"
+                    font.pixelSize: 14
+                }
+            }
+
+            Button {
+                id: searchButton
+                width: parent.width
+                height: 40
+                font.pixelSize: 14
+                text: mainWindow.batchSearch.pending > 0 ? "Przerwij (" + mainWindow.batchSearch.pending + ")" : "Szukaj"
+                onClicked: {
+                    if (mainWindow.batchSearch.pending > 0) {
+                        mainWindow.batchSearch.cancel()
+                    } else {
+                        mainWindow.searchCities(citiesInput.text.split(/[\n,;]/))
+                    }
+                }
+            }
+        }
+
+        ListView {
+            id: resultList
+            width: parent.width - inputColumn.width - parent.spacing
+            height: parent.height
+            spacing: 10
+            clip: true
+            model: mainWindow.batchSearch
+
+            delegate: Rectangle {
+                width: resultList.width
+                height: groupColumn.height + 20
+                color: model.state === BatchSearchModel.Pending ? "#fff8e1" : "#f0f0f0"
+                radius: 5
+
+                Column {
+                    id: groupColumn
+                    x: 10
+                    y: 10
+                    width: parent.width - 20
+                    spacing: 3
+
+                    Text {
+                        text: "<b>" + model.query + "</b> – " + stateNames[model.state] + ", stacji: " + model.stationCount
+                        font.pixelSize: 14
+                    }
+
+                    Repeater {
+                        model: stations
+
+                        Text {
+                            width: groupColumn.width
+                            text: modelData.stationName + " (" + modelData.distance.toFixed(1) + " km)"
+                            font.pixelSize: 12
+                            color: "#333"
+                            elide: Text.ElideRight
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    function open() {
+        visible = true
+    }
+
+    function close() {
+        visible = false
+    }
+}
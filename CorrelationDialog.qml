@@ -0,0 +1,114 @@
+import QtQuick 2.15
+import QtQuick.Controls 2.15
+import AirApi 1.0
+
+Window {
+    id: dialog
+    modality: Qt.ApplicationModal
+    title: "Korelacje między stacjami"
+    width: 800
+    height: 700
+    minimumWidth: 500
+    minimumHeight: 500
+    visible: false
+
+    Rectangle {
+        id: header
+        width: parent.width
+        height: 50
+        color: "#4CAF50"
+
+        Text {
+            anchors.centerIn: parent
+            text: "Korelacja parametru między stacjami"
+            color: "white"
+            font.pixelSize: 20
+            font.bold: true
+        }
+    }
+
+    Column {
+        anchors.top: header.bottom
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.bottom: parent.bottom
+        anchors.margins: 10
+        spacing: 10
+
+        Row {
+            id: controls
+            width: parent.width
+            spacing: 10
+
+            ComboBox {
+                id: paramSelector
+                width: 150
+                height: 40
+                model: mainWindow.catalogParams
+                font.pixelSize: 14
+                onPressedChanged: if (pressed) mainWindow.buildSensorCatalog()
+            }
+
+            ComboBox {
+                id: methodSelector
+                width: 150
+                height: 40
+                model: ["Pearson", "Spearman"]
+                font.pixelSize: 14
+            }
+
+            SpinBox {
+                id: hoursInput
+                height: 40
+                from: 24
+                to: 8760
+                stepSize: 24
+                value: 72
+                editable: true
+                font.pixelSize: 14
+            }
+
+            Button {
+                text: "Oblicz"
+                height: 40
+                font.pixelSize: 14
+                enabled: !mainWindow.correlationBusy && paramSelector.currentIndex >= 0
+                onClicked: {
+                    mainWindow.computeCorrelation(paramSelector.currentText, hoursInput.value, methodSelector.currentIndex === 1)
+                }
+            }
+        }
+
+        Text {
+            id: hoverText
+            width: parent.width
+            text: mainWindow.correlationBusy ? "Obliczanie..." : mainWindow.status
+            font.pixelSize: 14
+            color: "#333"
+            wrapMode: Text.WordWrap
+        }
+
+        Heatmap {
+            id: heatmap
+            width: parent.width
+            height: parent.height - controls.height - hoverText.height - 2 * parent.spacing
+            model: mainWindow.correlationModel
+
+            MouseArea {
+                anchors.fill: parent
+                hoverEnabled: true
+                onPositionChanged: {
+                    var cell = heatmap.cellAt(mouse.x, mouse.y)
+                    if (cell.x < 0) return
+                    var model = mainWindow.correlationModel
+                    var value = model.value(cell.y, cell.x)
+                    hoverText.text = model.label(cell.y) + " × " + model.label(cell.x) + ": " + (isNaN(value) ? "Brak danych" : value.toFixed(2))
+                }
+            }
+        }
+    }
+
+    function open() {
+        visible = true
+    }
+}
@@ -0,0 +1,115 @@
+import QtQuick 2.15
+import QtQuick.Controls 2.15
+import AirApi 1.0
+
+Window {
+    id: dialog
+    modality: Qt.NonModal
+    title: "Tablica obserwowanych stacji"
+    width: 1200
+    height: 800
+    minimumWidth: 500
+    minimumHeight: 400
+    visible: false
+
+    Rectangle {
+        id: header
+        width: parent.width
+        height: 50
+        color: "#4CAF50"
+
+        Text {
+            anchors.centerIn: parent
+            text: "Tablica obserwowanych stacji"
+            color: "white"
+            font.pixelSize: 20
+            font.bold: true
+        }
+    }
+
+    Row {
+        id: controls
+        anchors.top: header.bottom
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.margins: 10
+        spacing: 10
+
+        ComboBox {
+            id: paramSelector
+            width: 150
+            height: 40
+            font.pixelSize: 14
+            model: mainWindow.catalogParams
+            currentIndex: Math.max(0, mainWindow.catalogParams.indexOf(mainWindow.watchList.param))
+            onPressedChanged: if (pressed) mainWindow.buildSensorCatalog()
+            onActivated: mainWindow.setWatchParam(currentText)
+        }
+
+        SpinBox {
+            id: intervalInput
+            width: 170
+            height: 40
+            font.pixelSize: 14
+            from: 0
+            to: 3600
+            stepSize: 60
+            editable: true
+            value: mainWindow.watchList.refreshInterval
+            textFromValue: function(value) { return value === 0 ? "Ręcznie" : "co " + Math.round(value / 60) + " min" }
+            valueFromText: function(text) { var v = parseInt(text.replace(/[^0-9]/g, "")); return isNaN(v) ? 0 : v * 60 }
+            onValueModified: mainWindow.watchList.refreshInterval = value
+        }
+
+        Button {
+            text: "Odśwież"
+            height: 40
+            font.pixelSize: 14
+            onClicked: mainWindow.refreshWatchList()
+        }
+
+        Text {
+            height: 40
+            verticalAlignment: Text.AlignVCenter
+            font.pixelSize: 14
+            color: "#333"
+            text: mainWindow.watchList.count === 0
+                  ? "Dodaj stacje gwiazdką na liście stacji."
+                  : "Stacji: " + mainWindow.watchList.count
+                    + (mainWindow.watchList.lastRefresh !== "" ? ", odświeżono " + mainWindow.watchList.lastRefresh : "")
+                    + " (prawy przycisk usuwa kafelek)"
+        }
+    }
+
+    /**
+     * @brief All tiles drawn by one item, repainted once per refresh cycle.
+     */
+    Dashboard {
+        id: dashboard
+        anchors.top: controls.bottom
+        anchors.left: parent.left
+        anchors.right: parent.right
+        anchors.bottom: parent.bottom
+        anchors.margins: 10
+        watchList: mainWindow.watchList
+
+        MouseArea {
+            anchors.fill: parent
+            acceptedButtons: Qt.RightButton
+            onClicked: function(mouse) {
+                var index = dashboard.tileAt(mouse.x, mouse.y)
+                if (index >= 0) {
+                    mainWindow.toggleWatch(mainWindow.watchList.stationIdAt(index))
+                }
+            }
+        }
+    }
+
+    function open() {
+        visible = true
+    }
+
+    function close() {
+        visible = false
+    }
+}
@@ -18,6 +18,48 @@ Window {
 
     property var selectedSensors: ({})
     property var colors: ["#4CAF50", "#FF0000", "#0000FF", "#FFA500", "#800080", "#00CED1"]
+    property int rangeHours: 0
+    property var archiveData: ({})
+    property var snapshots: []
+    property string revisionPath: ""
+    property var revisionData: ({})
+
+    function loadArchive() {
+        var data = {}
+        if (rangeHours > 0) {
+            var ids = Object.keys(selectedSensors)
+            for (var i = 0; i < ids.length; i++) {
+                // Serie pochodne nie są archiwizowane
+                if (!isNaN(Number(ids[i]))) {
+                    data[ids[i]] = mainWindow.archivedSeries(Number(ids[i]), rangeHours, chartCanvas.width)
+                }
+            }
+        }
+        archiveData = data
+        chartCanvas.requestPaint()
+    }
+
+    // Porównuje zapis stacji z bieżącymi (zweryfikowanymi) danymi
+    function loadRevisions() {
+        var data = {}
+        var changed = 0, added = 0, removed = 0
+        if (revisionPath !== "") {
+            var ids = Object.keys(selectedSensors)
+            for (var i = 0; i < ids.length; i++) {
+                if (isNaN(Number(ids[i]))) continue
+                var diff = mainWindow.snapshotDiff(revisionPath, Number(ids[i]))
+                if (diff.samples === undefined) continue
+                data[ids[i]] = diff.samples
+                changed += diff.changed
+                added += diff.added
+                removed += diff.removed
+            }
+        }
+        revisionData = data
+        revisionSummary.text = revisionPath === "" ? ""
+            : "Zmienione: " + changed + ", dodane: " + added + ", usunięte: " + removed
+        chartCanvas.requestPaint()
+    }
 
     Rectangle {
         id: header
@@ -62,7 +104,7 @@ Window {
             ListView {
                 id: paramsList
                 width: parent.width
-                height: parent.height - paramsHeader.height - parent.spacing
+                height: parent.height - paramsHeader.height - derivedInput.height - derivedList.height - 3 * parent.spacing
                 spacing: 10
                 clip: true
                 model: mainWindow.sensors
@@ -91,6 +133,8 @@ Window {
                                     delete selectedSensors[modelData.sensorId]
                                     mainWindow.removeSensorData(modelData.sensorId)
                                 }
+                                if (rangeHours > 0) loadArchive()
+                                if (revisionPath !== "") loadRevisions()
                                 chartCanvas.requestPaint()
                             }
                         }
@@ -120,6 +164,77 @@ Window {
                     }
                 }
             }
+
+            Row {
+                id: derivedInput
+                width: parent.width
+                spacing: 5
+
+                TextField {
+                    id: expressionField
+                    width: parent.width - addDerivedButton.width - parent.spacing
+                    height: 40
+                    placeholderText: "Seria pochodna, np. s101 / s102"
+                    font.pixelSize: 14
+                    color: text === "" || mainWindow.expressionError(text) === "" ? "black" : "#FF0000"
+                    onAccepted: addDerivedButton.clicked()
+                }
+
+                Button {
+                    id: addDerivedButton
+                    text: "Dodaj"
+                    height: 40
+                    font.pixelSize: 14
+                    onClicked: {
+                        var key = mainWindow.addDerivedSeries(expressionField.text)
+                        if (key === "") return
+                        if (selectedSensors[key] === undefined) {
+                            derivedSeries.append({ "key": key })
+                        }
+                        selectedSensors[key] = key.substring(1)
+                        expressionField.text = ""
+                        chartCanvas.requestPaint()
+                    }
+                }
+            }
+
+            Column {
+                id: derivedList
+                width: parent.width
+                spacing: 5
+
+                Repeater {
+                    model: ListModel { id: derivedSeries }
+
+                    delegate: Rectangle {
+                        width: derivedList.width
+                        height: 30
+                        color: "#C8E6C9"
+                        radius: 5
+
+                        Text {
+                            anchors.left: parent.left
+                            anchors.leftMargin: 10
+                            anchors.verticalCenter: parent.verticalCenter
+                            text: model.key.substring(1)
+                            font.pixelSize: 14
+                        }
+
+                        Button {
+                            anchors.right: parent.right
+                            height: parent.height
+                            text: "Usuń"
+                            font.pixelSize: 12
+                            onClicked: {
+                                delete selectedSensors[model.key]
+                                mainWindow.removeDerivedSeries(model.key)
+                                derivedSeries.remove(index)
+                                chartCanvas.requestPaint()
+                            }
+                        }
+                    }
+                }
+            }
         }
 
         Column {
@@ -140,6 +255,10 @@ Window {
                     anchors.fill: parent
                     anchors.margins: 50
 
+                    function timeOf(date) {
+                        return Date.parse(date.replace(" ", "T"))
+                    }
+
                     onPaint: {
                         var ctx = getContext("2d")
                         ctx.clearRect(0, 0, width, height)
@@ -171,7 +290,7 @@ Window {
                         ctx.lineTo(0, height)
                         ctx.stroke()
 
-                        var sensorData = mainWindow.sensorData
+                        var sensorData = rangeHours > 0 ? archiveData : mainWindow.sensorData
                         var selectedSensorIds = Object.keys(selectedSensors)
                         if (selectedSensorIds.length === 0 || Object.keys(sensorData).length === 0) {
                             ctx.fillText("Wybierz mierzone parametry aby wyświetlić odczyty.", width / 2 - 150, height / 2)
@@ -182,12 +301,13 @@ Window {
                         var globalMinValue = Number.MAX_VALUE
                         var allDataPoints = []
                         var timePoints = []
+                        var minTime = Number.MAX_VALUE
+                        var maxTime = -Number.MAX_VALUE
 
                         for (var i = 0; i < selectedSensorIds.length; i++) {
                             var sensorId = selectedSensorIds[i]
                             var data = sensorData[sensorId]
                             if (!data) {
-                                console.log("No data for sensor:", sensorId)
                                 continue
                             }
 
@@ -197,14 +317,43 @@ Window {
                                     globalMaxValue = Math.max(globalMaxValue, value)
                                     globalMinValue = Math.min(globalMinValue, value)
                                 }
+                                if (data[j].max !== undefined) {
+                                    globalMaxValue = Math.max(globalMaxValue, data[j].max)
+                                    globalMinValue = Math.min(globalMinValue, data[j].min)
+                                }
                                 if (i === 0) {
                                     timePoints.push(data[j].date)
                                 }
                             }
+                            if (data.length > 0) {
+                                // Dane z API są uporządkowane od najnowszych
+                                minTime = Math.min(minTime, timeOf(data[data.length - 1].date))
+                                maxTime = Math.max(maxTime, timeOf(data[0].date))
+                            }
                             allDataPoints.push(data)
-                        }
 
-                        console.log("Time points:", timePoints.length, "Min value:", globalMinValue, "Max value:", globalMaxValue, "Selected sensors:", selectedSensorIds)
+                            var revisions = rangeHours === 0 ? revisionData[sensorId] : undefined
+                            if (revisions) {
+                                for (var j = 0; j < revisions.length; j++) {
+                                    if (revisions[j].archived !== null) {
+                                        globalMaxValue = Math.max(globalMaxValue, revisions[j].archived)
+                                        globalMinValue = Math.min(globalMinValue, revisions[j].archived)
+                                    }
+                                }
+                            }
+
+                            var forecast = mainWindow.forecastEnabled ? sensorData["f" + sensorId] : undefined
+                            if (forecast && forecast.length > 0) {
+                                for (var j = 0; j < forecast.length; j++) {
+                                    globalMaxValue = Math.max(globalMaxValue, forecast[j].upper)
+                                    globalMinValue = Math.min(globalMinValue, forecast[j].lower)
+                                }
+                                maxTime = Math.max(maxTime, timeOf(forecast[0].date))
+                            }
+                        }
+                        if (maxTime <= minTime) {
+                            maxTime = minTime + 1
+                        }
 
                         if (globalMaxValue === globalMinValue) {
                             globalMaxValue += 1
@@ -221,7 +370,7 @@ Window {
                         for (var i = 0; i < timePoints.length; i++) {
                             var time = timePoints[i].split(" ")[1]
                             if (time === "00:00:00") {
-                                var x = (i / (timePoints.length - 1)) * width
+                                var x = (timeOf(timePoints[i]) - minTime) / (maxTime - minTime) * width
                                 ctx.beginPath()
                                 ctx.moveTo(x, 0)
                                 ctx.lineTo(x, height)
@@ -235,6 +384,27 @@ Window {
                             var data = sensorData[sensorId]
                             if (!data) continue
 
+                            // Agregaty z archiwum: zakres min-max
+                            if (data.length > 0 && data[0].max !== undefined && data[0].count > 1) {
+                                ctx.fillStyle = colors[s]
+                                ctx.globalAlpha = 0.15
+                                ctx.beginPath()
+                                for (var i = 0; i < data.length; i++) {
+                                    var x = (timeOf(data[i].date) - minTime) / (maxTime - minTime) * width
+                                    var y = height - ((data[i].max - globalMinValue) / (globalMaxValue - globalMinValue)) * height
+                                    if (i === 0) ctx.moveTo(x, y)
+                                    else ctx.lineTo(x, y)
+                                }
+                                for (var i = data.length - 1; i >= 0; i--) {
+                                    var x = (timeOf(data[i].date) - minTime) / (maxTime - minTime) * width
+                                    var y = height - ((data[i].min - globalMinValue) / (globalMaxValue - globalMinValue)) * height
+                                    ctx.lineTo(x, y)
+                                }
+                                ctx.closePath()
+                                ctx.fill()
+                                ctx.globalAlpha = 1.0
+                            }
+
                             ctx.strokeStyle = colors[s]
                             ctx.lineWidth = 2
                             ctx.beginPath()
@@ -242,7 +412,7 @@ Window {
                             for (var i = 0; i < data.length; i++) {
                                 var value = data[i].value
                                 if (value === null || isNaN(value)) continue
-                                var x = (i / (data.length - 1)) * width
+                                var x = (timeOf(data[i].date) - minTime) / (maxTime - minTime) * width
                                 var y = height - ((value - globalMinValue) / (globalMaxValue - globalMinValue)) * height
                                 if (firstPoint) {
                                     ctx.moveTo(x, y)
@@ -252,6 +422,78 @@ Window {
                                 }
                             }
                             ctx.stroke()
+
+                            // Rewizje względem zapisu: zmiana od wartości zapisanej do bieżącej,
+                            // pomiary dodane na zielono, usunięte na czerwono
+                            var revisions = rangeHours === 0 ? revisionData[sensorId] : undefined
+                            if (revisions) {
+                                for (var i = 0; i < revisions.length; i++) {
+                                    var revision = revisions[i]
+                                    var x = (timeOf(revision.date) - minTime) / (maxTime - minTime) * width
+                                    var archivedY = revision.archived !== null ? height - ((revision.archived - globalMinValue) / (globalMaxValue - globalMinValue)) * height : 0
+                                    var liveY = revision.live !== null ? height - ((revision.live - globalMinValue) / (globalMaxValue - globalMinValue)) * height : 0
+                                    if (revision.kind === "changed") {
+                                        ctx.strokeStyle = "#FF9800"
+                                        ctx.lineWidth = 2
+                                        ctx.beginPath()
+                                        ctx.moveTo(x, archivedY)
+                                        ctx.lineTo(x, liveY)
+                                        ctx.stroke()
+                                        ctx.fillStyle = "#FF9800"
+                                        ctx.beginPath()
+                                        ctx.arc(x, liveY, 4, 0, 2 * Math.PI)
+                                        ctx.fill()
+                                    } else if (revision.kind === "added") {
+                                        ctx.fillStyle = "#2E7D32"
+                                        ctx.beginPath()
+                                        ctx.arc(x, liveY, 4, 0, 2 * Math.PI)
+                                        ctx.fill()
+                                    } else {
+                                        ctx.strokeStyle = "#C62828"
+                                        ctx.lineWidth = 2
+                                        ctx.beginPath()
+                                        ctx.moveTo(x - 4, archivedY - 4)
+                                        ctx.lineTo(x + 4, archivedY + 4)
+                                        ctx.moveTo(x + 4, archivedY - 4)
+                                        ctx.lineTo(x - 4, archivedY + 4)
+                                        ctx.stroke()
+                                    }
+                                }
+                            }
+
+                            // Prognoza 24h: przedział ufności i przerywana linia
+                            var forecast = mainWindow.forecastEnabled ? sensorData["f" + sensorId] : undefined
+                            if (!forecast || forecast.length === 0) continue
+
+                            var valueRange = globalMaxValue - globalMinValue
+                            ctx.fillStyle = colors[s]
+                            ctx.globalAlpha = 0.2
+                            ctx.beginPath()
+                            for (var i = 0; i < forecast.length; i++) {
+                                var x = (timeOf(forecast[i].date) - minTime) / (maxTime - minTime) * width
+                                var y = height - ((forecast[i].upper - globalMinValue) / valueRange) * height
+                                if (i === 0) ctx.moveTo(x, y)
+                                else ctx.lineTo(x, y)
+                            }
+                            for (var i = forecast.length - 1; i >= 0; i--) {
+                                var x = (timeOf(forecast[i].date) - minTime) / (maxTime - minTime) * width
+                                var y = height - ((forecast[i].lower - globalMinValue) / valueRange) * height
+                                ctx.lineTo(x, y)
+                            }
+                            ctx.closePath()
+                            ctx.fill()
+                            ctx.globalAlpha = 1.0
+
+                            ctx.setLineDash([4, 4])
+                            ctx.beginPath()
+                            for (var i = 0; i < forecast.length; i++) {
+                                var x = (timeOf(forecast[i].date) - minTime) / (maxTime - minTime) * width
+                                var y = height - ((forecast[i].value - globalMinValue) / valueRange) * height
+                                if (i === 0) ctx.moveTo(x, y)
+                                else ctx.lineTo(x, y)
+                            }
+                            ctx.stroke()
+                            ctx.setLineDash([])
                         }
 
                         ctx.fillStyle = "black"
@@ -264,7 +506,7 @@ Window {
                             var minutes = time.split(":")[1]
 
                             if (hour % 4 === 0 && hour !== lastHour) {
-                                var x = (i / (timePoints.length - 1)) * width
+                                var x = (timeOf(timePoints[i]) - minTime) / (maxTime - minTime) * width
                                 var timeLabel = (hour < 10 ? "0" + hour : hour) + ":" + minutes
                                 var dateLabel = date[2] + "." + date[1] + "." + date[0].slice(2)
                                 ctx.save()
@@ -339,6 +581,72 @@ Window {
                         }
                     }
 
+                    CheckBox {
+                        id: forecastCheckBox
+                        text: "Prognoza 24h"
+                        font.pixelSize: 14
+                        checked: mainWindow.forecastEnabled
+                        onToggled: {
+                            mainWindow.forecastEnabled = checked
+                            chartCanvas.requestPaint()
+                        }
+                    }
+
+                    Row {
+                        width: parent.width
+                        spacing: 10
+
+                        Text {
+                            anchors.verticalCenter: parent.verticalCenter
+                            text: "Zakres wykresu:"
+                            font.pixelSize: 14
+                        }
+
+                        ComboBox {
+                            id: rangeSelector
+                            property var hours: [0, 168, 720, 8760]
+                            width: 200
+                            height: 40
+                            font.pixelSize: 14
+                            model: ["Bieżące dane", "7 dni (archiwum)", "30 dni (archiwum)", "Rok (archiwum)"]
+                            onActivated: {
+                                rangeHours = hours[currentIndex]
+                                loadArchive()
+                            }
+                        }
+                    }
+
+                    Row {
+                        width: parent.width
+                        spacing: 10
+
+                        Text {
+                            anchors.verticalCenter: parent.verticalCenter
+                            text: "Porównaj z zapisem:"
+                            font.pixelSize: 14
+                        }
+
+                        ComboBox {
+                            id: snapshotSelector
+                            width: 200
+                            height: 40
+                            font.pixelSize: 14
+                            model: snapshots
+                            textRole: "saveDate"
+                            onActivated: {
+                                revisionPath = snapshots[currentIndex].path
+                                loadRevisions()
+                            }
+                        }
+
+                        Text {
+                            id: revisionSummary
+                            anchors.verticalCenter: parent.verticalCenter
+                            font.pixelSize: 14
+                            color: "#FF9800"
+                        }
+                    }
+
                     Button {
                         id: saveButton
                         width: parent.width
@@ -347,6 +655,7 @@ Window {
                         font.pixelSize: 14
                         onClicked: {
                             mainWindow.saveStationData(stationId, cityName, street + (number ? " " + number : ""))
+                            loadSnapshots()
                         }
                     }
 
@@ -439,7 +748,8 @@ Window {
     Connections {
         target: mainWindow
         function onSensorDataChanged() {
-            console.log("Sensor data changed, requesting paint and updating stats")
+            if (rangeHours > 0) loadArchive()
+            if (revisionPath !== "") loadRevisions()
             chartCanvas.requestPaint()
             latestValueText.text = Qt.binding(function() {
                 if (paramSelector.currentIndex < 0) return ""
@@ -452,7 +762,18 @@ Window {
         }
     }
 
+    // Lista zapisów stacji; pierwsza pozycja wyłącza porównanie
+    function loadSnapshots() {
+        var current = revisionPath
+        snapshots = [{ "path": "", "saveDate": "Brak" }].concat(mainWindow.stationSnapshots(stationId))
+        snapshotSelector.currentIndex = 0
+        for (var i = 0; i < snapshots.length; i++) {
+            if (snapshots[i].path === current) snapshotSelector.currentIndex = i
+        }
+    }
+
     function open() {
+        loadSnapshots()
         visible = true
     }
 }
@@ -0,0 +1,85 @@
+/**
+ * @file airquality.cpp
+ * @brief Implementation of the air quality index scale.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * Thresholds follow the hourly GIOŚ air quality index.
+ */
+
+#include "airquality.h"
+#include <cmath>
+
+namespace {
+
+/**
+ * @struct Thresholds
+ * @brief Upper bounds of the first five index levels of a parameter.
+ */
+struct Thresholds {
+    const char *param;      ///< Normalized parameter code
+    double bounds[5];       ///< Upper bounds in µg/m³
+};
+
+const Thresholds thresholds[] = {
+    {"PM10", {20, 50, 80, 110, 150}},
+    {"PM2.5", {13, 35, 55, 75, 110}},
+    {"NO2", {40, 100, 150, 230, 400}},
+    {"O3", {70, 120, 150, 180, 240}},
+    {"SO2", {50, 100, 200, 350, 500}},
+};
+
+} // namespace
+
+/**
+ * @brief Gets the index level of a concentration.
+ * @param param Parameter code, e.g. "PM10".
+ * @param value Concentration in µg/m³.
+ * @return Level 0 (very good) to 5 (very bad), -1 for NaN or an unknown parameter.
+ */
+int AirQuality::level(const QString &param, double value)
+{
+    if (std::isnan(value)) {
+        return -1;
+    }
+    const QString key = param.toUpper();
+    for (const Thresholds &t : thresholds) {
+        if (key != QLatin1String(t.param)) {
+            continue;
+        }
+        for (int i = 0; i < 5; ++i) {
+            if (value <= t.bounds[i]) {
+                return i;
+            }
+        }
+        return 5;
+    }
+    return -1;
+}
+
+/**
+ * @brief Gets the color of an index level.
+ * @param level Level from level(), -1 for no data.
+ * @return Opaque color; grey for no data.
+ */
+QRgb AirQuality::color(int level)
+{
+    static const QRgb colors[LevelCount] = {
+        qRgb(0x57, 0xb1, 0x08), qRgb(0xb0, 0xdd, 0x10), qRgb(0xff, 0xd9, 0x11),
+        qRgb(0xe5, 0x81, 0x00), qRgb(0xe5, 0x00, 0x00), qRgb(0x99, 0x00, 0x00)
+    };
+    return level >= 0 && level < LevelCount ? colors[level] : qRgb(0xa0, 0xa0, 0xa0);
+}
+
+/**
+ * @brief Gets the Polish name of an index level.
+ * @param level Level from level().
+ * @return Level name, "Brak indeksu" for -1.
+ */
+QString AirQuality::levelName(int level)
+{
+    static const char *names[LevelCount] = {
+        "Bardzo dobry", "Dobry", "Umiarkowany", "Dostateczny", "Zły", "Bardzo zły"
+    };
+    return level >= 0 && level < LevelCount ? QString::fromUtf8(names[level]) : QString("Brak indeksu");
+}
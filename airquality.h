@@ -0,0 +1,52 @@
+/**
+ * @file airquality.h
+ * @brief Header file for the air quality index scale.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the mapping of pollutant concentrations to the six GIOŚ
+ * air quality index levels and their colors.
+ */
+
+#ifndef AIRQUALITY_H
+#define AIRQUALITY_H
+
+#include <QRgb>
+#include <QString>
+
+/**
+ * @namespace AirQuality
+ * @brief GIOŚ air quality index scale.
+ */
+namespace AirQuality {
+
+/**
+ * @brief Number of index levels, from "bardzo dobry" to "bardzo zły".
+ */
+constexpr int LevelCount = 6;
+
+/**
+ * @brief Gets the index level of a concentration.
+ * @param param Parameter code, e.g. "PM10".
+ * @param value Concentration in µg/m³.
+ * @return Level 0 (very good) to 5 (very bad), -1 for NaN or an unknown parameter.
+ */
+int level(const QString &param, double value);
+
+/**
+ * @brief Gets the color of an index level.
+ * @param level Level from level(), -1 for no data.
+ * @return Opaque color; grey for no data.
+ */
+QRgb color(int level);
+
+/**
+ * @brief Gets the Polish name of an index level.
+ * @param level Level from level().
+ * @return Level name, "Brak indeksu" for -1.
+ */
+QString levelName(int level);
+
+} // namespace AirQuality
+
+#endif // AIRQUALITY_H
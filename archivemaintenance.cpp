@@ -0,0 +1,341 @@
+/**
+ * @file archivemaintenance.cpp
+ * @brief Implementation of the ArchiveMaintenance class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the batched parallel import of legacy snapshots, the
+ * import journal and the compaction and retention pass.
+ */
+
+#include "archivemaintenance.h"
+#include "taskpool.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QRegularExpression>
+#include <QtConcurrent>
+#include <cmath>
+
+namespace {
+
+/**
+ * @struct ParsedFile
+ * @brief Result of parsing one legacy file.
+ */
+struct ParsedFile {
+    QHash<int, Series> series;  ///< Series by sensor ID
+    bool ok = false;            ///< False if the file is not a valid snapshot
+};
+
+} // namespace
+
+/**
+ * @brief Constructs the maintenance of an archive.
+ * @param archive Archive to maintain; must outlive this object.
+ * @param parent Parent QObject.
+ */
+ArchiveMaintenance::ArchiveMaintenance(LocalArchive *archive, QObject *parent)
+    : QObject(parent),
+    m_archive(archive)
+{
+    // Jeden wątek koordynujący; parsowanie korzysta z globalnej puli
+    m_pool.setMaxThreadCount(1);
+    connect(&m_watcher, &QFutureWatcher<MaintenanceReport>::finished, this, [this]() {
+        emit finished(m_watcher.result());
+    });
+}
+
+/**
+ * @brief Destroys the object, cancelling a running maintenance.
+ */
+ArchiveMaintenance::~ArchiveMaintenance()
+{
+    cancel();
+}
+
+/**
+ * @brief Starts maintenance on a worker thread.
+ * @param legacyDirectory Directory with station_<id>_<timestamp>.json files.
+ */
+void ArchiveMaintenance::start(const QString &legacyDirectory)
+{
+    if (isRunning()) {
+        return;
+    }
+    m_cancelled = false;
+    m_watcher.setFuture(QtConcurrent::run(&m_pool, [this, legacyDirectory]() {
+        return run(legacyDirectory);
+    }));
+}
+
+/**
+ * @brief Cancels a running maintenance and waits for it to stop.
+ */
+void ArchiveMaintenance::cancel()
+{
+    m_cancelled = true;
+    m_watcher.waitForFinished();
+}
+
+/**
+ * @brief Runs maintenance on the calling thread.
+ * @param legacyDirectory Directory with station_<id>_<timestamp>.json files.
+ * @return Report of the run.
+ *
+ * A batch is journaled as a begin record with its sensors, then its files
+ * and a commit record once all its series are archived. A begin record
+ * without a commit means the run stopped mid-batch: the rollups of its
+ * sensors are rebuilt and the batch is imported again, which is harmless
+ * because appending already archived samples changes nothing.
+ */
+MaintenanceReport ArchiveMaintenance::run(const QString &legacyDirectory)
+{
+    MaintenanceReport report;
+    QSet<QString> imported;
+    QList<int> dirtySensors;
+    readJournal(&imported, &dirtySensors);
+
+    // Przerwana partia: surowe dane mogły trafić do archiwum bez agregatów
+    if (!dirtySensors.isEmpty()) {
+        for (int sensorId : std::as_const(dirtySensors)) {
+            if (!m_archive->rebuildRollups(sensorId)) {
+                report.interrupted = true;
+                return report;
+            }
+        }
+        appendJournal("C\n");
+    }
+
+    const QList<LegacyFile> files = pendingFiles(legacyDirectory, imported, &report.filesSkipped);
+    for (qsizetype first = 0; first < files.size(); first += BatchSize) {
+        if (m_cancelled) {
+            report.interrupted = true;
+            return report;
+        }
+
+        const QList<LegacyFile> batch = files.mid(first, BatchSize);
+        const QList<ParsedFile> parsed = TaskPool::instance().blockingMapped(batch, [](const LegacyFile &file) {
+            ParsedFile result;
+            result.series = readSnapshot(file.path, &result.ok);
+            return result;
+        }, TaskPool::Low);
+
+        // Pliki są posortowane od najstarszego zapisu, więc nowszy pomiar nadpisuje starszy
+        QMap<int, QMap<qint64, double>> merged;
+        QByteArray fileRecords;
+        for (qsizetype i = 0; i < batch.size(); ++i) {
+            fileRecords += "F\t" + batch[i].key.toUtf8() + "\n";
+            if (!parsed[i].ok) {
+                ++report.filesFailed;
+                continue;
+            }
+            ++report.filesImported;
+            for (auto it = parsed[i].series.cbegin(); it != parsed[i].series.cend(); ++it) {
+                QMap<qint64, double> &samples = merged[it.key()];
+                for (qsizetype k = 0; k < it.value().size(); ++k) {
+                    if (!std::isnan(it.value().values[k])) {
+                        samples.insert(it.value().timestamps[k], it.value().values[k]);
+                    }
+                }
+            }
+        }
+
+        QStringList sensorIds;
+        for (auto it = merged.cbegin(); it != merged.cend(); ++it) {
+            sensorIds.append(QString::number(it.key()));
+        }
+        if (!appendJournal("B\t" + sensorIds.join(',').toUtf8() + "\n")) {
+            report.interrupted = true;
+            return report;
+        }
+
+        for (auto it = merged.cbegin(); it != merged.cend(); ++it) {
+            Series series;
+            series.timestamps = it.value().keys();
+            series.values = it.value().values();
+            const int changed = m_archive->append(it.key(), series);
+            if (changed < 0) {
+                report.interrupted = true;
+                return report;
+            }
+            report.samplesImported += changed;
+        }
+
+        if (!appendJournal(fileRecords + "C\n")) {
+            report.interrupted = true;
+            return report;
+        }
+        emit progress(int(first + batch.size()), int(files.size()));
+    }
+
+    // Kompaktowanie i retencja
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const QList<int> sensors = m_archive->sensorIds();
+    for (int sensorId : sensors) {
+        if (m_cancelled) {
+            report.interrupted = true;
+            break;
+        }
+        const int packed = m_archive->compact(sensorId, now);
+        const qint64 expired = m_archive->applyRetention(sensorId, now);
+        if (packed < 0 || expired < 0) {
+            report.interrupted = true;
+            break;
+        }
+        report.segmentsCompacted += packed;
+        report.rowsExpired += expired;
+    }
+    return report;
+}
+
+/**
+ * @brief Gets the path of the import journal.
+ * @return File path inside the archive directory.
+ */
+QString ArchiveMaintenance::journalPath() const
+{
+    return m_archive->rootPath() + "/import.journal";
+}
+
+/**
+ * @brief Reads a station snapshot saved by MainWindow::saveStationData().
+ * @param path Snapshot file.
+ * @param ok Set to false if the file is not a valid snapshot.
+ * @return Series by sensor ID.
+ */
+QHash<int, Series> ArchiveMaintenance::readSnapshot(const QString &path, bool *ok)
+{
+    QHash<int, Series> result;
+    *ok = false;
+
+    QFile input(path);
+    if (!input.open(QIODevice::ReadOnly)) {
+        return result;
+    }
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(input.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        return result;
+    }
+
+    const QJsonArray sensors = doc.object()["sensors"].toArray();
+    for (const QJsonValue &sensor : sensors) {
+        const QJsonObject object = sensor.toObject();
+        const int sensorId = object["sensorId"].toInt();
+        if (sensorId <= 0) {
+            continue;
+        }
+        const Series series = SeriesStore::fromVariantList(object["measurements"].toArray().toVariantList());
+        if (!series.isEmpty()) {
+            result.insert(sensorId, series);
+        }
+    }
+    *ok = true;
+    return result;
+}
+
+/**
+ * @brief Lists legacy files not imported yet, oldest snapshot first.
+ * @param directory Directory to scan.
+ * @param imported Journal keys of imported files.
+ * @param skipped Incremented for every already imported file.
+ * @return Files to import.
+ *
+ * A file is identified by name, size and modification time, so a file
+ * rewritten under the same name is imported again.
+ */
+QList<ArchiveMaintenance::LegacyFile> ArchiveMaintenance::pendingFiles(const QString &directory, const QSet<QString> &imported, int *skipped)
+{
+    static const QRegularExpression pattern("^station_(\\d+)_(\\d{8}_\\d{6})\\.json$");
+
+    QList<LegacyFile> files;
+    const QFileInfoList entries = QDir(directory).entryInfoList(QStringList() << "station_*_*.json", QDir::Files);
+    for (const QFileInfo &entry : entries) {
+        const QRegularExpressionMatch match = pattern.match(entry.fileName());
+        if (!match.hasMatch()) {
+            continue;
+        }
+        LegacyFile file;
+        file.path = entry.absoluteFilePath();
+        file.key = QString("%1|%2|%3").arg(entry.fileName()).arg(entry.size())
+                       .arg(entry.lastModified().toMSecsSinceEpoch());
+        file.savedAt = match.captured(2);
+        if (imported.contains(file.key)) {
+            ++*skipped;
+            continue;
+        }
+        files.append(file);
+    }
+
+    std::sort(files.begin(), files.end(), [](const LegacyFile &a, const LegacyFile &b) {
+        return a.savedAt != b.savedAt ? a.savedAt < b.savedAt : a.path < b.path;
+    });
+    return files;
+}
+
+/**
+ * @brief Reads the journal.
+ * @param imported Receives the keys of files of finished batches.
+ * @param dirtySensors Receives the sensors of an unfinished batch.
+ *
+ * A record cut off by a crash has no terminating newline and is ignored.
+ */
+void ArchiveMaintenance::readJournal(QSet<QString> *imported, QList<int> *dirtySensors) const
+{
+    QFile file(journalPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QList<QByteArray> lines = file.readAll().split('\n');
+    // Ostatni element to fragment po ostatnim znaku nowej linii
+    lines.removeLast();
+
+    QStringList pending;
+    for (const QByteArray &line : std::as_const(lines)) {
+        if (line.startsWith("B\t")) {
+            pending.clear();
+            dirtySensors->clear();
+            for (const QByteArray &id : line.mid(2).split(',')) {
+                if (!id.isEmpty()) {
+                    dirtySensors->append(id.toInt());
+                }
+            }
+        } else if (line.startsWith("F\t")) {
+            pending.append(QString::fromUtf8(line.mid(2)));
+        } else if (line == "C") {
+            for (const QString &key : std::as_const(pending)) {
+                imported->insert(key);
+            }
+            pending.clear();
+            dirtySensors->clear();
+        }
+    }
+}
+
+/**
+ * @brief Appends records to the journal and syncs them to disk.
+ * @param records Complete, newline-terminated records.
+ * @return True on success.
+ *
+ * Unless the archive never syncs, the records are forced to disk, so a
+ * commit record never survives a crash that lost the data it confirms.
+ */
+bool ArchiveMaintenance::appendJournal(const QByteArray &records) const
+{
+    if (!QDir().mkpath(m_archive->rootPath())) {
+        return false;
+    }
+    QFile file(journalPath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        return false;
+    }
+    if (file.write(records) != records.size()) {
+        return false;
+    }
+    return m_archive->syncPolicy() == WriteAheadLog::SyncNever ? file.flush() : WriteAheadLog::syncFile(file);
+}
@@ -0,0 +1,162 @@
+/**
+ * @file archivemaintenance.h
+ * @brief Header file for the ArchiveMaintenance class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the background maintenance of the local archive: import
+ * of legacy station JSON snapshots, compaction and retention.
+ */
+
+#ifndef ARCHIVEMAINTENANCE_H
+#define ARCHIVEMAINTENANCE_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include "localarchive.h"
+
+/**
+ * @struct MaintenanceReport
+ * @brief Result of one maintenance run.
+ */
+struct MaintenanceReport {
+    int filesImported = 0;          ///< Legacy files imported in this run
+    int filesSkipped = 0;           ///< Legacy files imported by earlier runs
+    int filesFailed = 0;            ///< Legacy files that could not be parsed
+    qint64 samplesImported = 0;     ///< New or changed archived samples
+    int segmentsCompacted = 0;      ///< Month segments packed into yearly ones
+    qint64 rowsExpired = 0;         ///< Rows removed by the retention policy
+    bool interrupted = false;       ///< True if cancelled or failed to write
+};
+
+/**
+ * @class ArchiveMaintenance
+ * @brief Imports legacy snapshots and compacts the archive on a worker thread.
+ *
+ * Legacy files are processed in batches: the files of a batch are parsed in
+ * parallel, overlapping measurements are de-duplicated with the newest
+ * snapshot winning, and the merged series are appended to the archive. A
+ * journal next to the archive records every finished batch, so a run that
+ * was interrupted resumes with the first unfinished one.
+ */
+class ArchiveMaintenance : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int BatchSize = 64;    ///< Legacy files per batch
+
+    /**
+     * @brief Constructs the maintenance of an archive.
+     * @param archive Archive to maintain; must outlive this object.
+     * @param parent Parent QObject.
+     */
+    explicit ArchiveMaintenance(LocalArchive *archive, QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the object, cancelling a running maintenance.
+     */
+    ~ArchiveMaintenance() override;
+
+    /**
+     * @brief Starts maintenance on a worker thread.
+     * @param legacyDirectory Directory with station_<id>_<timestamp>.json files.
+     *
+     * Does nothing if a maintenance is already running.
+     */
+    void start(const QString &legacyDirectory);
+
+    /**
+     * @brief Runs maintenance on the calling thread.
+     * @param legacyDirectory Directory with station_<id>_<timestamp>.json files.
+     * @return Report of the run.
+     */
+    MaintenanceReport run(const QString &legacyDirectory);
+
+    /**
+     * @brief Cancels a running maintenance and waits for it to stop.
+     *
+     * The current batch is finished first, so the journal stays consistent.
+     */
+    void cancel();
+
+    /**
+     * @brief Checks whether maintenance is running.
+     * @return True while running.
+     */
+    bool isRunning() const { return m_watcher.isRunning(); }
+
+    /**
+     * @brief Gets the path of the import journal.
+     * @return File path inside the archive directory.
+     */
+    QString journalPath() const;
+
+    /**
+     * @brief Reads a station snapshot saved by MainWindow::saveStationData().
+     * @param path Snapshot file.
+     * @param ok Set to false if the file is not a valid snapshot.
+     * @return Series by sensor ID.
+     */
+    static QHash<int, Series> readSnapshot(const QString &path, bool *ok);
+
+signals:
+    /**
+     * @brief Emitted after every imported batch, from the worker thread.
+     * @param done Files processed so far.
+     * @param total Files to process in this run.
+     */
+    void progress(int done, int total);
+
+    /**
+     * @brief Emitted when a maintenance started by start() finishes.
+     * @param report Report of the run.
+     */
+    void finished(const MaintenanceReport &report);
+
+private:
+    /**
+     * @struct LegacyFile
+     * @brief Legacy snapshot file waiting for import.
+     */
+    struct LegacyFile {
+        QString path;           ///< File path
+        QString key;            ///< Journal key: name, size and modification time
+        QString savedAt;        ///< Save timestamp from the file name, sortable
+    };
+
+    /**
+     * @brief Lists legacy files not imported yet, oldest snapshot first.
+     * @param directory Directory to scan.
+     * @param imported Journal keys of imported files.
+     * @param skipped Incremented for every already imported file.
+     * @return Files to import.
+     */
+    static QList<LegacyFile> pendingFiles(const QString &directory, const QSet<QString> &imported, int *skipped);
+
+    /**
+     * @brief Reads the journal.
+     * @param imported Receives the keys of files of finished batches.
+     * @param dirtySensors Receives the sensors of an unfinished batch.
+     */
+    void readJournal(QSet<QString> *imported, QList<int> *dirtySensors) const;
+
+    /**
+     * @brief Appends records to the journal and syncs them to disk.
+     * @param records Complete, newline-terminated records.
+     * @return True on success.
+     */
+    bool appendJournal(const QByteArray &records) const;
+
+    LocalArchive *m_archive;                        ///< Maintained archive
+    QThreadPool m_pool;                             ///< Thread of the running maintenance
+    QFutureWatcher<MaintenanceReport> m_watcher;    ///< Running maintenance
+    std::atomic_bool m_cancelled{false};            ///< Set by cancel()
+};
+
+#endif // ARCHIVEMAINTENANCE_H
@@ -0,0 +1,182 @@
+/**
+ * @file async.cpp
+ * @brief Implementation of the coroutine layer over the network requests.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the cancellation token, the network reply awaiter and
+ * the awaitable provider requests.
+ */
+
+#include "async.h"
+#include <QNetworkReply>
+#include <QPointer>
+
+namespace Async {
+
+namespace {
+
+/**
+ * @brief Awaits a provider request which is aborted when the token is cancelled.
+ * @param send Function sending the request with the given callback and abort hook.
+ * @param token Cancellation token.
+ * @param cancelled Value returned when the token is cancelled.
+ * @return Awaiter resuming with the value passed to the callback.
+ *
+ * The awaiter resumes with the cancelled value at once; the abort only
+ * stops the request behind it, whose late callback is then ignored.
+ */
+template<typename T>
+CallbackAwaiter<T> request(std::function<void(std::function<void(T)>, const DataProvider::AbortHook &)> send,
+                           CancelToken token, T cancelled)
+{
+    return callback<T>([send, token](std::function<void(T)> resolve) mutable {
+        const auto subscription = std::make_shared<int>(-1);
+        send([token, subscription, resolve](T value) mutable {
+            token.unsubscribe(*subscription);
+            resolve(std::move(value));
+        }, [token, subscription](std::function<void()> abort) mutable {
+            *subscription = token.subscribe(std::move(abort));
+        });
+    }, token, std::move(cancelled));
+}
+
+} // namespace
+
+/**
+ * @brief Gets the error of cancelled requests.
+ * @return Error message.
+ */
+QString cancelledError()
+{
+    return QStringLiteral("Anulowano");
+}
+
+/**
+ * @brief Cancels all requests awaited with this token.
+ *
+ * Handlers may resume coroutines which register or remove other handlers,
+ * so the list is taken before any of them runs.
+ */
+void CancelToken::cancel()
+{
+    if (m_state->cancelled) {
+        return;
+    }
+    m_state->cancelled = true;
+    const QHash<int, std::function<void()>> handlers = std::exchange(m_state->handlers, {});
+    for (const std::function<void()> &handler : handlers) {
+        handler();
+    }
+}
+
+/**
+ * @brief Registers a function called by cancel().
+ * @param handler Function.
+ * @return Registration ID for unsubscribe().
+ */
+int CancelToken::subscribe(std::function<void()> handler)
+{
+    const int id = m_state->nextId++;
+    m_state->handlers.insert(id, std::move(handler));
+    return id;
+}
+
+/**
+ * @brief Removes a registered function.
+ * @param id Registration ID.
+ */
+void CancelToken::unsubscribe(int id)
+{
+    m_state->handlers.remove(id);
+}
+
+/**
+ * @brief Awaits the end of a network reply.
+ * @param reply Reply; the caller keeps ownership.
+ * @param token Cancellation token; cancelling aborts the reply.
+ * @return Awaiter resuming with the reply once it has finished.
+ *
+ * The awaiter itself ignores the token: the aborted reply finishes with
+ * QNetworkReply::OperationCanceledError and the coroutine sees that error.
+ */
+CallbackAwaiter<QNetworkReply *> finished(QNetworkReply *reply, CancelToken token)
+{
+    return CallbackAwaiter<QNetworkReply *>([reply, token](std::function<void(QNetworkReply *)> resolve) mutable {
+        if (reply->isFinished()) {
+            resolve(reply);
+            return;
+        }
+        const int subscription = token.subscribe([guard = QPointer<QNetworkReply>(reply)]() {
+            if (guard) {
+                guard->abort();
+            }
+        });
+        QObject::connect(reply, &QNetworkReply::finished, reply, [reply, token, subscription, resolve]() mutable {
+            token.unsubscribe(subscription);
+            resolve(reply);
+        }, Qt::SingleShotConnection);
+        if (token.isCancelled()) {
+            reply->abort();
+        }
+    }, CancelToken(), reply);
+}
+
+/**
+ * @brief Fetches all stations of a provider.
+ * @param provider Provider.
+ * @param token Cancellation token.
+ * @return Task returning the stations.
+ */
+Task<Result<QList<StationRecord>>> stations(DataProvider *provider, CancelToken token)
+{
+    using Value = Result<QList<StationRecord>>;
+    // Wartość nazwana: GCC 12 źle niszczy tymczasowe listy inicjalizujące w co_await
+    const Value cancelled{{}, cancelledError()};
+    co_return co_await request<Value>([provider](std::function<void(Value)> resolve,
+                                                  const DataProvider::AbortHook &abortHook) {
+        provider->fetchStations([resolve](const QList<StationRecord> &stations, const QString &error) {
+            resolve({stations, error});
+        }, abortHook);
+    }, token, cancelled);
+}
+
+/**
+ * @brief Fetches the sensors of a station from its provider.
+ * @param providers Providers.
+ * @param stationId Global station ID.
+ * @param token Cancellation token.
+ * @return Task returning the sensors.
+ */
+Task<Result<QList<SensorInfo>>> sensors(ProviderRegistry *providers, int stationId, CancelToken token)
+{
+    using Value = Result<QList<SensorInfo>>;
+    const Value cancelled{{}, cancelledError()};
+    co_return co_await request<Value>([providers, stationId](std::function<void(Value)> resolve,
+                                                            const DataProvider::AbortHook &abortHook) {
+        providers->fetchSensors(stationId, [resolve](const QList<SensorInfo> &sensors, const QString &error) {
+            resolve({sensors, error});
+        }, abortHook);
+    }, token, cancelled);
+}
+
+/**
+ * @brief Fetches the series of a sensor from its provider.
+ * @param providers Providers.
+ * @param sensorId Global sensor ID.
+ * @param token Cancellation token.
+ * @return Task returning the samples.
+ */
+Task<Result<Series>> series(ProviderRegistry *providers, int sensorId, CancelToken token)
+{
+    using Value = Result<Series>;
+    const Value cancelled{{}, cancelledError()};
+    co_return co_await request<Value>([providers, sensorId](std::function<void(Value)> resolve,
+                                                           const DataProvider::AbortHook &abortHook) {
+        providers->fetchSeries(sensorId, [resolve](const Series &series, const QString &error) {
+            resolve({series, error});
+        }, abortHook);
+    }, token, cancelled);
+}
+
+} // namespace Async
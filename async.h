@@ -0,0 +1,561 @@
+/**
+ * @file async.h
+ * @brief Header file of the coroutine layer over the network requests.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the Task coroutine type, awaitable callbacks and
+ * network replies, whenAll() and the cancellation token used by the fetch
+ * pipelines.
+ */
+
+#ifndef ASYNC_H
+#define ASYNC_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "dataprovider.h"
+
+class QNetworkReply;
+
+/**
+ * @namespace Async
+ * @brief Coroutines over the callback and signal based network requests.
+ *
+ * A Task does not run until it is awaited by another task or passed to
+ * start(). Awaiting resumes the coroutine from the callback or signal that
+ * ends the request, so everything runs on the thread of the event loop and
+ * the code after co_await may touch the GUI objects. Errors travel in the
+ * returned values, the way the provider callbacks report them.
+ */
+namespace Async {
+
+/**
+ * @struct Result
+ * @brief Value of a request and its error.
+ */
+template<typename T>
+struct Result {
+    T value;        ///< Value, default constructed on error
+    QString error;  ///< Error message, empty on success
+
+    /**
+     * @brief Checks whether the request succeeded.
+     * @return True if there is no error.
+     */
+    bool ok() const { return error.isEmpty(); }
+};
+
+/**
+ * @brief Gets the error of cancelled requests.
+ * @return Error message.
+ */
+QString cancelledError();
+
+/**
+ * @class CancelToken
+ * @brief Shared flag cancelling the requests of a pipeline.
+ *
+ * Copies share the flag. Awaiting a request with a cancelled token ends it
+ * at once with cancelledError(); network replies and the provider requests
+ * behind them are aborted.
+ */
+class CancelToken {
+public:
+    /**
+     * @brief Cancels all requests awaited with this token.
+     */
+    void cancel();
+
+    /**
+     * @brief Checks whether the token was cancelled.
+     * @return True after cancel().
+     */
+    bool isCancelled() const { return m_state->cancelled; }
+
+    /**
+     * @brief Registers a function called by cancel().
+     * @param handler Function.
+     * @return Registration ID for unsubscribe().
+     */
+    int subscribe(std::function<void()> handler);
+
+    /**
+     * @brief Removes a registered function.
+     * @param id Registration ID.
+     */
+    void unsubscribe(int id);
+
+private:
+    /**
+     * @struct State
+     * @brief Flag and handlers shared by the copies.
+     */
+    struct State {
+        bool cancelled = false;                         ///< Set by cancel()
+        int nextId = 0;                                 ///< Next registration ID
+        QHash<int, std::function<void()>> handlers;     ///< Functions called by cancel()
+    };
+
+    std::shared_ptr<State> m_state = std::make_shared<State>();     ///< Shared state
+};
+
+template<typename T = void>
+class Task;
+
+namespace detail {
+
+/**
+ * @struct FinalAwaiter
+ * @brief Resumes the awaiting coroutine when a task ends.
+ */
+struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+    {
+        const std::coroutine_handle<> next = handle.promise().continuation;
+        return next ? next : std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+};
+
+/**
+ * @struct PromiseBase
+ * @brief Part of the task promise independent of the value type.
+ */
+struct PromiseBase {
+    std::coroutine_handle<> continuation;   ///< Coroutine awaiting the task
+    std::exception_ptr exception;           ///< Exception thrown by the task
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() { exception = std::current_exception(); }
+};
+
+/**
+ * @struct Promise
+ * @brief Promise of a task returning a value.
+ */
+template<typename T>
+struct Promise : PromiseBase {
+    std::optional<T> value;     ///< Returned value
+
+    Task<T> get_return_object();
+
+    template<typename U>
+    void return_value(U &&result) { value.emplace(std::forward<U>(result)); }
+
+    T take()
+    {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+        return std::move(*value);
+    }
+};
+
+/**
+ * @struct Promise
+ * @brief Promise of a task returning nothing.
+ */
+template<>
+struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+
+    void return_void() const noexcept {}
+
+    void take() const
+    {
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * @class Task
+ * @brief Lazily started coroutine returning a T.
+ *
+ * The task owns its coroutine frame. Awaiting it (co_await std::move(task))
+ * starts it and resumes the awaiting coroutine with its value.
+ */
+template<typename T>
+class Task {
+public:
+    using promise_type = detail::Promise<T>;
+
+    /**
+     * @brief Constructs an empty task.
+     */
+    Task() = default;
+
+    /**
+     * @brief Takes ownership of a coroutine frame.
+     * @param handle Frame of the coroutine.
+     */
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+    Task(Task &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+
+    Task &operator=(Task &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+
+    /**
+     * @brief Destroys the coroutine frame.
+     */
+    ~Task() { reset(); }
+
+    /**
+     * @brief Checks whether the task owns a coroutine.
+     * @return False for a default constructed or moved from task.
+     */
+    bool isValid() const { return bool(m_handle); }
+
+    /**
+     * @brief Starts the task from an awaiting coroutine.
+     * @return Awaiter resuming with the value of the task.
+     *
+     * The task must be valid.
+     */
+    auto operator co_await() && noexcept
+    {
+        Q_ASSERT_X(isValid(), "Async::Task", "awaiting an empty task");
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept { return handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() { return handle.promise().take(); }
+        };
+        return Awaiter{m_handle};
+    }
+
+private:
+    /**
+     * @brief Destroys the owned coroutine frame.
+     */
+    void reset()
+    {
+        if (m_handle) {
+            m_handle.destroy();
+            m_handle = {};
+        }
+    }
+
+    std::coroutine_handle<promise_type> m_handle;   ///< Owned coroutine frame
+};
+
+namespace detail {
+
+template<typename T>
+Task<T> Promise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+/**
+ * @struct Detached
+ * @brief Coroutine freeing its own frame when it ends.
+ */
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const noexcept { return {}; }
+        std::suspend_never initial_suspend() const noexcept { return {}; }
+        std::suspend_never final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+/**
+ * @brief Awaits a task and passes its value to a function.
+ * @param task Task.
+ * @param done Function called with the value.
+ * @return Detached coroutine.
+ */
+template<typename T, typename Done>
+Detached drive(Task<T> task, Done done)
+{
+    if constexpr (std::is_void_v<T>) {
+        co_await std::move(task);
+        done();
+    } else {
+        done(co_await std::move(task));
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Runs a task without awaiting it.
+ * @param task Task; it runs until its first suspension before this returns.
+ * @param done Function called with the value when the task ends.
+ *
+ * An exception escaping the task terminates the program, like one
+ * escaping a slot.
+ */
+template<typename T, typename Done>
+void start(Task<T> task, Done done)
+{
+    detail::drive(std::move(task), std::move(done));
+}
+
+/**
+ * @brief Runs a task returning nothing without awaiting it.
+ * @param task Task.
+ */
+inline void start(Task<void> task)
+{
+    start(std::move(task), []() {});
+}
+
+/**
+ * @class CallbackAwaiter
+ * @brief Awaits a request reporting its value through a callback.
+ *
+ * The callback may be called before the starting function returns, as
+ * synchronous providers do; the coroutine then continues without
+ * suspending. A callback arriving after cancellation is ignored.
+ */
+template<typename T>
+class CallbackAwaiter {
+public:
+    using Resolve = std::function<void(T)>;     ///< Callback passed to the request
+
+    /**
+     * @brief Constructs the awaiter.
+     * @param starter Function sending the request with the given callback.
+     * @param token Cancellation token.
+     * @param cancelled Value returned when the token is cancelled.
+     */
+    CallbackAwaiter(std::function<void(Resolve)> starter, CancelToken token, T cancelled)
+        : m_starter(std::move(starter)), m_cancelled(std::move(cancelled)), m_state(std::make_shared<State>())
+    {
+        m_state->token = std::move(token);
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        const std::shared_ptr<State> state = m_state;
+        state->handle = handle;
+        if (state->token.isCancelled()) {
+            state->value = m_cancelled;
+            return false;
+        }
+        state->subscription = state->token.subscribe([state, cancelled = m_cancelled]() {
+            finish(state, cancelled);
+        });
+        m_starter([state](T value) {
+            finish(state, std::move(value));
+        });
+        if (state->done) {
+            return false;
+        }
+        state->suspended = true;
+        return true;
+    }
+
+    T await_resume() { return std::move(*m_state->value); }
+
+private:
+    /**
+     * @struct State
+     * @brief State shared with the callback, which may outlive the awaiter.
+     */
+    struct State {
+        std::coroutine_handle<> handle;     ///< Awaiting coroutine
+        std::optional<T> value;             ///< Received value
+        CancelToken token;                  ///< Cancellation token
+        int subscription = -1;              ///< Registration in the token
+        bool suspended = false;             ///< True once the coroutine suspended
+        bool done = false;                  ///< True once a value arrived
+    };
+
+    /**
+     * @brief Stores the first value and resumes the coroutine.
+     * @param state Shared state.
+     * @param value Value.
+     */
+    static void finish(const std::shared_ptr<State> &state, T value)
+    {
+        if (state->done) {
+            return;
+        }
+        state->done = true;
+        state->value = std::move(value);
+        state->token.unsubscribe(state->subscription);
+        if (state->suspended) {
+            state->handle.resume();
+        }
+    }
+
+    std::function<void(Resolve)> m_starter;     ///< Sends the request
+    T m_cancelled;                              ///< Value after cancellation
+    std::shared_ptr<State> m_state;             ///< State shared with the callback
+};
+
+/**
+ * @brief Awaits a callback based request.
+ * @param starter Function sending the request with the given callback.
+ * @param token Cancellation token.
+ * @param cancelled Value returned when the token is cancelled.
+ * @return Awaiter resuming with the value passed to the callback.
+ */
+template<typename T>
+CallbackAwaiter<T> callback(std::function<void(std::function<void(T)>)> starter, CancelToken token = {}, T cancelled = {})
+{
+    return CallbackAwaiter<T>(std::move(starter), std::move(token), std::move(cancelled));
+}
+
+/**
+ * @brief Awaits the end of a network reply.
+ * @param reply Reply; the caller keeps ownership.
+ * @param token Cancellation token; cancelling aborts the reply.
+ * @return Awaiter resuming with the reply once it has finished.
+ */
+CallbackAwaiter<QNetworkReply *> finished(QNetworkReply *reply, CancelToken token = {});
+
+namespace detail {
+
+/**
+ * @class AllAwaiter
+ * @brief Runs tasks concurrently and resumes when all of them have ended.
+ */
+template<typename T>
+class AllAwaiter {
+public:
+    /**
+     * @brief Constructs the awaiter.
+     * @param tasks Tasks, started when awaited.
+     */
+    explicit AllAwaiter(std::vector<Task<T>> tasks)
+        : m_tasks(std::move(tasks)), m_state(std::make_shared<State>())
+    {
+    }
+
+    bool await_ready() const noexcept { return m_tasks.empty(); }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        const std::shared_ptr<State> state = m_state;
+        state->handle = handle;
+        state->values.resize(m_tasks.size());
+        // Jeden dodatkowy licznik do końca pętli: zadania synchroniczne nie wznowią nas przedwcześnie
+        state->pending = m_tasks.size() + 1;
+        for (std::size_t i = 0; i < m_tasks.size(); ++i) {
+            start(std::move(m_tasks[i]), [state, i](T value) {
+                state->values[i] = std::move(value);
+                if (--state->pending == 0) {
+                    state->handle.resume();
+                }
+            });
+        }
+        return --state->pending != 0;
+    }
+
+    QList<T> await_resume()
+    {
+        QList<T> values;
+        values.reserve(qsizetype(m_state->values.size()));
+        for (std::optional<T> &value : m_state->values) {
+            values.append(std::move(*value));
+        }
+        return values;
+    }
+
+private:
+    /**
+     * @struct State
+     * @brief Values and the count of running tasks.
+     */
+    struct State {
+        std::coroutine_handle<> handle;         ///< Awaiting coroutine
+        std::vector<std::optional<T>> values;   ///< Values in task order
+        std::size_t pending = 0;                ///< Tasks still running, plus one while starting
+    };
+
+    std::vector<Task<T>> m_tasks;       ///< Tasks to start
+    std::shared_ptr<State> m_state;     ///< State shared with the tasks
+};
+
+} // namespace detail
+
+/**
+ * @brief Runs tasks concurrently.
+ * @param tasks Tasks.
+ * @return Task returning the values in the order of the tasks.
+ *
+ * All tasks are started before the first one is awaited, so their
+ * requests are in flight together.
+ */
+template<typename T>
+Task<QList<T>> whenAll(std::vector<Task<T>> tasks)
+{
+    co_return co_await detail::AllAwaiter<T>(std::move(tasks));
+}
+
+/**
+ * @brief Fetches all stations of a provider.
+ * @param provider Provider.
+ * @param token Cancellation token.
+ * @return Task returning the stations.
+ */
+Task<Result<QList<StationRecord>>> stations(DataProvider *provider, CancelToken token = {});
+
+/**
+ * @brief Fetches the sensors of a station from its provider.
+ * @param providers Providers.
+ * @param stationId Global station ID.
+ * @param token Cancellation token.
+ * @return Task returning the sensors.
+ */
+Task<Result<QList<SensorInfo>>> sensors(ProviderRegistry *providers, int stationId, CancelToken token = {});
+
+/**
+ * @brief Fetches the series of a sensor from its provider.
+ * @param providers Providers.
+ * @param sensorId Global sensor ID.
+ * @param token Cancellation token.
+ * @return Task returning the samples.
+ */
+Task<Result<Series>> series(ProviderRegistry *providers, int sensorId, CancelToken token = {});
+
+} // namespace Async
+
+#endif // ASYNC_H
@@ -0,0 +1,422 @@
+/**
+ * @file batchsearch.cpp
+ * @brief Implementation of the BatchSearchModel class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the local-first city lookup, the paced Nominatim queue
+ * and the station matching of the batch search.
+ */
+
+#include "batchsearch.h"
+#include "mainwindow.h"
+#include "metrics.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QUrlQuery>
+#include <QVariantMap>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+/**
+ * @brief Gets the metrics of the Nominatim requests.
+ * @return Metrics shared with the single city search.
+ */
+const RequestMetrics &geocodeMetrics()
+{
+    static const RequestMetrics metrics("geocode");
+    return metrics;
+}
+
+} // namespace
+
+/**
+ * @brief Constructs an empty model.
+ * @param network Network manager used for Nominatim requests.
+ * @param parent Parent QObject.
+ */
+BatchSearchModel::BatchSearchModel(QNetworkAccessManager *network, QObject *parent)
+    : QAbstractListModel(parent),
+    m_network(network),
+    m_buffers(ReplyBufferPool::of(network))
+{
+    m_dispatchTimer.setInterval(RequestInterval);
+    connect(&m_dispatchTimer, &QTimer::timeout, this, [this]() {
+        if (m_queue.isEmpty()) {
+            m_dispatchTimer.stop();
+        } else {
+            dispatch();
+        }
+    });
+}
+
+/**
+ * @brief Replaces the stations searched in.
+ * @param stations All stations.
+ */
+void BatchSearchModel::setStations(const QList<Station *> &stations)
+{
+    m_entries.clear();
+    m_entries.reserve(stations.size());
+    m_entriesByCity.clear();
+    m_coordinates.clear();
+    m_coordinates.reserve(int(stations.size()));
+    for (const Station *station : stations) {
+        m_entriesByCity[normalize(station->cityName())].append(int(m_entries.size()));
+        m_entries.append({station->stationId(), station->stationName(), station->cityName(), station->lat(), station->lon()});
+        m_coordinates.append(station->lat(), station->lon());
+    }
+}
+
+/**
+ * @brief Starts a search, cancelling the previous one.
+ * @param cities City names; blank names are skipped.
+ * @param radius Radius in km around each city, 0 to list the stations of
+ *               the city or the nearest one like the single search.
+ *
+ * Local matches are published before the first Nominatim request leaves, so
+ * the remote lookups overlap only with each other and the pacing interval.
+ */
+void BatchSearchModel::search(const QStringList &cities, double radius)
+{
+    cancel();
+
+    beginResetModel();
+    m_groups.clear();
+    m_rowsByKey.clear();
+    m_radius = std::max(0.0, radius);
+    m_pending = 0;
+    for (const QString &city : cities) {
+        const QString query = city.trimmed();
+        if (query.isEmpty()) {
+            continue;
+        }
+        const QString key = normalize(query);
+        Group group;
+        group.query = query;
+
+        const auto local = m_entriesByCity.constFind(key);
+        if (local != m_entriesByCity.cend()) {
+            // Miasto ze znanymi stacjami leży w ich środku ciężkości
+            double lat = 0.0;
+            double lon = 0.0;
+            for (int entry : local.value()) {
+                lat += m_entries[entry].lat;
+                lon += m_entries[entry].lon;
+            }
+            group.point = QGeoCoordinate(lat / local.value().size(), lon / local.value().size());
+            group.state = Local;
+            group.hits = match(key, group.point);
+        } else if (m_geocodeCache.contains(key)) {
+            static Counter *hits = Metrics::instance().counter("airapi_cache_hits_total", "Lookups answered from a cache.",
+                                                               "cache=\"geocode\"");
+            hits->add();
+            group.point = m_geocodeCache.value(key);
+            group.state = group.point.isValid() ? Geocoded : NotFound;
+            if (group.point.isValid()) {
+                group.hits = match(key, group.point);
+            }
+        } else {
+            static Counter *misses = Metrics::instance().counter("airapi_cache_misses_total", "Lookups a cache could not answer.",
+                                                                 "cache=\"geocode\"");
+            misses->add();
+            // Jedno zapytanie na miasto, nawet jeśli powtarza się na liście
+            QList<int> &rows = m_rowsByKey[key];
+            if (rows.isEmpty()) {
+                m_queue.append(key);
+                m_queryByKey.insert(key, query);
+            }
+            rows.append(int(m_groups.size()));
+            ++m_pending;
+        }
+        m_groups.append(group);
+    }
+    endResetModel();
+    emit countChanged();
+    emit pendingChanged();
+
+    if (m_pending == 0) {
+        emit finished();
+    } else if (!m_dispatchTimer.isActive()) {
+        dispatch();
+        m_dispatchTimer.start();
+    }
+}
+
+/**
+ * @brief Cancels the queued and running lookups.
+ *
+ * Cities still waiting are marked as failed.
+ */
+void BatchSearchModel::cancel()
+{
+    ++m_generation;
+    m_queue.clear();
+    m_queryByKey.clear();
+    const QList<QPointer<QNetworkReply>> replies = std::exchange(m_replies, {});
+    for (const QPointer<QNetworkReply> &reply : replies) {
+        if (reply) {
+            reply->abort();
+        }
+    }
+
+    for (auto it = m_rowsByKey.cbegin(); it != m_rowsByKey.cend(); ++it) {
+        for (int row : it.value()) {
+            m_groups[row].state = Failed;
+            emit dataChanged(index(row), index(row), {StateRole});
+        }
+    }
+    m_rowsByKey.clear();
+    if (m_pending != 0) {
+        m_pending = 0;
+        emit pendingChanged();
+    }
+}
+
+/**
+ * @brief Gets the number of matched stations of all cities.
+ * @return Station count.
+ */
+int BatchSearchModel::stationCount() const
+{
+    int total = 0;
+    for (const Group &group : m_groups) {
+        total += int(group.hits.size());
+    }
+    return total;
+}
+
+/**
+ * @brief Gets the memory held by the geocoding cache.
+ * @return Bytes and number of cached cities.
+ */
+MemoryAccounting::Usage BatchSearchModel::memoryUsage() const
+{
+    MemoryAccounting::Usage usage;
+    usage.objects = m_geocodeCache.size();
+    usage.bytes = MemoryAccounting::bytes(m_geocodeCache);
+    for (auto it = m_geocodeCache.cbegin(); it != m_geocodeCache.cend(); ++it) {
+        usage.bytes += MemoryAccounting::bytes(it.key());
+    }
+    return usage;
+}
+
+/**
+ * @brief Gets the station IDs matched for a city.
+ * @param row Row index.
+ * @return Station IDs, nearest first.
+ */
+QList<int> BatchSearchModel::stationIds(int row) const
+{
+    QList<int> ids;
+    if (row < 0 || row >= m_groups.size()) {
+        return ids;
+    }
+    for (const GeoTable::Hit &hit : m_groups[row].hits) {
+        ids.append(m_entries[hit.index].stationId);
+    }
+    return ids;
+}
+
+int BatchSearchModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : count();
+}
+
+QVariant BatchSearchModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_groups.size()) {
+        return QVariant();
+    }
+
+    const Group &group = m_groups[index.row()];
+    switch (role) {
+    case Qt::DisplayRole:
+    case QueryRole:
+        return group.query;
+    case StateRole:
+        return group.state;
+    case LatRole:
+        return group.point.isValid() ? group.point.latitude() : std::nan("");
+    case LonRole:
+        return group.point.isValid() ? group.point.longitude() : std::nan("");
+    case StationCountRole:
+        return int(group.hits.size());
+    case StationsRole: {
+        QVariantList stations;
+        stations.reserve(group.hits.size());
+        for (const GeoTable::Hit &hit : group.hits) {
+            const Entry &entry = m_entries[hit.index];
+            QVariantMap station;
+            station["stationId"] = entry.stationId;
+            station["stationName"] = entry.name;
+            station["cityName"] = entry.city;
+            station["distance"] = hit.distance;
+            stations.append(station);
+        }
+        return stations;
+    }
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> BatchSearchModel::roleNames() const
+{
+    return {
+        {QueryRole, "query"},
+        {StateRole, "state"},
+        {LatRole, "lat"},
+        {LonRole, "lon"},
+        {StationCountRole, "stationCount"},
+        {StationsRole, "stations"}
+    };
+}
+
+/**
+ * @brief Normalizes a city name for comparison.
+ * @param city City name.
+ * @return Lower-case name with simplified whitespace.
+ */
+QString BatchSearchModel::normalize(const QString &city)
+{
+    return city.toLower().simplified();
+}
+
+/**
+ * @brief Matches the stations of a located city.
+ * @param key Normalized city name.
+ * @param point Location of the city.
+ * @return Matched stations, nearest first.
+ *
+ * Uses the same rules as the single search: the stations within the radius,
+ * or else the stations of the city, or else the nearest station.
+ */
+QVector<GeoTable::Hit> BatchSearchModel::match(const QString &key, const QGeoCoordinate &point) const
+{
+    if (m_radius > 0.0) {
+        return m_coordinates.within(point.latitude(), point.longitude(), m_radius);
+    }
+
+    QVector<GeoTable::Hit> hits;
+    if (m_entries.isEmpty()) {
+        return hits;
+    }
+    QVector<double> distances(m_coordinates.size());
+    m_coordinates.distances(point.latitude(), point.longitude(), distances.data());
+
+    const QList<int> city = m_entriesByCity.value(key);
+    if (city.isEmpty()) {
+        const auto nearest = std::min_element(distances.cbegin(), distances.cend());
+        hits.append({int(nearest - distances.cbegin()), *nearest});
+        return hits;
+    }
+    for (int entry : city) {
+        hits.append({entry, distances[entry]});
+    }
+    std::sort(hits.begin(), hits.end(), [](const GeoTable::Hit &a, const GeoTable::Hit &b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.index < b.index;
+    });
+    return hits;
+}
+
+/**
+ * @brief Publishes the result of a lookup in every row of a city.
+ * @param key Normalized city name.
+ * @param point Location, invalid if the city is unknown.
+ * @param state State of the rows.
+ */
+void BatchSearchModel::resolve(const QString &key, const QGeoCoordinate &point, State state)
+{
+    const QList<int> rows = m_rowsByKey.take(key);
+    if (rows.isEmpty()) {
+        return;
+    }
+
+    const QVector<GeoTable::Hit> hits = point.isValid() ? match(key, point) : QVector<GeoTable::Hit>();
+    for (int row : rows) {
+        Group &group = m_groups[row];
+        group.point = point;
+        group.state = state;
+        group.hits = hits;
+        emit dataChanged(index(row), index(row));
+    }
+
+    m_pending -= int(rows.size());
+    emit pendingChanged();
+    if (m_pending == 0) {
+        emit finished();
+    }
+}
+
+/**
+ * @brief Sends the next queued Nominatim request.
+ */
+void BatchSearchModel::dispatch()
+{
+    if (m_queue.isEmpty()) {
+        return;
+    }
+    const QString key = m_queue.takeFirst();
+
+    QUrlQuery query;
+    query.addQueryItem("q", m_queryByKey.take(key));
+    query.addQueryItem("format", "json");
+    query.addQueryItem("limit", "1");
+
+    QUrl url("https://nominatim.openstreetmap.org/search");
+    url.setQuery(query);
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "ControlStationsApp/1.0");
+    QNetworkReply *reply = m_network->get(request);
+    m_buffers->attach(reply);
+    geocodeMetrics().track(reply);
+    m_replies.append(reply);
+    const int generation = m_generation;
+    connect(reply, &QNetworkReply::finished, this, [this, reply, key, generation]() {
+        onGeocodeReply(reply, key, generation);
+    });
+}
+
+/**
+ * @brief Handles a Nominatim reply.
+ * @param reply Network reply.
+ * @param key Normalized city name.
+ * @param generation Search the request belongs to.
+ *
+ * Answers are cached even for a cancelled search, so the next search of the
+ * city needs no request.
+ */
+void BatchSearchModel::onGeocodeReply(QNetworkReply *reply, const QString &key, int generation)
+{
+    reply->deleteLater();
+    m_replies.removeAll(reply);
+    if (reply->error() != QNetworkReply::NoError) {
+        if (generation == m_generation) {
+            resolve(key, QGeoCoordinate(), Failed);
+        }
+        return;
+    }
+
+    QGeoCoordinate point;
+    {
+        HistogramTimer timer(geocodeMetrics().parse);
+        const PooledBuffer body = m_buffers->take(reply);
+        const QJsonArray results = QJsonDocument::fromJson(body.data()).array();
+        if (!results.isEmpty()) {
+            const QJsonObject result = results.first().toObject();
+            point = QGeoCoordinate(result["lat"].toString().toDouble(), result["lon"].toString().toDouble());
+        }
+    }
+    m_geocodeCache.insert(key, point);
+
+    if (generation == m_generation) {
+        resolve(key, point, point.isValid() ? Geocoded : NotFound);
+    }
+}
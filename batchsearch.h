@@ -0,0 +1,229 @@
+/**
+ * @file batchsearch.h
+ * @brief Header file for the BatchSearchModel class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the search of stations for many cities at once, with the
+ * results grouped by city.
+ */
+
+#ifndef BATCHSEARCH_H
+#define BATCHSEARCH_H
+
+#include <QAbstractListModel>
+#include <QGeoCoordinate>
+#include <QHash>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+#include "geotable.h"
+#include "memoryaccounting.h"
+#include "replybufferpool.h"
+
+class Station;
+
+/**
+ * @class BatchSearchModel
+ * @brief List model of station searches for many cities, one row per city.
+ *
+ * Cities are resolved locally first: a city with known stations is located
+ * at their centroid, and earlier Nominatim answers are cached. Only the
+ * remaining cities go to Nominatim, one request per second as its usage
+ * policy requires, while every local match is published at once. Repeated
+ * cities share one lookup.
+ */
+class BatchSearchModel : public QAbstractListModel {
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+    Q_PROPERTY(int pending READ pending NOTIFY pendingChanged)
+
+public:
+    /**
+     * @brief State of a city row.
+     */
+    enum State {
+        Pending,    ///< Waiting for Nominatim
+        Local,      ///< Located from the known stations
+        Geocoded,   ///< Located by Nominatim or the cache
+        NotFound,   ///< Unknown city
+        Failed      ///< Nominatim request failed
+    };
+    Q_ENUM(State)
+
+    /**
+     * @brief Custom data roles.
+     */
+    enum Roles {
+        QueryRole = Qt::UserRole + 1,   ///< City as entered
+        StateRole,                      ///< State of the row
+        LatRole,                        ///< Latitude of the city, NaN if unknown
+        LonRole,                        ///< Longitude of the city, NaN if unknown
+        StationCountRole,               ///< Number of matched stations
+        StationsRole                    ///< List of maps with "stationId", "stationName", "cityName" and "distance" in km
+    };
+
+    /**
+     * @brief Constructs an empty model.
+     * @param network Network manager used for Nominatim requests.
+     * @param parent Parent QObject.
+     */
+    explicit BatchSearchModel(QNetworkAccessManager *network, QObject *parent = nullptr);
+
+    /**
+     * @brief Replaces the stations searched in.
+     * @param stations All stations.
+     */
+    void setStations(const QList<Station *> &stations);
+
+    /**
+     * @brief Starts a search, cancelling the previous one.
+     * @param cities City names; blank names are skipped.
+     * @param radius Radius in km around each city, 0 to list the stations of
+     *               the city or the nearest one like the single search.
+     */
+    void search(const QStringList &cities, double radius = 0.0);
+
+    /**
+     * @brief Cancels the queued and running lookups.
+     */
+    Q_INVOKABLE void cancel();
+
+    /**
+     * @brief Gets the number of cities.
+     * @return Row count.
+     */
+    int count() const { return int(m_groups.size()); }
+
+    /**
+     * @brief Gets the number of cities still waiting for Nominatim.
+     * @return Pending row count.
+     */
+    int pending() const { return m_pending; }
+
+    /**
+     * @brief Gets the memory held by the geocoding cache.
+     * @return Bytes and number of cached cities.
+     */
+    MemoryAccounting::Usage memoryUsage() const;
+
+    /**
+     * @brief Gets the number of matched stations of all cities.
+     * @return Station count.
+     */
+    int stationCount() const;
+
+    /**
+     * @brief Gets the station IDs matched for a city.
+     * @param row Row index.
+     * @return Station IDs, nearest first.
+     */
+    QList<int> stationIds(int row) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    /**
+     * @brief Interval between Nominatim requests in ms.
+     */
+    static constexpr int RequestInterval = 1000;
+
+signals:
+    /**
+     * @brief Emitted when the number of cities changes.
+     */
+    void countChanged();
+
+    /**
+     * @brief Emitted when the number of pending cities changes.
+     */
+    void pendingChanged();
+
+    /**
+     * @brief Emitted when every city of a search is resolved.
+     */
+    void finished();
+
+private:
+    /**
+     * @struct Entry
+     * @brief Station data needed for matching.
+     */
+    struct Entry {
+        int stationId = 0;  ///< Station ID
+        QString name;       ///< Station name
+        QString city;       ///< City name
+        double lat = 0.0;   ///< Latitude
+        double lon = 0.0;   ///< Longitude
+    };
+
+    /**
+     * @struct Group
+     * @brief Result of one city.
+     */
+    struct Group {
+        QString query;                  ///< City as entered
+        State state = Pending;          ///< State of the row
+        QGeoCoordinate point;           ///< Location of the city
+        QVector<GeoTable::Hit> hits;    ///< Matched stations, nearest first
+    };
+
+    /**
+     * @brief Normalizes a city name for comparison.
+     * @param city City name.
+     * @return Lower-case name with simplified whitespace.
+     */
+    static QString normalize(const QString &city);
+
+    /**
+     * @brief Matches the stations of a located city.
+     * @param key Normalized city name.
+     * @param point Location of the city.
+     * @return Matched stations, nearest first.
+     */
+    QVector<GeoTable::Hit> match(const QString &key, const QGeoCoordinate &point) const;
+
+    /**
+     * @brief Publishes the result of a lookup in every row of a city.
+     * @param key Normalized city name.
+     * @param point Location, invalid if the city is unknown.
+     * @param state State of the rows.
+     */
+    void resolve(const QString &key, const QGeoCoordinate &point, State state);
+
+    /**
+     * @brief Sends the next queued Nominatim request.
+     */
+    void dispatch();
+
+    /**
+     * @brief Handles a Nominatim reply.
+     * @param reply Network reply.
+     * @param key Normalized city name.
+     * @param generation Search the request belongs to.
+     */
+    void onGeocodeReply(QNetworkReply *reply, const QString &key, int generation);
+
+    QNetworkAccessManager *m_network;               ///< Network manager
+    ReplyBufferPool *m_buffers;                     ///< Receives the reply bodies
+    QVector<Entry> m_entries;                       ///< Stations searched in
+    GeoTable m_coordinates;                         ///< Coordinates of m_entries
+    QHash<QString, QList<int>> m_entriesByCity;     ///< Entries by normalized city
+    QHash<QString, QGeoCoordinate> m_geocodeCache;  ///< Nominatim answers, invalid for unknown cities
+    QVector<Group> m_groups;                        ///< Results in input order
+    QHash<QString, QList<int>> m_rowsByKey;         ///< Pending rows by normalized city
+    QStringList m_queue;                            ///< Cities waiting for a request
+    QHash<QString, QString> m_queryByKey;           ///< City text sent to Nominatim
+    QList<QPointer<QNetworkReply>> m_replies;       ///< Running requests
+    QTimer m_dispatchTimer;                         ///< Paces Nominatim requests
+    double m_radius = 0.0;                          ///< Radius of the search in km
+    int m_pending = 0;                              ///< Rows waiting for Nominatim
+    int m_generation = 0;                           ///< Current search, ignores stale replies
+};
+
+#endif // BATCHSEARCH_H
@@ -0,0 +1,341 @@
+/**
+ * @file correlation.cpp
+ * @brief Implementation of the correlation routines and CorrelationModel.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the standardization, the tiled Gram product kernel and
+ * the heatmap table model.
+ */
+
+#include "correlation.h"
+#include "taskpool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+constexpr int Lanes = 8;            ///< Independent accumulators per dot product
+constexpr int TileSize = 64;        ///< Columns per tile side
+constexpr qsizetype ChunkSize = 1024; ///< Samples per time chunk, keeps a tile in L2
+
+/**
+ * @struct Standardized
+ * @brief Unit-norm columns stored contiguously with padded stride.
+ */
+struct Standardized {
+    QVector<float> data;        ///< Column-major values, stride floats per column
+    qsizetype stride = 0;       ///< Padded column length, multiple of Lanes
+    int columns = 0;            ///< Column count, padded to an even number
+    QVector<char> valid;        ///< True for columns with a defined correlation
+};
+
+/**
+ * @brief Standardizes columns to zero mean and unit norm.
+ * @param columns Input columns.
+ * @param method Correlation coefficient.
+ * @param cancelled Optional flag; once set, columns not started yet are skipped.
+ * @return Standardized columns; missing samples become 0, i.e. the mean.
+ */
+Standardized standardize(const QVector<QVector<double>> &columns, Correlation::Method method,
+                         const std::atomic_bool *cancelled)
+{
+    Standardized result;
+    const int k = int(columns.size());
+    const qsizetype n = k > 0 ? columns.first().size() : 0;
+    result.stride = (n + Lanes - 1) / Lanes * Lanes;
+    result.columns = k + (k & 1);
+    result.data.fill(0.0f, result.columns * result.stride);
+    result.valid.fill(0, result.columns);
+
+    float *data = result.data.data();
+    char *valid = result.valid.data();
+    const qsizetype stride = result.stride;
+
+    QVector<int> indices(k);
+    std::iota(indices.begin(), indices.end(), 0);
+    TaskPool::instance().blockingMap(indices, [&](int c) {
+        QVector<double> column = columns[c];
+        if (method == Correlation::Spearman) {
+            Correlation::rankTransform(column);
+        }
+
+        double sum = 0.0;
+        qsizetype count = 0;
+        for (double v : column) {
+            if (!std::isnan(v)) {
+                sum += v;
+                ++count;
+            }
+        }
+        if (count < 2) {
+            return;
+        }
+        const double mean = sum / count;
+        double squares = 0.0;
+        for (double v : column) {
+            if (!std::isnan(v)) {
+                squares += (v - mean) * (v - mean);
+            }
+        }
+        if (squares <= 0.0) {
+            return;
+        }
+
+        const double scale = 1.0 / std::sqrt(squares);
+        float *out = data + c * stride;
+        for (qsizetype t = 0; t < n; ++t) {
+            const double v = column[t];
+            out[t] = std::isnan(v) ? 0.0f : float((v - mean) * scale);
+        }
+        valid[c] = 1;
+    }, TaskPool::High, cancelled);
+    return result;
+}
+
+/**
+ * @brief Computes four dot products of two column pairs over a time range.
+ * @param a0 First row column.
+ * @param a1 Second row column.
+ * @param b0 First column column.
+ * @param b1 Second column column.
+ * @param begin First sample, multiple of Lanes.
+ * @param end End sample, multiple of Lanes.
+ * @param out Output: a0·b0, a0·b1, a1·b0, a1·b1.
+ *
+ * Each lane accumulates independently, so the inner loop maps directly to
+ * SIMD registers without reassociating floating point sums.
+ */
+void dot2x2(const float *a0, const float *a1, const float *b0, const float *b1,
+            qsizetype begin, qsizetype end, double out[4])
+{
+    float s00[Lanes] = {};
+    float s01[Lanes] = {};
+    float s10[Lanes] = {};
+    float s11[Lanes] = {};
+    for (qsizetype t = begin; t < end; t += Lanes) {
+        for (int l = 0; l < Lanes; ++l) {
+            const float x0 = a0[t + l];
+            const float x1 = a1[t + l];
+            const float y0 = b0[t + l];
+            const float y1 = b1[t + l];
+            s00[l] += x0 * y0;
+            s01[l] += x0 * y1;
+            s10[l] += x1 * y0;
+            s11[l] += x1 * y1;
+        }
+    }
+    for (int l = 0; l < Lanes; ++l) {
+        out[0] += s00[l];
+        out[1] += s01[l];
+        out[2] += s10[l];
+        out[3] += s11[l];
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Replaces values by their ranks, averaging ties.
+ * @param column Column to transform in place; NaN values are left unchanged.
+ */
+void Correlation::rankTransform(QVector<double> &column)
+{
+    QVector<qsizetype> order;
+    order.reserve(column.size());
+    for (qsizetype i = 0; i < column.size(); ++i) {
+        if (!std::isnan(column[i])) {
+            order.append(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&column](qsizetype a, qsizetype b) {
+        return column[a] < column[b];
+    });
+
+    qsizetype i = 0;
+    while (i < order.size()) {
+        qsizetype j = i + 1;
+        while (j < order.size() && column[order[j]] == column[order[i]]) {
+            ++j;
+        }
+        // Remisy dostają średnią rangę
+        const double rank = (i + j + 1) / 2.0;
+        for (qsizetype m = i; m < j; ++m) {
+            column[order[m]] = rank;
+        }
+        i = j;
+    }
+}
+
+/**
+ * @brief Computes the correlation matrix of aligned columns.
+ * @param columns Aligned columns of equal length, NaN for missing samples.
+ * @param method Correlation coefficient.
+ * @param cancelled Optional flag; once set, the remaining work is skipped.
+ * @return Row-major k×k matrix, empty if cancelled.
+ */
+QVector<float> Correlation::compute(const QVector<QVector<double>> &columns, Method method,
+                                    const std::atomic_bool *cancelled)
+{
+    const int k = int(columns.size());
+    QVector<float> matrix(qsizetype(k) * k, std::numeric_limits<float>::quiet_NaN());
+    if (k == 0) {
+        return matrix;
+    }
+
+    const Standardized z = standardize(columns, method, cancelled);
+    if (cancelled && cancelled->load()) {
+        return QVector<float>();
+    }
+    float *result = matrix.data();
+
+    // Tylko kafelki nad przekątną, macierz jest symetryczna
+    QVector<QPair<int, int>> tiles;
+    for (int bi = 0; bi < z.columns; bi += TileSize) {
+        for (int bj = bi; bj < z.columns; bj += TileSize) {
+            tiles.append({bi, bj});
+        }
+    }
+
+    TaskPool::instance().blockingMap(tiles, [&](const QPair<int, int> &tile) {
+        const int iEnd = std::min(tile.first + TileSize, z.columns);
+        const int jEnd = std::min(tile.second + TileSize, z.columns);
+        QVector<double> acc(TileSize * TileSize, 0.0);
+
+        for (qsizetype t0 = 0; t0 < z.stride; t0 += ChunkSize) {
+            const qsizetype t1 = std::min(t0 + ChunkSize, z.stride);
+            for (int i = tile.first; i < iEnd; i += 2) {
+                const float *a0 = z.data.constData() + i * z.stride;
+                const float *a1 = a0 + z.stride;
+                for (int j = std::max(tile.second, i); j < jEnd; j += 2) {
+                    const float *b0 = z.data.constData() + j * z.stride;
+                    const float *b1 = b0 + z.stride;
+                    double *cell = acc.data() + (i - tile.first) * TileSize + (j - tile.second);
+                    double dots[4] = {0.0, 0.0, 0.0, 0.0};
+                    dot2x2(a0, a1, b0, b1, t0, t1, dots);
+                    cell[0] += dots[0];
+                    cell[1] += dots[1];
+                    cell[TileSize] += dots[2];
+                    cell[TileSize + 1] += dots[3];
+                }
+            }
+        }
+
+        for (int i = tile.first; i < std::min(iEnd, k); ++i) {
+            if (!z.valid[i]) {
+                continue;
+            }
+            for (int j = std::max(tile.second, i - (i & 1)); j < std::min(jEnd, k); ++j) {
+                if (!z.valid[j]) {
+                    continue;
+                }
+                const float r = i == j ? 1.0f
+                    : float(std::clamp(acc[(i - tile.first) * TileSize + (j - tile.second)], -1.0, 1.0));
+                result[qsizetype(i) * k + j] = r;
+                result[qsizetype(j) * k + i] = r;
+            }
+        }
+    }, TaskPool::High, cancelled);
+
+    // Część kafelków mogła zostać pominięta
+    if (cancelled && cancelled->load()) {
+        return QVector<float>();
+    }
+    return matrix;
+}
+
+/**
+ * @brief Replaces the matrix.
+ * @param labels Labels of the rows and columns.
+ * @param matrix Row-major matrix of labels.size() squared values.
+ */
+void CorrelationModel::setMatrix(const QStringList &labels, const QVector<float> &matrix)
+{
+    beginResetModel();
+    m_labels = labels;
+    m_matrix = matrix;
+    endResetModel();
+
+    const int n = size();
+    m_image = QImage(n, n, QImage::Format_RGB32);
+    for (int row = 0; row < n; ++row) {
+        QRgb *line = reinterpret_cast<QRgb *>(m_image.scanLine(row));
+        for (int column = 0; column < n; ++column) {
+            line[column] = colorFor(m_matrix[qsizetype(row) * n + column]).rgb();
+        }
+    }
+    emit matrixChanged();
+}
+
+/**
+ * @brief Gets a coefficient.
+ * @param row Row index.
+ * @param column Column index.
+ * @return Correlation coefficient, NaN outside the matrix.
+ */
+double CorrelationModel::value(int row, int column) const
+{
+    const int n = size();
+    if (row < 0 || column < 0 || row >= n || column >= n) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return m_matrix[qsizetype(row) * n + column];
+}
+
+/**
+ * @brief Maps a coefficient to the heatmap color.
+ * @param value Coefficient in [-1, 1].
+ * @return Blue for -1, white for 0, red for 1, grey for NaN.
+ */
+QColor CorrelationModel::colorFor(double value)
+{
+    if (std::isnan(value)) {
+        return QColor("#d3d3d3");
+    }
+    const int fade = int(255 * (1.0 - std::min(std::fabs(value), 1.0)));
+    return value >= 0 ? QColor(255, fade, fade) : QColor(fade, fade, 255);
+}
+
+int CorrelationModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : size();
+}
+
+int CorrelationModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : size();
+}
+
+QVariant CorrelationModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+    case ValueRole:
+        return value(index.row(), index.column());
+    case ColorRole:
+        return colorFor(value(index.row(), index.column()));
+    case RowLabelRole:
+        return label(index.row());
+    case ColumnLabelRole:
+        return label(index.column());
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> CorrelationModel::roleNames() const
+{
+    return {
+        {Qt::DisplayRole, "display"},
+        {ValueRole, "value"},
+        {ColorRole, "color"},
+        {RowLabelRole, "rowLabel"},
+        {ColumnLabelRole, "columnLabel"}
+    };
+}
@@ -0,0 +1,142 @@
+/**
+ * @file correlation.h
+ * @brief Header file for the cross-station correlation routines and model.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the Pearson/Spearman correlation matrix computation over
+ * aligned series and the table model exposing the matrix to the heatmap view.
+ */
+
+#ifndef CORRELATION_H
+#define CORRELATION_H
+
+#include <QAbstractTableModel>
+#include <QColor>
+#include <QImage>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+
+/**
+ * @namespace Correlation
+ * @brief Correlation matrix computation.
+ */
+namespace Correlation {
+
+/**
+ * @brief Correlation coefficient.
+ */
+enum Method {
+    Pearson,    ///< Linear correlation of the values
+    Spearman    ///< Linear correlation of the ranks
+};
+
+/**
+ * @brief Computes the correlation matrix of aligned columns.
+ * @param columns Aligned columns of equal length, NaN for missing samples.
+ * @param method Correlation coefficient.
+ * @param cancelled Optional flag; once set, the remaining work is skipped.
+ * @return Row-major k×k matrix; NaN for columns with fewer than two samples
+ *         or zero variance. Empty if cancelled.
+ *
+ * Columns are standardized to unit norm with missing samples set to the
+ * column mean, so the matrix is a single Gram product. The product is split
+ * into tiles computed in parallel; each tile runs a 2×2 register-blocked dot
+ * product kernel with independent lane accumulators the compiler vectorizes.
+ */
+QVector<float> compute(const QVector<QVector<double>> &columns, Method method,
+                       const std::atomic_bool *cancelled = nullptr);
+
+/**
+ * @brief Replaces values by their ranks, averaging ties.
+ * @param column Column to transform in place; NaN values are left unchanged.
+ */
+void rankTransform(QVector<double> &column);
+
+} // namespace Correlation
+
+/**
+ * @class CorrelationModel
+ * @brief Table model of a correlation matrix for the heatmap view.
+ */
+class CorrelationModel : public QAbstractTableModel {
+    Q_OBJECT
+    Q_PROPERTY(int size READ size NOTIFY matrixChanged)
+
+public:
+    /**
+     * @brief Custom data roles.
+     */
+    enum Roles {
+        ValueRole = Qt::UserRole + 1,   ///< Correlation coefficient
+        ColorRole,                      ///< Heatmap color
+        RowLabelRole,                   ///< Label of the row station
+        ColumnLabelRole                 ///< Label of the column station
+    };
+
+    /**
+     * @brief Constructs an empty model.
+     * @param parent Parent QObject.
+     */
+    explicit CorrelationModel(QObject *parent = nullptr) : QAbstractTableModel(parent) {}
+
+    /**
+     * @brief Replaces the matrix.
+     * @param labels Labels of the rows and columns.
+     * @param matrix Row-major matrix of labels.size() squared values.
+     */
+    void setMatrix(const QStringList &labels, const QVector<float> &matrix);
+
+    /**
+     * @brief Gets the matrix dimension.
+     * @return Number of rows and columns.
+     */
+    int size() const { return int(m_labels.size()); }
+
+    /**
+     * @brief Gets the label of a row or column.
+     * @param index Row or column index.
+     * @return Label.
+     */
+    Q_INVOKABLE QString label(int index) const { return m_labels.value(index); }
+
+    /**
+     * @brief Gets a coefficient.
+     * @param row Row index.
+     * @param column Column index.
+     * @return Correlation coefficient.
+     */
+    Q_INVOKABLE double value(int row, int column) const;
+
+    /**
+     * @brief Maps a coefficient to the heatmap color.
+     * @param value Coefficient in [-1, 1].
+     * @return Blue for -1, white for 0, red for 1, grey for NaN.
+     */
+    static QColor colorFor(double value);
+
+    /**
+     * @brief Gets the matrix rendered as an image, one pixel per coefficient.
+     * @return Heatmap image.
+     */
+    const QImage &image() const { return m_image; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+signals:
+    /**
+     * @brief Emitted when the matrix is replaced.
+     */
+    void matrixChanged();
+
+private:
+    QStringList m_labels;       ///< Row and column labels
+    QVector<float> m_matrix;    ///< Row-major coefficients
+    QImage m_image;             ///< Heatmap image of the matrix
+};
+
+#endif // CORRELATION_H
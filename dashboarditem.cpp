@@ -0,0 +1,229 @@
+/**
+ * @file dashboarditem.cpp
+ * @brief Implementation of the DashboardItem class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the tile layout, the partial repaint and the painting of
+ * the dashboard tiles.
+ */
+
+#include "dashboarditem.h"
+#include "airquality.h"
+#include "metrics.h"
+#include <QDateTime>
+#include <QFontMetricsF>
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Constructs the item.
+ * @param parent Parent item.
+ */
+DashboardItem::DashboardItem(QQuickItem *parent)
+    : QQuickPaintedItem(parent)
+{
+    setOpaquePainting(true);
+    setFillColor(QColor("#fafafa"));
+}
+
+/**
+ * @brief Sets the displayed watch list.
+ * @param watchList Watch list.
+ */
+void DashboardItem::setWatchList(WatchList *watchList)
+{
+    if (m_watchList == watchList) {
+        return;
+    }
+    if (m_watchList) {
+        disconnect(m_watchList, nullptr, this, nullptr);
+    }
+    m_watchList = watchList;
+    if (m_watchList) {
+        connect(m_watchList, &WatchList::tilesChanged, this, [this]() { update(); });
+        connect(m_watchList, &WatchList::tilesUpdated, this, [this](const QList<int> &indexes) {
+            // Tylko prostokąty przeliczonych kafelków, jedno przemalowanie na cykl
+            for (int index : indexes) {
+                update(tileRect(index).toAlignedRect());
+            }
+        });
+    }
+    emit watchListChanged();
+    update();
+}
+
+/**
+ * @brief Sets the number of columns.
+ * @param columns Columns, 0 to derive them from the width.
+ */
+void DashboardItem::setColumns(int columns)
+{
+    columns = std::max(0, columns);
+    if (columns == m_columns) {
+        return;
+    }
+    m_columns = columns;
+    emit layoutChanged();
+    update();
+}
+
+/**
+ * @brief Sets the spacing between tiles.
+ * @param spacing Spacing in pixels.
+ */
+void DashboardItem::setSpacing(qreal spacing)
+{
+    if (qFuzzyCompare(m_spacing, spacing)) {
+        return;
+    }
+    m_spacing = spacing;
+    emit layoutChanged();
+    update();
+}
+
+/**
+ * @brief Gets the effective number of columns.
+ * @return Columns, at least 1.
+ */
+int DashboardItem::effectiveColumns() const
+{
+    if (m_columns > 0) {
+        return m_columns;
+    }
+    return std::max(1, int((width() + m_spacing) / (MinTileWidth + m_spacing)));
+}
+
+/**
+ * @brief Gets the rectangle of a tile.
+ * @param index Tile index.
+ * @return Rectangle in item coordinates, empty if out of range.
+ */
+QRectF DashboardItem::tileRect(int index) const
+{
+    const int count = m_watchList ? m_watchList->count() : 0;
+    if (index < 0 || index >= count) {
+        return QRectF();
+    }
+    const int cols = effectiveColumns();
+    const int rows = (count + cols - 1) / cols;
+    const qreal w = (width() - (cols - 1) * m_spacing) / cols;
+    const qreal h = (height() - (rows - 1) * m_spacing) / rows;
+    return QRectF((index % cols) * (w + m_spacing), (index / cols) * (h + m_spacing), w, h);
+}
+
+/**
+ * @brief Maps an item position to a tile.
+ * @param x Horizontal position in item coordinates.
+ * @param y Vertical position in item coordinates.
+ * @return Tile index, -1 outside every tile.
+ */
+int DashboardItem::tileAt(qreal x, qreal y) const
+{
+    const int count = m_watchList ? m_watchList->count() : 0;
+    if (count == 0 || x < 0 || y < 0) {
+        return -1;
+    }
+    const int cols = effectiveColumns();
+    const int rows = (count + cols - 1) / cols;
+    const qreal w = (width() - (cols - 1) * m_spacing) / cols;
+    const qreal h = (height() - (rows - 1) * m_spacing) / rows;
+    const int index = int(y / (h + m_spacing)) * cols + int(x / (w + m_spacing));
+    return index < count && tileRect(index).contains(x, y) ? index : -1;
+}
+
+/**
+ * @brief Paints the tiles intersecting the dirty region.
+ * @param painter Painter of the item.
+ *
+ * The painter is clipped to the dirty rectangle of a partial update, so
+ * tiles outside it are skipped without painting.
+ */
+void DashboardItem::paint(QPainter *painter)
+{
+    if (!m_watchList) {
+        return;
+    }
+    static Histogram *paintTime = Metrics::instance().histogram("airapi_paint_duration_seconds", "Time spent painting an item.",
+                                                                Histogram::frameBuckets(), "item=\"dashboard\"");
+    HistogramTimer timer(paintTime);
+    painter->setRenderHint(QPainter::Antialiasing, true);
+    const QRectF dirty = painter->hasClipping() ? painter->clipBoundingRect() : QRectF(0, 0, width(), height());
+    const QVector<WatchTile> &tiles = m_watchList->tiles();
+    for (int i = 0; i < tiles.size(); ++i) {
+        const QRectF rect = tileRect(i);
+        if (rect.intersects(dirty)) {
+            paintTile(painter, tiles[i], rect);
+        }
+    }
+}
+
+/**
+ * @brief Paints one tile.
+ * @param painter Painter of the item.
+ * @param tile Tile data.
+ * @param rect Tile rectangle.
+ */
+void DashboardItem::paintTile(QPainter *painter, const WatchTile &tile, const QRectF &rect) const
+{
+    // Tło kafelka w kolorze poziomu indeksu
+    const QColor levelColor = QColor::fromRgb(AirQuality::color(tile.level));
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(levelColor.lighter(170));
+    painter->drawRoundedRect(rect, 5, 5);
+    painter->setBrush(levelColor);
+    painter->drawRoundedRect(QRectF(rect.left(), rect.top(), 6, rect.height()), 3, 3);
+
+    const qreal margin = 10.0;
+    const QRectF content = rect.adjusted(margin + 4, margin, -margin, -margin);
+
+    QFont font = painter->font();
+    font.setPixelSize(int(std::clamp(content.height() / 9.0, 10.0, 16.0)));
+    font.setBold(true);
+    painter->setFont(font);
+    painter->setPen(QColor("#333"));
+    const QFontMetricsF titleMetrics(font);
+    painter->drawText(QRectF(content.left(), content.top(), content.width(), titleMetrics.height()),
+                      Qt::AlignLeft | Qt::AlignVCenter,
+                      titleMetrics.elidedText(tile.title, Qt::ElideRight, content.width()));
+    qreal y = content.top() + titleMetrics.height();
+
+    const bool hasValue = !std::isnan(tile.value);
+    QFont valueFont = font;
+    valueFont.setPixelSize(int(std::clamp(content.height() / 4.0, 14.0, 40.0)));
+    painter->setFont(valueFont);
+    const QFontMetricsF valueMetrics(valueFont);
+    const QString arrow = tile.trend == WatchTile::Rising ? QStringLiteral("▲")
+                          : tile.trend == WatchTile::Falling ? QStringLiteral("▼")
+                                                             : QStringLiteral("►");
+    const QString valueText = hasValue ? QString::number(tile.value, 'f', 1) + " " + arrow : QStringLiteral("—");
+    painter->drawText(QRectF(content.left(), y, content.width(), valueMetrics.height()),
+                      Qt::AlignLeft | Qt::AlignVCenter, valueText);
+    y += valueMetrics.height();
+
+    font.setBold(false);
+    painter->setFont(font);
+    painter->setPen(QColor("#555"));
+    const QString info = hasValue
+                             ? AirQuality::levelName(tile.level) + ", "
+                                   + QDateTime::fromMSecsSinceEpoch(tile.timestamp).toString("HH:mm")
+                             : (tile.sensorId < 0 ? QStringLiteral("Brak czujnika") : QStringLiteral("Brak danych"));
+    painter->drawText(QRectF(content.left(), y, content.width(), titleMetrics.height()),
+                      Qt::AlignLeft | Qt::AlignVCenter,
+                      titleMetrics.elidedText(info, Qt::ElideRight, content.width()));
+    y += titleMetrics.height() + 4;
+
+    // Wykres ostatnich godzin w pozostałej części kafelka
+    const QRectF chart(content.left(), y, content.width(), content.bottom() - y);
+    if (tile.sparkline.size() >= 2 && chart.height() > 8) {
+        QPolygonF line;
+        line.reserve(tile.sparkline.size());
+        for (const QPointF &p : tile.sparkline) {
+            line.append(QPointF(chart.left() + p.x() * chart.width(), chart.bottom() - p.y() * chart.height()));
+        }
+        painter->setPen(QPen(QColor("#2196F3"), 1.5));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawPolyline(line);
+    }
+}
@@ -0,0 +1,129 @@
+/**
+ * @file dashboarditem.h
+ * @brief Header file for the DashboardItem class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the QML item drawing the watch list as a wall of tiles.
+ */
+
+#ifndef DASHBOARDITEM_H
+#define DASHBOARDITEM_H
+
+#include <QQuickPaintedItem>
+#include <QPointer>
+#include <QRectF>
+#include "watchlist.h"
+
+/**
+ * @class DashboardItem
+ * @brief Draws every tile of a WatchList in one painted item.
+ *
+ * A refresh cycle of the watch list marks only the rectangles of the
+ * recomputed tiles dirty, so the whole wall is updated by one partial
+ * repaint and one texture upload instead of one delegate per tile.
+ */
+class DashboardItem : public QQuickPaintedItem {
+    Q_OBJECT
+    Q_PROPERTY(WatchList *watchList READ watchList WRITE setWatchList NOTIFY watchListChanged)
+    Q_PROPERTY(int columns READ columns WRITE setColumns NOTIFY layoutChanged)
+    Q_PROPERTY(qreal spacing READ spacing WRITE setSpacing NOTIFY layoutChanged)
+
+public:
+    static constexpr qreal MinTileWidth = 220.0;    ///< Narrowest tile with automatic columns
+
+    /**
+     * @brief Constructs the item.
+     * @param parent Parent item.
+     */
+    explicit DashboardItem(QQuickItem *parent = nullptr);
+
+    /**
+     * @brief Gets the displayed watch list.
+     * @return Watch list.
+     */
+    WatchList *watchList() const { return m_watchList; }
+
+    /**
+     * @brief Sets the displayed watch list.
+     * @param watchList Watch list.
+     */
+    void setWatchList(WatchList *watchList);
+
+    /**
+     * @brief Gets the number of columns.
+     * @return Columns, 0 if derived from the width.
+     */
+    int columns() const { return m_columns; }
+
+    /**
+     * @brief Sets the number of columns.
+     * @param columns Columns, 0 to derive them from the width.
+     */
+    void setColumns(int columns);
+
+    /**
+     * @brief Gets the spacing between tiles.
+     * @return Spacing in pixels.
+     */
+    qreal spacing() const { return m_spacing; }
+
+    /**
+     * @brief Sets the spacing between tiles.
+     * @param spacing Spacing in pixels.
+     */
+    void setSpacing(qreal spacing);
+
+    /**
+     * @brief Gets the rectangle of a tile.
+     * @param index Tile index.
+     * @return Rectangle in item coordinates, empty if out of range.
+     */
+    QRectF tileRect(int index) const;
+
+    /**
+     * @brief Maps an item position to a tile.
+     * @param x Horizontal position in item coordinates.
+     * @param y Vertical position in item coordinates.
+     * @return Tile index, -1 outside every tile.
+     */
+    Q_INVOKABLE int tileAt(qreal x, qreal y) const;
+
+    /**
+     * @brief Paints the tiles intersecting the dirty region.
+     * @param painter Painter of the item.
+     */
+    void paint(QPainter *painter) override;
+
+signals:
+    /**
+     * @brief Emitted when the watch list changes.
+     */
+    void watchListChanged();
+
+    /**
+     * @brief Emitted when the columns or the spacing change.
+     */
+    void layoutChanged();
+
+private:
+    /**
+     * @brief Gets the effective number of columns.
+     * @return Columns, at least 1.
+     */
+    int effectiveColumns() const;
+
+    /**
+     * @brief Paints one tile.
+     * @param painter Painter of the item.
+     * @param tile Tile data.
+     * @param rect Tile rectangle.
+     */
+    void paintTile(QPainter *painter, const WatchTile &tile, const QRectF &rect) const;
+
+    QPointer<WatchList> m_watchList;    ///< Displayed watch list
+    int m_columns = 0;                  ///< Columns, 0 if derived from the width
+    qreal m_spacing = 8.0;              ///< Spacing between tiles
+};
+
+#endif // DASHBOARDITEM_H
@@ -0,0 +1,620 @@
+/**
+ * @file databankimporter.cpp
+ * @brief Implementation of the DataBankImporter class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the header and metadata parsing of data bank files and
+ * the chunked parallel parsing of their hourly rows.
+ */
+
+#include "databankimporter.h"
+#include "taskpool.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSet>
+#include <QThread>
+#include <QTimeZone>
+#include <QtConcurrent>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+/**
+ * @struct Chunk
+ * @brief Range of complete data rows of a mapped file.
+ */
+struct Chunk {
+    const char *begin = nullptr;    ///< First byte of the first row
+    const char *end = nullptr;      ///< Byte after the last row
+};
+
+/**
+ * @struct ChunkResult
+ * @brief Series parsed from one chunk.
+ */
+struct ChunkResult {
+    QVector<Series> bySlot; ///< Samples by slot, in row order
+    qint64 rows = 0;        ///< Data rows of the chunk
+};
+
+/**
+ * @struct FileLayout
+ * @brief Column mapping of one data file.
+ */
+struct FileLayout {
+    char separator = ';';       ///< Field separator
+    QVector<int> slotOfColumn;  ///< Slot of each station column, -1 to skip
+    QVector<double> scales;     ///< Unit conversion of each station column
+    QList<int> sensors;         ///< Sensor ID of each slot
+};
+
+/**
+ * @brief Finds the end of a line.
+ * @param p Start of the line.
+ * @param end End of the data.
+ * @return Position of the newline, or end.
+ */
+const char *lineEnd(const char *p, const char *end)
+{
+    const char *newline = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)));
+    return newline ? newline : end;
+}
+
+/**
+ * @brief Strips a trailing carriage return, surrounding spaces and quotes.
+ * @param begin Start of the text, advanced.
+ * @param end End of the text, moved back.
+ */
+void trim(const char *&begin, const char *&end)
+{
+    while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '"')) {
+        ++begin;
+    }
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '"' || end[-1] == '\r')) {
+        --end;
+    }
+}
+
+/**
+ * @brief Splits a header line into fields.
+ * @param begin Start of the line.
+ * @param end End of the line.
+ * @param separator Field separator.
+ * @return Trimmed fields; separators inside quotes do not split.
+ */
+QList<QByteArray> splitFields(const char *begin, const char *end, char separator)
+{
+    QList<QByteArray> fields;
+    const char *start = begin;
+    bool quoted = false;
+    for (const char *p = begin; p <= end; ++p) {
+        if (p < end && *p == '"') {
+            quoted = !quoted;
+        } else if (p == end || (*p == separator && !quoted)) {
+            const char *b = start;
+            const char *e = p;
+            trim(b, e);
+            fields.append(QByteArray(b, e - b));
+            start = p + 1;
+        }
+    }
+    return fields;
+}
+
+/**
+ * @brief Guesses the field separator from the first line.
+ * @param begin Start of the line.
+ * @param end End of the line.
+ * @return ';' if present, otherwise ','.
+ *
+ * Excel saves Polish spreadsheets with ';' and decimal commas.
+ */
+char detectSeparator(const char *begin, const char *end)
+{
+    return std::memchr(begin, ';', size_t(end - begin)) ? ';' : ',';
+}
+
+/**
+ * @brief Parses a number with a decimal point or comma.
+ * @param begin Start of the field.
+ * @param end End of the field.
+ * @param value Parsed value.
+ * @return False if the field is empty or not a number.
+ */
+bool parseValue(const char *begin, const char *end, double &value)
+{
+    trim(begin, end);
+    char buffer[32];
+    const qsizetype length = end - begin;
+    if (length <= 0 || length >= qsizetype(sizeof(buffer))) {
+        return false;
+    }
+    for (qsizetype i = 0; i < length; ++i) {
+        buffer[i] = begin[i] == ',' ? '.' : begin[i];
+    }
+    const std::from_chars_result result = std::from_chars(buffer, buffer + length, value);
+    return result.ec == std::errc() && result.ptr == buffer + length;
+}
+
+/**
+ * @brief Parses the timestamp of a data row.
+ * @param begin Start of the field.
+ * @param end End of the field.
+ * @param timestamp Milliseconds since epoch.
+ * @return False if the field is not a date with an hour.
+ *
+ * Accepts "yyyy-MM-dd HH:mm[:ss]" and "dd.MM.yyyy HH:mm[:ss]", the forms
+ * written by the data bank and by Excel. Hour 24:00 is midnight of the
+ * next day. The data bank keeps CET all year, so rows are read with a fixed
+ * UTC+1 offset regardless of the time zone of the machine.
+ */
+bool parseTimestamp(const char *begin, const char *end, qint64 &timestamp)
+{
+    int parts[6] = {0, 0, 0, 0, 0, 0};
+    int digits[6] = {0, 0, 0, 0, 0, 0};
+    int count = 0;
+    for (const char *p = begin; p < end && count < 6; ++p) {
+        if (*p >= '0' && *p <= '9') {
+            parts[count] = parts[count] * 10 + (*p - '0');
+            ++digits[count];
+        } else if (digits[count] > 0) {
+            ++count;
+        }
+    }
+    if (count < 6 && digits[count] > 0) {
+        ++count;
+    }
+    if (count < 5) {
+        return false;
+    }
+
+    QDate date;
+    if (digits[0] == 4) {
+        date = QDate(parts[0], parts[1], parts[2]);
+    } else if (digits[2] == 4) {
+        date = QDate(parts[2], parts[1], parts[0]);
+    }
+    if (!date.isValid() || parts[3] > 24 || parts[4] > 59 || parts[5] > 59) {
+        return false;
+    }
+    if (parts[3] == 24) {
+        date = date.addDays(1);
+        parts[3] = 0;
+    }
+    static const QTimeZone cet = QTimeZone::fromSecondsAheadOfUtc(3600);
+    timestamp = QDateTime(date, QTime(parts[3], parts[4], parts[5]), cet).toMSecsSinceEpoch();
+    return true;
+}
+
+/**
+ * @brief Parses the data rows of a chunk.
+ * @param chunk Rows to parse.
+ * @param layout Column mapping of the file.
+ * @return Samples by slot.
+ *
+ * Rows that do not start with a timestamp, such as summary rows, are
+ * skipped. Empty cells are missing measurements and produce no sample.
+ */
+ChunkResult parseChunk(const Chunk &chunk, const FileLayout &layout)
+{
+    ChunkResult result;
+    result.bySlot.resize(layout.sensors.size());
+    const qsizetype columns = layout.slotOfColumn.size();
+    const char *p = chunk.begin;
+    while (p < chunk.end) {
+        const char *end = lineEnd(p, chunk.end);
+        const char *field = p;
+        const char *fieldEnd = static_cast<const char *>(std::memchr(field, layout.separator, size_t(end - field)));
+        qint64 timestamp = 0;
+        if (fieldEnd && parseTimestamp(field, fieldEnd, timestamp)) {
+            ++result.rows;
+            for (qsizetype column = 0; column < columns && fieldEnd < end; ++column) {
+                field = fieldEnd + 1;
+                fieldEnd = static_cast<const char *>(std::memchr(field, layout.separator, size_t(end - field)));
+                if (!fieldEnd) {
+                    fieldEnd = end;
+                }
+                const int slot = layout.slotOfColumn[column];
+                double value = 0.0;
+                if (slot >= 0 && parseValue(field, fieldEnd, value)) {
+                    result.bySlot[slot].timestamps.append(timestamp);
+                    result.bySlot[slot].values.append(value * layout.scales[column]);
+                }
+            }
+        }
+        p = end + 1;
+    }
+    return result;
+}
+
+/**
+ * @brief Sorts a series and keeps the last value of repeated timestamps.
+ * @param series Series to normalize.
+ *
+ * Rows of a file are already in order; repeats come from a station listed
+ * under both its old and its current code.
+ */
+void normalize(Series &series)
+{
+    if (!std::is_sorted(series.timestamps.cbegin(), series.timestamps.cend())) {
+        QVector<qsizetype> order(series.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&series](qsizetype a, qsizetype b) {
+            return series.timestamps[a] < series.timestamps[b];
+        });
+        Series sorted;
+        sorted.timestamps.reserve(series.size());
+        sorted.values.reserve(series.size());
+        for (qsizetype i : order) {
+            sorted.timestamps.append(series.timestamps[i]);
+            sorted.values.append(series.values[i]);
+        }
+        series = std::move(sorted);
+    }
+    qsizetype kept = 0;
+    for (qsizetype i = 0; i < series.size(); ++i) {
+        if (kept > 0 && series.timestamps[kept - 1] == series.timestamps[i]) {
+            series.values[kept - 1] = series.values[i];
+            continue;
+        }
+        series.timestamps[kept] = series.timestamps[i];
+        series.values[kept] = series.values[i];
+        ++kept;
+    }
+    series.timestamps.resize(kept);
+    series.values.resize(kept);
+}
+
+} // namespace
+
+/**
+ * @brief Constructs the importer of an archive.
+ * @param archive Archive receiving the data; must outlive this object.
+ * @param parent Parent QObject.
+ */
+DataBankImporter::DataBankImporter(LocalArchive *archive, QObject *parent)
+    : QObject(parent),
+    m_archive(archive)
+{
+    // Jeden wątek koordynujący; fragmenty plików parsuje globalna pula
+    m_pool.setMaxThreadCount(1);
+    connect(&m_watcher, &QFutureWatcher<BankImportReport>::finished, this, [this]() {
+        emit finished(m_watcher.result());
+    });
+}
+
+/**
+ * @brief Destroys the object, cancelling a running import.
+ */
+DataBankImporter::~DataBankImporter()
+{
+    cancel();
+}
+
+/**
+ * @brief Starts an import on a worker thread.
+ * @param paths Data files.
+ * @param stationByCode Station IDs by station code.
+ * @param catalog Sensor catalog used to find the sensor of a column.
+ */
+void DataBankImporter::start(const QStringList &paths, const QHash<QString, int> &stationByCode, const SensorCatalog &catalog)
+{
+    if (isRunning()) {
+        return;
+    }
+    m_cancelled = false;
+    m_watcher.setFuture(QtConcurrent::run(&m_pool, [this, paths, stationByCode, catalog]() {
+        return run(paths, stationByCode, catalog);
+    }));
+}
+
+/**
+ * @brief Cancels a running import and waits for it to stop.
+ */
+void DataBankImporter::cancel()
+{
+    m_cancelled = true;
+    m_watcher.waitForFinished();
+}
+
+/**
+ * @brief Runs an import on the calling thread.
+ * @param paths Data files.
+ * @param stationByCode Station IDs by station code.
+ * @param catalog Sensor catalog used to find the sensor of a column.
+ * @return Report of the import.
+ */
+BankImportReport DataBankImporter::run(const QStringList &paths, const QHash<QString, int> &stationByCode, const SensorCatalog &catalog)
+{
+    BankImportReport report;
+    for (qsizetype i = 0; i < paths.size(); ++i) {
+        if (m_cancelled) {
+            report.interrupted = true;
+            break;
+        }
+        if (!importFile(paths[i], stationByCode, catalog, &report)) {
+            report.interrupted = true;
+            break;
+        }
+        emit progress(int(i + 1), int(paths.size()));
+    }
+    report.unmappedStations.removeDuplicates();
+    report.unmappedStations.sort();
+    return report;
+}
+
+/**
+ * @brief Imports one file.
+ * @param path Data file.
+ * @param stationByCode Station IDs by station code.
+ * @param catalog Sensor catalog.
+ * @param report Report updated with the result.
+ * @return False if the archive could not be written.
+ *
+ * The parameter and averaging time are taken from the "Wskaźnik" and
+ * "Czas uśredniania" header rows or, in older files without them, from a
+ * file name such as "2015_PM10_1g.csv". CO is published in mg/m3 and is
+ * converted to µg/m3 used by the API.
+ */
+bool DataBankImporter::importFile(const QString &path, const QHash<QString, int> &stationByCode,
+                                  const SensorCatalog &catalog, BankImportReport *report)
+{
+    static const QRegularExpression namePattern("^\\d{4}_(.+)_(\\d+g)$");
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0) {
+        ++report->filesFailed;
+        return true;
+    }
+    // Mapowanie pliku zamiast kopiowania; readAll tylko gdy system go odmówi
+    QByteArray copy;
+    const char *data = reinterpret_cast<const char *>(file.map(0, file.size()));
+    if (!data) {
+        copy = file.readAll();
+        data = copy.constData();
+    }
+    const char *const end = data + file.size();
+
+    // Nagłówek: wiersze do pierwszego wiersza zaczynającego się od daty
+    FileLayout layout;
+    layout.separator = detectSeparator(data, lineEnd(data, end));
+    QList<QByteArray> codes;
+    QList<QByteArray> params;
+    QList<QByteArray> averaging;
+    QList<QByteArray> units;
+    const char *p = data;
+    while (p < end) {
+        const char *e = lineEnd(p, end);
+        const char *first = static_cast<const char *>(std::memchr(p, layout.separator, size_t(e - p)));
+        qint64 timestamp = 0;
+        if (first && parseTimestamp(p, first, timestamp)) {
+            break;
+        }
+        QList<QByteArray> fields = splitFields(p, e, layout.separator);
+        const QByteArray key = fields.isEmpty() ? QByteArray() : fields.takeFirst().toLower();
+        if (key.startsWith("kod stacji")) {
+            codes = fields;
+        } else if (key.startsWith("wska")) {
+            params = fields;
+        } else if (key.startsWith("czas u")) {
+            averaging = fields;
+        } else if (key.startsWith("jednostka")) {
+            units = fields;
+        }
+        p = e + 1;
+    }
+    const char *const dataBegin = std::min(p, end);
+    if (codes.isEmpty()) {
+        ++report->filesFailed;
+        return true;
+    }
+
+    const QRegularExpressionMatch nameMatch = namePattern.match(QFileInfo(path).completeBaseName());
+    QHash<int, int> slotOfSensor;
+    layout.slotOfColumn.fill(-1, codes.size());
+    layout.scales.fill(1.0, codes.size());
+    bool hourly = false;
+    for (qsizetype column = 0; column < codes.size(); ++column) {
+        const QString period = column < averaging.size() ? QString::fromLatin1(averaging[column])
+                                                          : nameMatch.captured(2);
+        if (period.compare("1g", Qt::CaseInsensitive) != 0 || codes[column].isEmpty()) {
+            continue;
+        }
+        hourly = true;
+        const QString code = QString::fromLatin1(codes[column]);
+        const QString param = column < params.size() ? QString::fromLatin1(params[column]) : nameMatch.captured(1);
+        const int stationId = stationByCode.value(code, -1);
+        int sensorId = -1;
+        if (stationId < 0) {
+            report->unmappedStations.append(code);
+        } else {
+            for (int candidate : catalog.sensorsForParam(param)) {
+                if (catalog.sensor(candidate).stationId == stationId) {
+                    sensorId = candidate;
+                    break;
+                }
+            }
+        }
+        if (sensorId < 0) {
+            ++report->columnsUnmapped;
+            continue;
+        }
+        auto slot = slotOfSensor.find(sensorId);
+        if (slot == slotOfSensor.end()) {
+            slot = slotOfSensor.insert(sensorId, int(layout.sensors.size()));
+            layout.sensors.append(sensorId);
+        }
+        layout.slotOfColumn[column] = slot.value();
+        if (column < units.size() && units[column].toLower().startsWith("mg/")) {
+            layout.scales[column] = 1000.0;
+        }
+        ++report->columnsImported;
+    }
+    if (!hourly) {
+        ++report->filesSkipped;
+        return true;
+    }
+
+    // Podział na fragmenty na granicach wierszy, kilka na rdzeń dla wyrównania obciążenia
+    const qint64 size = end - dataBegin;
+    const qint64 chunkCount = std::clamp<qint64>(size / MinChunkSize, 1, qMax(1, QThread::idealThreadCount()) * 4);
+    QList<Chunk> chunks;
+    const char *chunkBegin = dataBegin;
+    for (qint64 i = 1; i <= chunkCount && chunkBegin < end; ++i) {
+        const char *chunkEnd = i == chunkCount ? end : dataBegin + size * i / chunkCount;
+        if (chunkEnd < chunkBegin) {
+            continue;
+        }
+        chunkEnd = chunkEnd == end ? end : std::min(lineEnd(chunkEnd, end) + 1, end);
+        chunks.append({chunkBegin, chunkEnd});
+        chunkBegin = chunkEnd;
+    }
+
+    const QList<ChunkResult> parsed = TaskPool::instance().blockingMapped(chunks, [&layout](const Chunk &chunk) {
+        return parseChunk(chunk, layout);
+    }, TaskPool::Low);
+
+    ++report->filesImported;
+    for (const ChunkResult &result : parsed) {
+        report->rowsParsed += result.rows;
+    }
+    for (qsizetype slot = 0; slot < layout.sensors.size(); ++slot) {
+        Series series;
+        qsizetype total = 0;
+        for (const ChunkResult &result : parsed) {
+            total += result.bySlot[slot].size();
+        }
+        series.timestamps.reserve(total);
+        series.values.reserve(total);
+        for (const ChunkResult &result : parsed) {
+            series.timestamps.append(result.bySlot[slot].timestamps);
+            series.values.append(result.bySlot[slot].values);
+        }
+        normalize(series);
+        if (series.isEmpty()) {
+            continue;
+        }
+        // Lata starsze niż retencja surowych danych trafiają tylko do agregatów
+        qint64 rolledUp = 0;
+        qint64 expired = 0;
+        const int changed = m_archive->appendHistory(layout.sensors[slot], series, &rolledUp, &expired);
+        if (changed < 0) {
+            return false;
+        }
+        report->samplesImported += changed;
+        report->samplesRolledUp += rolledUp;
+        report->samplesExpired += expired;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the station metadata file of the data bank.
+ * @param path CSV file with "Kod stacji", "Stary Kod stacji" and WGS84
+ *        coordinate columns.
+ * @param ok Set to false if the file has no such columns.
+ * @return Stations of the file.
+ *
+ * Columns are found by their headers, so the column order of the various
+ * editions of the file does not matter. Old codes are listed with commas
+ * or spaces in one cell.
+ */
+QList<BankStation> DataBankImporter::readMetadata(const QString &path, bool *ok)
+{
+    QList<BankStation> stations;
+    *ok = false;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return stations;
+    }
+    const QByteArray content = file.readAll();
+    const char *p = content.constData();
+    const char *const end = p + content.size();
+    const char separator = detectSeparator(p, lineEnd(p, end));
+
+    qsizetype codeColumn = -1;
+    qsizetype oldCodeColumn = -1;
+    qsizetype latColumn = -1;
+    qsizetype lonColumn = -1;
+    while (p < end) {
+        const char *e = lineEnd(p, end);
+        const QList<QByteArray> fields = splitFields(p, e, separator);
+        p = e + 1;
+
+        if (codeColumn < 0) {
+            for (qsizetype i = 0; i < fields.size(); ++i) {
+                const QByteArray name = fields[i].toLower();
+                if (name == "kod stacji") {
+                    codeColumn = i;
+                } else if (name.startsWith("stary kod")) {
+                    oldCodeColumn = i;
+                } else if (name.startsWith("wgs84")) {
+                    // Najpierw szerokość (φ N), potem długość (λ E)
+                    (latColumn < 0 ? latColumn : lonColumn) = i;
+                }
+            }
+            if (codeColumn < 0 || lonColumn < 0) {
+                codeColumn = -1;
+                oldCodeColumn = latColumn = lonColumn = -1;
+            }
+            continue;
+        }
+
+        if (fields.size() <= std::max(codeColumn, lonColumn) || fields[codeColumn].isEmpty()) {
+            continue;
+        }
+        BankStation station;
+        bool latOk = false;
+        bool lonOk = false;
+        station.lat = QByteArray(fields[latColumn]).replace(',', '.').toDouble(&latOk);
+        station.lon = QByteArray(fields[lonColumn]).replace(',', '.').toDouble(&lonOk);
+        if (!latOk || !lonOk) {
+            continue;
+        }
+        station.codes.append(QString::fromLatin1(fields[codeColumn]));
+        if (oldCodeColumn >= 0 && oldCodeColumn < fields.size()) {
+            static const QRegularExpression codeSeparators("[,\\s]+");
+            station.codes.append(QString::fromLatin1(fields[oldCodeColumn]).split(codeSeparators, Qt::SkipEmptyParts));
+        }
+        stations.append(station);
+    }
+    *ok = codeColumn >= 0;
+    return stations;
+}
+
+/**
+ * @brief Lists the files of a data bank directory.
+ * @param directory Directory with the files saved as CSV.
+ * @param metadataPath Receives the metadata file, empty if none.
+ * @return Data files, sorted by name.
+ *
+ * The metadata file is recognized by its coordinate columns, not by its
+ * name, which changes between editions.
+ */
+QStringList DataBankImporter::scanDirectory(const QString &directory, QString *metadataPath)
+{
+    QStringList files;
+    metadataPath->clear();
+    const QFileInfoList entries = QDir(directory).entryInfoList(QStringList() << "*.csv", QDir::Files, QDir::Name);
+    for (const QFileInfo &entry : entries) {
+        QFile file(entry.absoluteFilePath());
+        if (!file.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        const QByteArray head = file.read(4096).toLower();
+        if (metadataPath->isEmpty() && head.contains("kod stacji") && head.contains("wgs84")) {
+            *metadataPath = entry.absoluteFilePath();
+        } else {
+            files.append(entry.absoluteFilePath());
+        }
+    }
+    return files;
+}
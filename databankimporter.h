@@ -0,0 +1,166 @@
+/**
+ * @file databankimporter.h
+ * @brief Header file for the DataBankImporter class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the bulk import of the yearly measurement files of the
+ * GIOŚ data bank into the local archive.
+ */
+
+#ifndef DATABANKIMPORTER_H
+#define DATABANKIMPORTER_H
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <atomic>
+#include "localarchive.h"
+#include "sensorcatalog.h"
+
+/**
+ * @struct BankStation
+ * @brief Station of the data bank metadata file.
+ */
+struct BankStation {
+    QStringList codes;  ///< Current code followed by the old codes
+    double lat = 0.0;   ///< Latitude in degrees
+    double lon = 0.0;   ///< Longitude in degrees
+};
+
+/**
+ * @struct BankImportReport
+ * @brief Result of one data bank import.
+ */
+struct BankImportReport {
+    int filesImported = 0;          ///< Files with at least one imported column
+    int filesSkipped = 0;           ///< Files without hourly columns
+    int filesFailed = 0;            ///< Files that could not be read
+    qint64 rowsParsed = 0;          ///< Data rows of all files
+    int columnsImported = 0;        ///< Columns mapped to a sensor
+    int columnsUnmapped = 0;        ///< Hourly columns without a sensor
+    qint64 samplesImported = 0;     ///< New or changed archived samples
+    qint64 samplesRolledUp = 0;     ///< Samples past the raw retention, kept in rollups only
+    qint64 samplesExpired = 0;      ///< Samples past every retention limit, dropped
+    QStringList unmappedStations;   ///< Sorted codes of unknown stations
+    bool interrupted = false;       ///< True if cancelled or failed to write
+};
+
+/**
+ * @class DataBankImporter
+ * @brief Imports GIOŚ data bank CSV files into the archive on a worker thread.
+ *
+ * The data bank publishes one file per year, parameter and averaging time,
+ * with a header of rows such as "Kod stacji", "Wskaźnik", "Czas uśredniania"
+ * and "Jednostka" followed by one row per hour and one column per station.
+ * Only hourly ("1g") columns are imported. A file is memory-mapped, its data
+ * rows are split into chunks at line boundaries and the chunks are parsed on
+ * the global thread pool. Re-importing a file is harmless because appending
+ * already archived samples changes nothing, so no journal is kept. Years
+ * older than the raw retention of the archive are kept as daily and monthly
+ * rollups, see LocalArchive::appendHistory().
+ */
+class DataBankImporter : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr qint64 MinChunkSize = 256 * 1024;  ///< Smallest chunk worth a task
+
+    /**
+     * @brief Constructs the importer of an archive.
+     * @param archive Archive receiving the data; must outlive this object.
+     * @param parent Parent QObject.
+     */
+    explicit DataBankImporter(LocalArchive *archive, QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the object, cancelling a running import.
+     */
+    ~DataBankImporter() override;
+
+    /**
+     * @brief Starts an import on a worker thread.
+     * @param paths Data files.
+     * @param stationByCode Station IDs by station code.
+     * @param catalog Sensor catalog used to find the sensor of a column.
+     *
+     * Does nothing if an import is already running.
+     */
+    void start(const QStringList &paths, const QHash<QString, int> &stationByCode, const SensorCatalog &catalog);
+
+    /**
+     * @brief Runs an import on the calling thread.
+     * @param paths Data files.
+     * @param stationByCode Station IDs by station code.
+     * @param catalog Sensor catalog used to find the sensor of a column.
+     * @return Report of the import.
+     */
+    BankImportReport run(const QStringList &paths, const QHash<QString, int> &stationByCode, const SensorCatalog &catalog);
+
+    /**
+     * @brief Cancels a running import and waits for it to stop.
+     *
+     * The current file is finished first.
+     */
+    void cancel();
+
+    /**
+     * @brief Checks whether an import is running.
+     * @return True while running.
+     */
+    bool isRunning() const { return m_watcher.isRunning(); }
+
+    /**
+     * @brief Reads the station metadata file of the data bank.
+     * @param path CSV file with "Kod stacji", "Stary Kod stacji" and WGS84
+     *        coordinate columns.
+     * @param ok Set to false if the file has no such columns.
+     * @return Stations of the file.
+     */
+    static QList<BankStation> readMetadata(const QString &path, bool *ok);
+
+    /**
+     * @brief Lists the files of a data bank directory.
+     * @param directory Directory with the files saved as CSV.
+     * @param metadataPath Receives the metadata file, empty if none.
+     * @return Data files, sorted by name.
+     */
+    static QStringList scanDirectory(const QString &directory, QString *metadataPath);
+
+signals:
+    /**
+     * @brief Emitted after every imported file, from the worker thread.
+     * @param done Files processed so far.
+     * @param total Files to process.
+     */
+    void progress(int done, int total);
+
+    /**
+     * @brief Emitted when an import started by start() finishes.
+     * @param report Report of the import.
+     */
+    void finished(const BankImportReport &report);
+
+private:
+    /**
+     * @brief Imports one file.
+     * @param path Data file.
+     * @param stationByCode Station IDs by station code.
+     * @param catalog Sensor catalog.
+     * @param report Report updated with the result.
+     * @return False if the archive could not be written.
+     */
+    bool importFile(const QString &path, const QHash<QString, int> &stationByCode,
+                    const SensorCatalog &catalog, BankImportReport *report);
+
+    LocalArchive *m_archive;                        ///< Archive receiving the data
+    QThreadPool m_pool;                             ///< Thread of the running import
+    QFutureWatcher<BankImportReport> m_watcher;     ///< Running import
+    std::atomic_bool m_cancelled{false};            ///< Set by cancel()
+};
+
+#endif // DATABANKIMPORTER_H
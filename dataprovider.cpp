@@ -0,0 +1,109 @@
+/**
+ * @file dataprovider.cpp
+ * @brief Implementation of the ProviderRegistry class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the request routing and the qualified IDs of the
+ * provider registry.
+ */
+
+#include "dataprovider.h"
+
+/**
+ * @brief Registers a provider and takes ownership of it.
+ * @param provider Provider.
+ * @return Index of the provider, -1 if the registry is full.
+ */
+int ProviderRegistry::add(DataProvider *provider)
+{
+    if (m_providers.size() >= DataProvider::MaxProviders) {
+        return -1;
+    }
+    const int index = int(m_providers.size());
+    provider->setParent(this);
+    provider->setIndex(index);
+    m_providers.append(provider);
+    return index;
+}
+
+/**
+ * @brief Gets the provider owning a global ID.
+ * @param globalId Global station or sensor ID.
+ * @return Provider, nullptr if none.
+ */
+DataProvider *ProviderRegistry::providerFor(int globalId) const
+{
+    const int index = DataProvider::providerIndex(globalId);
+    return globalId >= 0 && index < m_providers.size() ? m_providers[index] : nullptr;
+}
+
+/**
+ * @brief Fetches the sensors of a station from its provider.
+ * @param stationId Global station ID.
+ * @param done Called with the sensors.
+ * @param abortHook Passed to the provider.
+ */
+void ProviderRegistry::fetchSensors(int stationId, const DataProvider::SensorsCallback &done,
+                                    const DataProvider::AbortHook &abortHook)
+{
+    if (DataProvider *provider = providerFor(stationId)) {
+        provider->fetchSensors(stationId, done, abortHook);
+    } else {
+        done({}, "Nieznany dostawca stacji " + QString::number(stationId));
+    }
+}
+
+/**
+ * @brief Fetches the series of a sensor from its provider.
+ * @param sensorId Global sensor ID.
+ * @param done Called with the samples.
+ * @param abortHook Passed to the provider.
+ */
+void ProviderRegistry::fetchSeries(int sensorId, const DataProvider::SeriesCallback &done,
+                                   const DataProvider::AbortHook &abortHook)
+{
+    if (DataProvider *provider = providerFor(sensorId)) {
+        provider->fetchSeries(sensorId, done, abortHook);
+    } else {
+        done({}, "Nieznany dostawca czujnika " + QString::number(sensorId));
+    }
+}
+
+/**
+ * @brief Formats a global ID with the name of its provider.
+ * @param globalId Global ID.
+ * @return Qualified ID, e.g. "gios:114".
+ */
+QString ProviderRegistry::qualifiedId(int globalId) const
+{
+    const DataProvider *provider = providerFor(globalId);
+    const QString local = QString::number(DataProvider::localId(globalId));
+    return provider ? provider->name() + ":" + local : local;
+}
+
+/**
+ * @brief Parses a qualified ID.
+ * @param qualifiedId ID such as "gios:114"; a plain number belongs to the
+ *        first provider.
+ * @return Global ID, -1 if the provider or the number is invalid.
+ */
+int ProviderRegistry::resolve(const QString &qualifiedId) const
+{
+    const qsizetype colon = qualifiedId.indexOf(':');
+    bool ok = false;
+    const int local = qualifiedId.mid(colon + 1).toInt(&ok);
+    if (!ok || local < 0 || local > DataProvider::LocalIdMask) {
+        return -1;
+    }
+    if (colon < 0) {
+        return local;
+    }
+    const QString name = qualifiedId.left(colon);
+    for (const DataProvider *provider : m_providers) {
+        if (provider->name() == name) {
+            return provider->globalId(local);
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,202 @@
+/**
+ * @file dataprovider.h
+ * @brief Header file for the DataProvider interface and the ProviderRegistry class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the interface of a measurement network and the registry
+ * routing requests to the network that owns an ID.
+ */
+
+#ifndef DATAPROVIDER_H
+#define DATAPROVIDER_H
+
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <functional>
+#include "sensorcatalog.h"
+#include "seriesstore.h"
+
+/**
+ * @struct StationRecord
+ * @brief Station as reported by a provider.
+ */
+struct StationRecord {
+    int stationId = 0;  ///< Global station ID
+    QString name;       ///< Station name
+    QString city;       ///< City name
+    QString address;    ///< Street address
+    double lat = 0.0;   ///< Latitude in degrees
+    double lon = 0.0;   ///< Longitude in degrees
+};
+
+/**
+ * @class DataProvider
+ * @brief Source of stations, sensors and series of one measurement network.
+ *
+ * IDs passed to and reported by a provider are global: the index of the
+ * provider in the registry is stored in the high bits and the ID used by the
+ * network in the low bits. The first provider keeps the network IDs as they
+ * are, so the GIOŚ IDs in the catalog and the archive stay valid.
+ *
+ * Requests complete asynchronously through callbacks; the error message
+ * passed to a callback is empty on success.
+ */
+class DataProvider : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int LocalIdBits = 24;                          ///< Bits of the network ID
+    static constexpr int LocalIdMask = (1 << LocalIdBits) - 1;      ///< Mask of the network ID
+    static constexpr int MaxProviders = 1 << (31 - LocalIdBits);    ///< Largest number of providers
+
+    using StationsCallback = std::function<void(const QList<StationRecord> &stations, const QString &error)>;
+    using SensorsCallback = std::function<void(const QList<SensorInfo> &sensors, const QString &error)>;
+    using SeriesCallback = std::function<void(const Series &series, const QString &error)>;
+    using AbortHook = std::function<void(std::function<void()> abort)>;    ///< Receives the abort function of a request
+
+    /**
+     * @brief Constructs a provider.
+     * @param parent Parent QObject.
+     */
+    explicit DataProvider(QObject *parent = nullptr) : QObject(parent) {}
+
+    /**
+     * @brief Gets the prefix of qualified IDs.
+     * @return Provider name, e.g. "gios".
+     */
+    virtual QString name() const = 0;
+
+    /**
+     * @brief Fetches all stations of the network.
+     * @param done Called with the stations.
+     * @param abortHook Called with a function aborting the request, if it can be aborted.
+     */
+    virtual void fetchStations(StationsCallback done, const AbortHook &abortHook = {}) = 0;
+
+    /**
+     * @brief Fetches the sensors of a station.
+     * @param stationId Global station ID.
+     * @param done Called with the sensors.
+     * @param abortHook Called with a function aborting the request, if it can be aborted.
+     */
+    virtual void fetchSensors(int stationId, SensorsCallback done, const AbortHook &abortHook = {}) = 0;
+
+    /**
+     * @brief Fetches the recent series of a sensor.
+     * @param sensorId Global sensor ID.
+     * @param done Called with the samples, sorted by timestamp.
+     * @param abortHook Called with a function aborting the request, if it can be aborted.
+     */
+    virtual void fetchSeries(int sensorId, SeriesCallback done, const AbortHook &abortHook = {}) = 0;
+
+    /**
+     * @brief Gets the index of the provider in the registry.
+     * @return Index.
+     */
+    int index() const { return m_index; }
+
+    /**
+     * @brief Sets the index of the provider in the registry.
+     * @param index Index.
+     */
+    void setIndex(int index) { m_index = index; }
+
+    /**
+     * @brief Converts a network ID to a global ID of this provider.
+     * @param localId Network ID.
+     * @return Global ID.
+     */
+    int globalId(int localId) const { return (m_index << LocalIdBits) | (localId & LocalIdMask); }
+
+    /**
+     * @brief Extracts the network ID of a global ID.
+     * @param globalId Global ID.
+     * @return Network ID.
+     */
+    static int localId(int globalId) { return globalId & LocalIdMask; }
+
+    /**
+     * @brief Extracts the provider index of a global ID.
+     * @param globalId Global ID.
+     * @return Provider index.
+     */
+    static int providerIndex(int globalId) { return globalId >> LocalIdBits; }
+
+private:
+    int m_index = 0;    ///< Index in the registry
+};
+
+/**
+ * @class ProviderRegistry
+ * @brief Providers by index, routing every request to the owner of an ID.
+ */
+class ProviderRegistry : public QObject {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs an empty registry.
+     * @param parent Parent QObject.
+     */
+    explicit ProviderRegistry(QObject *parent = nullptr) : QObject(parent) {}
+
+    /**
+     * @brief Registers a provider and takes ownership of it.
+     * @param provider Provider.
+     * @return Index of the provider, -1 if the registry is full.
+     */
+    int add(DataProvider *provider);
+
+    /**
+     * @brief Gets all providers.
+     * @return Providers by index.
+     */
+    const QList<DataProvider *> &providers() const { return m_providers; }
+
+    /**
+     * @brief Gets the provider owning a global ID.
+     * @param globalId Global station or sensor ID.
+     * @return Provider, nullptr if none.
+     */
+    DataProvider *providerFor(int globalId) const;
+
+    /**
+     * @brief Fetches the sensors of a station from its provider.
+     * @param stationId Global station ID.
+     * @param done Called with the sensors.
+     * @param abortHook Passed to the provider.
+     */
+    void fetchSensors(int stationId, const DataProvider::SensorsCallback &done,
+                      const DataProvider::AbortHook &abortHook = {});
+
+    /**
+     * @brief Fetches the series of a sensor from its provider.
+     * @param sensorId Global sensor ID.
+     * @param done Called with the samples.
+     * @param abortHook Passed to the provider.
+     */
+    void fetchSeries(int sensorId, const DataProvider::SeriesCallback &done,
+                     const DataProvider::AbortHook &abortHook = {});
+
+    /**
+     * @brief Formats a global ID with the name of its provider.
+     * @param globalId Global ID.
+     * @return Qualified ID, e.g. "gios:114".
+     */
+    QString qualifiedId(int globalId) const;
+
+    /**
+     * @brief Parses a qualified ID.
+     * @param qualifiedId ID such as "gios:114"; a plain number belongs to the
+     *        first provider.
+     * @return Global ID, -1 if the provider or the number is invalid.
+     */
+    int resolve(const QString &qualifiedId) const;
+
+private:
+    QList<DataProvider *> m_providers;  ///< Providers by index
+};
+
+#endif // DATAPROVIDER_H
@@ -0,0 +1,571 @@
+/**
+ * @file expression.cpp
+ * @brief Implementation of the Expression and DerivedSeriesEngine classes.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the tokenizer, the recursive descent parser, the compiler
+ * from AST to array kernels and the kernels themselves. Kernels are plain
+ * loops over contiguous arrays with the operation chosen outside the loop, so
+ * the compiler can vectorize them.
+ */
+
+#include "expression.h"
+#include <QHash>
+#include <cmath>
+#include <limits>
+
+/**
+ * @struct ExpressionNode
+ * @brief AST node of a parsed expression.
+ */
+struct ExpressionNode {
+    enum Kind { Number, Sensor, Unary, Binary, Call };
+
+    Kind kind = Number;         ///< Node kind
+    double number = 0.0;        ///< Value of a Number node
+    int sensorId = 0;           ///< Sensor of a Sensor node
+    QChar op;                   ///< Operator of a Unary or Binary node
+    QString name;               ///< Function name of a Call node
+    QVector<int> children;      ///< Indices of child nodes
+};
+
+/**
+ * @class ExpressionParser
+ * @brief Recursive descent parser and compiler for Expression.
+ */
+class ExpressionParser {
+public:
+    /**
+     * @brief Constructs a parser for a text.
+     * @param text Expression text.
+     */
+    explicit ExpressionParser(const QString &text) : m_text(text) {}
+
+    /**
+     * @brief Parses and compiles the text.
+     * @param error Output for the error message.
+     * @return Compiled expression, invalid on error.
+     */
+    Expression run(QString *error)
+    {
+        Expression expression;
+        const int root = parseExpr();
+        skipSpaces();
+        if (m_error.isEmpty() && m_pos < m_text.size()) {
+            fail(QString("Nieoczekiwany znak '%1'").arg(m_text[m_pos]));
+        }
+        if (m_error.isEmpty() && m_inputs.isEmpty()) {
+            fail("Wyrażenie nie zawiera żadnego czujnika");
+        }
+        if (!m_error.isEmpty()) {
+            if (error) {
+                *error = m_error;
+            }
+            return expression;
+        }
+
+        m_expression = &expression;
+        expression.m_result = compile(root);
+        expression.m_inputs = m_inputs;
+        expression.m_text = print(root, true);
+        expression.m_valid = true;
+        return expression;
+    }
+
+private:
+    using Op = Expression::Op;
+    using Operand = Expression::Operand;
+
+    /**
+     * @brief Records the first parse error.
+     * @param message Error message.
+     * @return Invalid node index.
+     */
+    int fail(const QString &message)
+    {
+        if (m_error.isEmpty()) {
+            m_error = message + QString(" (pozycja %1)").arg(m_pos + 1);
+        }
+        return -1;
+    }
+
+    void skipSpaces()
+    {
+        while (m_pos < m_text.size() && m_text[m_pos].isSpace()) {
+            ++m_pos;
+        }
+    }
+
+    bool accept(QChar c)
+    {
+        skipSpaces();
+        if (m_pos < m_text.size() && m_text[m_pos] == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    int addNode(ExpressionNode node)
+    {
+        m_nodes.append(std::move(node));
+        return int(m_nodes.size()) - 1;
+    }
+
+    int binary(QChar op, int left, int right)
+    {
+        if (left < 0 || right < 0) {
+            return -1;
+        }
+        ExpressionNode node;
+        node.kind = ExpressionNode::Binary;
+        node.op = op;
+        node.children = {left, right};
+        return addNode(node);
+    }
+
+    int parseExpr()
+    {
+        int left = parseTerm();
+        while (m_error.isEmpty()) {
+            if (accept('+')) {
+                left = binary('+', left, parseTerm());
+            } else if (accept('-')) {
+                left = binary('-', left, parseTerm());
+            } else {
+                break;
+            }
+        }
+        return left;
+    }
+
+    int parseTerm()
+    {
+        int left = parseUnary();
+        while (m_error.isEmpty()) {
+            if (accept('*')) {
+                left = binary('*', left, parseUnary());
+            } else if (accept('/')) {
+                left = binary('/', left, parseUnary());
+            } else {
+                break;
+            }
+        }
+        return left;
+    }
+
+    int parseUnary()
+    {
+        if (accept('-')) {
+            const int operand = parseUnary();
+            if (operand < 0) {
+                return -1;
+            }
+            ExpressionNode node;
+            node.kind = ExpressionNode::Unary;
+            node.op = '-';
+            node.children = {operand};
+            return addNode(node);
+        }
+        return parsePower();
+    }
+
+    int parsePower()
+    {
+        const int base = parsePrimary();
+        if (m_error.isEmpty() && accept('^')) {
+            return binary('^', base, parseUnary());
+        }
+        return base;
+    }
+
+    int parsePrimary()
+    {
+        skipSpaces();
+        if (m_pos >= m_text.size()) {
+            return fail("Niekompletne wyrażenie");
+        }
+
+        const QChar c = m_text[m_pos];
+        if (c == '(') {
+            ++m_pos;
+            const int inner = parseExpr();
+            if (!accept(')')) {
+                return fail("Brak nawiasu zamykającego");
+            }
+            return inner;
+        }
+
+        if (c.isDigit() || c == '.') {
+            const int start = m_pos;
+            while (m_pos < m_text.size() && (m_text[m_pos].isDigit() || m_text[m_pos] == '.')) {
+                ++m_pos;
+            }
+            if (m_pos < m_text.size() && (m_text[m_pos] == 'e' || m_text[m_pos] == 'E')) {
+                ++m_pos;
+                if (m_pos < m_text.size() && (m_text[m_pos] == '+' || m_text[m_pos] == '-')) {
+                    ++m_pos;
+                }
+                while (m_pos < m_text.size() && m_text[m_pos].isDigit()) {
+                    ++m_pos;
+                }
+            }
+            bool ok = false;
+            ExpressionNode node;
+            node.kind = ExpressionNode::Number;
+            node.number = m_text.mid(start, m_pos - start).toDouble(&ok);
+            if (!ok) {
+                return fail("Niepoprawna liczba");
+            }
+            return addNode(node);
+        }
+
+        if (c.isLetter()) {
+            const int start = m_pos;
+            while (m_pos < m_text.size() && m_text[m_pos].isLetterOrNumber()) {
+                ++m_pos;
+            }
+            const QString word = m_text.mid(start, m_pos - start).toLower();
+
+            if (accept('(')) {
+                static const QHash<QString, int> arity = {
+                    {"abs", 1}, {"sqrt", 1}, {"log", 1}, {"exp", 1}, {"min", 2}, {"max", 2}
+                };
+                if (!arity.contains(word)) {
+                    return fail(QString("Nieznana funkcja '%1'").arg(word));
+                }
+                ExpressionNode node;
+                node.kind = ExpressionNode::Call;
+                node.name = word;
+                do {
+                    const int arg = parseExpr();
+                    if (arg < 0) {
+                        return -1;
+                    }
+                    node.children.append(arg);
+                } while (accept(','));
+                if (!accept(')')) {
+                    return fail("Brak nawiasu zamykającego");
+                }
+                if (node.children.size() != arity.value(word)) {
+                    return fail(QString("Funkcja '%1' oczekuje %2 argumentów").arg(word).arg(arity.value(word)));
+                }
+                return addNode(node);
+            }
+
+            bool ok = false;
+            const int sensorId = word.mid(1).toInt(&ok);
+            if (!word.startsWith('s') || !ok) {
+                return fail(QString("Nieznany identyfikator '%1', użyj s<ID czujnika>").arg(word));
+            }
+            if (!m_inputs.contains(sensorId)) {
+                m_inputs.append(sensorId);
+            }
+            ExpressionNode node;
+            node.kind = ExpressionNode::Sensor;
+            node.sensorId = sensorId;
+            return addNode(node);
+        }
+
+        return fail(QString("Nieoczekiwany znak '%1'").arg(c));
+    }
+
+    /**
+     * @brief Maps an AST operator or function to a kernel operation.
+     * @param node AST node.
+     * @return Kernel operation.
+     */
+    static Op opFor(const ExpressionNode &node)
+    {
+        if (node.kind == ExpressionNode::Unary) {
+            return Op::Neg;
+        }
+        if (node.kind == ExpressionNode::Call) {
+            static const QHash<QString, Op> ops = {
+                {"abs", Op::Abs}, {"sqrt", Op::Sqrt}, {"log", Op::Log},
+                {"exp", Op::Exp}, {"min", Op::Min}, {"max", Op::Max}
+            };
+            return ops.value(node.name);
+        }
+        switch (node.op.unicode()) {
+        case '+': return Op::Add;
+        case '-': return Op::Sub;
+        case '*': return Op::Mul;
+        case '/': return Op::Div;
+        default: return Op::Pow;
+        }
+    }
+
+    /**
+     * @brief Compiles a node, folding constant subtrees.
+     * @param index Node index.
+     * @return Operand holding the node value.
+     */
+    Operand compile(int index)
+    {
+        const ExpressionNode &node = m_nodes[index];
+        Operand result;
+
+        if (node.kind == ExpressionNode::Number) {
+            result.constant = node.number;
+            return result;
+        }
+
+        if (node.kind == ExpressionNode::Sensor) {
+            if (m_loaded.contains(node.sensorId)) {
+                result.reg = m_loaded.value(node.sensorId);
+                return result;
+            }
+            Expression::Instruction load;
+            load.op = Op::Load;
+            load.dst = m_expression->m_registers++;
+            load.a.reg = int(m_inputs.indexOf(node.sensorId));
+            m_expression->m_program.append(load);
+            m_loaded.insert(node.sensorId, load.dst);
+            result.reg = load.dst;
+            return result;
+        }
+
+        Expression::Instruction instruction;
+        instruction.op = opFor(node);
+        instruction.a = compile(node.children[0]);
+        if (node.children.size() > 1) {
+            instruction.b = compile(node.children[1]);
+        }
+
+        if (instruction.a.reg < 0 && instruction.b.reg < 0) {
+            result.constant = Expression::apply(instruction.op, instruction.a.constant, instruction.b.constant);
+            return result;
+        }
+
+        instruction.dst = m_expression->m_registers++;
+        m_expression->m_program.append(instruction);
+        result.reg = instruction.dst;
+        return result;
+    }
+
+    /**
+     * @brief Prints a node in canonical form.
+     * @param index Node index.
+     * @param top True for the root node, which is printed without parentheses.
+     * @return Canonical text.
+     */
+    QString print(int index, bool top) const
+    {
+        const ExpressionNode &node = m_nodes[index];
+        switch (node.kind) {
+        case ExpressionNode::Number:
+            return QString::number(node.number, 'g', 15);
+        case ExpressionNode::Sensor:
+            return QString("s%1").arg(node.sensorId);
+        case ExpressionNode::Unary:
+            return "-" + print(node.children[0], false);
+        case ExpressionNode::Call: {
+            QStringList args;
+            for (int child : node.children) {
+                args.append(print(child, true));
+            }
+            return node.name + "(" + args.join(", ") + ")";
+        }
+        case ExpressionNode::Binary:
+            break;
+        }
+        const QString text = print(node.children[0], false) + " " + node.op + " " + print(node.children[1], false);
+        return top ? text : "(" + text + ")";
+    }
+
+    const QString m_text;                   ///< Source text
+    int m_pos = 0;                          ///< Current parse position
+    QString m_error;                        ///< First error message
+    QVector<ExpressionNode> m_nodes;        ///< AST nodes
+    QList<int> m_inputs;                    ///< Referenced sensors
+    QHash<int, int> m_loaded;               ///< Register of each loaded sensor
+    Expression *m_expression = nullptr;     ///< Expression being compiled
+};
+
+/**
+ * @brief Parses and compiles an expression.
+ * @param text Expression text.
+ * @param error Optional output for the parse error message.
+ * @return Compiled expression, invalid on error.
+ */
+Expression Expression::parse(const QString &text, QString *error)
+{
+    return ExpressionParser(text).run(error);
+}
+
+/**
+ * @brief Applies an operation to scalars.
+ * @param op Operation.
+ * @param x First operand.
+ * @param y Second operand, ignored by unary operations.
+ * @return Result.
+ *
+ * Used for constant folding and by the kernels, so both agree exactly.
+ */
+double Expression::apply(Op op, double x, double y)
+{
+    switch (op) {
+    case Op::Load: return x;
+    case Op::Neg: return -x;
+    case Op::Abs: return std::fabs(x);
+    case Op::Sqrt: return std::sqrt(x);
+    case Op::Log: return std::log(x);
+    case Op::Exp: return std::exp(x);
+    case Op::Add: return x + y;
+    case Op::Sub: return x - y;
+    case Op::Mul: return x * y;
+    case Op::Div: return x / y;
+    case Op::Pow: return std::pow(x, y);
+    case Op::Min: return std::isnan(x + y) ? x + y : (x < y ? x : y);
+    case Op::Max: return std::isnan(x + y) ? x + y : (x > y ? x : y);
+    }
+    return x;
+}
+
+namespace {
+
+/**
+ * @brief Runs a binary kernel with register or constant operands.
+ * @param out Output array.
+ * @param x First operand array, or nullptr for the constant cx.
+ * @param cx First constant operand.
+ * @param y Second operand array, or nullptr for the constant cy.
+ * @param cy Second constant operand.
+ * @param n Array length.
+ * @param f Scalar operation, inlined into the loop.
+ */
+template <typename F>
+void binaryKernel(double *out, const double *x, double cx, const double *y, double cy, qsizetype n, F f)
+{
+    if (x && y) {
+        for (qsizetype i = 0; i < n; ++i) {
+            out[i] = f(x[i], y[i]);
+        }
+    } else if (x) {
+        for (qsizetype i = 0; i < n; ++i) {
+            out[i] = f(x[i], cy);
+        }
+    } else {
+        for (qsizetype i = 0; i < n; ++i) {
+            out[i] = f(cx, y[i]);
+        }
+    }
+}
+
+/**
+ * @brief Runs a unary kernel.
+ * @param out Output array.
+ * @param x Operand array.
+ * @param n Array length.
+ * @param f Scalar operation, inlined into the loop.
+ */
+template <typename F>
+void unaryKernel(double *out, const double *x, qsizetype n, F f)
+{
+    for (qsizetype i = 0; i < n; ++i) {
+        out[i] = f(x[i]);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Evaluates the expression over aligned input columns.
+ * @param columns One column per entry of sensorIds(), all of equal length.
+ * @return Result column; NaN wherever an input is NaN.
+ *
+ * Input columns are loaded by pointer without copying; every other
+ * instruction writes one full array.
+ */
+QVector<double> Expression::evaluate(const QVector<QVector<double>> &columns) const
+{
+    if (!m_valid || columns.size() != m_inputs.size()) {
+        return {};
+    }
+    const qsizetype n = columns.isEmpty() ? 0 : columns.first().size();
+
+    QVector<QVector<double>> storage(m_registers);
+    QVector<const double *> regs(m_registers, nullptr);
+
+    for (const Instruction &ins : m_program) {
+        if (ins.op == Op::Load) {
+            regs[ins.dst] = columns[ins.a.reg].constData();
+            continue;
+        }
+
+        storage[ins.dst].resize(n);
+        double *out = storage[ins.dst].data();
+        regs[ins.dst] = out;
+        const double *x = ins.a.reg >= 0 ? regs[ins.a.reg] : nullptr;
+        const double *y = ins.b.reg >= 0 ? regs[ins.b.reg] : nullptr;
+        const double cx = ins.a.constant;
+        const double cy = ins.b.constant;
+
+        switch (ins.op) {
+        case Op::Neg: unaryKernel(out, x, n, [](double v) { return -v; }); break;
+        case Op::Abs: unaryKernel(out, x, n, [](double v) { return std::fabs(v); }); break;
+        case Op::Sqrt: unaryKernel(out, x, n, [](double v) { return std::sqrt(v); }); break;
+        case Op::Log: unaryKernel(out, x, n, [](double v) { return std::log(v); }); break;
+        case Op::Exp: unaryKernel(out, x, n, [](double v) { return std::exp(v); }); break;
+        case Op::Add: binaryKernel(out, x, cx, y, cy, n, [](double a, double b) { return a + b; }); break;
+        case Op::Sub: binaryKernel(out, x, cx, y, cy, n, [](double a, double b) { return a - b; }); break;
+        case Op::Mul: binaryKernel(out, x, cx, y, cy, n, [](double a, double b) { return a * b; }); break;
+        case Op::Div: binaryKernel(out, x, cx, y, cy, n, [](double a, double b) { return a / b; }); break;
+        case Op::Pow: binaryKernel(out, x, cx, y, cy, n, [](double a, double b) { return std::pow(a, b); }); break;
+        case Op::Min: binaryKernel(out, x, cx, y, cy, n, [](double a, double b) { return apply(Op::Min, a, b); }); break;
+        case Op::Max: binaryKernel(out, x, cx, y, cy, n, [](double a, double b) { return apply(Op::Max, a, b); }); break;
+        case Op::Load: break;
+        }
+    }
+
+    if (m_result.reg < 0) {
+        return QVector<double>(n, m_result.constant);
+    }
+    if (!storage[m_result.reg].isEmpty() || n == 0) {
+        return std::move(storage[m_result.reg]);
+    }
+    // Wynik to bezpośrednio kolumna wejściowa
+    return columns[m_program[m_result.reg].a.reg];
+}
+
+/**
+ * @brief Evaluates an expression.
+ * @param expression Compiled expression.
+ * @param result Output series.
+ * @return False if an input series is not in the store yet.
+ *
+ * Inputs are aligned with an outer time-join, so a timestamp missing in one
+ * input yields NaN in the result.
+ */
+bool DerivedSeriesEngine::evaluate(const Expression &expression, Series *result)
+{
+    const QList<int> inputs = expression.sensorIds();
+    QList<const Series *> series;
+    QVector<quint64> versions;
+    for (int sensorId : inputs) {
+        const Series *input = m_store->find(sensorId);
+        if (!input) {
+            return false;
+        }
+        series.append(input);
+        versions.append(m_store->version(sensorId));
+    }
+
+    auto it = m_cache.constFind(expression.text());
+    if (it != m_cache.cend() && it->versions == versions) {
+        ++m_cacheHits;
+        *result = it->result;
+        return true;
+    }
+
+    AlignedSeries aligned = SeriesStore::timeJoin(series);
+    Series computed;
+    computed.values = expression.evaluate(aligned.columns);
+    computed.timestamps = std::move(aligned.timestamps);
+
+    m_cache.insert(expression.text(), CacheEntry{versions, computed});
+    *result = computed;
+    return true;
+}
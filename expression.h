@@ -0,0 +1,171 @@
+/**
+ * @file expression.h
+ * @brief Header file for the Expression and DerivedSeriesEngine classes.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines a small expression language over sensor series, e.g.
+ * "s101 / s102" or "(s92 - s95) * 1.88". Expressions are parsed to an AST,
+ * compiled to a list of array kernels and evaluated over aligned columns.
+ */
+
+#ifndef EXPRESSION_H
+#define EXPRESSION_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "seriesstore.h"
+
+/**
+ * @class Expression
+ * @brief Parsed and compiled derived-series expression.
+ *
+ * Grammar:
+ * @code
+ * expr    := term (('+' | '-') term)*
+ * term    := unary (('*' | '/') unary)*
+ * unary   := '-' unary | power
+ * power   := primary ('^' unary)?
+ * primary := number | 's' sensorId | name '(' expr (',' expr)* ')' | '(' expr ')'
+ * @endcode
+ * Supported functions: abs, sqrt, log, exp, min, max.
+ */
+class Expression {
+public:
+    /**
+     * @brief Parses and compiles an expression.
+     * @param text Expression text.
+     * @param error Optional output for the parse error message.
+     * @return Compiled expression, invalid on error.
+     */
+    static Expression parse(const QString &text, QString *error = nullptr);
+
+    /**
+     * @brief Checks whether the expression was compiled successfully.
+     * @return True if valid.
+     */
+    bool isValid() const { return m_valid; }
+
+    /**
+     * @brief Gets the canonical text of the expression.
+     * @return Expression text printed from the AST.
+     */
+    QString text() const { return m_text; }
+
+    /**
+     * @brief Gets the sensors referenced by the expression.
+     * @return Distinct sensor IDs; their order defines the input columns.
+     */
+    QList<int> sensorIds() const { return m_inputs; }
+
+    /**
+     * @brief Evaluates the expression over aligned input columns.
+     * @param columns One column per entry of sensorIds(), all of equal length.
+     * @return Result column; NaN wherever an input is NaN.
+     */
+    QVector<double> evaluate(const QVector<QVector<double>> &columns) const;
+
+private:
+    friend class ExpressionParser;
+
+    /**
+     * @brief Kernel operation of the compiled program.
+     */
+    enum class Op { Load, Neg, Abs, Sqrt, Log, Exp, Add, Sub, Mul, Div, Pow, Min, Max };
+
+    /**
+     * @struct Operand
+     * @brief Instruction operand: either a register or a constant.
+     */
+    struct Operand {
+        int reg = -1;           ///< Register index, -1 for a constant
+        double constant = 0.0;  ///< Constant value
+    };
+
+    /**
+     * @struct Instruction
+     * @brief Single array kernel writing one register.
+     */
+    struct Instruction {
+        Op op = Op::Load;   ///< Operation
+        int dst = 0;        ///< Destination register
+        Operand a;          ///< First operand (input column for Load)
+        Operand b;          ///< Second operand for binary operations
+    };
+
+    /**
+     * @brief Applies an operation to scalars.
+     * @param op Operation.
+     * @param x First operand.
+     * @param y Second operand, ignored by unary operations.
+     * @return Result.
+     */
+    static double apply(Op op, double x, double y);
+
+    bool m_valid = false;                   ///< True if compiled
+    QString m_text;                         ///< Canonical expression text
+    QList<int> m_inputs;                    ///< Input sensor IDs
+    QVector<Instruction> m_program;         ///< Compiled kernels
+    int m_registers = 0;                    ///< Number of registers
+    Operand m_result;                       ///< Operand holding the result
+};
+
+/**
+ * @class DerivedSeriesEngine
+ * @brief Evaluates expressions over the series store with a result cache.
+ *
+ * Results are cached by canonical expression text and reused as long as the
+ * versions of all input series are unchanged.
+ */
+class DerivedSeriesEngine {
+public:
+    /**
+     * @brief Constructs the engine over a series store.
+     * @param store Series store providing the inputs.
+     */
+    explicit DerivedSeriesEngine(const SeriesStore *store) : m_store(store) {}
+
+    /**
+     * @brief Evaluates an expression.
+     * @param expression Compiled expression.
+     * @param result Output series.
+     * @return False if an input series is not in the store yet.
+     */
+    bool evaluate(const Expression &expression, Series *result);
+
+    /**
+     * @brief Gets the number of cached results.
+     * @return Cache size.
+     */
+    int cacheSize() const { return m_cache.size(); }
+
+    /**
+     * @brief Gets the number of evaluations served from the cache.
+     * @return Cache hit count.
+     */
+    quint64 cacheHits() const { return m_cacheHits; }
+
+    /**
+     * @brief Drops a cached result.
+     * @param text Canonical expression text.
+     */
+    void invalidate(const QString &text) { m_cache.remove(text); }
+
+private:
+    /**
+     * @struct CacheEntry
+     * @brief Cached result with the input versions it was computed from.
+     */
+    struct CacheEntry {
+        QVector<quint64> versions;  ///< Input versions
+        Series result;              ///< Cached result
+    };
+
+    const SeriesStore *m_store;             ///< Input series
+    QHash<QString, CacheEntry> m_cache;     ///< Results by expression text
+    quint64 m_cacheHits = 0;                ///< Cache hit count
+};
+
+#endif // EXPRESSION_H
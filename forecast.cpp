@@ -0,0 +1,297 @@
+/**
+ * @file forecast.cpp
+ * @brief Implementation of the HoltWinters and ForecastEngine classes.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the Holt-Winters recurrences and the batch scheduling of
+ * forecasts on the thread pool.
+ */
+
+#include "forecast.h"
+#include "taskpool.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Converts the forecast to the measurement list format used in QML.
+ * @return List of maps with "date", "value", "lower" and "upper", newest first.
+ */
+QVariantList Forecast::toVariantList() const
+{
+    QVariantList list;
+    list.reserve(mean.size());
+    for (qsizetype i = mean.size() - 1; i >= 0; --i) {
+        QVariantMap data;
+        data["date"] = SeriesStore::formatDate(mean.timestamps[i]);
+        data["value"] = mean.values[i];
+        data["lower"] = lower[i];
+        data["upper"] = upper[i];
+        list.append(data);
+    }
+    return list;
+}
+
+/**
+ * @brief Updates the model with samples newer than the last seen one.
+ * @param series Hourly series of the sensor.
+ *
+ * Samples at or before the last processed timestamp are ignored, so values
+ * revised later by validation do not change a fitted model.
+ */
+void HoltWinters::update(const Series &series)
+{
+    if (!m_fitted && !initialize(series)) {
+        return;
+    }
+
+    const auto begin = std::upper_bound(series.timestamps.cbegin(), series.timestamps.cend(), m_lastTimestamp);
+    for (qsizetype i = begin - series.timestamps.cbegin(); i < series.size(); ++i) {
+        if (!std::isnan(series.values[i])) {
+            step(series.timestamps[i], series.values[i]);
+        }
+    }
+}
+
+/**
+ * @brief Initializes the components from the first two days of data.
+ * @param series Hourly series.
+ * @return True if there were enough samples.
+ *
+ * Level and trend come from the daily means, the season from the deviations
+ * from those means. The recurrences then run over the whole series.
+ */
+bool HoltWinters::initialize(const Series &series)
+{
+    qsizetype first = 0;
+    while (first < series.size() && std::isnan(series.values[first])) {
+        ++first;
+    }
+    if (first == series.size()) {
+        return false;
+    }
+
+    const qint64 start = series.timestamps[first];
+    double sums[2] = {0.0, 0.0};
+    int counts[2] = {0, 0};
+    for (qsizetype i = first; i < series.size(); ++i) {
+        const int day = int((series.timestamps[i] - start) / (Season * HourMs));
+        if (day > 1) {
+            break;
+        }
+        if (!std::isnan(series.values[i])) {
+            sums[day] += series.values[i];
+            ++counts[day];
+        }
+    }
+    // Co najmniej połowa godzin z każdej z dwóch pierwszych dób
+    if (counts[0] < Season / 2 || counts[1] < Season / 2) {
+        return false;
+    }
+
+    const double means[2] = {sums[0] / counts[0], sums[1] / counts[1]};
+    double seasonSums[Season] = {};
+    int seasonCounts[Season] = {};
+    for (qsizetype i = first; i < series.size(); ++i) {
+        const int day = int((series.timestamps[i] - start) / (Season * HourMs));
+        if (day > 1) {
+            break;
+        }
+        if (!std::isnan(series.values[i])) {
+            const int s = slot(series.timestamps[i]);
+            seasonSums[s] += series.values[i] - means[day];
+            ++seasonCounts[s];
+        }
+    }
+
+    m_level = means[0];
+    m_trend = (means[1] - means[0]) / Season;
+    for (int s = 0; s < Season; ++s) {
+        m_season[s] = seasonCounts[s] > 0 ? seasonSums[s] / seasonCounts[s] : 0.0;
+    }
+    m_errorVariance = -1.0;
+    m_lastTimestamp = start - 1;
+    m_fitted = true;
+    return true;
+}
+
+/**
+ * @brief Applies one observation.
+ * @param timestamp Sample timestamp.
+ * @param value Sample value.
+ *
+ * Missing hours between two samples advance the level by the trend only.
+ */
+void HoltWinters::step(qint64 timestamp, double value)
+{
+    const qint64 gap = std::max<qint64>(1, (timestamp - m_lastTimestamp) / HourMs);
+    m_level += m_trend * double(gap - 1);
+
+    const int s = slot(timestamp);
+    const double seasonal = m_season[s];
+    const double error = value - (m_level + m_trend + seasonal);
+
+    const double level = m_alpha * (value - seasonal) + (1.0 - m_alpha) * (m_level + m_trend);
+    m_trend = m_beta * (level - m_level) + (1.0 - m_beta) * m_trend;
+    m_level = level;
+    m_season[s] = m_gamma * (value - level) + (1.0 - m_gamma) * seasonal;
+
+    m_errorVariance = m_errorVariance < 0.0 ? error * error : 0.95 * m_errorVariance + 0.05 * error * error;
+    m_lastTimestamp = timestamp;
+}
+
+/**
+ * @brief Forecasts the next hours.
+ * @param hours Forecast horizon.
+ * @return Forecast starting one hour after the last processed sample.
+ *
+ * The band widens with the horizon as the one-step error accumulates.
+ * Concentrations cannot be negative, so values are clamped at zero.
+ */
+Forecast HoltWinters::forecast(int hours) const
+{
+    Forecast result;
+    if (!m_fitted || m_lastTimestamp < 0) {
+        return result;
+    }
+
+    const double variance = std::max(0.0, m_errorVariance);
+    for (int h = 1; h <= hours; ++h) {
+        const qint64 t = m_lastTimestamp + h * HourMs;
+        const double mean = m_level + h * m_trend + m_season[slot(t)];
+        const double sigma = std::sqrt(variance * (1.0 + (h - 1) * m_alpha * m_alpha));
+        result.mean.timestamps.append(t);
+        result.mean.values.append(std::max(0.0, mean));
+        result.lower.append(std::max(0.0, mean - 1.96 * sigma));
+        result.upper.append(std::max(0.0, mean + 1.96 * sigma));
+    }
+    return result;
+}
+
+/**
+ * @brief Constructs the engine.
+ * @param parent Parent QObject.
+ */
+ForecastEngine::ForecastEngine(QObject *parent)
+    : QObject(parent)
+{
+    connect(&m_watcher, &QFutureWatcher<void>::finished, this, &ForecastEngine::onBatchFinished);
+}
+
+/**
+ * @brief Destroys the engine, cancelling a running batch.
+ */
+ForecastEngine::~ForecastEngine()
+{
+    cancel();
+}
+
+/**
+ * @brief Schedules forecasts of sensors.
+ * @param inputs Current series by sensor ID.
+ */
+void ForecastEngine::schedule(const QHash<int, Series> &inputs)
+{
+    for (auto it = inputs.cbegin(); it != inputs.cend(); ++it) {
+        m_removed.remove(it.key());
+    }
+    m_pending.insert(inputs);
+    if (!m_watcher.isRunning()) {
+        startBatch();
+    }
+}
+
+/**
+ * @brief Drops the model and forecast of a sensor.
+ * @param sensorId Sensor ID.
+ */
+void ForecastEngine::remove(int sensorId)
+{
+    m_models.remove(sensorId);
+    m_forecasts.remove(sensorId);
+    m_pending.remove(sensorId);
+    if (m_watcher.isRunning()) {
+        m_removed.insert(sensorId);
+    }
+}
+
+/**
+ * @brief Cancels the running batch and drops the pending inputs.
+ *
+ * Jobs not started yet are skipped and the results of the batch are
+ * discarded; returns once no job runs any more.
+ */
+void ForecastEngine::cancel()
+{
+    m_pending.clear();
+    if (!m_watcher.isRunning()) {
+        return;
+    }
+    m_cancelled = true;
+    m_watcher.cancel();
+    m_watcher.waitForFinished();
+}
+
+/**
+ * @brief Starts a batch for the pending inputs.
+ *
+ * Every job owns a copy of its model, so workers share no state.
+ */
+void ForecastEngine::startBatch()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    m_jobs.clear();
+    for (auto it = m_pending.cbegin(); it != m_pending.cend(); ++it) {
+        Job job;
+        job.sensorId = it.key();
+        job.model = m_models.value(it.key());
+        job.series = it.value();
+        m_jobs.append(job);
+    }
+    m_pending.clear();
+
+    m_cancelled = false;
+    m_watcher.setFuture(TaskPool::instance().run([this]() {
+        TaskPool::instance().blockingMap(m_jobs, [](Job &job) {
+            job.model.update(job.series);
+            if (job.model.isFitted()) {
+                job.forecast = job.model.forecast(Horizon);
+            }
+        }, TaskPool::Normal, &m_cancelled);
+    }));
+}
+
+/**
+ * @brief Collects results of the finished batch.
+ */
+void ForecastEngine::onBatchFinished()
+{
+    // Wyniki przerwanej partii są niepełne, modele zostają sprzed niej
+    if (m_cancelled) {
+        m_jobs.clear();
+        m_removed.clear();
+        return;
+    }
+
+    QList<int> updated;
+    for (const Job &job : std::as_const(m_jobs)) {
+        if (m_removed.contains(job.sensorId)) {
+            continue;
+        }
+        m_models.insert(job.sensorId, job.model);
+        if (job.model.isFitted()) {
+            m_forecasts.insert(job.sensorId, job.forecast);
+            updated.append(job.sensorId);
+        }
+    }
+    m_jobs.clear();
+    m_removed.clear();
+
+    if (!updated.isEmpty()) {
+        emit forecastsUpdated(updated);
+    }
+    startBatch();
+}
@@ -0,0 +1,209 @@
+/**
+ * @file forecast.h
+ * @brief Header file for the HoltWinters and ForecastEngine classes.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the short-term per-sensor forecast: an additive
+ * Holt-Winters model with daily seasonality, fitted in batch on a thread pool
+ * and refitted incrementally as new hourly samples arrive.
+ */
+
+#ifndef FORECAST_H
+#define FORECAST_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QVector>
+#include <QFutureWatcher>
+#include <atomic>
+#include "seriesstore.h"
+
+/**
+ * @struct Forecast
+ * @brief Forecast series with a 95% confidence band.
+ */
+struct Forecast {
+    Series mean;                ///< Forecast values, hourly
+    QVector<double> lower;      ///< Lower band, same length as mean
+    QVector<double> upper;      ///< Upper band, same length as mean
+
+    /**
+     * @brief Converts the forecast to the measurement list format used in QML.
+     * @return List of maps with "date", "value", "lower" and "upper", newest first.
+     */
+    QVariantList toVariantList() const;
+};
+
+/**
+ * @class HoltWinters
+ * @brief Additive Holt-Winters model with a 24-hour season.
+ *
+ * The seasonal slot of a sample is its hour of day, so gaps in the series do
+ * not shift the season.
+ */
+class HoltWinters {
+public:
+    static constexpr int Season = 24;               ///< Season length in hours
+    static constexpr qint64 HourMs = 3600 * 1000;   ///< One hour in milliseconds
+
+    /**
+     * @brief Updates the model with samples newer than the last seen one.
+     * @param series Hourly series of the sensor.
+     *
+     * The first call fits the model from scratch; later calls only process the
+     * new tail, so refitting costs O(new samples).
+     */
+    void update(const Series &series);
+
+    /**
+     * @brief Checks whether the model has enough data to forecast.
+     * @return True if fitted.
+     */
+    bool isFitted() const { return m_fitted; }
+
+    /**
+     * @brief Gets the timestamp of the last processed sample.
+     * @return Milliseconds since epoch.
+     */
+    qint64 lastTimestamp() const { return m_lastTimestamp; }
+
+    /**
+     * @brief Forecasts the next hours.
+     * @param hours Forecast horizon.
+     * @return Forecast starting one hour after the last processed sample.
+     */
+    Forecast forecast(int hours) const;
+
+private:
+    /**
+     * @brief Initializes the components from the first two days of data.
+     * @param series Hourly series.
+     * @return True if there were enough samples.
+     */
+    bool initialize(const Series &series);
+
+    /**
+     * @brief Applies one observation.
+     * @param timestamp Sample timestamp.
+     * @param value Sample value.
+     */
+    void step(qint64 timestamp, double value);
+
+    /**
+     * @brief Gets the seasonal slot of a timestamp.
+     * @param timestamp Milliseconds since epoch.
+     * @return Hour of day slot.
+     */
+    static int slot(qint64 timestamp) { return int((timestamp / HourMs) % Season); }
+
+    double m_alpha = 0.3;               ///< Level smoothing
+    double m_beta = 0.02;               ///< Trend smoothing
+    double m_gamma = 0.2;               ///< Season smoothing
+    bool m_fitted = false;              ///< True once initialized
+    double m_level = 0.0;               ///< Level component
+    double m_trend = 0.0;               ///< Trend per hour
+    double m_season[Season] = {};       ///< Seasonal components
+    double m_errorVariance = 0.0;       ///< Smoothed squared one-step error
+    qint64 m_lastTimestamp = -1;        ///< Last processed sample
+};
+
+/**
+ * @class ForecastEngine
+ * @brief Fits Holt-Winters models of many sensors in batch.
+ *
+ * Each sensor keeps its model between runs, so a batch run only feeds the
+ * samples merged since the previous run. Requests arriving while a batch
+ * runs are coalesced into the next batch.
+ */
+class ForecastEngine : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int Horizon = 24;  ///< Forecast horizon in hours
+
+    /**
+     * @brief Constructs the engine.
+     * @param parent Parent QObject.
+     */
+    explicit ForecastEngine(QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the engine, cancelling a running batch.
+     */
+    ~ForecastEngine() override;
+
+    /**
+     * @brief Schedules forecasts of sensors.
+     * @param inputs Current series by sensor ID.
+     */
+    void schedule(const QHash<int, Series> &inputs);
+
+    /**
+     * @brief Drops the model and forecast of a sensor.
+     * @param sensorId Sensor ID.
+     */
+    void remove(int sensorId);
+
+    /**
+     * @brief Cancels the running batch and drops the pending inputs.
+     *
+     * Jobs not started yet are skipped and the results of the batch are
+     * discarded; returns once no job runs any more.
+     */
+    void cancel();
+
+    /**
+     * @brief Gets the latest forecast of a sensor.
+     * @param sensorId Sensor ID.
+     * @return Forecast, empty if none.
+     */
+    Forecast forecast(int sensorId) const { return m_forecasts.value(sensorId); }
+
+    /**
+     * @brief Checks whether a batch is running.
+     * @return True while fitting.
+     */
+    bool isBusy() const { return m_watcher.isRunning(); }
+
+signals:
+    /**
+     * @brief Emitted when a batch finishes.
+     * @param sensorIds Sensors with a new forecast.
+     */
+    void forecastsUpdated(const QList<int> &sensorIds);
+
+private:
+    /**
+     * @struct Job
+     * @brief Fit of one sensor within a batch.
+     */
+    struct Job {
+        int sensorId = 0;       ///< Sensor ID
+        HoltWinters model;      ///< Model, updated in place
+        Series series;          ///< Input series
+        Forecast forecast;      ///< Output forecast
+    };
+
+    /**
+     * @brief Starts a batch for the pending inputs.
+     */
+    void startBatch();
+
+    /**
+     * @brief Collects results of the finished batch.
+     */
+    void onBatchFinished();
+
+    QHash<int, HoltWinters> m_models;       ///< Models by sensor ID
+    QHash<int, Forecast> m_forecasts;       ///< Forecasts by sensor ID
+    QHash<int, Series> m_pending;           ///< Inputs waiting for the next batch
+    QList<Job> m_jobs;                      ///< Jobs of the running batch
+    QSet<int> m_removed;                    ///< Sensors removed while a batch runs
+    QFutureWatcher<void> m_watcher;         ///< Running batch
+    std::atomic_bool m_cancelled{false};    ///< Set by cancel(), stops the running batch
+};
+
+#endif // FORECAST_H
@@ -0,0 +1,142 @@
+/**
+ * @file geotable.cpp
+ * @brief Implementation of the GeoTable class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the batched haversine kernel and the radius query.
+ */
+
+#include "geotable.h"
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/**
+ * @brief Converts degrees to radians.
+ * @param degrees Angle in degrees.
+ * @return Angle in radians.
+ */
+constexpr double radians(double degrees)
+{
+    return degrees * M_PI / 180.0;
+}
+
+} // namespace
+
+/**
+ * @brief Removes all entries.
+ */
+void GeoTable::clear()
+{
+    m_lat.clear();
+    m_lon.clear();
+    m_cosLat.clear();
+}
+
+/**
+ * @brief Reserves space for entries.
+ * @param size Expected number of entries.
+ */
+void GeoTable::reserve(int size)
+{
+    m_lat.reserve(size);
+    m_lon.reserve(size);
+    m_cosLat.reserve(size);
+}
+
+/**
+ * @brief Appends an entry.
+ * @param lat Latitude in degrees.
+ * @param lon Longitude in degrees.
+ */
+void GeoTable::append(double lat, double lon)
+{
+    m_lat.append(radians(lat));
+    m_lon.append(radians(lon));
+    m_cosLat.append(std::cos(radians(lat)));
+}
+
+/**
+ * @brief Gets the memory held by the columns.
+ * @return Bytes and number of entries.
+ */
+MemoryAccounting::Usage GeoTable::memoryUsage() const
+{
+    MemoryAccounting::Usage usage;
+    usage.objects = m_lat.size();
+    usage.bytes = MemoryAccounting::bytes(m_lat) + MemoryAccounting::bytes(m_lon) + MemoryAccounting::bytes(m_cosLat);
+    return usage;
+}
+
+/**
+ * @brief Computes the haversine term of all entries.
+ * @param lat Latitude of the point in radians.
+ * @param lon Longitude of the point in radians.
+ * @param out Output array of size() terms in [0, 1].
+ *
+ * The loop has no branches and reads each column sequentially, so the
+ * compiler can vectorize it.
+ */
+void GeoTable::haversines(double lat, double lon, double *out) const
+{
+    const double cosLat = std::cos(lat);
+    const double *lats = m_lat.constData();
+    const double *lons = m_lon.constData();
+    const double *cosLats = m_cosLat.constData();
+    const int n = size();
+    for (int i = 0; i < n; ++i) {
+        const double sinLat = std::sin((lats[i] - lat) * 0.5);
+        const double sinLon = std::sin((lons[i] - lon) * 0.5);
+        out[i] = std::min(1.0, sinLat * sinLat + cosLat * cosLats[i] * sinLon * sinLon);
+    }
+}
+
+/**
+ * @brief Computes the distances of all entries from a point.
+ * @param lat Latitude of the point in degrees.
+ * @param lon Longitude of the point in degrees.
+ * @param out Output array of size() distances in km.
+ */
+void GeoTable::distances(double lat, double lon, double *out) const
+{
+    haversines(radians(lat), radians(lon), out);
+    const int n = size();
+    for (int i = 0; i < n; ++i) {
+        out[i] = 2.0 * EarthRadius * std::asin(std::sqrt(out[i]));
+    }
+}
+
+/**
+ * @brief Finds the entries within a radius of a point.
+ * @param lat Latitude of the point in degrees.
+ * @param lon Longitude of the point in degrees.
+ * @param radius Radius in km.
+ * @return Entries within the radius, nearest first.
+ *
+ * The haversine term grows with the distance, so the radius is compared in
+ * that domain and the arc sine is computed only for the hits.
+ */
+QVector<GeoTable::Hit> GeoTable::within(double lat, double lon, double radius) const
+{
+    QVector<Hit> hits;
+    if (radius < 0.0 || m_lat.isEmpty()) {
+        return hits;
+    }
+
+    QVector<double> terms(size());
+    haversines(radians(lat), radians(lon), terms.data());
+    const double half = std::sin(std::min(radius / EarthRadius, M_PI) * 0.5);
+    const double limit = half * half;
+    for (int i = 0; i < terms.size(); ++i) {
+        if (terms[i] <= limit) {
+            hits.append({i, 2.0 * EarthRadius * std::asin(std::sqrt(terms[i]))});
+        }
+    }
+    std::sort(hits.begin(), hits.end(), [](const Hit &a, const Hit &b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.index < b.index;
+    });
+    return hits;
+}
@@ -0,0 +1,103 @@
+/**
+ * @file geotable.h
+ * @brief Header file for the GeoTable class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the coordinate table used for distance queries over all
+ * stations.
+ */
+
+#ifndef GEOTABLE_H
+#define GEOTABLE_H
+
+#include <QVector>
+#include "memoryaccounting.h"
+
+/**
+ * @class GeoTable
+ * @brief Structure-of-arrays table of coordinates with batched great-circle
+ *        distances.
+ *
+ * Latitudes, longitudes and latitude cosines are kept in separate columns in
+ * radians, so the haversine kernel runs as one tight loop over contiguous
+ * arrays without trigonometry of the stored points.
+ */
+class GeoTable {
+public:
+    /**
+     * @struct Hit
+     * @brief Entry found by a radius query.
+     */
+    struct Hit {
+        int index = 0;          ///< Entry index
+        double distance = 0.0;  ///< Distance in km
+    };
+
+    /**
+     * @brief Mean Earth radius in km.
+     */
+    static constexpr double EarthRadius = 6371.0088;
+
+    /**
+     * @brief Removes all entries.
+     */
+    void clear();
+
+    /**
+     * @brief Reserves space for entries.
+     * @param size Expected number of entries.
+     */
+    void reserve(int size);
+
+    /**
+     * @brief Appends an entry.
+     * @param lat Latitude in degrees.
+     * @param lon Longitude in degrees.
+     */
+    void append(double lat, double lon);
+
+    /**
+     * @brief Gets the number of entries.
+     * @return Entry count.
+     */
+    int size() const { return int(m_lat.size()); }
+
+    /**
+     * @brief Gets the memory held by the columns.
+     * @return Bytes and number of entries.
+     */
+    MemoryAccounting::Usage memoryUsage() const;
+
+    /**
+     * @brief Computes the distances of all entries from a point.
+     * @param lat Latitude of the point in degrees.
+     * @param lon Longitude of the point in degrees.
+     * @param out Output array of size() distances in km.
+     */
+    void distances(double lat, double lon, double *out) const;
+
+    /**
+     * @brief Finds the entries within a radius of a point.
+     * @param lat Latitude of the point in degrees.
+     * @param lon Longitude of the point in degrees.
+     * @param radius Radius in km.
+     * @return Entries within the radius, nearest first.
+     */
+    QVector<Hit> within(double lat, double lon, double radius) const;
+
+private:
+    /**
+     * @brief Computes the haversine term of all entries.
+     * @param lat Latitude of the point in radians.
+     * @param lon Longitude of the point in radians.
+     * @param out Output array of size() terms in [0, 1].
+     */
+    void haversines(double lat, double lon, double *out) const;
+
+    QVector<double> m_lat;      ///< Latitudes in radians
+    QVector<double> m_lon;      ///< Longitudes in radians
+    QVector<double> m_cosLat;   ///< Cosines of the latitudes
+};
+
+#endif // GEOTABLE_H
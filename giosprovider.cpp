@@ -0,0 +1,244 @@
+/**
+ * @file giosprovider.cpp
+ * @brief Implementation of the GiosProvider class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the requests to the GIOŚ API and the parsing of its
+ * replies.
+ */
+
+#include "giosprovider.h"
+#include "metrics.h"
+#include "replybufferpool.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPointer>
+
+namespace {
+
+/**
+ * @brief Reads a network ID which fits the low bits of a global ID.
+ * @param value JSON value.
+ * @param id Receives the ID.
+ * @param error Receives the error if the ID is out of range; may be nullptr.
+ * @return True if the ID is valid.
+ */
+bool takeLocalId(const QJsonValue &value, int &id, QString *error)
+{
+    id = value.toInt(-1);
+    if (id >= 0 && id <= DataProvider::LocalIdMask) {
+        return true;
+    }
+    if (error) {
+        *error = "Identyfikator GIOŚ poza zakresem: " + QString::number(value.toDouble(), 'f', 0);
+    }
+    return false;
+}
+
+} // namespace
+
+/**
+ * @brief Constructs the provider.
+ * @param networkManager Network manager used for the requests.
+ * @param parent Parent QObject.
+ */
+GiosProvider::GiosProvider(QNetworkAccessManager *networkManager, QObject *parent)
+    : DataProvider(parent),
+    m_networkManager(networkManager),
+    m_buffers(ReplyBufferPool::of(networkManager)),
+    m_baseUrl("https://api.gios.gov.pl/pjp-api/rest/")
+{
+}
+
+/**
+ * @brief Sends a GET request to the API.
+ * @param path Path below the API root.
+ * @param metrics Metrics of the endpoint.
+ * @param abortHook Called with a function aborting the reply.
+ * @return Reply whose body streams into a pooled buffer.
+ *
+ * The abort function does nothing once the reply has been deleted.
+ */
+QNetworkReply *GiosProvider::get(const QString &path, const RequestMetrics &metrics, const AbortHook &abortHook)
+{
+    QNetworkRequest request(m_baseUrl.resolved(QUrl(path)));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    QNetworkReply *reply = m_networkManager->get(request);
+    m_buffers->attach(reply);
+    metrics.track(reply);
+    if (abortHook) {
+        abortHook([guard = QPointer<QNetworkReply>(reply)]() {
+            if (guard) {
+                guard->abort();
+            }
+        });
+    }
+    return reply;
+}
+
+/**
+ * @brief Fetches all stations of the network.
+ * @param done Called with the stations.
+ * @param abortHook Called with a function aborting the reply.
+ */
+void GiosProvider::fetchStations(StationsCallback done, const AbortHook &abortHook)
+{
+    static const RequestMetrics metrics("stations");
+    QNetworkReply *reply = get("station/findAll", metrics, abortHook);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, done]() {
+        if (reply->error() != QNetworkReply::NoError) {
+            done({}, reply->errorString());
+        } else {
+            QList<StationRecord> stations;
+            QString error;
+            {
+                HistogramTimer timer(metrics.parse);
+                const PooledBuffer body = m_buffers->take(reply);
+                stations = parseStations(QJsonDocument::fromJson(body.data()).array(), &error);
+            }
+            done(stations, error);
+        }
+        reply->deleteLater();
+    });
+}
+
+/**
+ * @brief Fetches the sensors of a station.
+ * @param stationId Global station ID.
+ * @param done Called with the sensors.
+ * @param abortHook Called with a function aborting the reply.
+ */
+void GiosProvider::fetchSensors(int stationId, SensorsCallback done, const AbortHook &abortHook)
+{
+    static const RequestMetrics metrics("sensors");
+    QNetworkReply *reply = get(QString("station/sensors/%1").arg(localId(stationId)), metrics, abortHook);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, stationId, done]() {
+        if (reply->error() != QNetworkReply::NoError) {
+            done({}, reply->errorString());
+        } else {
+            QList<SensorInfo> sensors;
+            QString error;
+            {
+                HistogramTimer timer(metrics.parse);
+                const PooledBuffer body = m_buffers->take(reply);
+                sensors = parseSensors(QJsonDocument::fromJson(body.data()).array(), stationId, &error);
+            }
+            done(sensors, error);
+        }
+        reply->deleteLater();
+    });
+}
+
+/**
+ * @brief Fetches the recent series of a sensor.
+ * @param sensorId Global sensor ID.
+ * @param done Called with the samples, sorted by timestamp.
+ * @param abortHook Called with a function aborting the reply.
+ */
+void GiosProvider::fetchSeries(int sensorId, SeriesCallback done, const AbortHook &abortHook)
+{
+    static const RequestMetrics metrics("data");
+    QNetworkReply *reply = get(QString("data/getData/%1").arg(localId(sensorId)), metrics, abortHook);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, done]() {
+        if (reply->error() != QNetworkReply::NoError) {
+            done({}, reply->errorString());
+        } else {
+            Series series;
+            {
+                HistogramTimer timer(metrics.parse);
+                const PooledBuffer body = m_buffers->take(reply);
+                series = parseSeries(QJsonDocument::fromJson(body.data()).object()["values"].toArray());
+            }
+            done(series, QString());
+        }
+        reply->deleteLater();
+    });
+}
+
+/**
+ * @brief Parses a stations API reply.
+ * @param stations JSON array of stations.
+ * @param error Receives the error if an ID does not fit a global ID; may be nullptr.
+ * @return Stations with global IDs, empty on error.
+ *
+ * An ID above LocalIdMask would be cut to another station's ID, so the
+ * whole reply is rejected, as LineIngest rejects such a line.
+ */
+QList<StationRecord> GiosProvider::parseStations(const QJsonArray &stations, QString *error) const
+{
+    QList<StationRecord> result;
+    result.reserve(stations.size());
+    for (const QJsonValue &value : stations) {
+        QJsonObject obj = value.toObject();
+        StationRecord station;
+        if (!takeLocalId(obj["id"], station.stationId, error)) {
+            return {};
+        }
+        station.stationId = globalId(station.stationId);
+        station.name = obj["stationName"].toString();
+        station.city = obj["city"].toObject()["name"].toString();
+        station.address = obj["addressStreet"].toString();
+        station.lat = obj["gegrLat"].toString().toDouble();
+        station.lon = obj["gegrLon"].toString().toDouble();
+        result.append(station);
+    }
+    return result;
+}
+
+/**
+ * @brief Parses a sensors API reply.
+ * @param sensors JSON array of sensors.
+ * @param stationId Global station ID used when a sensor does not carry one.
+ * @param error Receives the error if an ID does not fit a global ID; may be nullptr.
+ * @return Sensors with global IDs, empty on error.
+ */
+QList<SensorInfo> GiosProvider::parseSensors(const QJsonArray &sensors, int stationId, QString *error) const
+{
+    QList<SensorInfo> result;
+    result.reserve(sensors.size());
+    for (const QJsonValue &sensorValue : sensors) {
+        QJsonObject obj = sensorValue.toObject();
+        QJsonObject param = obj["param"].toObject();
+        SensorInfo info;
+        if (!takeLocalId(obj["id"], info.sensorId, error)) {
+            return {};
+        }
+        info.sensorId = globalId(info.sensorId);
+        if (!obj.contains("stationId")) {
+            info.stationId = stationId;
+        } else if (takeLocalId(obj["stationId"], info.stationId, error)) {
+            info.stationId = globalId(info.stationId);
+        } else {
+            return {};
+        }
+        info.paramId = param["idParam"].toInt();
+        info.paramCode = param["paramCode"].toString();
+        info.paramFormula = param["paramFormula"].toString();
+        info.paramName = param["paramName"].toString();
+        result.append(info);
+    }
+    return result;
+}
+
+/**
+ * @brief Parses the measurements of a sensor data API reply.
+ * @param values JSON array of measurements, newest first.
+ * @return Series sorted by timestamp.
+ */
+Series GiosProvider::parseSeries(const QJsonArray &values)
+{
+    QVariantList measurements;
+    measurements.reserve(values.size());
+    for (const QJsonValue &value : values) {
+        QJsonObject dataPoint = value.toObject();
+        QVariantMap data;
+        data["date"] = dataPoint["date"].toString();
+        data["value"] = dataPoint["value"].toVariant();
+        measurements.append(data);
+    }
+    return SeriesStore::fromVariantList(measurements);
+}
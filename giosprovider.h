@@ -0,0 +1,111 @@
+/**
+ * @file giosprovider.h
+ * @brief Header file for the GiosProvider class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the provider of the GIOŚ air quality API.
+ */
+
+#ifndef GIOSPROVIDER_H
+#define GIOSPROVIDER_H
+
+#include <QJsonArray>
+#include <QUrl>
+#include "dataprovider.h"
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class ReplyBufferPool;
+struct RequestMetrics;
+
+/**
+ * @class GiosProvider
+ * @brief Stations, sensors and series of the GIOŚ API.
+ */
+class GiosProvider : public DataProvider {
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructs the provider.
+     * @param networkManager Network manager used for the requests.
+     * @param parent Parent QObject.
+     */
+    explicit GiosProvider(QNetworkAccessManager *networkManager, QObject *parent = nullptr);
+
+    /**
+     * @brief Gets the prefix of qualified IDs.
+     * @return "gios".
+     */
+    QString name() const override { return QStringLiteral("gios"); }
+
+    /**
+     * @brief Fetches all stations of the network.
+     * @param done Called with the stations.
+     * @param abortHook Called with a function aborting the reply.
+     */
+    void fetchStations(StationsCallback done, const AbortHook &abortHook = {}) override;
+
+    /**
+     * @brief Fetches the sensors of a station.
+     * @param stationId Global station ID.
+     * @param done Called with the sensors.
+     * @param abortHook Called with a function aborting the reply.
+     */
+    void fetchSensors(int stationId, SensorsCallback done, const AbortHook &abortHook = {}) override;
+
+    /**
+     * @brief Fetches the recent series of a sensor.
+     * @param sensorId Global sensor ID.
+     * @param done Called with the samples, sorted by timestamp.
+     * @param abortHook Called with a function aborting the reply.
+     */
+    void fetchSeries(int sensorId, SeriesCallback done, const AbortHook &abortHook = {}) override;
+
+    /**
+     * @brief Parses a stations API reply.
+     * @param stations JSON array of stations.
+     * @param error Receives the error if an ID does not fit a global ID; may be nullptr.
+     * @return Stations with global IDs, empty on error.
+     */
+    QList<StationRecord> parseStations(const QJsonArray &stations, QString *error = nullptr) const;
+
+    /**
+     * @brief Parses a sensors API reply.
+     * @param sensors JSON array of sensors.
+     * @param stationId Global station ID used when a sensor does not carry one.
+     * @param error Receives the error if an ID does not fit a global ID; may be nullptr.
+     * @return Sensors with global IDs, empty on error.
+     */
+    QList<SensorInfo> parseSensors(const QJsonArray &sensors, int stationId, QString *error = nullptr) const;
+
+    /**
+     * @brief Parses the measurements of a sensor data API reply.
+     * @param values JSON array of measurements, newest first.
+     * @return Series sorted by timestamp.
+     */
+    static Series parseSeries(const QJsonArray &values);
+
+    /**
+     * @brief Sets the API root.
+     * @param url Root URL ending with a slash, e.g. of a local replay server.
+     */
+    void setBaseUrl(const QUrl &url) { m_baseUrl = url; }
+
+private:
+    /**
+     * @brief Sends a GET request to the API.
+     * @param path Path below the API root.
+     * @param metrics Metrics of the endpoint.
+     * @param abortHook Called with a function aborting the reply.
+     * @return Reply whose body streams into a pooled buffer.
+     */
+    QNetworkReply *get(const QString &path, const RequestMetrics &metrics, const AbortHook &abortHook);
+
+    QNetworkAccessManager *m_networkManager;    ///< Sends the requests
+    ReplyBufferPool *m_buffers;                 ///< Receives the reply bodies
+    QUrl m_baseUrl;                             ///< API root
+};
+
+#endif // GIOSPROVIDER_H
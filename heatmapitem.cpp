@@ -0,0 +1,77 @@
+/**
+ * @file heatmapitem.cpp
+ * @brief Implementation of the HeatmapItem class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the painting and hit testing of the heatmap item.
+ */
+
+#include "heatmapitem.h"
+#include "metrics.h"
+#include <QPainter>
+
+/**
+ * @brief Constructs the item.
+ * @param parent Parent item.
+ */
+HeatmapItem::HeatmapItem(QQuickItem *parent)
+    : QQuickPaintedItem(parent)
+{
+    setAntialiasing(false);
+}
+
+/**
+ * @brief Sets the displayed model.
+ * @param model Correlation model.
+ */
+void HeatmapItem::setModel(CorrelationModel *model)
+{
+    if (m_model == model) {
+        return;
+    }
+    if (m_model) {
+        disconnect(m_model, nullptr, this, nullptr);
+    }
+    m_model = model;
+    if (m_model) {
+        connect(m_model, &CorrelationModel::matrixChanged, this, [this]() { update(); });
+    }
+    emit modelChanged();
+    update();
+}
+
+/**
+ * @brief Maps an item position to a matrix cell.
+ * @param x Horizontal position in item coordinates.
+ * @param y Vertical position in item coordinates.
+ * @return Cell as (column, row), (-1, -1) outside the matrix.
+ */
+QPoint HeatmapItem::cellAt(qreal x, qreal y) const
+{
+    const int n = m_model ? m_model->size() : 0;
+    const qreal side = qMin(width(), height());
+    if (n == 0 || x < 0 || y < 0 || x >= side || y >= side) {
+        return QPoint(-1, -1);
+    }
+    return QPoint(int(x * n / side), int(y * n / side));
+}
+
+/**
+ * @brief Paints the heatmap.
+ * @param painter Painter of the item.
+ *
+ * The matrix image is scaled without smoothing, so each cell stays sharp.
+ */
+void HeatmapItem::paint(QPainter *painter)
+{
+    if (!m_model || m_model->size() == 0) {
+        return;
+    }
+    static Histogram *paintTime = Metrics::instance().histogram("airapi_paint_duration_seconds", "Time spent painting an item.",
+                                                                Histogram::frameBuckets(), "item=\"heatmap\"");
+    HistogramTimer timer(paintTime);
+    const qreal side = qMin(width(), height());
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+    painter->drawImage(QRectF(0, 0, side, side), m_model->image());
+}
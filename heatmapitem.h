@@ -0,0 +1,71 @@
+/**
+ * @file heatmapitem.h
+ * @brief Header file for the HeatmapItem class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the QML item drawing a correlation matrix as a heatmap.
+ */
+
+#ifndef HEATMAPITEM_H
+#define HEATMAPITEM_H
+
+#include <QQuickPaintedItem>
+#include <QPointer>
+#include "correlation.h"
+
+/**
+ * @class HeatmapItem
+ * @brief Draws the image of a CorrelationModel scaled to the item size.
+ *
+ * A single painted item replaces one delegate per cell, so a 1000×1000
+ * matrix costs one texture upload instead of a million QML objects.
+ */
+class HeatmapItem : public QQuickPaintedItem {
+    Q_OBJECT
+    Q_PROPERTY(CorrelationModel *model READ model WRITE setModel NOTIFY modelChanged)
+
+public:
+    /**
+     * @brief Constructs the item.
+     * @param parent Parent item.
+     */
+    explicit HeatmapItem(QQuickItem *parent = nullptr);
+
+    /**
+     * @brief Gets the displayed model.
+     * @return Correlation model.
+     */
+    CorrelationModel *model() const { return m_model; }
+
+    /**
+     * @brief Sets the displayed model.
+     * @param model Correlation model.
+     */
+    void setModel(CorrelationModel *model);
+
+    /**
+     * @brief Maps an item position to a matrix cell.
+     * @param x Horizontal position in item coordinates.
+     * @param y Vertical position in item coordinates.
+     * @return Cell as (column, row), (-1, -1) outside the matrix.
+     */
+    Q_INVOKABLE QPoint cellAt(qreal x, qreal y) const;
+
+    /**
+     * @brief Paints the heatmap.
+     * @param painter Painter of the item.
+     */
+    void paint(QPainter *painter) override;
+
+signals:
+    /**
+     * @brief Emitted when the model changes.
+     */
+    void modelChanged();
+
+private:
+    QPointer<CorrelationModel> m_model;     ///< Displayed model
+};
+
+#endif // HEATMAPITEM_H
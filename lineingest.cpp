@@ -0,0 +1,454 @@
+/**
+ * @file lineingest.cpp
+ * @brief Implementation of the LineIngest class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the connection handling, the line parser and the batched
+ * merge of ingested points.
+ */
+
+#include "lineingest.h"
+#include <QDateTime>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+/**
+ * @brief Skips spaces.
+ * @param p Current position, advanced past the spaces.
+ * @param end End of the line.
+ */
+void skipSpaces(const char *&p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        ++p;
+    }
+}
+
+/**
+ * @brief Parses one number field.
+ * @param p Current position, advanced past the field.
+ * @param end End of the line.
+ * @param value Parsed value.
+ * @return True if the field is a number followed by a space or the line end.
+ *
+ * std::from_chars does not depend on the C locale, unlike strtod, which
+ * would expect a decimal comma under a Polish locale.
+ */
+template<typename T>
+bool takeNumber(const char *&p, const char *end, T &value)
+{
+    skipSpaces(p, end);
+    const std::from_chars_result result = std::from_chars(p, end, value);
+    if (result.ec != std::errc() || (result.ptr < end && *result.ptr != ' ' && *result.ptr != '\t')) {
+        return false;
+    }
+    p = result.ptr;
+    return true;
+}
+
+/**
+ * @brief Parses one ID field of the wire protocol.
+ * @param p Current position, advanced past the field.
+ * @param end End of the line.
+ * @param id Parsed ID, local to the endpoint.
+ * @return True if the field is a number that fits a local ID.
+ */
+bool takeLocalId(const char *&p, const char *end, int &id)
+{
+    return takeNumber(p, end, id) && id >= 0 && id <= DataProvider::LocalIdMask;
+}
+
+/**
+ * @brief Checks whether a line starts with a keyword followed by a space.
+ * @param p Start of the line.
+ * @param end End of the line.
+ * @param keyword Keyword.
+ * @return True if it does.
+ */
+bool startsWith(const char *p, const char *end, const char *keyword)
+{
+    const size_t length = std::strlen(keyword);
+    return size_t(end - p) > length && std::memcmp(p, keyword, length) == 0 && p[length] == ' ';
+}
+
+/**
+ * @brief Gets the rest of a line as text.
+ * @param p Current position.
+ * @param end End of the line.
+ * @return Trimmed text.
+ */
+QString restOfLine(const char *p, const char *end)
+{
+    return QString::fromUtf8(p, end - p).trimmed();
+}
+
+} // namespace
+
+/**
+ * @brief Constructs a stopped endpoint.
+ * @param store Series store receiving the points.
+ * @param parent Parent QObject.
+ */
+LineIngest::LineIngest(SeriesStore *store, QObject *parent)
+    : DataProvider(parent),
+    m_store(store)
+{
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FlushIntervalMs);
+    connect(&m_flushTimer, &QTimer::timeout, this, &LineIngest::flush);
+}
+
+/**
+ * @brief Starts listening on the loopback interface.
+ * @param port TCP port, 0 for any free port.
+ * @return True on success.
+ *
+ * Only local processes can connect; sensors reach the application through a
+ * gateway running on the same machine.
+ */
+bool LineIngest::listen(quint16 port)
+{
+    if (!m_server) {
+        m_server = new QTcpServer(this);
+        connect(m_server, &QTcpServer::newConnection, this, &LineIngest::onNewConnection);
+    }
+    m_server->close();
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        m_errorString = m_server->errorString();
+        return false;
+    }
+    m_errorString.clear();
+    return true;
+}
+
+/**
+ * @brief Gets the listening port.
+ * @return Port, 0 if not listening.
+ */
+quint16 LineIngest::serverPort() const
+{
+    return m_server && m_server->isListening() ? m_server->serverPort() : 0;
+}
+
+/**
+ * @brief Reports the declared stations.
+ * @param done Called at once with the stations.
+ * @param abortHook Not called, the answer is immediate.
+ */
+void LineIngest::fetchStations(StationsCallback done, const AbortHook &)
+{
+    QList<StationRecord> stations;
+    stations.reserve(m_stations.size());
+    for (const IngestStation &declared : std::as_const(m_stations)) {
+        StationRecord record;
+        record.stationId = declared.stationId;
+        record.name = declared.name;
+        record.address = "Czujnik własny";
+        record.lat = declared.lat;
+        record.lon = declared.lon;
+        stations.append(record);
+    }
+    done(stations, QString());
+}
+
+/**
+ * @brief Reports the declared sensors of a station.
+ * @param stationId Global station ID.
+ * @param done Called at once with the sensors.
+ * @param abortHook Not called, the answer is immediate.
+ */
+void LineIngest::fetchSensors(int stationId, SensorsCallback done, const AbortHook &)
+{
+    QList<SensorInfo> sensors;
+    for (const SensorInfo &sensor : std::as_const(m_sensors)) {
+        if (sensor.stationId == stationId) {
+            sensors.append(sensor);
+        }
+    }
+    done(sensors, QString());
+}
+
+/**
+ * @brief Reports the ingested series of a sensor.
+ * @param sensorId Global sensor ID.
+ * @param done Called at once with the samples in the store.
+ * @param abortHook Not called, the answer is immediate.
+ *
+ * Points still waiting for a flush are not included.
+ */
+void LineIngest::fetchSeries(int sensorId, SeriesCallback done, const AbortHook &)
+{
+    const Series *series = m_store->find(sensorId);
+    if (series) {
+        done(*series, QString());
+    } else if (m_sensors.contains(sensorId)) {
+        done(Series(), QString());
+    } else {
+        done(Series(), "Nieznany czujnik własny " + QString::number(localId(sensorId)));
+    }
+}
+
+/**
+ * @brief Accepts a new connection.
+ */
+void LineIngest::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        // Ograniczony bufor Qt: wstrzymane czytanie zapełnia okno TCP nadawcy
+        socket->setReadBufferSize(ReadChunk);
+        m_buffers.insert(socket, QByteArray());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { readConnection(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            // Rozłączony nadawca nie czeka na wznowienie, więc czytamy do końca
+            readConnection(socket);
+            while (m_paused) {
+                flush();
+            }
+            QByteArray rest = m_buffers.take(socket);
+            if (!rest.isEmpty()) {
+                // Ostatni wiersz bez znaku końca linii
+                rest.append('\n');
+                parse(rest.constData(), rest.size());
+            }
+            socket->deleteLater();
+        });
+    }
+}
+
+/**
+ * @brief Reads and parses the data of a connection until paused.
+ * @param socket Connection.
+ */
+void LineIngest::readConnection(QTcpSocket *socket)
+{
+    const auto it = m_buffers.find(socket);
+    if (it == m_buffers.end()) {
+        return;
+    }
+    QByteArray &buffer = it.value();
+    while (!m_paused) {
+        buffer.remove(0, parse(buffer.constData(), buffer.size()));
+        if (m_paused) {
+            break;
+        }
+        if (buffer.size() > MaxLineLength) {
+            ++m_rejectedLines;
+            buffer.clear();
+        }
+        const QByteArray chunk = socket->read(ReadChunk);
+        if (chunk.isEmpty()) {
+            break;
+        }
+        buffer.append(chunk);
+    }
+}
+
+/**
+ * @brief Parses complete lines of a buffer.
+ * @param data Buffer.
+ * @param size Buffer size in bytes.
+ * @return Number of bytes consumed; a trailing incomplete line is left,
+ *         as is the rest of the buffer once reading is paused.
+ */
+qsizetype LineIngest::parse(const char *data, qsizetype size)
+{
+    m_now = QDateTime::currentMSecsSinceEpoch();
+    const char *const begin = data;
+    const char *const end = data + size;
+    const char *p = begin;
+    while (p < end && !m_paused) {
+        const char *newline = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)));
+        if (!newline) {
+            break;
+        }
+        const char *lineEnd = newline;
+        if (lineEnd > p && lineEnd[-1] == '\r') {
+            --lineEnd;
+        }
+        if (!parseLine(p, lineEnd)) {
+            ++m_rejectedLines;
+        }
+        p = newline + 1;
+    }
+    if (m_paused) {
+        m_flushTimer.start(0);
+    } else if (m_pendingPoints > 0 && !m_flushTimer.isActive()) {
+        m_flushTimer.start(FlushIntervalMs);
+    }
+    return p - begin;
+}
+
+/**
+ * @brief Parses one line without its terminator.
+ * @param p Start of the line.
+ * @param end End of the line.
+ * @return True if the line was valid.
+ */
+bool LineIngest::parseLine(const char *p, const char *end)
+{
+    skipSpaces(p, end);
+    if (p == end || *p == '#') {
+        return true;
+    }
+    if (startsWith(p, end, "station")) {
+        return parseStation(p + 7, end);
+    }
+    if (startsWith(p, end, "sensor")) {
+        return parseSensor(p + 6, end);
+    }
+
+    int sensorId = 0;
+    double value = 0.0;
+    qint64 timestamp = m_now;
+    if (!takeLocalId(p, end, sensorId) || !takeNumber(p, end, value)) {
+        return false;
+    }
+    skipSpaces(p, end);
+    if (p < end && !takeNumber(p, end, timestamp)) {
+        return false;
+    }
+    skipSpaces(p, end);
+    if (p != end) {
+        return false;
+    }
+
+    // Kolejne punkty zwykle należą do tego samego czujnika
+    sensorId = globalId(sensorId);
+    if (sensorId != m_lastSensorId || !m_lastSeries) {
+        m_lastSeries = &m_pending[sensorId];
+        m_lastSensorId = sensorId;
+    }
+    m_lastSeries->timestamps.append(timestamp);
+    m_lastSeries->values.append(value);
+    ++m_acceptedPoints;
+    if (++m_pendingPoints >= m_maxPendingPoints) {
+        m_paused = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a station declaration.
+ * @param p Start of the fields.
+ * @param end End of the line.
+ * @return True if the line was valid.
+ */
+bool LineIngest::parseStation(const char *p, const char *end)
+{
+    IngestStation station;
+    if (!takeLocalId(p, end, station.stationId) || !takeNumber(p, end, station.lat)
+        || !takeNumber(p, end, station.lon)) {
+        return false;
+    }
+    station.name = restOfLine(p, end);
+    if (station.name.isEmpty() || std::abs(station.lat) > 90.0 || std::abs(station.lon) > 180.0) {
+        return false;
+    }
+
+    station.stationId = globalId(station.stationId);
+    const auto it = m_stations.constFind(station.stationId);
+    if (it != m_stations.cend() && it->name == station.name && it->lat == station.lat && it->lon == station.lon) {
+        return true;
+    }
+    m_stations.insert(station.stationId, station);
+    emit stationDeclared(station);
+    return true;
+}
+
+/**
+ * @brief Parses a sensor declaration.
+ * @param p Start of the fields.
+ * @param end End of the line.
+ * @return True if the line was valid.
+ */
+bool LineIngest::parseSensor(const char *p, const char *end)
+{
+    SensorInfo info;
+    if (!takeLocalId(p, end, info.sensorId) || !takeLocalId(p, end, info.stationId)) {
+        return false;
+    }
+    info.paramCode = restOfLine(p, end);
+    if (info.paramCode.isEmpty()) {
+        return false;
+    }
+    info.paramFormula = info.paramCode;
+    info.paramName = info.paramCode;
+    info.sensorId = globalId(info.sensorId);
+    info.stationId = globalId(info.stationId);
+
+    const auto it = m_sensors.constFind(info.sensorId);
+    if (it != m_sensors.cend() && it->stationId == info.stationId && it->paramCode == info.paramCode) {
+        return true;
+    }
+    m_sensors.insert(info.sensorId, info);
+    emit sensorDeclared(info);
+    return true;
+}
+
+/**
+ * @brief Merges the pending points into the store and resumes reading.
+ *
+ * Points of a sensor usually arrive in order; out-of-order batches are
+ * sorted and repeated timestamps keep the last value before the merge.
+ */
+void LineIngest::flush()
+{
+    m_flushTimer.stop();
+    QList<int> sensorIds;
+    sensorIds.reserve(m_pending.size());
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+        Series &batch = it.value();
+        if (!std::is_sorted(batch.timestamps.cbegin(), batch.timestamps.cend())) {
+            QVector<qsizetype> order(batch.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&batch](qsizetype a, qsizetype b) {
+                return batch.timestamps[a] < batch.timestamps[b];
+            });
+            Series sorted;
+            sorted.timestamps.reserve(batch.size());
+            sorted.values.reserve(batch.size());
+            for (qsizetype i : order) {
+                sorted.timestamps.append(batch.timestamps[i]);
+                sorted.values.append(batch.values[i]);
+            }
+            batch = std::move(sorted);
+        }
+        qsizetype kept = 0;
+        for (qsizetype i = 0; i < batch.size(); ++i) {
+            if (kept > 0 && batch.timestamps[kept - 1] == batch.timestamps[i]) {
+                batch.values[kept - 1] = batch.values[i];
+                continue;
+            }
+            batch.timestamps[kept] = batch.timestamps[i];
+            batch.values[kept] = batch.values[i];
+            ++kept;
+        }
+        batch.timestamps.resize(kept);
+        batch.values.resize(kept);
+        m_store->merge(it.key(), batch);
+        sensorIds.append(it.key());
+    }
+    m_pending.clear();
+    m_lastSensorId = -1;
+    m_lastSeries = nullptr;
+    m_pendingPoints = 0;
+    m_paused = false;
+
+    if (!sensorIds.isEmpty()) {
+        emit sensorsUpdated(sensorIds);
+    }
+
+    // Dane zatrzymane w buforach podczas wstrzymania nie wywołają już readyRead
+    const QList<QTcpSocket *> sockets = m_buffers.keys();
+    for (QTcpSocket *socket : sockets) {
+        readConnection(socket);
+    }
+}
@@ -0,0 +1,252 @@
+/**
+ * @file lineingest.h
+ * @brief Header file for the LineIngest class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the local line protocol endpoint through which our own
+ * sensors push measurements into the series store.
+ */
+
+#ifndef LINEINGEST_H
+#define LINEINGEST_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QTimer>
+#include <algorithm>
+#include "dataprovider.h"
+
+class QTcpServer;
+class QTcpSocket;
+
+/**
+ * @struct IngestStation
+ * @brief Station declared over the line protocol.
+ */
+struct IngestStation {
+    int stationId = 0;  ///< Global station ID
+    QString name;       ///< Station name
+    double lat = 0.0;   ///< Latitude in degrees
+    double lon = 0.0;   ///< Longitude in degrees
+};
+
+/**
+ * @class LineIngest
+ * @brief TCP line protocol endpoint on localhost feeding the series store.
+ *
+ * Every line is one record, fields are separated by spaces:
+ * @code
+ * station <stationId> <lat> <lon> <name>
+ * sensor <sensorId> <stationId> <paramCode>
+ * <sensorId> <value> [<timestamp in ms since epoch>]
+ * @endcode
+ * Lines starting with '#' are comments. A missing timestamp means the time of
+ * arrival. Declarations are expected at the start of every connection.
+ *
+ * The endpoint is the provider of our own sensors: IDs on the wire are local
+ * to it and become global IDs of its registry index, so they never collide
+ * with the IDs of GIOŚ. The provider requests answer from the declarations
+ * and the store without any network traffic.
+ *
+ * Points are parsed without allocations and collected per sensor; a flush
+ * merges each sensor once. When too many points are pending, reading stops
+ * until the next flush, so the socket buffers fill and TCP flow control
+ * slows the senders down instead of memory growing without bound.
+ */
+class LineIngest : public DataProvider {
+    Q_OBJECT
+
+public:
+    static constexpr quint16 DefaultPort = 8095;            ///< Port used when not configured
+    static constexpr int FlushIntervalMs = 250;             ///< Longest delay of a pending point
+    static constexpr int DefaultMaxPendingPoints = 200000;  ///< Pending points that pause reading
+    static constexpr qint64 ReadChunk = 64 * 1024;          ///< Bytes read from a socket at once
+    static constexpr qsizetype MaxLineLength = 1024;        ///< Longer lines are dropped
+
+    /**
+     * @brief Constructs a stopped endpoint.
+     * @param store Series store receiving the points.
+     * @param parent Parent QObject.
+     */
+    explicit LineIngest(SeriesStore *store, QObject *parent = nullptr);
+
+    /**
+     * @brief Starts listening on the loopback interface.
+     * @param port TCP port, 0 for any free port.
+     * @return True on success.
+     */
+    bool listen(quint16 port = DefaultPort);
+
+    /**
+     * @brief Gets the prefix of qualified IDs.
+     * @return "local".
+     */
+    QString name() const override { return QStringLiteral("local"); }
+
+    /**
+     * @brief Reports the declared stations.
+     * @param done Called at once with the stations.
+     * @param abortHook Not called, the answer is immediate.
+     */
+    void fetchStations(StationsCallback done, const AbortHook &abortHook = {}) override;
+
+    /**
+     * @brief Reports the declared sensors of a station.
+     * @param stationId Global station ID.
+     * @param done Called at once with the sensors.
+     * @param abortHook Not called, the answer is immediate.
+     */
+    void fetchSensors(int stationId, SensorsCallback done, const AbortHook &abortHook = {}) override;
+
+    /**
+     * @brief Reports the ingested series of a sensor.
+     * @param sensorId Global sensor ID.
+     * @param done Called at once with the samples in the store.
+     * @param abortHook Not called, the answer is immediate.
+     */
+    void fetchSeries(int sensorId, SeriesCallback done, const AbortHook &abortHook = {}) override;
+
+    /**
+     * @brief Gets the listening port.
+     * @return Port, 0 if not listening.
+     */
+    quint16 serverPort() const;
+
+    /**
+     * @brief Gets the error of the last listen().
+     * @return Error message, empty on success.
+     */
+    QString errorString() const { return m_errorString; }
+
+    /**
+     * @brief Sets the number of pending points that pauses reading.
+     * @param points Point limit, at least 1.
+     */
+    void setMaxPendingPoints(int points) { m_maxPendingPoints = std::max(1, points); }
+
+    /**
+     * @brief Parses complete lines of a buffer.
+     * @param data Buffer.
+     * @param size Buffer size in bytes.
+     * @return Number of bytes consumed; a trailing incomplete line is left,
+     *         as is the rest of the buffer once reading is paused.
+     */
+    qsizetype parse(const char *data, qsizetype size);
+
+    /**
+     * @brief Merges the pending points into the store and resumes reading.
+     */
+    void flush();
+
+    /**
+     * @brief Checks whether reading is paused until the next flush.
+     * @return True if paused.
+     */
+    bool isPaused() const { return m_paused; }
+
+    /**
+     * @brief Gets the number of points waiting for a flush.
+     * @return Point count.
+     */
+    int pendingPoints() const { return m_pendingPoints; }
+
+    /**
+     * @brief Gets the number of accepted points.
+     * @return Point count since construction.
+     */
+    quint64 acceptedPoints() const { return m_acceptedPoints; }
+
+    /**
+     * @brief Gets the number of rejected lines.
+     * @return Line count since construction.
+     */
+    quint64 rejectedLines() const { return m_rejectedLines; }
+
+    /**
+     * @brief Gets the declared stations.
+     * @return Stations by global station ID.
+     */
+    const QHash<int, IngestStation> &stations() const { return m_stations; }
+
+    /**
+     * @brief Gets the declared sensors.
+     * @return Sensors by global sensor ID.
+     */
+    const QHash<int, SensorInfo> &sensors() const { return m_sensors; }
+
+signals:
+    /**
+     * @brief Emitted when a station is declared for the first time or moved.
+     * @param station Station.
+     */
+    void stationDeclared(const IngestStation &station);
+
+    /**
+     * @brief Emitted when a sensor is declared for the first time or changed.
+     * @param sensor Sensor metadata.
+     */
+    void sensorDeclared(const SensorInfo &sensor);
+
+    /**
+     * @brief Emitted once per flush with the sensors that received points.
+     * @param sensorIds Global sensor IDs.
+     */
+    void sensorsUpdated(const QList<int> &sensorIds);
+
+private:
+    /**
+     * @brief Parses one line without its terminator.
+     * @param p Start of the line.
+     * @param end End of the line.
+     * @return True if the line was valid.
+     */
+    bool parseLine(const char *p, const char *end);
+
+    /**
+     * @brief Parses a station declaration.
+     * @param p Start of the fields.
+     * @param end End of the line.
+     * @return True if the line was valid.
+     */
+    bool parseStation(const char *p, const char *end);
+
+    /**
+     * @brief Parses a sensor declaration.
+     * @param p Start of the fields.
+     * @param end End of the line.
+     * @return True if the line was valid.
+     */
+    bool parseSensor(const char *p, const char *end);
+
+    /**
+     * @brief Accepts a new connection.
+     */
+    void onNewConnection();
+
+    /**
+     * @brief Reads and parses the data of a connection until paused.
+     * @param socket Connection.
+     */
+    void readConnection(QTcpSocket *socket);
+
+    SeriesStore *m_store;                       ///< Receives the points
+    QTcpServer *m_server = nullptr;             ///< Listening socket
+    QString m_errorString;                      ///< Error of the last listen()
+    QHash<QTcpSocket *, QByteArray> m_buffers;  ///< Unparsed data by connection
+    QHash<int, Series> m_pending;               ///< Points waiting for a flush by global sensor ID
+    int m_lastSensorId = -1;                    ///< Sensor of m_lastSeries
+    Series *m_lastSeries = nullptr;             ///< Pending series of the previous point
+    int m_pendingPoints = 0;                    ///< Points in m_pending
+    int m_maxPendingPoints = DefaultMaxPendingPoints; ///< Pending points that pause reading
+    bool m_paused = false;                      ///< Reading stopped until the next flush
+    qint64 m_now = 0;                           ///< Arrival time of the parsed buffer
+    quint64 m_acceptedPoints = 0;               ///< Accepted points
+    quint64 m_rejectedLines = 0;                ///< Rejected lines
+    QHash<int, IngestStation> m_stations;       ///< Declared stations
+    QHash<int, SensorInfo> m_sensors;           ///< Declared sensors
+    QTimer m_flushTimer;                        ///< Flushes the pending points
+};
+
+#endif // LINEINGEST_H
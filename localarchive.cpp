@@ -0,0 +1,1230 @@
+/**
+ * @file localarchive.cpp
+ * @brief Implementation of the LocalArchive class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the segment file format, the merge of appended samples,
+ * the incremental maintenance of the rollup pyramid and the log replay.
+ */
+
+#include "localarchive.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QVariantMap>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+/**
+ * @struct SegmentHeader
+ * @brief Header of a segment file.
+ *
+ * The header is followed by count timestamps (qint64) and then by each value
+ * column (count doubles), all in host byte order. A file written on a host
+ * with the other byte order fails the magic check.
+ */
+struct SegmentHeader {
+    quint32 magic;      ///< SegmentMagic
+    quint16 version;    ///< SegmentVersion
+    quint16 columns;    ///< Number of value columns
+    quint32 count;      ///< Number of rows
+    quint32 reserved;   ///< Zero, pads the header to 16 bytes
+};
+
+static_assert(sizeof(SegmentHeader) == 16, "Segment data must stay 8-byte aligned");
+
+constexpr quint32 SegmentMagic = 0x47535141;    ///< "AQSG"
+constexpr quint16 SegmentVersion = 1;           ///< Current format version
+constexpr qint64 HourMs = 3600 * 1000;          ///< One hour in milliseconds
+constexpr qint64 DayMs = 24 * HourMs;           ///< One day in milliseconds
+
+/**
+ * @brief Checks a segment header against the file it was read from.
+ * @param header Segment header.
+ * @param columns Expected number of value columns.
+ * @param fileSize Size of the segment file.
+ * @return True if the header is valid and the file holds all its rows.
+ */
+bool validHeader(const SegmentHeader &header, int columns, qint64 fileSize)
+{
+    const qint64 expected = qint64(sizeof(header)) + qint64(header.count) * 8 * (1 + columns);
+    return header.magic == SegmentMagic && header.version == SegmentVersion
+           && header.columns == columns && fileSize >= expected;
+}
+
+/**
+ * @brief Gets the cutoff of a retention limit.
+ * @param days Age limit in days, 0 for none.
+ * @param now Current time in ms since epoch.
+ * @return Start of the oldest day to keep, or the minimum qint64 for none.
+ */
+qint64 retentionCutoff(int days, qint64 now)
+{
+    if (days <= 0) {
+        return std::numeric_limits<qint64>::min();
+    }
+    return LocalArchive::bucketStart(now - days * DayMs, LocalArchive::Daily);
+}
+
+/**
+ * @brief Gets the start of the bucket following a bucket.
+ * @param start Bucket start.
+ * @param resolution Bucket resolution.
+ * @return Start of the next bucket.
+ */
+qint64 nextBucket(qint64 start, LocalArchive::Resolution resolution)
+{
+    const QDateTime dateTime = QDateTime::fromMSecsSinceEpoch(start);
+    switch (resolution) {
+    case LocalArchive::Daily:
+        return dateTime.addDays(1).toMSecsSinceEpoch();
+    case LocalArchive::Monthly:
+        return dateTime.addMonths(1).toMSecsSinceEpoch();
+    default:
+        return start + HourMs;
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Converts the series to the measurement list format used in QML.
+ * @return List of maps with "date", "value" (the mean), "min", "max" and
+ *         "count", newest first like the API.
+ */
+QVariantList ArchiveSeries::toVariantList() const
+{
+    QVariantList list;
+    list.reserve(size());
+    for (qsizetype i = size() - 1; i >= 0; --i) {
+        QVariantMap data;
+        data["date"] = SeriesStore::formatDate(timestamps[i]);
+        data["value"] = mean[i];
+        data["min"] = min[i];
+        data["max"] = max[i];
+        data["count"] = counts[i];
+        list.append(data);
+    }
+    return list;
+}
+
+/**
+ * @brief Copies the rows into a series.
+ * @return Series with min, max, mean and count of every row.
+ */
+ArchiveSeries ArchiveView::toSeries() const
+{
+    ArchiveSeries result;
+    result.timestamps.reserve(m_size);
+    result.min.reserve(m_size);
+    result.max.reserve(m_size);
+    result.mean.reserve(m_size);
+    result.counts.reserve(m_size);
+    const auto appendRows = [](auto &list, const auto *rows, qsizetype count) {
+        const qsizetype at = list.size();
+        list.resize(at + count);
+        std::copy_n(rows, count, list.begin() + at);
+    };
+    for (const Block &block : m_blocks) {
+        appendRows(result.timestamps, block.timestamps, block.size);
+        if (m_resolution == LocalArchive::Hourly) {
+            appendRows(result.min, block.columns[0], block.size);
+            appendRows(result.max, block.columns[0], block.size);
+            appendRows(result.mean, block.columns[0], block.size);
+            result.counts.insert(result.counts.size(), block.size, 1);
+            continue;
+        }
+        for (qsizetype k = 0; k < block.size; ++k) {
+            const double count = block.columns[LocalArchive::CountColumn][k];
+            result.min.append(block.columns[LocalArchive::MinColumn][k]);
+            result.max.append(block.columns[LocalArchive::MaxColumn][k]);
+            result.mean.append(block.columns[LocalArchive::SumColumn][k] / count);
+            result.counts.append(int(count));
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Appends the part of a block within a window.
+ * @param block Whole block, sorted by timestamp.
+ * @param from Window start in ms since epoch, inclusive.
+ * @param to Window end in ms since epoch, inclusive.
+ * @param owner Keeps the memory of the block alive.
+ * @param mapped True if the block points into a mapped file.
+ */
+void ArchiveView::append(Block block, qint64 from, qint64 to, std::shared_ptr<const void> owner, bool mapped)
+{
+    const qint64 *begin = std::lower_bound(block.timestamps, block.timestamps + block.size, from);
+    const qint64 *end = std::upper_bound(begin, block.timestamps + block.size, to);
+    if (begin == end) {
+        return;
+    }
+    const qsizetype offset = begin - block.timestamps;
+    block.timestamps = begin;
+    block.size = end - begin;
+    for (const double *&column : block.columns) {
+        if (column) {
+            column += offset;
+        }
+    }
+    m_blocks.append(block);
+    m_owners.append(std::move(owner));
+    m_size += block.size;
+    if (mapped) {
+        ++m_mappedBlocks;
+    }
+}
+
+/**
+ * @brief Archives samples of a sensor.
+ * @param sensorId Sensor ID.
+ * @param series Samples sorted by timestamp; NaN values are skipped.
+ * @return Number of new or changed samples, -1 on a write error.
+ *
+ * Segments are written with QSaveFile, which syncs them before the rename.
+ * Once the log outgrows CheckpointBytes, checkpoint() makes the renames
+ * durable and empties the log.
+ */
+int LocalArchive::append(int sensorId, const Series &series)
+{
+    QMutexLocker locker(&m_mutex);
+    return appendLocked(sensorId, series);
+}
+
+/**
+ * @brief Archives historical samples of a sensor, such as a bulk import.
+ * @param sensorId Sensor ID.
+ * @param series Samples sorted by timestamp; NaN values are skipped.
+ * @param rolledUp Receives the number of samples older than the raw
+ *        retention that were archived in the rollups only.
+ * @param expired Receives the number of samples older than every retention
+ *        limit, which were dropped.
+ * @return Number of new or changed raw samples, -1 on a write error.
+ *
+ * The raw samples are archived first, so a month split by the raw cutoff
+ * gets its monthly rollup from all of its days. The rollups of expired days
+ * are not logged: they are derived from the imported samples only, and
+ * importing the same data again repairs them after a crash.
+ */
+int LocalArchive::appendHistory(int sensorId, const Series &series, qint64 *rolledUp, qint64 *expired)
+{
+    QMutexLocker locker(&m_mutex);
+    *rolledUp = 0;
+    *expired = 0;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const qsizetype end = std::lower_bound(series.timestamps.cbegin(), series.timestamps.cend(),
+                                           retentionCutoff(m_retention.hourlyDays, now))
+                          - series.timestamps.cbegin();
+    const int changed = appendLocked(sensorId, series);
+    if (changed < 0 || (end > 0 && !rollUpRows(sensorId, series, end, now, rolledUp, expired))) {
+        return -1;
+    }
+    return changed;
+}
+
+/**
+ * @brief Archives samples; the caller holds the mutex.
+ * @param sensorId Sensor ID.
+ * @param series Samples sorted by timestamp; NaN values are skipped.
+ * @return Number of new or changed samples, -1 on a write error.
+ */
+int LocalArchive::appendLocked(int sensorId, const Series &series)
+{
+    if (!m_recovered && recoverLocked() < 0) {
+        return -1;
+    }
+    const int changed = appendRows(sensorId, series, true);
+    if (changed > 0 && m_wal.size() >= CheckpointBytes && !checkpoint()) {
+        return -1;
+    }
+    return changed;
+}
+
+/**
+ * @brief Replays the write-ahead log left by an interrupted run.
+ * @return Number of replayed records, -1 on a read or write error.
+ */
+int LocalArchive::recover()
+{
+    QMutexLocker locker(&m_mutex);
+    return recoverLocked();
+}
+
+/**
+ * @brief Sets when the write-ahead log is forced to disk.
+ * @param policy Sync policy.
+ * @param intervalMs Sync interval of WriteAheadLog::SyncPeriodic in ms.
+ */
+void LocalArchive::setSyncPolicy(WriteAheadLog::SyncPolicy policy, int intervalMs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_wal.setSyncPolicy(policy, intervalMs);
+}
+
+/**
+ * @brief Gets the sync policy of the write-ahead log.
+ * @return Sync policy.
+ */
+WriteAheadLog::SyncPolicy LocalArchive::syncPolicy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_wal.syncPolicy();
+}
+
+/**
+ * @brief Replays the write-ahead log; the caller holds the mutex.
+ * @return Number of replayed records, -1 on a read or write error.
+ *
+ * Replaying a record that already reached the raw segments rewrites only
+ * the rollups of its days, which the crash may have left stale, so the
+ * whole log is replayed in write order and then emptied.
+ */
+int LocalArchive::recoverLocked()
+{
+    bool ok = false;
+    const QList<QByteArray> records = m_wal.recover(nullptr, &ok);
+    if (!ok) {
+        return -1;
+    }
+    for (const QByteArray &record : records) {
+        int sensorId = 0;
+        Series series;
+        if (decodeRecord(record, &sensorId, &series) && appendRows(sensorId, series, false) < 0) {
+            return -1;
+        }
+    }
+    if (!records.isEmpty() && !checkpoint()) {
+        return -1;
+    }
+    m_recovered = true;
+    return int(records.size());
+}
+
+/**
+ * @brief Empties the log once the segments it restores are durable.
+ * @return True on success.
+ *
+ * The segment files are synced before their rename, but the renames live in
+ * the directories. Unless the policy is WriteAheadLog::SyncNever, every
+ * sensor directory written since the last checkpoint and the archive
+ * directory holding new sensor directories are synced first, so a power
+ * loss cannot drop a segment after the record restoring it is gone.
+ */
+bool LocalArchive::checkpoint()
+{
+    // Dziennik znika dopiero, gdy nowe nazwy segmentów są na dysku
+    if (m_wal.syncPolicy() != WriteAheadLog::SyncNever && !m_unsyncedDirs.isEmpty()) {
+        for (const QString &path : std::as_const(m_unsyncedDirs)) {
+            if (!WriteAheadLog::syncDirectory(path)) {
+                return false;
+            }
+        }
+        if (!WriteAheadLog::syncDirectory(m_rootPath)) {
+            return false;
+        }
+    }
+    m_unsyncedDirs.clear();
+    return m_wal.reset();
+}
+
+/**
+ * @brief Merges samples into the segments; the caller holds the mutex.
+ * @param sensorId Sensor ID.
+ * @param series Samples sorted by timestamp; NaN values are skipped.
+ * @param logged True to record every changed month in the log first.
+ * @return Number of new or changed samples, -1 on a write error.
+ *
+ * Samples are grouped by month. A month whose samples are all already
+ * archived with the same values is neither logged nor rewritten, so
+ * archiving the same window repeatedly costs only the reads. A replayed
+ * record always recomputes the rollups of its days: the raw segment is
+ * renamed before the rollups are written, so a crash in between leaves the
+ * raw values equal and the rollups stale.
+ */
+int LocalArchive::appendRows(int sensorId, const Series &series, bool logged)
+{
+    const qint64 cutoff = retentionCutoff(m_retention.hourlyDays, QDateTime::currentMSecsSinceEpoch());
+    int changed = 0;
+    qsizetype i = std::lower_bound(series.timestamps.cbegin(), series.timestamps.cend(), cutoff)
+                  - series.timestamps.cbegin();
+    while (i < series.size()) {
+        const qint64 month = bucketStart(series.timestamps[i], Monthly);
+        const qint64 monthEnd = nextBucket(month, Monthly);
+
+        Segment rows;
+        rows.columns.resize(1);
+        for (; i < series.size() && series.timestamps[i] < monthEnd; ++i) {
+            if (!std::isnan(series.values[i])) {
+                rows.timestamps.append(series.timestamps[i]);
+                rows.columns[0].append(series.values[i]);
+            }
+        }
+        if (rows.timestamps.isEmpty()) {
+            continue;
+        }
+
+        Segment raw = readRaw(sensorId, month, monthEnd - 1);
+
+        // Zmienione próbki wyznaczają dni do przeliczenia; przy odtwarzaniu wszystkie dni rekordu
+        QVector<qint64> days;
+        int monthChanged = 0;
+        for (qsizetype r = 0; r < rows.timestamps.size(); ++r) {
+            const qint64 t = rows.timestamps[r];
+            const auto it = std::lower_bound(raw.timestamps.cbegin(), raw.timestamps.cend(), t);
+            const bool same = it != raw.timestamps.cend() && *it == t
+                              && raw.columns[0][it - raw.timestamps.cbegin()] == rows.columns[0][r];
+            if (!same) {
+                ++monthChanged;
+            } else if (logged) {
+                continue;
+            }
+            const qint64 day = bucketStart(t, Daily);
+            if (days.isEmpty() || days.last() != day) {
+                days.append(day);
+            }
+        }
+        if (days.isEmpty()) {
+            continue;
+        }
+
+        if (logged && !m_wal.append(encodeRecord(sensorId, rows))) {
+            return -1;
+        }
+
+        // Segment miesiąca ma pierwszeństwo przed spakowanym rokiem
+        if (monthChanged > 0) {
+            const QString path = segmentPath(sensorId, Hourly, month);
+            Segment stored = readSegment(path, 1);
+            mergeRows(stored, rows);
+            if (!writeSegment(path, stored)) {
+                return -1;
+            }
+        }
+        mergeRows(raw, rows);
+        m_unsyncedDirs.insert(sensorPath(sensorId));
+        if (!updateRollups(sensorId, raw, days)) {
+            return -1;
+        }
+        changed += monthChanged;
+    }
+    return changed;
+}
+
+/**
+ * @brief Aggregates samples past the raw retention into the rollups.
+ * @param sensorId Sensor ID.
+ * @param series Samples sorted by timestamp; NaN values are skipped.
+ * @param end Index of the first sample within the raw retention.
+ * @param now Current time in ms since epoch.
+ * @param rolledUp Receives the number of samples kept in a rollup.
+ * @param expired Receives the number of samples past every retention.
+ * @return True on success.
+ *
+ * The samples replace the daily rollups of their days, since the raw data
+ * of those days is gone or about to expire. A month whose days are all kept
+ * is re-aggregated from its daily rollups, an older one from the samples.
+ * Rollups the retention policy would remove are not written.
+ */
+bool LocalArchive::rollUpRows(int sensorId, const Series &series, qsizetype end, qint64 now,
+                              qint64 *rolledUp, qint64 *expired)
+{
+    const qint64 dailyCutoff = retentionCutoff(m_retention.dailyDays, now);
+    const qint64 monthlyCutoff = retentionCutoff(m_retention.monthlyDays, now);
+    qsizetype i = 0;
+    while (i < end) {
+        const qint64 month = bucketStart(series.timestamps[i], Monthly);
+        const qint64 monthEnd = nextBucket(month, Monthly);
+
+        Segment rows;
+        rows.columns.resize(1);
+        QVector<qint64> days;
+        for (; i < end && series.timestamps[i] < monthEnd; ++i) {
+            if (std::isnan(series.values[i])) {
+                continue;
+            }
+            rows.timestamps.append(series.timestamps[i]);
+            rows.columns[0].append(series.values[i]);
+            const qint64 day = bucketStart(series.timestamps[i], Daily);
+            if (days.isEmpty() || days.last() != day) {
+                days.append(day);
+            }
+        }
+        if (rows.timestamps.isEmpty()) {
+            continue;
+        }
+
+        // Dni starsze niż retencja agregatów dziennych przepadają, chyba że zostaje miesiąc
+        const Segment dailyRows = sliceRows(aggregate(rows, Daily, days), dailyCutoff, monthEnd - 1);
+        const bool monthKept = month >= monthlyCutoff;
+        const qsizetype kept = monthKept ? rows.timestamps.size()
+                                         : rows.timestamps.cend()
+                                               - std::lower_bound(rows.timestamps.cbegin(), rows.timestamps.cend(), dailyCutoff);
+        *rolledUp += kept;
+        *expired += rows.timestamps.size() - kept;
+
+        Segment daily;
+        if (!dailyRows.timestamps.isEmpty()) {
+            const QString dailyPath = segmentPath(sensorId, Daily, month);
+            daily = readSegment(dailyPath, RollupColumns);
+            mergeRows(daily, dailyRows);
+            if (!writeSegment(dailyPath, daily)) {
+                return false;
+            }
+        }
+        if (monthKept) {
+            const QString monthlyPath = segmentPath(sensorId, Monthly, month);
+            Segment monthly = readSegment(monthlyPath, RollupColumns);
+            mergeRows(monthly, aggregate(month >= dailyCutoff ? daily : rows, Monthly, {month}));
+            if (!writeSegment(monthlyPath, monthly)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Queries a time window of a sensor without copying rows.
+ * @param sensorId Sensor ID.
+ * @param from Window start in ms since epoch, inclusive.
+ * @param to Window end in ms since epoch, inclusive.
+ * @param resolution Resolution to read.
+ * @return View of the samples or aggregates whose start lies within the
+ *         window, one block per segment file.
+ *
+ * Only the segments overlapping the window are opened, and each is cut by
+ * binary search over its timestamps. Raw months of a year with a packed
+ * segment are merged with it and therefore copied.
+ */
+ArchiveView LocalArchive::series(int sensorId, qint64 from, qint64 to, Resolution resolution) const
+{
+    QMutexLocker locker(&m_mutex);
+    ArchiveView view;
+    view.m_resolution = resolution;
+    if (from > to) {
+        return view;
+    }
+    if (resolution != Hourly) {
+        for (const QString &path : rollupPaths(sensorId, from, to, resolution)) {
+            addSegment(view, path, RollupColumns, from, to);
+        }
+        return view;
+    }
+
+    const QDate first = QDateTime::fromMSecsSinceEpoch(from).date();
+    const QDate last = QDateTime::fromMSecsSinceEpoch(to).date();
+    for (int year : rawYears(sensorId)) {
+        if (year < first.year() || year > last.year()) {
+            continue;
+        }
+        const QDate begin(year, year == first.year() ? first.month() : 1, 1);
+        const QDate end(year, year == last.year() ? last.month() : 12, 1);
+        if (QFile::exists(packPath(sensorId, year))) {
+            const qint64 yearEnd = nextBucket(end.startOfDay().toMSecsSinceEpoch(), Monthly) - 1;
+            addRows(view, readRaw(sensorId, std::max(from, begin.startOfDay().toMSecsSinceEpoch()), std::min(to, yearEnd)), from, to);
+            continue;
+        }
+        for (QDate month = begin; month <= end; month = month.addMonths(1)) {
+            addSegment(view, segmentPath(sensorId, Hourly, month.startOfDay().toMSecsSinceEpoch()), 1, from, to);
+        }
+    }
+    return view;
+}
+
+/**
+ * @brief Reads a time window of a sensor.
+ * @param sensorId Sensor ID.
+ * @param from Window start in ms since epoch, inclusive.
+ * @param to Window end in ms since epoch, inclusive.
+ * @param resolution Resolution to read.
+ * @return Samples or aggregates whose start lies within the window.
+ */
+ArchiveSeries LocalArchive::read(int sensorId, qint64 from, qint64 to, Resolution resolution) const
+{
+    return series(sensorId, from, to, resolution).toSeries();
+}
+
+/**
+ * @brief Gets the IDs of all archived sensors.
+ * @return Sorted list of sensor IDs.
+ */
+QList<int> LocalArchive::sensorIds() const
+{
+    QMutexLocker locker(&m_mutex);
+    QList<int> ids;
+    const QStringList entries = QDir(m_rootPath).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &entry : entries) {
+        bool ok = false;
+        const int id = entry.toInt(&ok);
+        if (ok) {
+            ids.append(id);
+        }
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+/**
+ * @brief Gets the retention policy.
+ * @return Retention policy.
+ */
+RetentionPolicy LocalArchive::retention() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_retention;
+}
+
+/**
+ * @brief Sets the retention policy.
+ * @param policy Retention policy, enforced by applyRetention().
+ */
+void LocalArchive::setRetention(const RetentionPolicy &policy)
+{
+    QMutexLocker locker(&m_mutex);
+    m_retention = policy;
+}
+
+/**
+ * @brief Packs small raw months of closed years into yearly segments.
+ * @param sensorId Sensor ID.
+ * @param now Current time in ms since epoch.
+ * @return Number of month segments removed, -1 on a write error.
+ *
+ * Months still receiving data belong to the current year and are left
+ * alone. Full months stay as they are; only months below SmallSegmentRows
+ * rows, typical of short saved snapshots, are packed.
+ */
+int LocalArchive::compact(int sensorId, qint64 now)
+{
+    QMutexLocker locker(&m_mutex);
+    const int currentYear = QDateTime::fromMSecsSinceEpoch(now).date().year();
+    const QDir dir(sensorPath(sensorId));
+    const QStringList names = dir.entryList(QStringList() << "raw-??????.seg", QDir::Files, QDir::Name);
+
+    QMap<int, QStringList> small;
+    for (const QString &name : names) {
+        const int year = name.mid(4, 4).toInt();
+        if (year >= currentYear) {
+            continue;
+        }
+        const QString path = dir.filePath(name);
+        if (readSegment(path, 1).timestamps.size() < SmallSegmentRows) {
+            small[year].append(path);
+        }
+    }
+
+    int removed = 0;
+    for (auto it = small.cbegin(); it != small.cend(); ++it) {
+        const QString pack = packPath(sensorId, it.key());
+        Segment packed = readSegment(pack, 1);
+        for (const QString &path : it.value()) {
+            mergeRows(packed, readSegment(path, 1));
+        }
+        if (!writeSegment(pack, packed)) {
+            return -1;
+        }
+        for (const QString &path : it.value()) {
+            QFile::remove(path);
+            ++removed;
+        }
+    }
+    return removed;
+}
+
+/**
+ * @brief Removes data older than the retention policy allows.
+ * @param sensorId Sensor ID.
+ * @param now Current time in ms since epoch.
+ * @return Number of removed rows, -1 on a write error.
+ *
+ * Cutoffs are aligned to day starts, so a day is either fully kept or fully
+ * removed at every resolution.
+ */
+qint64 LocalArchive::applyRetention(int sensorId, qint64 now)
+{
+    QMutexLocker locker(&m_mutex);
+    const QDir dir(sensorPath(sensorId));
+    const struct {
+        const char *pattern;
+        int columns;
+        int days;
+    } rules[] = {
+        {"raw-*.seg", 1, m_retention.hourlyDays},
+        {"daily-*.seg", RollupColumns, m_retention.dailyDays},
+        {"monthly.seg", RollupColumns, m_retention.monthlyDays},
+    };
+
+    qint64 removed = 0;
+    for (const auto &rule : rules) {
+        if (rule.days <= 0) {
+            continue;
+        }
+        const qint64 cutoff = retentionCutoff(rule.days, now);
+        const QStringList names = dir.entryList(QStringList() << rule.pattern, QDir::Files);
+        for (const QString &name : names) {
+            const qint64 count = expireRows(dir.filePath(name), rule.columns, cutoff);
+            if (count < 0) {
+                return -1;
+            }
+            removed += count;
+        }
+    }
+    return removed;
+}
+
+/**
+ * @brief Recomputes the rollups of all raw data of a sensor.
+ * @param sensorId Sensor ID.
+ * @return True on success.
+ *
+ * Rollups are recomputed month by month for the days present in the raw
+ * segments, so days whose raw data already expired keep their rollups.
+ */
+bool LocalArchive::rebuildRollups(int sensorId)
+{
+    QMutexLocker locker(&m_mutex);
+    const QList<int> years = rawYears(sensorId);
+    if (years.isEmpty()) {
+        return true;
+    }
+
+    for (QDate month(years.first(), 1, 1); month.year() <= years.last(); month = month.addMonths(1)) {
+        const qint64 start = month.startOfDay().toMSecsSinceEpoch();
+        const Segment raw = readRaw(sensorId, start, nextBucket(start, Monthly) - 1);
+        QVector<qint64> days;
+        for (const qint64 t : raw.timestamps) {
+            const qint64 day = bucketStart(t, Daily);
+            if (days.isEmpty() || days.last() != day) {
+                days.append(day);
+            }
+        }
+        if (!days.isEmpty() && !updateRollups(sensorId, raw, days)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Picks the finest resolution that fits a chart.
+ * @param from Window start in ms since epoch.
+ * @param to Window end in ms since epoch.
+ * @param pixels Width of the chart in pixels.
+ * @return Hourly if every hour gets a pixel, otherwise Daily if every day
+ *         does, otherwise Monthly.
+ */
+LocalArchive::Resolution LocalArchive::chooseResolution(qint64 from, qint64 to, int pixels)
+{
+    const qint64 hours = std::max<qint64>(0, to - from) / HourMs;
+    pixels = std::max(1, pixels);
+    if (hours <= pixels) {
+        return Hourly;
+    }
+    if (hours / 24 <= pixels) {
+        return Daily;
+    }
+    return Monthly;
+}
+
+/**
+ * @brief Gets the start of the bucket containing a timestamp.
+ * @param timestamp Milliseconds since epoch.
+ * @param resolution Bucket resolution.
+ * @return Bucket start in local time; the timestamp itself for Hourly.
+ */
+qint64 LocalArchive::bucketStart(qint64 timestamp, Resolution resolution)
+{
+    if (resolution == Hourly) {
+        return timestamp;
+    }
+    const QDate date = QDateTime::fromMSecsSinceEpoch(timestamp).date();
+    const QDate start = resolution == Daily ? date : QDate(date.year(), date.month(), 1);
+    return start.startOfDay().toMSecsSinceEpoch();
+}
+
+/**
+ * @brief Encodes a log record of appended raw rows.
+ * @param sensorId Sensor ID.
+ * @param rows Raw rows of one month.
+ * @return Record payload.
+ *
+ * The payload holds the sensor ID (qint32), the row count (quint32), the
+ * timestamps and the values, in host byte order like the segments.
+ */
+QByteArray LocalArchive::encodeRecord(int sensorId, const Segment &rows)
+{
+    const qint32 id = sensorId;
+    const quint32 count = quint32(rows.timestamps.size());
+    QByteArray record;
+    record.reserve(8 + count * (sizeof(qint64) + sizeof(double)));
+    record.append(reinterpret_cast<const char *>(&id), sizeof(id));
+    record.append(reinterpret_cast<const char *>(&count), sizeof(count));
+    record.append(reinterpret_cast<const char *>(rows.timestamps.constData()), count * sizeof(qint64));
+    record.append(reinterpret_cast<const char *>(rows.columns[0].constData()), count * sizeof(double));
+    return record;
+}
+
+/**
+ * @brief Decodes a log record of appended raw rows.
+ * @param record Record payload.
+ * @param sensorId Receives the sensor ID.
+ * @param series Receives the rows.
+ * @return False if the record is malformed.
+ */
+bool LocalArchive::decodeRecord(const QByteArray &record, int *sensorId, Series *series)
+{
+    qint32 id = 0;
+    quint32 count = 0;
+    if (record.size() < 8) {
+        return false;
+    }
+    std::memcpy(&id, record.constData(), sizeof(id));
+    std::memcpy(&count, record.constData() + 4, sizeof(count));
+    if (quint64(record.size()) != 8 + quint64(count) * (sizeof(qint64) + sizeof(double))) {
+        return false;
+    }
+
+    *sensorId = id;
+    series->timestamps.resize(count);
+    series->values.resize(count);
+    std::memcpy(series->timestamps.data(), record.constData() + 8, count * sizeof(qint64));
+    std::memcpy(series->values.data(), record.constData() + 8 + count * sizeof(qint64), count * sizeof(double));
+    return true;
+}
+
+/**
+ * @brief Gets the directory of a sensor.
+ * @param sensorId Sensor ID.
+ * @return Directory path.
+ */
+QString LocalArchive::sensorPath(int sensorId) const
+{
+    return m_rootPath + "/" + QString::number(sensorId);
+}
+
+/**
+ * @brief Gets the segment file holding a timestamp.
+ * @param sensorId Sensor ID.
+ * @param resolution Segment resolution.
+ * @param timestamp Milliseconds since epoch.
+ * @return File path.
+ */
+QString LocalArchive::segmentPath(int sensorId, Resolution resolution, qint64 timestamp) const
+{
+    const QDate date = QDateTime::fromMSecsSinceEpoch(timestamp).date();
+    switch (resolution) {
+    case Hourly:
+        return sensorPath(sensorId) + "/raw-" + date.toString("yyyyMM") + ".seg";
+    case Daily:
+        return sensorPath(sensorId) + "/daily-" + date.toString("yyyy") + ".seg";
+    default:
+        return sensorPath(sensorId) + "/monthly.seg";
+    }
+}
+
+/**
+ * @brief Gets the packed raw segment of a year.
+ * @param sensorId Sensor ID.
+ * @param year Year.
+ * @return File path.
+ */
+QString LocalArchive::packPath(int sensorId, int year) const
+{
+    return sensorPath(sensorId) + "/raw-" + QString::number(year) + ".seg";
+}
+
+/**
+ * @brief Gets the rollup segment files overlapping a window, in time order.
+ * @param sensorId Sensor ID.
+ * @param from Window start in ms since epoch.
+ * @param to Window end in ms since epoch.
+ * @param resolution Daily or Monthly.
+ * @return File paths.
+ */
+QStringList LocalArchive::rollupPaths(int sensorId, qint64 from, qint64 to, Resolution resolution) const
+{
+    QStringList paths;
+    if (from > to) {
+        return paths;
+    }
+    if (resolution == Monthly) {
+        paths.append(segmentPath(sensorId, Monthly, from));
+        return paths;
+    }
+
+    const int first = QDateTime::fromMSecsSinceEpoch(from).date().year();
+    const int last = QDateTime::fromMSecsSinceEpoch(to).date().year();
+    for (int year = first; year <= last; ++year) {
+        paths.append(segmentPath(sensorId, Daily, QDate(year, 1, 1).startOfDay().toMSecsSinceEpoch()));
+    }
+    return paths;
+}
+
+/**
+ * @brief Reads raw rows of a window from month and packed segments.
+ * @param sensorId Sensor ID.
+ * @param from Window start in ms since epoch, inclusive.
+ * @param to Window end in ms since epoch, inclusive.
+ * @return Raw rows; month segments take precedence over packed rows.
+ *
+ * Month segments of a packed year are written after the last compaction,
+ * so their rows are the newer ones.
+ */
+LocalArchive::Segment LocalArchive::readRaw(int sensorId, qint64 from, qint64 to) const
+{
+    Segment result;
+    result.columns.resize(1);
+    if (from > to) {
+        return result;
+    }
+
+    const QDate first = QDateTime::fromMSecsSinceEpoch(from).date();
+    const QDate last = QDateTime::fromMSecsSinceEpoch(to).date();
+    for (int year = first.year(); year <= last.year(); ++year) {
+        Segment rows = sliceRows(readSegment(packPath(sensorId, year), 1), from, to);
+        const QDate begin(year, year == first.year() ? first.month() : 1, 1);
+        const QDate end(year, year == last.year() ? last.month() : 12, 1);
+        for (QDate month = begin; month <= end; month = month.addMonths(1)) {
+            const QString path = segmentPath(sensorId, Hourly, month.startOfDay().toMSecsSinceEpoch());
+            mergeRows(rows, sliceRows(readSegment(path, 1), from, to));
+        }
+        result.timestamps.append(rows.timestamps);
+        result.columns[0].append(rows.columns[0]);
+    }
+    return result;
+}
+
+/**
+ * @brief Gets the years having raw segments.
+ * @param sensorId Sensor ID.
+ * @return Sorted years.
+ */
+QList<int> LocalArchive::rawYears(int sensorId) const
+{
+    QList<int> years;
+    const QStringList names = QDir(sensorPath(sensorId)).entryList(QStringList() << "raw-*.seg", QDir::Files, QDir::Name);
+    for (const QString &name : names) {
+        const int year = name.mid(4, 4).toInt();
+        if (year > 0 && !years.contains(year)) {
+            years.append(year);
+        }
+    }
+    std::sort(years.begin(), years.end());
+    return years;
+}
+
+/**
+ * @brief Reads a segment file.
+ * @param path File path.
+ * @param columns Expected number of value columns.
+ * @return Segment, empty if the file is missing or invalid.
+ */
+LocalArchive::Segment LocalArchive::readSegment(const QString &path, int columns)
+{
+    Segment segment;
+    segment.columns.resize(columns);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return segment;
+    }
+    const QByteArray data = file.readAll();
+    if (data.size() < qsizetype(sizeof(SegmentHeader))) {
+        return segment;
+    }
+
+    SegmentHeader header;
+    std::memcpy(&header, data.constData(), sizeof(header));
+    if (!validHeader(header, columns, data.size())) {
+        return segment;
+    }
+
+    const char *cursor = data.constData() + sizeof(header);
+    segment.timestamps.resize(header.count);
+    std::memcpy(segment.timestamps.data(), cursor, header.count * sizeof(qint64));
+    cursor += header.count * sizeof(qint64);
+    for (QVector<double> &column : segment.columns) {
+        column.resize(header.count);
+        std::memcpy(column.data(), cursor, header.count * sizeof(double));
+        cursor += header.count * sizeof(double);
+    }
+    return segment;
+}
+
+/**
+ * @brief Adds the rows of a segment file within a window to a view.
+ * @param view Target view.
+ * @param path Segment file.
+ * @param columns Expected number of value columns.
+ * @param from Window start in ms since epoch, inclusive.
+ * @param to Window end in ms since epoch, inclusive.
+ *
+ * The file is memory mapped and the block points into the mapping. Segments
+ * are only ever replaced by a rename, which leaves a live mapping intact.
+ * Windows refuses to replace a mapped file, so there the rows are copied.
+ */
+void LocalArchive::addSegment(ArchiveView &view, const QString &path, int columns, qint64 from, qint64 to)
+{
+#ifndef Q_OS_WIN
+    auto file = std::make_shared<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const qint64 size = file->size();
+    const uchar *data = size >= qint64(sizeof(SegmentHeader)) ? file->map(0, size) : nullptr;
+    if (data) {
+        SegmentHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (!validHeader(header, columns, size)) {
+            return;
+        }
+        // Mapowanie zaczyna się na granicy strony, a nagłówek ma 16 bajtów
+        ArchiveView::Block block;
+        block.timestamps = reinterpret_cast<const qint64 *>(data + sizeof(header));
+        for (int c = 0; c < columns; ++c) {
+            block.columns[c] = reinterpret_cast<const double *>(data + sizeof(header)) + qsizetype(header.count) * (1 + c);
+        }
+        block.size = header.count;
+        view.append(block, from, to, std::move(file), true);
+        return;
+    }
+#endif
+    addRows(view, readSegment(path, columns), from, to);
+}
+
+/**
+ * @brief Adds rows held in memory to a view.
+ * @param view Target view.
+ * @param segment Rows, moved into the view.
+ * @param from Window start in ms since epoch, inclusive.
+ * @param to Window end in ms since epoch, inclusive.
+ */
+void LocalArchive::addRows(ArchiveView &view, Segment segment, qint64 from, qint64 to)
+{
+    if (segment.timestamps.isEmpty()) {
+        return;
+    }
+    const auto rows = std::make_shared<const Segment>(std::move(segment));
+    ArchiveView::Block block;
+    block.timestamps = rows->timestamps.constData();
+    for (qsizetype c = 0; c < rows->columns.size(); ++c) {
+        block.columns[c] = rows->columns[c].constData();
+    }
+    block.size = rows->timestamps.size();
+    view.append(block, from, to, rows, false);
+}
+
+/**
+ * @brief Cuts a time window out of a segment.
+ * @param segment Source segment.
+ * @param from Window start in ms since epoch, inclusive.
+ * @param to Window end in ms since epoch, inclusive.
+ * @return Rows within the window.
+ */
+LocalArchive::Segment LocalArchive::sliceRows(const Segment &segment, qint64 from, qint64 to)
+{
+    const auto begin = std::lower_bound(segment.timestamps.cbegin(), segment.timestamps.cend(), from);
+    const auto end = std::upper_bound(begin, segment.timestamps.cend(), to);
+    const qsizetype first = begin - segment.timestamps.cbegin();
+    const qsizetype count = end - begin;
+    if (first == 0 && count == segment.timestamps.size()) {
+        return segment;
+    }
+
+    Segment result;
+    result.timestamps = segment.timestamps.mid(first, count);
+    for (const QVector<double> &column : segment.columns) {
+        result.columns.append(column.mid(first, count));
+    }
+    return result;
+}
+
+/**
+ * @brief Drops rows older than a cutoff and rewrites or removes the file.
+ * @param path Segment file.
+ * @param columns Number of value columns.
+ * @param cutoff Oldest timestamp to keep.
+ * @return Number of removed rows, -1 on a write error.
+ */
+qint64 LocalArchive::expireRows(const QString &path, int columns, qint64 cutoff)
+{
+    const Segment segment = readSegment(path, columns);
+    const Segment kept = sliceRows(segment, cutoff, std::numeric_limits<qint64>::max());
+    const qint64 removed = segment.timestamps.size() - kept.timestamps.size();
+    if (removed == 0) {
+        return 0;
+    }
+    if (kept.timestamps.isEmpty()) {
+        return QFile::remove(path) ? removed : -1;
+    }
+    return writeSegment(path, kept) ? removed : -1;
+}
+
+/**
+ * @brief Writes a segment file atomically.
+ * @param path File path.
+ * @param segment Segment to write.
+ * @return True on success.
+ *
+ * The file is written next to the target and renamed over it, so a reader
+ * sees either the old or the new segment.
+ */
+bool LocalArchive::writeSegment(const QString &path, const Segment &segment)
+{
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        return false;
+    }
+
+    SegmentHeader header;
+    header.magic = SegmentMagic;
+    header.version = SegmentVersion;
+    header.columns = quint16(segment.columns.size());
+    header.count = quint32(segment.timestamps.size());
+    header.reserved = 0;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(segment.timestamps.constData()),
+               segment.timestamps.size() * sizeof(qint64));
+    for (const QVector<double> &column : segment.columns) {
+        file.write(reinterpret_cast<const char *>(column.constData()), column.size() * sizeof(double));
+    }
+    return file.commit();
+}
+
+/**
+ * @brief Replaces or inserts rows of a segment.
+ * @param segment Target segment.
+ * @param rows Rows to merge, sorted by timestamp, with the same columns.
+ *
+ * Both inputs are sorted, so the merge is a single linear pass.
+ */
+void LocalArchive::mergeRows(Segment &segment, const Segment &rows)
+{
+    if (rows.timestamps.isEmpty()) {
+        return;
+    }
+    if (segment.timestamps.isEmpty()) {
+        segment = rows;
+        return;
+    }
+
+    const qsizetype columns = segment.columns.size();
+    Segment merged;
+    merged.timestamps.reserve(segment.timestamps.size() + rows.timestamps.size());
+    merged.columns.resize(columns);
+
+    qsizetype i = 0;
+    qsizetype j = 0;
+    while (i < segment.timestamps.size() || j < rows.timestamps.size()) {
+        const bool takeOld = j >= rows.timestamps.size()
+                             || (i < segment.timestamps.size() && segment.timestamps[i] < rows.timestamps[j]);
+        if (takeOld) {
+            merged.timestamps.append(segment.timestamps[i]);
+            for (qsizetype c = 0; c < columns; ++c) {
+                merged.columns[c].append(segment.columns[c][i]);
+            }
+            ++i;
+        } else {
+            // Nowy wiersz zastępuje zapisany o tym samym czasie
+            if (i < segment.timestamps.size() && segment.timestamps[i] == rows.timestamps[j]) {
+                ++i;
+            }
+            merged.timestamps.append(rows.timestamps[j]);
+            for (qsizetype c = 0; c < columns; ++c) {
+                merged.columns[c].append(rows.columns[c][j]);
+            }
+            ++j;
+        }
+    }
+    segment = std::move(merged);
+}
+
+/**
+ * @brief Aggregates rows of a segment into buckets.
+ * @param source Raw segment (one column) or rollup segment.
+ * @param resolution Resolution of the buckets.
+ * @param buckets Bucket starts to compute, sorted.
+ * @return Rollup rows of the non-empty buckets.
+ *
+ * Rollups of rollups combine min, max, sum and count, so a month is built
+ * from its days without touching the raw samples.
+ */
+LocalArchive::Segment LocalArchive::aggregate(const Segment &source, Resolution resolution, const QVector<qint64> &buckets)
+{
+    Segment result;
+    result.columns.resize(RollupColumns);
+    const bool raw = source.columns.size() == 1;
+
+    for (const qint64 bucket : buckets) {
+        const qint64 end = nextBucket(bucket, resolution);
+        const auto first = std::lower_bound(source.timestamps.cbegin(), source.timestamps.cend(), bucket);
+        const auto last = std::lower_bound(first, source.timestamps.cend(), end);
+
+        double min = std::numeric_limits<double>::infinity();
+        double max = -std::numeric_limits<double>::infinity();
+        double sum = 0.0;
+        double count = 0.0;
+        for (qsizetype k = first - source.timestamps.cbegin(); k < last - source.timestamps.cbegin(); ++k) {
+            if (raw) {
+                const double value = source.columns[0][k];
+                min = std::min(min, value);
+                max = std::max(max, value);
+                sum += value;
+                count += 1.0;
+            } else {
+                min = std::min(min, source.columns[MinColumn][k]);
+                max = std::max(max, source.columns[MaxColumn][k]);
+                sum += source.columns[SumColumn][k];
+                count += source.columns[CountColumn][k];
+            }
+        }
+        if (count == 0.0) {
+            continue;
+        }
+        result.timestamps.append(bucket);
+        result.columns[MinColumn].append(min);
+        result.columns[MaxColumn].append(max);
+        result.columns[SumColumn].append(sum);
+        result.columns[CountColumn].append(count);
+    }
+    return result;
+}
+
+/**
+ * @brief Recomputes rollups of days touched by an append.
+ * @param sensorId Sensor ID.
+ * @param raw Updated raw segment of one month.
+ * @param days Touched day starts, sorted.
+ * @return True on success.
+ *
+ * The touched days are re-aggregated from the raw month, and the month is
+ * then re-aggregated from its daily rollups.
+ */
+bool LocalArchive::updateRollups(int sensorId, const Segment &raw, const QVector<qint64> &days)
+{
+    const QString dailyPath = segmentPath(sensorId, Daily, days.first());
+    Segment daily = readSegment(dailyPath, RollupColumns);
+    mergeRows(daily, aggregate(raw, Daily, days));
+    if (!writeSegment(dailyPath, daily)) {
+        return false;
+    }
+
+    const qint64 month = bucketStart(days.first(), Monthly);
+    const QString monthlyPath = segmentPath(sensorId, Monthly, month);
+    Segment monthly = readSegment(monthlyPath, RollupColumns);
+    mergeRows(monthly, aggregate(daily, Monthly, {month}));
+    return writeSegment(monthlyPath, monthly);
+}
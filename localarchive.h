@@ -0,0 +1,556 @@
+/**
+ * @file localarchive.h
+ * @brief Header file for the LocalArchive class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the on-disk archive of sensor measurements: raw hourly
+ * segments per month and a pyramid of daily and monthly rollups maintained as
+ * data is archived, with a write-ahead log for crash safety.
+ */
+
+#ifndef LOCALARCHIVE_H
+#define LOCALARCHIVE_H
+
+#include <QList>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QVariantList>
+#include <QVector>
+#include <memory>
+#include "seriesstore.h"
+#include "writeaheadlog.h"
+
+/**
+ * @struct ArchiveSeries
+ * @brief Series read from the archive at some resolution.
+ *
+ * At hourly resolution min, max and mean are the raw value and every count
+ * is 1. At coarser resolutions every sample aggregates one day or month.
+ */
+struct ArchiveSeries {
+    QVector<qint64> timestamps; ///< Sample or bucket start times, ascending
+    QVector<double> min;        ///< Minimum of each bucket
+    QVector<double> max;        ///< Maximum of each bucket
+    QVector<double> mean;       ///< Mean of each bucket
+    QVector<int> counts;        ///< Number of hourly samples in each bucket
+
+    /**
+     * @brief Gets the number of samples.
+     * @return Sample count.
+     */
+    qsizetype size() const { return timestamps.size(); }
+
+    /**
+     * @brief Checks whether the series has no samples.
+     * @return True if empty.
+     */
+    bool isEmpty() const { return timestamps.isEmpty(); }
+
+    /**
+     * @brief Converts the series to the measurement list format used in QML.
+     * @return List of maps with "date", "value" (the mean), "min", "max" and
+     *         "count", newest first like the API.
+     */
+    QVariantList toVariantList() const;
+};
+
+class ArchiveView;
+
+/**
+ * @struct RetentionPolicy
+ * @brief Maximum age of archived data per resolution.
+ *
+ * An age of 0 keeps the data forever. Raw data can expire early because the
+ * rollups keep long-range views available.
+ */
+struct RetentionPolicy {
+    int hourlyDays = 0;     ///< Age limit of raw hourly samples in days
+    int dailyDays = 0;      ///< Age limit of daily rollups in days
+    int monthlyDays = 0;    ///< Age limit of monthly rollups in days
+};
+
+/**
+ * @class LocalArchive
+ * @brief Archive of sensor series in binary segment files.
+ *
+ * Every sensor has its own directory holding:
+ * - raw-YYYYMM.seg: hourly values of one month,
+ * - raw-YYYY.seg: hourly values of small months of a closed year, packed by
+ *   compact(),
+ * - daily-YYYY.seg: daily min/max/sum/count of one year,
+ * - monthly.seg: monthly min/max/sum/count.
+ *
+ * Appending merges the samples into the raw segments and recomputes only the
+ * days and months they touch, so the rollups never need a full rebuild.
+ * Every appended month is first recorded in archive.wal; after a crash,
+ * recover() replays the log, so a month whose raw segment and rollups were
+ * written only in part is completed.
+ * All operations are serialized by a mutex, so the archive can be maintained
+ * on a worker thread while the GUI thread appends.
+ */
+class LocalArchive {
+public:
+    /**
+     * @brief Resolution of archived data.
+     */
+    enum Resolution {
+        Hourly,     ///< Raw samples
+        Daily,      ///< One aggregate per calendar day
+        Monthly     ///< One aggregate per calendar month
+    };
+
+    /**
+     * @brief Constructs an archive rooted at a directory.
+     * @param rootPath Archive directory, created on the first append.
+     */
+    explicit LocalArchive(const QString &rootPath = "archive")
+        : m_rootPath(rootPath), m_wal(rootPath + "/archive.wal") {}
+
+    static constexpr int SmallSegmentRows = 24 * 7;     ///< Raw months below this size are packed
+    static constexpr qint64 CheckpointBytes = 1 << 20;  ///< Log size that triggers a checkpoint
+
+    /**
+     * @brief Gets the archive directory.
+     * @return Directory path.
+     */
+    QString rootPath() const { return m_rootPath; }
+
+    /**
+     * @brief Replays the write-ahead log left by an interrupted run.
+     * @return Number of replayed records, -1 on a read or write error.
+     *
+     * Called once when the archive is opened; append() calls it itself if
+     * it was not called yet.
+     */
+    int recover();
+
+    /**
+     * @brief Sets when the write-ahead log is forced to disk.
+     * @param policy Sync policy.
+     * @param intervalMs Sync interval of WriteAheadLog::SyncPeriodic in ms.
+     */
+    void setSyncPolicy(WriteAheadLog::SyncPolicy policy, int intervalMs = 1000);
+
+    /**
+     * @brief Gets the sync policy of the write-ahead log.
+     * @return Sync policy.
+     */
+    WriteAheadLog::SyncPolicy syncPolicy() const;
+
+    /**
+     * @brief Archives samples of a sensor.
+     * @param sensorId Sensor ID.
+     * @param series Samples sorted by timestamp; NaN values are skipped.
+     * @return Number of new or changed samples, -1 on a write error.
+     *
+     * Samples with an archived timestamp replace the archived value. Samples
+     * older than the raw retention are skipped, so a day is never aggregated
+     * from a partly expired month.
+     */
+    int append(int sensorId, const Series &series);
+
+    /**
+     * @brief Archives historical samples of a sensor, such as a bulk import.
+     * @param sensorId Sensor ID.
+     * @param series Samples sorted by timestamp; NaN values are skipped.
+     * @param rolledUp Receives the number of samples older than the raw
+     *        retention that were archived in the rollups only.
+     * @param expired Receives the number of samples older than every
+     *        retention limit, which were dropped.
+     * @return Number of new or changed raw samples, -1 on a write error.
+     *
+     * Samples within the raw retention are archived like append() does.
+     * Older samples replace the daily and monthly rollups of their days
+     * instead of being skipped.
+     */
+    int appendHistory(int sensorId, const Series &series, qint64 *rolledUp, qint64 *expired);
+
+    /**
+     * @brief Queries a time window of a sensor without copying rows.
+     * @param sensorId Sensor ID.
+     * @param from Window start in ms since epoch, inclusive.
+     * @param to Window end in ms since epoch, inclusive.
+     * @param resolution Resolution to read.
+     * @return View of the samples or aggregates whose start lies within the
+     *         window, one block per segment file.
+     */
+    ArchiveView series(int sensorId, qint64 from, qint64 to, Resolution resolution) const;
+
+    /**
+     * @brief Reads a time window of a sensor.
+     * @param sensorId Sensor ID.
+     * @param from Window start in ms since epoch, inclusive.
+     * @param to Window end in ms since epoch, inclusive.
+     * @param resolution Resolution to read.
+     * @return Samples or aggregates whose start lies within the window.
+     */
+    ArchiveSeries read(int sensorId, qint64 from, qint64 to, Resolution resolution) const;
+
+    /**
+     * @brief Gets the IDs of all archived sensors.
+     * @return Sorted list of sensor IDs.
+     */
+    QList<int> sensorIds() const;
+
+    /**
+     * @brief Gets the retention policy.
+     * @return Retention policy.
+     */
+    RetentionPolicy retention() const;
+
+    /**
+     * @brief Sets the retention policy.
+     * @param policy Retention policy, enforced by applyRetention().
+     */
+    void setRetention(const RetentionPolicy &policy);
+
+    /**
+     * @brief Packs small raw months of closed years into yearly segments.
+     * @param sensorId Sensor ID.
+     * @param now Current time in ms since epoch.
+     * @return Number of month segments removed, -1 on a write error.
+     *
+     * The yearly segment is written before the month segments are removed,
+     * so an interrupted compaction leaves duplicate rows at worst, which
+     * reads merge transparently.
+     */
+    int compact(int sensorId, qint64 now);
+
+    /**
+     * @brief Removes data older than the retention policy allows.
+     * @param sensorId Sensor ID.
+     * @param now Current time in ms since epoch.
+     * @return Number of removed rows, -1 on a write error.
+     */
+    qint64 applyRetention(int sensorId, qint64 now);
+
+    /**
+     * @brief Recomputes the rollups of all raw data of a sensor.
+     * @param sensorId Sensor ID.
+     * @return True on success.
+     *
+     * Used to repair rollups after an interrupted append. Rollups of expired
+     * raw data are kept.
+     */
+    bool rebuildRollups(int sensorId);
+
+    /**
+     * @brief Picks the finest resolution that fits a chart.
+     * @param from Window start in ms since epoch.
+     * @param to Window end in ms since epoch.
+     * @param pixels Width of the chart in pixels.
+     * @return Hourly if every hour gets a pixel, otherwise Daily if every day
+     *         does, otherwise Monthly.
+     */
+    static Resolution chooseResolution(qint64 from, qint64 to, int pixels);
+
+    /**
+     * @brief Gets the start of the bucket containing a timestamp.
+     * @param timestamp Milliseconds since epoch.
+     * @param resolution Bucket resolution.
+     * @return Bucket start in local time; the timestamp itself for Hourly.
+     */
+    static qint64 bucketStart(qint64 timestamp, Resolution resolution);
+
+private:
+    friend class ArchiveView;
+
+    /**
+     * @struct Segment
+     * @brief Contents of one segment file.
+     */
+    struct Segment {
+        QVector<qint64> timestamps;         ///< Sorted timestamps
+        QVector<QVector<double>> columns;   ///< Value columns, one per field
+    };
+
+    /**
+     * @brief Rollup columns of a daily or monthly segment.
+     */
+    enum RollupColumn {
+        MinColumn,      ///< Minimum
+        MaxColumn,      ///< Maximum
+        SumColumn,      ///< Sum of values
+        CountColumn,    ///< Number of samples
+        RollupColumns   ///< Number of rollup columns
+    };
+
+    /**
+     * @brief Archives samples; the caller holds the mutex.
+     * @param sensorId Sensor ID.
+     * @param series Samples sorted by timestamp; NaN values are skipped.
+     * @return Number of new or changed samples, -1 on a write error.
+     */
+    int appendLocked(int sensorId, const Series &series);
+
+    /**
+     * @brief Replays the write-ahead log; the caller holds the mutex.
+     * @return Number of replayed records, -1 on a read or write error.
+     */
+    int recoverLocked();
+
+    /**
+     * @brief Empties the log once the segments it restores are durable.
+     * @return True on success.
+     */
+    bool checkpoint();
+
+    /**
+     * @brief Merges samples into the segments; the caller holds the mutex.
+     * @param sensorId Sensor ID.
+     * @param series Samples sorted by timestamp; NaN values are skipped.
+     * @param logged True to record every changed month in the log first.
+     * @return Number of new or changed samples, -1 on a write error.
+     */
+    int appendRows(int sensorId, const Series &series, bool logged);
+
+    /**
+     * @brief Aggregates samples past the raw retention into the rollups.
+     * @param sensorId Sensor ID.
+     * @param series Samples sorted by timestamp; NaN values are skipped.
+     * @param end Index of the first sample within the raw retention.
+     * @param now Current time in ms since epoch.
+     * @param rolledUp Receives the number of samples kept in a rollup.
+     * @param expired Receives the number of samples past every retention.
+     * @return True on success.
+     */
+    bool rollUpRows(int sensorId, const Series &series, qsizetype end, qint64 now,
+                    qint64 *rolledUp, qint64 *expired);
+
+    /**
+     * @brief Encodes a log record of appended raw rows.
+     * @param sensorId Sensor ID.
+     * @param rows Raw rows of one month.
+     * @return Record payload.
+     */
+    static QByteArray encodeRecord(int sensorId, const Segment &rows);
+
+    /**
+     * @brief Decodes a log record of appended raw rows.
+     * @param record Record payload.
+     * @param sensorId Receives the sensor ID.
+     * @param series Receives the rows.
+     * @return False if the record is malformed.
+     */
+    static bool decodeRecord(const QByteArray &record, int *sensorId, Series *series);
+
+    /**
+     * @brief Gets the directory of a sensor.
+     * @param sensorId Sensor ID.
+     * @return Directory path.
+     */
+    QString sensorPath(int sensorId) const;
+
+    /**
+     * @brief Gets the segment file holding a timestamp.
+     * @param sensorId Sensor ID.
+     * @param resolution Segment resolution.
+     * @param timestamp Milliseconds since epoch.
+     * @return File path.
+     */
+    QString segmentPath(int sensorId, Resolution resolution, qint64 timestamp) const;
+
+    /**
+     * @brief Gets the packed raw segment of a year.
+     * @param sensorId Sensor ID.
+     * @param year Year.
+     * @return File path.
+     */
+    QString packPath(int sensorId, int year) const;
+
+    /**
+     * @brief Gets the rollup segment files overlapping a window, in time order.
+     * @param sensorId Sensor ID.
+     * @param from Window start in ms since epoch.
+     * @param to Window end in ms since epoch.
+     * @param resolution Daily or Monthly.
+     * @return File paths.
+     */
+    QStringList rollupPaths(int sensorId, qint64 from, qint64 to, Resolution resolution) const;
+
+    /**
+     * @brief Reads raw rows of a window from month and packed segments.
+     * @param sensorId Sensor ID.
+     * @param from Window start in ms since epoch, inclusive.
+     * @param to Window end in ms since epoch, inclusive.
+     * @return Raw rows; month segments take precedence over packed rows.
+     */
+    Segment readRaw(int sensorId, qint64 from, qint64 to) const;
+
+    /**
+     * @brief Gets the years having raw segments.
+     * @param sensorId Sensor ID.
+     * @return Sorted years.
+     */
+    QList<int> rawYears(int sensorId) const;
+
+    /**
+     * @brief Reads a segment file.
+     * @param path File path.
+     * @param columns Expected number of value columns.
+     * @return Segment with the given columns, empty if the file is missing or
+     *         invalid.
+     */
+    static Segment readSegment(const QString &path, int columns);
+
+    /**
+     * @brief Adds the rows of a segment file within a window to a view.
+     * @param view Target view.
+     * @param path Segment file.
+     * @param columns Expected number of value columns.
+     * @param from Window start in ms since epoch, inclusive.
+     * @param to Window end in ms since epoch, inclusive.
+     */
+    static void addSegment(ArchiveView &view, const QString &path, int columns, qint64 from, qint64 to);
+
+    /**
+     * @brief Adds rows held in memory to a view.
+     * @param view Target view.
+     * @param segment Rows, moved into the view.
+     * @param from Window start in ms since epoch, inclusive.
+     * @param to Window end in ms since epoch, inclusive.
+     */
+    static void addRows(ArchiveView &view, Segment segment, qint64 from, qint64 to);
+
+    /**
+     * @brief Cuts a time window out of a segment.
+     * @param segment Source segment.
+     * @param from Window start in ms since epoch, inclusive.
+     * @param to Window end in ms since epoch, inclusive.
+     * @return Rows within the window.
+     */
+    static Segment sliceRows(const Segment &segment, qint64 from, qint64 to);
+
+    /**
+     * @brief Drops rows older than a cutoff and rewrites or removes the file.
+     * @param path Segment file.
+     * @param columns Number of value columns.
+     * @param cutoff Oldest timestamp to keep.
+     * @return Number of removed rows, -1 on a write error.
+     */
+    static qint64 expireRows(const QString &path, int columns, qint64 cutoff);
+
+    /**
+     * @brief Writes a segment file atomically.
+     * @param path File path.
+     * @param segment Segment to write.
+     * @return True on success.
+     */
+    static bool writeSegment(const QString &path, const Segment &segment);
+
+    /**
+     * @brief Replaces or inserts rows of a segment.
+     * @param segment Target segment.
+     * @param rows Rows to merge, sorted by timestamp, with the same columns.
+     */
+    static void mergeRows(Segment &segment, const Segment &rows);
+
+    /**
+     * @brief Aggregates rows of a segment into buckets.
+     * @param source Raw segment (one column) or rollup segment.
+     * @param resolution Resolution of the buckets.
+     * @param buckets Bucket starts to compute, sorted.
+     * @return Rollup rows of the non-empty buckets.
+     */
+    static Segment aggregate(const Segment &source, Resolution resolution, const QVector<qint64> &buckets);
+
+    /**
+     * @brief Recomputes rollups of days touched by an append.
+     * @param sensorId Sensor ID.
+     * @param raw Updated raw segment of one month.
+     * @param days Touched day starts, sorted.
+     * @return True on success.
+     */
+    bool updateRollups(int sensorId, const Segment &raw, const QVector<qint64> &days);
+
+    QString m_rootPath;             ///< Archive directory
+    RetentionPolicy m_retention;    ///< Retention policy
+    WriteAheadLog m_wal;            ///< Log of appended months
+    bool m_recovered = false;       ///< True once the log was replayed
+    QSet<QString> m_unsyncedDirs;   ///< Sensor directories with renames since the last checkpoint
+    mutable QMutex m_mutex;         ///< Serializes all operations
+};
+
+/**
+ * @class ArchiveView
+ * @brief Result of an archive query as blocks of rows in place.
+ *
+ * Every block points into a memory mapped segment file where possible, so a
+ * query costs the binary searches that cut the blocks, not a copy of the
+ * rows. The view keeps the mappings alive; segments rewritten after the
+ * query do not change it.
+ */
+class ArchiveView {
+public:
+    /**
+     * @struct Block
+     * @brief Rows of one segment file within the queried window.
+     *
+     * At hourly resolution columns[0] holds the raw values; rollups hold
+     * min, max, sum and count in columns 0 to 3.
+     */
+    struct Block {
+        const qint64 *timestamps = nullptr; ///< Timestamps, ascending
+        const double *columns[4] = {};      ///< Value columns
+        qsizetype size = 0;                 ///< Number of rows
+    };
+
+    /**
+     * @brief Gets the resolution of the rows.
+     * @return Resolution.
+     */
+    LocalArchive::Resolution resolution() const { return m_resolution; }
+
+    /**
+     * @brief Gets the number of rows.
+     * @return Row count over all blocks.
+     */
+    qsizetype size() const { return m_size; }
+
+    /**
+     * @brief Checks whether the view has no rows.
+     * @return True if empty.
+     */
+    bool isEmpty() const { return m_size == 0; }
+
+    /**
+     * @brief Gets the blocks in time order.
+     * @return Non-empty blocks.
+     */
+    const QList<Block> &blocks() const { return m_blocks; }
+
+    /**
+     * @brief Gets the number of blocks read without copying.
+     * @return Number of memory mapped blocks.
+     */
+    int mappedBlocks() const { return m_mappedBlocks; }
+
+    /**
+     * @brief Copies the rows into a series.
+     * @return Series with min, max, mean and count of every row.
+     */
+    ArchiveSeries toSeries() const;
+
+private:
+    friend class LocalArchive;
+
+    /**
+     * @brief Appends the part of a block within a window.
+     * @param block Whole block, sorted by timestamp.
+     * @param from Window start in ms since epoch, inclusive.
+     * @param to Window end in ms since epoch, inclusive.
+     * @param owner Keeps the memory of the block alive.
+     * @param mapped True if the block points into a mapped file.
+     */
+    void append(Block block, qint64 from, qint64 to, std::shared_ptr<const void> owner, bool mapped);
+
+    LocalArchive::Resolution m_resolution = LocalArchive::Hourly;   ///< Resolution of the rows
+    QList<Block> m_blocks;                          ///< Blocks in time order
+    QList<std::shared_ptr<const void>> m_owners;    ///< Owners of the block memory
+    qsizetype m_size = 0;                           ///< Row count
+    int m_mappedBlocks = 0;                         ///< Blocks read without copying
+};
+
+#endif // LOCALARCHIVE_H
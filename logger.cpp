@@ -0,0 +1,525 @@
+/**
+ * @file logger.cpp
+ * @brief Implementation of the Logger and LogCategory classes.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the category registry, the lock-free record queue and
+ * the writer thread with its repeat limit and output formats.
+ */
+
+#include "logger.h"
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QList>
+#include <QThread>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+
+/**
+ * @struct CategoryRegistry
+ * @brief Registered categories and the level rules applied to them.
+ */
+struct CategoryRegistry {
+    QMutex mutex;                                   ///< Guards the fields below
+    QList<LogCategory *> categories;                ///< Registered categories
+    QHash<QByteArray, LogCategory::Level> rules;    ///< Levels by category name
+    int defaultRule = -1;                           ///< Level of "*", -1 if none
+};
+
+/**
+ * @brief Gets the category registry.
+ * @return Registry, created on first use.
+ */
+CategoryRegistry &registry()
+{
+    static CategoryRegistry instance;
+    return instance;
+}
+
+/**
+ * @brief Gets the level a rule set gives a category.
+ * @param registry Registry, locked.
+ * @param name Category name.
+ * @param defaultLevel Level of the category without a rule.
+ * @return Level.
+ */
+LogCategory::Level ruleLevel(const CategoryRegistry &registry, const QByteArray &name, LogCategory::Level defaultLevel)
+{
+    const auto it = registry.rules.constFind(name);
+    if (it != registry.rules.cend()) {
+        return it.value();
+    }
+    return registry.defaultRule >= 0 ? LogCategory::Level(registry.defaultRule) : defaultLevel;
+}
+
+Logger *s_instance = nullptr;   ///< Logger returned by Logger::instance()
+
+} // namespace
+
+/**
+ * @brief Constructs and registers a category.
+ * @param name Category name, e.g. "sensors".
+ * @param defaultLevel Level used unless a rule sets another one.
+ */
+LogCategory::LogCategory(const char *name, Level defaultLevel)
+    : m_name(name),
+    m_defaultLevel(defaultLevel),
+    m_level(defaultLevel)
+{
+    CategoryRegistry &categories = registry();
+    QMutexLocker locker(&categories.mutex);
+    m_level.store(ruleLevel(categories, m_name, m_defaultLevel), std::memory_order_relaxed);
+    categories.categories.append(this);
+}
+
+/**
+ * @brief Unregisters the category.
+ */
+LogCategory::~LogCategory()
+{
+    CategoryRegistry &categories = registry();
+    QMutexLocker locker(&categories.mutex);
+    categories.categories.removeOne(this);
+}
+
+/**
+ * @brief Applies level rules to all present and future categories.
+ * @param rules Comma separated "name=level" pairs.
+ * @return False if a rule could not be parsed; valid rules still apply.
+ */
+bool LogCategory::setRules(const QString &rules)
+{
+    CategoryRegistry &categories = registry();
+    QMutexLocker locker(&categories.mutex);
+    bool ok = true;
+    for (const QString &rule : rules.split(',', Qt::SkipEmptyParts)) {
+        const qsizetype equals = rule.indexOf('=');
+        Level level = Info;
+        if (equals <= 0 || !parseLevel(rule.mid(equals + 1).trimmed(), &level)) {
+            ok = false;
+            continue;
+        }
+        const QByteArray name = rule.left(equals).trimmed().toUtf8();
+        if (name == "*") {
+            categories.defaultRule = level;
+        } else {
+            categories.rules.insert(name, level);
+        }
+    }
+    for (LogCategory *category : std::as_const(categories.categories)) {
+        category->setLevel(ruleLevel(categories, category->m_name, category->m_defaultLevel));
+    }
+    return ok;
+}
+
+/**
+ * @brief Parses a level name.
+ * @param name "debug", "info", "warning", "error" or "off".
+ * @param level Parsed level.
+ * @return False if the name is unknown.
+ */
+bool LogCategory::parseLevel(const QString &name, Level *level)
+{
+    static const char *const names[] = {"debug", "info", "warning", "error", "off"};
+    for (int i = Debug; i <= Off; ++i) {
+        if (name.compare(QLatin1String(names[i]), Qt::CaseInsensitive) == 0) {
+            *level = Level(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Gets the name of a level.
+ * @param level Level.
+ * @return Lowercase level name.
+ */
+const char *LogCategory::levelName(Level level)
+{
+    switch (level) {
+    case Debug: return "debug";
+    case Info: return "info";
+    case Warning: return "warning";
+    case Error: return "error";
+    case Off: break;
+    }
+    return "off";
+}
+
+/**
+ * @brief Constructs a logger writing text to stderr.
+ * @param capacity Queue capacity, rounded up to a power of two.
+ */
+Logger::Logger(int capacity)
+{
+    quint64 size = 2;
+    while (size < quint64(capacity)) {
+        size *= 2;
+    }
+    m_slots.reset(new Slot[size]);
+    m_mask = size - 1;
+    for (quint64 i = 0; i < size; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+}
+
+/**
+ * @brief Writes the queued records and stops the writer thread.
+ */
+Logger::~Logger()
+{
+    if (s_instance == this) {
+        qInstallMessageHandler(nullptr);
+        s_instance = nullptr;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stop = true;
+        m_wake.wakeOne();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+/**
+ * @brief Gets the application logger.
+ * @return Logger configured by configureFromEnvironment().
+ */
+Logger &Logger::instance()
+{
+    static Logger logger;
+    s_instance = &logger;
+    return logger;
+}
+
+/**
+ * @brief Applies the AIRAPI_LOG, AIRAPI_LOG_FORMAT and AIRAPI_LOG_FILE
+ *        environment variables.
+ */
+void Logger::configureFromEnvironment()
+{
+    const QString rules = qEnvironmentVariable("AIRAPI_LOG");
+    if (!rules.isEmpty() && !LogCategory::setRules(rules)) {
+        std::fprintf(stderr, "Nieprawidłowa wartość AIRAPI_LOG: %s\n", qPrintable(rules));
+    }
+    setFormat(qEnvironmentVariable("AIRAPI_LOG_FORMAT").compare("json", Qt::CaseInsensitive) == 0 ? Json : Text);
+
+    const QString path = qEnvironmentVariable("AIRAPI_LOG_FILE");
+    if (!path.isEmpty()) {
+        auto file = std::make_shared<QFile>(path);
+        if (file->open(QIODevice::WriteOnly | QIODevice::Append)) {
+            setSink([file](const QByteArray &lines) {
+                file->write(lines);
+                file->flush();
+            });
+        } else {
+            std::fprintf(stderr, "Nie można otworzyć pliku dziennika %s\n", qPrintable(path));
+        }
+    }
+}
+
+/**
+ * @brief Queues a record.
+ * @param category Category.
+ * @param level Level; the record is ignored if the category disables it.
+ * @param message Message, also the key of the repeat limit.
+ * @param fields Structured fields.
+ */
+void Logger::log(const LogCategory &category, LogCategory::Level level, const QString &message, const QJsonObject &fields)
+{
+    if (!category.isEnabled(level)) {
+        return;
+    }
+    Record record;
+    record.timestamp = QDateTime::currentMSecsSinceEpoch();
+    record.level = level;
+    record.category = category.name();
+    record.message = message;
+    record.fields = fields;
+    if (!push(std::move(record))) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        m_droppedTotal.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Writes all records queued so far and waits until they are out.
+ */
+void Logger::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    const quint64 target = ++m_flushRequests;
+    m_wake.wakeOne();
+    while (m_flushesDone < target) {
+        m_flushed.wait(&m_mutex);
+    }
+}
+
+/**
+ * @brief Sets the output format.
+ * @param format Format.
+ */
+void Logger::setFormat(Format format)
+{
+    m_format.store(format, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Replaces the output.
+ * @param sink Called on the writer thread with complete lines; an empty
+ *        function restores stderr.
+ */
+void Logger::setSink(Sink sink)
+{
+    QMutexLocker locker(&m_mutex);
+    m_sink = std::move(sink);
+}
+
+/**
+ * @brief Routes Qt messages, including QML console output, to the logger.
+ * @param type Message type.
+ * @param context Source of the message.
+ * @param message Message.
+ *
+ * Every Qt category gets a LogCategory of the same name on first use, so
+ * rules such as "qml=warning" silence console.log of QML code.
+ */
+void Logger::messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    static QMutex mutex;
+    static QHash<QByteArray, LogCategory *> categories;
+
+    const QByteArray name = context.category ? QByteArray(context.category) : QByteArray("default");
+    LogCategory *category = nullptr;
+    {
+        QMutexLocker locker(&mutex);
+        category = categories.value(name);
+        if (!category) {
+            // Kategorie Qt żyją do końca programu
+            category = new LogCategory(name.constData(), LogCategory::Debug);
+            categories.insert(name, category);
+        }
+    }
+
+    LogCategory::Level level = LogCategory::Debug;
+    switch (type) {
+    case QtDebugMsg: level = LogCategory::Debug; break;
+    case QtInfoMsg: level = LogCategory::Info; break;
+    case QtWarningMsg: level = LogCategory::Warning; break;
+    case QtCriticalMsg:
+    case QtFatalMsg: level = LogCategory::Error; break;
+    }
+
+    QJsonObject fields;
+    if (context.file) {
+        fields["file"] = QString::fromUtf8(context.file);
+        fields["line"] = context.line;
+    }
+    Logger &logger = instance();
+    logger.log(*category, level, message, fields);
+    if (type == QtFatalMsg) {
+        logger.flush();
+        std::abort();
+    }
+}
+
+/**
+ * @brief Claims a queue slot and stores a record.
+ * @param record Record.
+ * @return False if the queue is full.
+ *
+ * A slot whose sequence equals the claimed position is free; the producer
+ * publishes the record by advancing the sequence past the position.
+ */
+bool Logger::push(Record &&record)
+{
+    quint64 position = m_head.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot &slot = m_slots[position & m_mask];
+        const quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+        const qint64 difference = qint64(sequence - position);
+        if (difference == 0) {
+            if (m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot.record = std::move(record);
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = m_head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Takes the oldest published record; writer thread only.
+ * @param record Receives the record.
+ * @return False if no record is ready.
+ */
+bool Logger::pop(Record *record)
+{
+    Slot &slot = m_slots[m_tail & m_mask];
+    if (slot.sequence.load(std::memory_order_acquire) != m_tail + 1) {
+        return false;
+    }
+    *record = std::move(slot.record);
+    slot.sequence.store(m_tail + m_mask + 1, std::memory_order_release);
+    ++m_tail;
+    return true;
+}
+
+/**
+ * @brief Writer thread loop.
+ */
+void Logger::run()
+{
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        // Zgłoszenia flush() sprzed tego opróżnienia zostaną nim obsłużone
+        const bool stop = m_stop;
+        const quint64 requested = m_flushRequests;
+        const bool forced = requested != m_flushesDone;
+        locker.unlock();
+        drain(forced || stop);
+        locker.relock();
+        if (forced) {
+            m_flushesDone = requested;
+            m_flushed.wakeAll();
+        }
+        if (stop) {
+            break;
+        }
+        if (m_flushRequests == m_flushesDone && !m_stop) {
+            m_wake.wait(&m_mutex, FlushIntervalMs);
+        }
+    }
+}
+
+/**
+ * @brief Formats and writes all ready records; writer thread only.
+ * @param summarizeAll True to summarize every suppressed repeat.
+ *
+ * A forced drain also waits for records whose slot was claimed before it
+ * started but is still being filled by its producer.
+ */
+void Logger::drain(bool summarizeAll)
+{
+    const quint64 claimed = summarizeAll ? m_head.load(std::memory_order_acquire) : 0;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QByteArray out;
+    Record record;
+    for (;;) {
+        if (!pop(&record)) {
+            if (m_tail >= claimed) {
+                break;
+            }
+            QThread::yieldCurrentThread();
+            continue;
+        }
+        Repeats &repeats = m_repeats[QString::fromLatin1(record.category) + '/' + record.message];
+        if (record.timestamp - repeats.windowStart >= 1000) {
+            if (repeats.suppressed > 0) {
+                repeats.last.fields["repeated"] = repeats.suppressed;
+                format(repeats.last, &out);
+            }
+            repeats.windowStart = record.timestamp;
+            repeats.written = 0;
+            repeats.suppressed = 0;
+        }
+        if (repeats.written < MaxRepeats) {
+            ++repeats.written;
+            format(record, &out);
+        } else {
+            ++repeats.suppressed;
+            repeats.last = std::move(record);
+        }
+    }
+
+    // Podsumowania powtórzeń z zamkniętych okien; stare wpisy znikają
+    for (auto it = m_repeats.begin(); it != m_repeats.end();) {
+        Repeats &repeats = it.value();
+        if (repeats.suppressed > 0 && (summarizeAll || now - repeats.windowStart >= 1000)) {
+            repeats.last.fields["repeated"] = repeats.suppressed;
+            format(repeats.last, &out);
+            repeats.suppressed = 0;
+            repeats.written = MaxRepeats;
+        }
+        if (repeats.suppressed == 0 && now - repeats.windowStart >= 10000) {
+            it = m_repeats.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    const qint64 dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        Record warning;
+        warning.timestamp = now;
+        warning.level = LogCategory::Warning;
+        warning.category = "log";
+        warning.message = "Pełna kolejka dziennika, pominięto wpisy";
+        warning.fields["dropped"] = dropped;
+        format(warning, &out);
+    }
+
+    if (out.isEmpty()) {
+        return;
+    }
+    Sink sink;
+    {
+        QMutexLocker locker(&m_mutex);
+        sink = m_sink;
+    }
+    if (sink) {
+        sink(out);
+    } else {
+        std::fwrite(out.constData(), 1, size_t(out.size()), stderr);
+        std::fflush(stderr);
+    }
+}
+
+/**
+ * @brief Appends one formatted record to the output batch.
+ * @param record Record.
+ * @param out Output batch.
+ *
+ * JSON lines carry the fields next to "time", "level", "category" and
+ * "message", which take precedence over fields of the same name.
+ */
+void Logger::format(const Record &record, QByteArray *out) const
+{
+    const QString time = QDateTime::fromMSecsSinceEpoch(record.timestamp).toUTC().toString(Qt::ISODateWithMs);
+    if (m_format.load(std::memory_order_relaxed) == Json) {
+        QJsonObject object = record.fields;
+        object["time"] = time;
+        object["level"] = QLatin1String(LogCategory::levelName(record.level));
+        object["category"] = QString::fromLatin1(record.category);
+        object["message"] = record.message;
+        *out += QJsonDocument(object).toJson(QJsonDocument::Compact);
+        *out += '\n';
+        return;
+    }
+
+    *out += time.toUtf8() + ' ' + LogCategory::levelName(record.level) + ' ' + record.category + ": "
+            + record.message.toUtf8();
+    for (auto it = record.fields.constBegin(); it != record.fields.constEnd(); ++it) {
+        const QJsonValue value = it.value();
+        QByteArray text;
+        if (value.isObject() || value.isArray()) {
+            text = QJsonDocument::fromVariant(value.toVariant()).toJson(QJsonDocument::Compact);
+        } else {
+            text = value.toVariant().toString().toUtf8();
+        }
+        *out += ' ' + it.key().toUtf8() + '=' + text;
+    }
+    *out += '\n';
+}
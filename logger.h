@@ -0,0 +1,298 @@
+/**
+ * @file logger.h
+ * @brief Header file for the Logger and LogCategory classes.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the asynchronous structured logger: categories with
+ * their own levels, a lock-free queue of records and a background thread
+ * formatting them as text or JSON lines.
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QMutex>
+#include <QString>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class QThread;
+
+/**
+ * @class LogCategory
+ * @brief Named source of log records with its own minimum level.
+ *
+ * Categories are usually file-scope objects. The level check is a relaxed
+ * atomic load, so a disabled debug record on a hot path costs a comparison;
+ * callers building fields check isEnabled() first.
+ */
+class LogCategory {
+public:
+    /**
+     * @enum Level
+     * @brief Severity of a record.
+     */
+    enum Level {
+        Debug,      ///< Diagnostics, off by default
+        Info,       ///< Normal operation
+        Warning,    ///< Recoverable problems
+        Error,      ///< Failed operations
+        Off         ///< Category disabled
+    };
+
+    /**
+     * @brief Constructs and registers a category.
+     * @param name Category name, e.g. "sensors".
+     * @param defaultLevel Level used unless a rule sets another one.
+     */
+    explicit LogCategory(const char *name, Level defaultLevel = Info);
+
+    /**
+     * @brief Unregisters the category.
+     */
+    ~LogCategory();
+
+    LogCategory(const LogCategory &) = delete;
+    LogCategory &operator=(const LogCategory &) = delete;
+
+    /**
+     * @brief Gets the name.
+     * @return Category name.
+     */
+    const QByteArray &name() const { return m_name; }
+
+    /**
+     * @brief Checks whether records of a level are logged.
+     * @param level Level.
+     * @return True if the level is at least the category level.
+     */
+    bool isEnabled(Level level) const { return level >= m_level.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Sets the minimum level.
+     * @param level Level.
+     */
+    void setLevel(Level level) { m_level.store(level, std::memory_order_relaxed); }
+
+    /**
+     * @brief Applies level rules to all present and future categories.
+     * @param rules Comma separated "name=level" pairs, e.g.
+     *        "sensors=debug,archive=warning"; "*" matches every category
+     *        without its own rule.
+     * @return False if a rule could not be parsed; valid rules still apply.
+     */
+    static bool setRules(const QString &rules);
+
+    /**
+     * @brief Parses a level name.
+     * @param name "debug", "info", "warning", "error" or "off".
+     * @param level Parsed level.
+     * @return False if the name is unknown.
+     */
+    static bool parseLevel(const QString &name, Level *level);
+
+    /**
+     * @brief Gets the name of a level.
+     * @param level Level.
+     * @return Lowercase level name.
+     */
+    static const char *levelName(Level level);
+
+private:
+    QByteArray m_name;                  ///< Category name
+    Level m_defaultLevel;               ///< Level without a rule
+    std::atomic<int> m_level;           ///< Current minimum level
+};
+
+/**
+ * @class Logger
+ * @brief Queues log records and writes them on a background thread.
+ *
+ * Producers on any thread claim a slot of a bounded multi-producer queue
+ * with one compare-and-swap and never wait: a record that does not fit is
+ * counted and reported as dropped. The writer thread drains the queue every
+ * FlushIntervalMs or on flush(), limits repeats of the same message to
+ * MaxRepeats per second and writes the formatted batch to the sink.
+ */
+class Logger {
+public:
+    static constexpr int DefaultCapacity = 8192;    ///< Queued records
+    static constexpr int FlushIntervalMs = 50;      ///< Writer wake-up interval
+    static constexpr int MaxRepeats = 5;            ///< Repeats per second written
+
+    /**
+     * @enum Format
+     * @brief Output format.
+     */
+    enum Format {
+        Text,   ///< One human-readable line per record
+        Json    ///< One JSON object per line
+    };
+
+    using Sink = std::function<void(const QByteArray &lines)>;
+
+    /**
+     * @brief Constructs a logger writing text to stderr.
+     * @param capacity Queue capacity, rounded up to a power of two.
+     */
+    explicit Logger(int capacity = DefaultCapacity);
+
+    /**
+     * @brief Writes the queued records and stops the writer thread.
+     */
+    ~Logger();
+
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    /**
+     * @brief Gets the application logger.
+     * @return Logger configured by configureFromEnvironment().
+     */
+    static Logger &instance();
+
+    /**
+     * @brief Applies the AIRAPI_LOG, AIRAPI_LOG_FORMAT and AIRAPI_LOG_FILE
+     *        environment variables.
+     *
+     * AIRAPI_LOG holds the category rules, AIRAPI_LOG_FORMAT is "text" or
+     * "json" and AIRAPI_LOG_FILE redirects the output from stderr.
+     */
+    void configureFromEnvironment();
+
+    /**
+     * @brief Queues a record.
+     * @param category Category.
+     * @param level Level; the record is ignored if the category disables it.
+     * @param message Message, also the key of the repeat limit.
+     * @param fields Structured fields.
+     */
+    void log(const LogCategory &category, LogCategory::Level level, const QString &message,
+             const QJsonObject &fields = QJsonObject());
+
+    /**
+     * @brief Writes all records queued so far and waits until they are out.
+     *
+     * Repeats suppressed so far are summarized immediately.
+     */
+    void flush();
+
+    /**
+     * @brief Sets the output format.
+     * @param format Format.
+     */
+    void setFormat(Format format);
+
+    /**
+     * @brief Replaces the output.
+     * @param sink Called on the writer thread with complete lines; an empty
+     *        function restores stderr.
+     */
+    void setSink(Sink sink);
+
+    /**
+     * @brief Gets the number of records lost because the queue was full.
+     * @return Dropped records since construction.
+     */
+    qint64 droppedCount() const { return m_droppedTotal.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Routes Qt messages, including QML console output, to the logger.
+     * @param type Message type.
+     * @param context Source of the message.
+     * @param message Message.
+     */
+    static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message);
+
+private:
+    /**
+     * @struct Record
+     * @brief Queued log record, formatted by the writer thread.
+     */
+    struct Record {
+        qint64 timestamp = 0;                       ///< Milliseconds since epoch
+        LogCategory::Level level = LogCategory::Info; ///< Level
+        QByteArray category;                        ///< Category name
+        QString message;                            ///< Message
+        QJsonObject fields;                         ///< Structured fields
+    };
+
+    /**
+     * @struct Slot
+     * @brief Queue cell; the sequence tells whose turn it is.
+     */
+    struct Slot {
+        std::atomic<quint64> sequence{0};   ///< Position the slot is ready for
+        Record record;                      ///< Queued record
+    };
+
+    /**
+     * @struct Repeats
+     * @brief Repeat limit state of one message.
+     */
+    struct Repeats {
+        qint64 windowStart = 0;     ///< Start of the one second window
+        int written = 0;            ///< Records written in the window
+        int suppressed = 0;         ///< Records suppressed in the window
+        Record last;                ///< Last suppressed record
+    };
+
+    /**
+     * @brief Claims a queue slot and stores a record.
+     * @param record Record.
+     * @return False if the queue is full.
+     */
+    bool push(Record &&record);
+
+    /**
+     * @brief Takes the oldest published record; writer thread only.
+     * @param record Receives the record.
+     * @return False if no record is ready.
+     */
+    bool pop(Record *record);
+
+    /**
+     * @brief Writer thread loop.
+     */
+    void run();
+
+    /**
+     * @brief Formats and writes all ready records; writer thread only.
+     * @param summarizeAll True to summarize every suppressed repeat.
+     */
+    void drain(bool summarizeAll);
+
+    /**
+     * @brief Appends one formatted record to the output batch.
+     * @param record Record.
+     * @param out Output batch.
+     */
+    void format(const Record &record, QByteArray *out) const;
+
+    std::unique_ptr<Slot[]> m_slots;                ///< Queue cells
+    quint64 m_mask;                                 ///< Capacity minus one
+    alignas(64) std::atomic<quint64> m_head{0};     ///< Next position to claim
+    alignas(64) quint64 m_tail = 0;                 ///< Next position to take
+    std::atomic<qint64> m_dropped{0};               ///< Drops not reported yet
+    std::atomic<qint64> m_droppedTotal{0};          ///< Drops since construction
+    std::atomic<int> m_format{Text};                ///< Output format
+
+    QMutex m_mutex;                                 ///< Guards the fields below
+    QWaitCondition m_wake;                          ///< Wakes the writer
+    QWaitCondition m_flushed;                       ///< Signals a finished drain
+    bool m_stop = false;                            ///< Set by the destructor
+    quint64 m_flushRequests = 0;                    ///< Calls of flush()
+    quint64 m_flushesDone = 0;                      ///< Calls of flush() served
+    Sink m_sink;                                    ///< Output, empty for stderr
+
+    QHash<QString, Repeats> m_repeats;              ///< Repeat limits; writer thread only
+    QThread *m_thread = nullptr;                    ///< Writer thread
+};
+
+#endif // LOGGER_H
@@ -11,7 +11,80 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QQmlEngine>
+#include <QQuickWindow>
 #include "mainwindow.h"
+#include "heatmapitem.h"
+#include "playbacklayer.h"
+#include "sparklinelayer.h"
+#include "dashboarditem.h"
+#include "logger.h"
+#include "metrics.h"
+#include "memorybenchmark.h"
+#include "poolbenchmark.h"
+#include "reportrenderer.h"
+#include <QCommandLineParser>
+#include <QEventLoop>
+#include <QTextStream>
+#include <memory>
+
+/**
+ * @brief Writes station reports without opening a window.
+ * @param app Application.
+ * @return 0, or 1 if a report could not be written.
+ *
+ * The station list is loaded as at startup, then the reports are rendered
+ * on the thread pool from the series in memory and the local archive.
+ */
+static int runReport(QGuiApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Raporty stacji w plikach PNG lub PDF, bez okna.");
+    parser.addHelpOption();
+    const QCommandLineOption reportOption("report", "Identyfikatory stacji oddzielone przecinkami.", "ids");
+    const QCommandLineOption dirOption("report-dir", "Katalog raportów.", "dir", "reports");
+    const QCommandLineOption formatOption("report-format", "Format: png lub pdf.", "format", "png");
+    const QCommandLineOption hoursOption("report-hours", "Długość okresu raportu w godzinach.", "hours", "168");
+    const QCommandLineOption waitOption("report-wait", "Czas oczekiwania na listę stacji w sekundach.", "s", "30");
+    parser.addOptions({reportOption, dirOption, formatOption, hoursOption, waitOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    ReportRenderer::Format format = ReportRenderer::Png;
+    if (!ReportRenderer::parseFormat(parser.value(formatOption), &format)) {
+        out << "Nieznany format raportu: " << parser.value(formatOption) << "\n";
+        return 1;
+    }
+    QList<int> ids;
+    for (const QString &id : parser.value(reportOption).split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        ids.append(id.trimmed().toInt(&ok));
+        if (!ok) {
+            out << "Nieprawidłowy identyfikator stacji: " << id << "\n";
+            return 1;
+        }
+    }
+
+    // Nazwy i położenia stacji przychodzą od dostawców; bez nich raport ma same dane.
+    // Dostawcy odpowiadający od razu wypełniają listę już w konstruktorze.
+    MainWindow mainWindow;
+    QQmlListProperty<Station> stations = mainWindow.allStations();
+    if (stations.count(&stations) == 0) {
+        QEventLoop loop;
+        QObject::connect(&mainWindow, &MainWindow::allStationsChanged, &loop, &QEventLoop::quit);
+        QTimer::singleShot(parser.value(waitOption).toInt() * 1000, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+
+    ReportRenderer renderer;
+    const ReportSummary summary = renderer.run(mainWindow.reportStations(ids, parser.value(hoursOption).toInt()),
+                                               mainWindow.stationMapPoints(), parser.value(dirOption), format);
+    for (const QString &file : summary.files) {
+        out << file << "\n";
+    }
+    out << QString("Zapisano %1 plików, błędy: %2.\n").arg(summary.written).arg(summary.failed);
+    return summary.failed > 0 ? 1 : 0;
+}
 
 /**
  * @brief Main function of the application.
@@ -24,8 +97,54 @@
  */
 int main(int argc, char *argv[])
 {
+    // Pomiar pamięci działa bez okna: --bench-memory [--stations n] [--samples n]
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--bench-memory") == 0) {
+            QCoreApplication app(argc, argv);
+            return MemoryBenchmark::main(app.arguments());
+        }
+    }
+
+    // Porównanie pul wątków bez okna: --bench-pool [--scale n] [--repeat n]
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--bench-pool") == 0) {
+            QCoreApplication app(argc, argv);
+            return PoolBenchmark::main(app.arguments());
+        }
+    }
+
+    // Raporty bez okna: --report 114,117 [--report-format pdf] [--report-dir dir]
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--report") == 0) {
+            if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+                qputenv("QT_QPA_PLATFORM", "offscreen");
+            }
+            QGuiApplication app(argc, argv);
+            Logger::instance().configureFromEnvironment();
+            qInstallMessageHandler(Logger::messageHandler);
+            const int exitCode = runReport(app);
+            Logger::instance().flush();
+            return exitCode;
+        }
+    }
+
     QGuiApplication app(argc, argv);
 
+    // Dziennik asynchroniczny; komunikaty Qt i console.log z QML też przez niego
+    Logger::instance().configureFromEnvironment();
+    qInstallMessageHandler(Logger::messageHandler);
+
+    // Rejestracja własnych elementów QML
+    qmlRegisterType<HeatmapItem>("AirApi", 1, 0, "Heatmap");
+    qmlRegisterType<PlaybackLayer>("AirApi", 1, 0, "PlaybackLayer");
+    qmlRegisterType<SparklineLayer>("AirApi", 1, 0, "SparklineLayer");
+    qmlRegisterType<DashboardItem>("AirApi", 1, 0, "Dashboard");
+    qmlRegisterUncreatableType<PlaybackEngine>("AirApi", 1, 0, "PlaybackEngine", "Dostępny jako mainWindow.playback");
+    qmlRegisterUncreatableType<StationSortFilterModel>("AirApi", 1, 0, "StationSortFilterModel", "Dostępny jako mainWindow.stationModel");
+    qmlRegisterUncreatableType<BatchSearchModel>("AirApi", 1, 0, "BatchSearchModel", "Dostępny jako mainWindow.batchSearch");
+    qmlRegisterUncreatableType<SparklineCache>("AirApi", 1, 0, "SparklineCache", "Dostępny jako mainWindow.sparklines");
+    qmlRegisterUncreatableType<WatchList>("AirApi", 1, 0, "WatchList", "Dostępny jako mainWindow.watchList");
+
     // Utworzenie instancji MainWindow
     MainWindow mainWindow;
 
@@ -41,5 +160,23 @@ int main(int argc, char *argv[])
                      }, Qt::QueuedConnection);
     engine.load(url);
 
-    return app.exec();
+    // Czas klatki od synchronizacji do wyświetlenia, mierzony w wątku renderowania
+    if (auto *window = qobject_cast<QQuickWindow *>(engine.rootObjects().value(0))) {
+        Histogram *frameTime = Metrics::instance().histogram("airapi_frame_duration_seconds", "Time from synchronizing a frame to presenting it.",
+                                                             Histogram::frameBuckets());
+        auto frameStart = std::make_shared<QElapsedTimer>();
+        QObject::connect(window, &QQuickWindow::beforeSynchronizing, window, [frameStart]() {
+            frameStart->start();
+        }, Qt::DirectConnection);
+        QObject::connect(window, &QQuickWindow::frameSwapped, window, [frameTime, frameStart]() {
+            if (frameStart->isValid()) {
+                frameTime->observe(frameStart->nsecsElapsed() / 1e9);
+                frameStart->invalidate();
+            }
+        }, Qt::DirectConnection);
+    }
+
+    const int exitCode = app.exec();
+    Logger::instance().flush();
+    return exitCode;
 }
@@ -12,6 +12,7 @@ import QtQuick 2.15
 import QtQuick.Controls 2.15
 import QtLocation 5.15
 import QtPositioning 5.15
+import AirApi 1.0
 
 /**
  * @brief Main application window.
@@ -67,7 +68,7 @@ ApplicationWindow {
              */
             TextField {
                 id: cityInput
-                width: parent.width - searchButton.width - 10
+                width: parent.width - radiusInput.width - searchButton.width - correlationButton.width - archiveButton.width - batchButton.width - dashboardButton.width - 60
                 height: 40
                 placeholderText: "Wpisz nazwę miasta"
                 font.pixelSize: 16
@@ -76,6 +77,24 @@ ApplicationWindow {
                 }
             }
 
+            /**
+             * @brief Search radius in km; 0 lists the stations of the city.
+             */
+            SpinBox {
+                id: radiusInput
+                width: 150
+                height: 40
+                font.pixelSize: 14
+                from: 0
+                to: 300
+                stepSize: 5
+                editable: true
+                value: mainWindow.searchRadius
+                textFromValue: function(value) { return value === 0 ? "Miasto" : value + " km" }
+                valueFromText: function(text) { var v = parseInt(text); return isNaN(v) ? 0 : v }
+                onValueModified: mainWindow.searchRadius = value
+            }
+
             /**
              * @brief Button to trigger city search.
              */
@@ -88,6 +107,74 @@ ApplicationWindow {
                     mainWindow.searchCity(cityInput.text)
                 }
             }
+
+            /**
+             * @brief Button opening the cross-station correlation view.
+             */
+            Button {
+                id: correlationButton
+                text: "Korelacje"
+                height: 40
+                font.pixelSize: 14
+                onClicked: {
+                    var component = Qt.createComponent("qrc:/CorrelationDialog.qml");
+                    if (component.status === Component.Ready) {
+                        var dialog = component.createObject(root);
+                        dialog.open();
+                    }
+                }
+            }
+
+            /**
+             * @brief Button opening the local archive browser.
+             */
+            Button {
+                id: archiveButton
+                text: "Archiwum"
+                height: 40
+                font.pixelSize: 14
+                onClicked: {
+                    var component = Qt.createComponent("qrc:/ArchivedDataDialog.qml");
+                    if (component.status === Component.Ready) {
+                        var dialog = component.createObject(root);
+                        dialog.open();
+                    }
+                }
+            }
+
+            /**
+             * @brief Button opening the multi-city search.
+             */
+            Button {
+                id: batchButton
+                text: "Wiele miast"
+                height: 40
+                font.pixelSize: 14
+                onClicked: {
+                    var component = Qt.createComponent("qrc:/BatchSearchDialog.qml");
+                    if (component.status === Component.Ready) {
+                        var dialog = component.createObject(root);
+                        dialog.open();
+                    }
+                }
+            }
+
+            /**
+             * @brief Button opening the dashboard of watched stations.
+             */
+            Button {
+                id: dashboardButton
+                text: "Tablica (" + mainWindow.watchList.count + ")"
+                height: 40
+                font.pixelSize: 14
+                onClicked: {
+                    var component = Qt.createComponent("qrc:/DashboardDialog.qml");
+                    if (component.status === Component.Ready) {
+                        var dialog = component.createObject(root);
+                        dialog.open();
+                    }
+                }
+            }
         }
 
         /**
@@ -248,6 +335,108 @@ ApplicationWindow {
                             }
                         }
                     }
+
+                    /**
+                     * @brief Overlay drawing the current time-lapse frame.
+                     */
+                    PlaybackLayer {
+                        id: playbackLayer
+                        anchors.fill: parent
+                        visible: playbackBar.active
+                        engine: mainWindow.playback
+                        center: map.center
+                        zoomLevel: map.zoomLevel
+                    }
+                }
+
+                /**
+                 * @brief Controls of the nationwide time-lapse of the last 72 hours.
+                 */
+                Rectangle {
+                    id: playbackBar
+                    property bool active: false ///< True while the time-lapse is shown
+                    anchors.left: parent.left
+                    anchors.bottom: parent.bottom
+                    anchors.margins: 4
+                    width: active ? parent.width - 8 : playbackToggle.width + 10
+                    height: 50
+                    radius: 5
+                    color: "#e0ffffff"
+
+                    Row {
+                        anchors.fill: parent
+                        anchors.margins: 5
+                        spacing: 10
+
+                        Button {
+                            id: playbackToggle
+                            text: playbackBar.active ? "Zamknij" : "Animacja 72h"
+                            height: 40
+                            font.pixelSize: 14
+                            onClicked: {
+                                playbackBar.active = !playbackBar.active
+                                if (playbackBar.active) {
+                                    mainWindow.preparePlayback(playbackParam.currentText)
+                                } else {
+                                    mainWindow.playback.playing = false
+                                }
+                            }
+                        }
+
+                        ComboBox {
+                            id: playbackParam
+                            visible: playbackBar.active
+                            width: 110
+                            height: 40
+                            model: mainWindow.catalogParams
+                            currentIndex: Math.max(0, mainWindow.catalogParams.indexOf("PM10"))
+                            onPressedChanged: if (pressed) mainWindow.buildSensorCatalog()
+                            onActivated: mainWindow.preparePlayback(currentText)
+                        }
+
+                        Button {
+                            id: playButton
+                            visible: playbackBar.active
+                            text: mainWindow.playback.playing ? "Pauza" : "Odtwórz"
+                            height: 40
+                            font.pixelSize: 14
+                            enabled: mainWindow.playback.frameCount > 0
+                            onClicked: mainWindow.playback.playing = !mainWindow.playback.playing
+                        }
+
+                        Slider {
+                            id: playbackSlider
+                            visible: playbackBar.active
+                            width: parent.width - playbackToggle.width - playbackParam.width - playButton.width
+                                   - playbackSpeed.width - frameTimeText.width - 50
+                            height: 40
+                            from: 0
+                            to: Math.max(0, mainWindow.playback.frameCount - 1)
+                            stepSize: 1
+                            value: mainWindow.playback.frame
+                            onMoved: mainWindow.playback.frame = value
+                        }
+
+                        ComboBox {
+                            id: playbackSpeed
+                            visible: playbackBar.active
+                            width: 90
+                            height: 40
+                            model: [1, 4, 12, 24]
+                            currentIndex: 1
+                            displayText: currentText + " h/s"
+                            onActivated: mainWindow.playback.speed = Number(currentText)
+                        }
+
+                        Text {
+                            id: frameTimeText
+                            visible: playbackBar.active
+                            anchors.verticalCenter: parent.verticalCenter
+                            text: mainWindow.playback.frameCount > 0 ? mainWindow.playback.frameTime.substring(0, 16) : "Brak danych"
+                            font.pixelSize: 14
+                            color: "#333"
+                        }
+                    }
                 }
             }
 
@@ -272,82 +461,174 @@ ApplicationWindow {
                 }
 
                 /**
-                 * @brief List of searched stations.
+                 * @brief Sort and filter controls of the station list.
                  */
-                ListView {
-                    id: stationList
+                Row {
+                    id: listControls
                     width: parent.width
-                    height: parent.height - listHeader.height - parent.spacing
-                    spacing: 10
-                    clip: true
-
-                    model: mainWindow.stations
-
-                    delegate: Rectangle {
-                        width: parent.width
-                        height: 120
-                        color: modelData.stationId === root.highlightedStationId ? "#e0e0e0" : (mouseArea.containsMouse ? "#e0e0e0" : "#f0f0f0")
-                        radius: 5
-
-                        /**
-                         * @brief Handles mouse interactions with station list items.
-                         */
-                        MouseArea {
-                            id: mouseArea
-                            anchors.fill: parent
-                            hoverEnabled: true
-                            z: 1
-                            onEntered: {
-                                root.highlightedStationId = modelData.stationId
-                            }
-                            onExited: {
-                                root.highlightedStationId = -1
-                            }
-                            onClicked: {
-                                mainWindow.fetchSensors(modelData.stationId)
-                                var component = Qt.createComponent("qrc:/StationDialog.qml");
-                                if (component.status === Component.Ready) {
-                                    var address = modelData.address ? modelData.address : "Brak danych";
-                                    var street = address === "Brak danych" ? "Brak danych" : address.split(" ")[0];
-                                    var number = address === "Brak danych" ? "" : (address.split(" ").length > 1 ? address.split(" ")[1] : "");
-                                    var dialog = component.createObject(root, {
-                                        "stationId": modelData.stationId,
-                                        "cityName": modelData.cityName,
-                                        "street": street,
-                                        "number": number
-                                    });
-                                    dialog.open();
+                    spacing: 5
+
+                    ComboBox {
+                        id: sortSelector
+                        width: 150
+                        height: 35
+                        font.pixelSize: 12
+                        model: ["Kolejność API", "Odległość", "Miasto", "Nazwa", "Ostatni odczyt", "Indeks"]
+                        currentIndex: mainWindow.stationModel.sortKey
+                        onActivated: mainWindow.stationModel.sortKey = currentIndex
+                    }
+
+                    Button {
+                        id: directionButton
+                        width: 35
+                        height: 35
+                        text: mainWindow.stationModel.descending ? "↓" : "↑"
+                        onClicked: mainWindow.stationModel.descending = !mainWindow.stationModel.descending
+                    }
+
+                    ComboBox {
+                        id: sparklineSelector
+                        width: 110
+                        height: 35
+                        font.pixelSize: 12
+                        model: ["Bez wykresu"].concat(mainWindow.catalogParams)
+                        onPressedChanged: if (pressed) mainWindow.buildSensorCatalog()
+                        onActivated: mainWindow.setSparklineParam(currentIndex === 0 ? "" : currentText)
+                    }
+
+                    TextField {
+                        width: parent.width - sortSelector.width - directionButton.width - sparklineSelector.width - 3 * parent.spacing
+                        height: 35
+                        font.pixelSize: 12
+                        placeholderText: "Filtruj stacje..."
+                        onTextChanged: mainWindow.stationModel.filterText = text
+                    }
+                }
+
+                /**
+                 * @brief List of searched stations with their sparklines.
+                 */
+                Item {
+                    width: parent.width
+                    height: parent.height - listHeader.height - listControls.height - 2 * parent.spacing
+
+                    ListView {
+                        id: stationList
+                        anchors.fill: parent
+                        spacing: 10
+                        clip: true
+
+                        model: mainWindow.stationModel
+
+                        delegate: Rectangle {
+                            width: parent.width
+                            height: 120
+                            color: model.stationId === root.highlightedStationId ? "#e0e0e0" : (mouseArea.containsMouse ? "#e0e0e0" : "#f0f0f0")
+                            radius: 5
+
+                            /**
+                             * @brief Handles mouse interactions with station list items.
+                             */
+                            MouseArea {
+                                id: mouseArea
+                                anchors.fill: parent
+                                hoverEnabled: true
+                                z: 1
+                                onEntered: {
+                                    root.highlightedStationId = model.stationId
+                                }
+                                onExited: {
+                                    root.highlightedStationId = -1
+                                }
+                                onClicked: {
+                                    mainWindow.fetchSensors(model.stationId)
+                                    var component = Qt.createComponent("qrc:/StationDialog.qml");
+                                    if (component.status === Component.Ready) {
+                                        var address = model.address ? model.address : "Brak danych";
+                                        var street = address === "Brak danych" ? "Brak danych" : address.split(" ")[0];
+                                        var number = address === "Brak danych" ? "" : (address.split(" ").length > 1 ? address.split(" ")[1] : "");
+                                        var dialog = component.createObject(root, {
+                                            "stationId": model.stationId,
+                                            "cityName": model.cityName,
+                                            "street": street,
+                                            "number": number
+                                        });
+                                        dialog.open();
+                                    }
                                 }
                             }
-                        }
 
-                        /**
-                         * @brief Displays station details in the list item.
-                         */
-                        Column {
-                            anchors.fill: parent
-                            anchors.margins: 10
-                            spacing: 5
-                            z: 0
-
-                            Text {
-                                text: "<b>Nazwa:</b> " + modelData.stationName
-                                font.pixelSize: 14
-                            }
-                            Text {
-                                text: "<b>ID:</b> " + modelData.stationId
-                                font.pixelSize: 14
+                            /**
+                             * @brief Adds the station to the dashboard or removes it.
+                             */
+                            Button {
+                                id: watchButton
+                                anchors.top: parent.top
+                                anchors.right: parent.right
+                                anchors.topMargin: 8
+                                anchors.rightMargin: mainWindow.sparklines.param !== "" ? 140 : 10
+                                width: 30
+                                height: 30
+                                z: 2
+                                flat: true
+                                font.pixelSize: 18
+                                // count wiąże tekst ze zmianami listy obserwowanych
+                                text: mainWindow.watchList.count >= 0 && mainWindow.watchList.contains(model.stationId) ? "★" : "☆"
+                                onClicked: mainWindow.toggleWatch(model.stationId)
                             }
-                            Text {
-                                text: "<b>Współrzędne:</b> " + modelData.lat + ", " + modelData.lon
-                                font.pixelSize: 14
-                            }
-                            Text {
-                                text: "<b>Adres:</b> " + (modelData.address ? modelData.address : "Brak danych")
-                                font.pixelSize: 14
+
+                            /**
+                             * @brief Displays station details in the list item.
+                             */
+                            Column {
+                                anchors.fill: parent
+                                anchors.margins: 10
+                                anchors.rightMargin: watchButton.anchors.rightMargin + watchButton.width + 5
+                                spacing: 5
+                                z: 0
+
+                                Text {
+                                    width: parent.width
+                                    elide: Text.ElideRight
+                                    text: "<b>Nazwa:</b> " + model.stationName
+                                    font.pixelSize: 14
+                                }
+                                Text {
+                                    width: parent.width
+                                    elide: Text.ElideRight
+                                    text: "<b>ID:</b> " + mainWindow.qualifiedId(model.stationId)
+                                    font.pixelSize: 14
+                                }
+                                Text {
+                                    width: parent.width
+                                    elide: Text.ElideRight
+                                    text: "<b>Współrzędne:</b> " + model.lat + ", " + model.lon
+                                    font.pixelSize: 14
+                                }
+                                Text {
+                                    width: parent.width
+                                    elide: Text.ElideRight
+                                    text: "<b>Adres:</b> " + (model.address ? model.address : "Brak danych")
+                                    font.pixelSize: 14
+                                }
                             }
                         }
                     }
+
+                    /**
+                     * @brief Sparklines of the visible rows, drawn over the list in one node.
+                     */
+                    SparklineLayer {
+                        anchors.fill: parent
+                        clip: true
+                        cache: mainWindow.sparklines
+                        model: mainWindow.stationModel
+                        contentY: stationList.contentY - stationList.originY
+                        rowHeight: 120
+                        rowSpacing: stationList.spacing
+                        lineRect: Qt.rect(width - 135, 15, 120, 90)
+                        visible: mainWindow.sparklines.param !== ""
+                    }
                 }
             }
         }
@@ -9,14 +9,34 @@
  */
 
 #include "mainwindow.h"
+#include "seriesdiff.h"
+#include "airquality.h"
+#include "giosprovider.h"
+#include "logger.h"
+#include "metrics.h"
+#include "taskpool.h"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QNetworkRequest>
 #include <QUrlQuery>
-#include <QDebug>
 #include <QFile>
+#include <QSaveFile>
+#include <QDir>
 #include <QDateTime>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+LogCategory logArchive("archive");                  ///< Archive and its settings
+LogCategory logIngest("ingest");                    ///< Line protocol endpoint
+LogCategory logSensors("sensors");                  ///< Sensor data replies
+LogCategory logMetrics("metrics");                  ///< Metrics endpoint
+
+} // namespace
 
 /**
  * @brief Constructs a MainWindow object.
@@ -29,105 +49,1126 @@ MainWindow::MainWindow(QObject *parent)
     : QObject(parent),
     m_mapCenter(52.2297, 21.0122), // Domyślnie Warszawa
     m_status("Wprowadź nazwę miasta i kliknij Szukaj"),
-    m_networkManager(new QNetworkAccessManager(this))
+    m_networkManager(new QNetworkAccessManager(this)),
+    m_replyBuffers(ReplyBufferPool::of(m_networkManager)),
+    m_correlationModel(new CorrelationModel(this)),
+    m_forecastEngine(new ForecastEngine(this)),
+    m_playback(new PlaybackEngine(this)),
+    m_archiveMaintenance(new ArchiveMaintenance(&m_archive, this)),
+    m_dataBankImporter(new DataBankImporter(&m_archive, this)),
+    m_reportRenderer(new ReportRenderer(this)),
+    m_stationModel(new StationSortFilterModel(this)),
+    m_batchSearch(new BatchSearchModel(m_networkManager, this)),
+    m_sparklines(new SparklineCache(&m_seriesStore, this)),
+    m_watchList(new WatchList(&m_seriesStore, this)),
+    m_watchListPath("watchlist.json"),
+    m_ingest(new LineIngest(&m_seriesStore, this)),
+    m_providers(new ProviderRegistry(this)),
+    m_metricsExporter(new MetricsExporter(&Metrics::instance(), this))
+{
+    m_providers->add(new GiosProvider(m_networkManager));
+    m_providers->add(m_ingest);
+
+    // Wczytaj katalog czujników zapisany przy poprzednim uruchomieniu w danych aplikacji
+    const QString dataDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dataDir);
+    m_catalogPath = QDir(dataDir).filePath("sensor_catalog.json");
+    m_sensorCatalog.load(m_catalogPath);
+    m_catalogSaveTimer.setSingleShot(true);
+    m_catalogSaveTimer.setInterval(1000);
+    connect(&m_catalogSaveTimer, &QTimer::timeout, this, [this]() {
+        m_sensorCatalog.save(m_catalogPath);
+    });
+
+    connect(m_forecastEngine, &ForecastEngine::forecastsUpdated, this, &MainWindow::onForecastsUpdated);
+    m_playbackRebuildTimer.setSingleShot(true);
+    m_playbackRebuildTimer.setInterval(500);
+    connect(&m_playbackRebuildTimer, &QTimer::timeout, this, &MainWindow::rebuildPlayback);
+    m_archiveTimer.setSingleShot(true);
+    m_archiveTimer.setInterval(2000);
+    connect(&m_archiveTimer, &QTimer::timeout, this, &MainWindow::flushArchive);
+
+    // Surowe dane 2 lata, agregaty dzienne 10 lat, miesięczne bez limitu
+    RetentionPolicy retention;
+    retention.hourlyDays = 2 * 365;
+    retention.dailyDays = 10 * 365;
+    m_archive.setRetention(retention);
+
+    // Polityka fsync dziennika archiwum, np. AIRAPI_FSYNC=always lub periodic:500
+    WriteAheadLog::SyncPolicy syncPolicy = WriteAheadLog::SyncPeriodic;
+    int syncInterval = 1000;
+    const QString syncSetting = qEnvironmentVariable("AIRAPI_FSYNC");
+    if (!syncSetting.isEmpty() && !WriteAheadLog::parseSyncPolicy(syncSetting, &syncPolicy, &syncInterval)) {
+        Logger::instance().log(logArchive, LogCategory::Warning, "Nieprawidłowa wartość AIRAPI_FSYNC",
+                               {{"value", syncSetting}});
+    }
+    m_archive.setSyncPolicy(syncPolicy, syncInterval);
+    const int replayed = m_archive.recover();
+    if (replayed < 0) {
+        m_status = "Błąd odtwarzania dziennika archiwum.";
+    } else if (replayed > 0) {
+        m_status = QString("Odtworzono %1 niedokończonych zapisów archiwum.").arg(replayed);
+    }
+    connect(m_archiveMaintenance, &ArchiveMaintenance::finished, this, &MainWindow::onArchiveMaintenanceFinished);
+    runArchiveMaintenance();
+    connect(m_dataBankImporter, &DataBankImporter::progress, this, [this](int done, int total) {
+        m_status = QString("Import banku danych: %1 z %2 plików...").arg(done).arg(total);
+        emit statusChanged();
+    });
+    connect(m_dataBankImporter, &DataBankImporter::finished, this, &MainWindow::onDataBankImportFinished);
+    connect(m_reportRenderer, &ReportRenderer::progress, this, [this](int done, int total) {
+        m_status = QString("Raport: %1 z %2 stacji...").arg(done).arg(total);
+        emit statusChanged();
+    });
+    connect(m_reportRenderer, &ReportRenderer::finished, this, &MainWindow::onReportFinished);
+    m_watchList->load(m_watchListPath);
+    connect(m_watchList, &WatchList::tilesChanged, this, [this]() {
+        m_watchList->save(m_watchListPath);
+    });
+    connect(m_watchList, &WatchList::refreshRequested, this, &MainWindow::refreshWatchList);
+    refreshWatchList();
+
+    // Własne czujniki, np. AIRAPI_INGEST_PORT=9000; 0 wyłącza odbiór
+    m_ingestDeclarationTimer.setSingleShot(true);
+    m_ingestDeclarationTimer.setInterval(200);
+    connect(&m_ingestDeclarationTimer, &QTimer::timeout, this, &MainWindow::applyIngestDeclarations);
+    connect(m_ingest, &LineIngest::stationDeclared, this, [this](const IngestStation &) {
+        m_ingestStationsChanged = true;
+        m_ingestDeclarationTimer.start();
+    });
+    connect(m_ingest, &LineIngest::sensorDeclared, this, [this](const SensorInfo &sensor) {
+        m_ingestSensorsPending.append(sensor);
+        m_ingestDeclarationTimer.start();
+    });
+    connect(m_ingest, &LineIngest::sensorsUpdated, this, [this](const QList<int> &sensorIds) {
+        for (int sensorId : sensorIds) {
+            scheduleArchive(sensorId);
+            m_sparklines->sensorUpdated(sensorId);
+        }
+    });
+    bool ingestPortSet = false;
+    const int ingestPort = qEnvironmentVariableIntValue("AIRAPI_INGEST_PORT", &ingestPortSet);
+    if (!ingestPortSet || ingestPort > 0) {
+        const quint16 port = ingestPortSet ? quint16(ingestPort) : LineIngest::DefaultPort;
+        if (!m_ingest->listen(port)) {
+            Logger::instance().log(logIngest, LogCategory::Warning, "Nie można nasłuchiwać na porcie",
+                                   {{"port", port}, {"error", m_ingest->errorString()}});
+        }
+    }
+
+    // Metryki Prometheusa, np. AIRAPI_METRICS_PORT=9464; domyślnie wyłączone
+    registerMetrics();
+    const int metricsPort = qEnvironmentVariableIntValue("AIRAPI_METRICS_PORT");
+    if (metricsPort > 0 && !m_metricsExporter->listen(quint16(metricsPort))) {
+        Logger::instance().log(logMetrics, LogCategory::Warning, "Nie można nasłuchiwać na porcie",
+                               {{"port", metricsPort}, {"error", m_metricsExporter->errorString()}});
+    }
+
+    connect(m_batchSearch, &BatchSearchModel::finished, this, [this]() {
+        m_status = QString("Wyszukiwanie zbiorcze zakończone: %1 miast, %2 stacji.").arg(m_batchSearch->count()).arg(m_batchSearch->stationCount());
+        emit statusChanged();
+    });
+    connect(&m_correlationWatcher, &QFutureWatcher<QVector<float>>::finished, this, [this]() {
+        if (m_correlationCancelled) {
+            emit correlationBusyChanged();
+            return;
+        }
+        m_correlationModel->setMatrix(m_correlationLabels, m_correlationWatcher.result());
+        m_status = QString("Obliczono macierz korelacji dla %1 stacji.").arg(m_correlationLabels.size());
+        emit statusChanged();
+        emit correlationBusyChanged();
+    });
+
+    // Pobierz stacje wszystkich dostawców równolegle przy starcie
+    for (DataProvider *provider : m_providers->providers()) {
+        const int index = provider->index();
+        provider->fetchStations([this, index](const QList<StationRecord> &stations, const QString &error) {
+            onStationsFetched(index, stations, error);
+        });
+    }
+}
+
+/**
+ * @brief Destroys the MainWindow object.
+ *
+ * Saves the sensor catalog and archives sensors if a write is still pending.
+ */
+MainWindow::~MainWindow()
+{
+    Metrics::instance().removeCallbacks(this);
+    m_searchToken.cancel();
+    m_stationToken.cancel();
+    m_correlationCancelled = true;
+    m_correlationWatcher.waitForFinished();
+    m_forecastEngine->cancel();
+    m_archiveMaintenance->cancel();
+    m_dataBankImporter->cancel();
+    m_reportRenderer->cancel();
+    flushArchive();
+    if (m_catalogSaveTimer.isActive()) {
+        m_catalogSaveTimer.stop();
+        m_sensorCatalog.save(m_catalogPath);
+    }
+}
+
+/**
+ * @brief Searches for stations in a given city.
+ * @param city City name to search for.
+ *
+ * Sends a request to the Nominatim API to geocode the city and updates the map center.
+ * A search still running is cancelled.
+ */
+void MainWindow::searchCity(const QString &city)
 {
-    // Pobierz wszystkie stacje przy starcie
-    QNetworkRequest request(QUrl("https://api.gios.gov.pl/pjp-api/rest/station/findAll"));
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    m_status = "Wyszukiwanie: " + city + "...";
+    emit statusChanged();
+
+    // Nowe wyszukiwanie przerywa poprzednie, więc spóźniona odpowiedź go nie nadpisze
+    m_searchToken.cancel();
+    m_searchToken = Async::CancelToken();
+    Async::start(searchPipeline(city, m_searchToken));
+}
+
+/**
+ * @brief Geocodes a city, selects its stations and prefetches their sensors.
+ * @param city City name.
+ * @param token Cancelled by the next search.
+ * @return Task of the pipeline.
+ *
+ * The sensors of all found stations missing from the catalog are requested
+ * at once, so the station dialog opens with the catalog already filled.
+ */
+Async::Task<> MainWindow::searchPipeline(QString city, Async::CancelToken token)
+{
+    QUrlQuery query;
+    query.addQueryItem("q", city);
+    query.addQueryItem("format", "json");
+    query.addQueryItem("limit", "1");
+
+    QUrl url("https://nominatim.openstreetmap.org/search");
+    url.setQuery(query);
+
+    QNetworkRequest request(url);
+    request.setHeader(QNetworkRequest::UserAgentHeader, "ControlStationsApp/1.0");
+    static const RequestMetrics metrics("geocode");
     QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-        onStationsReply(reply);
+    m_replyBuffers->attach(reply);
+    metrics.track(reply);
+    co_await Async::finished(reply, token);
+    if (token.isCancelled()) {
+        reply->deleteLater();
+        co_return;
+    }
+    // Bez wybranych stacji nie ma czego uzupełniać; m_stations to wynik poprzedniego wyszukiwania
+    if (!onGeocodeReply(reply, city)) {
+        co_return;
+    }
+
+    QList<int> stationIds;
+    std::vector<Async::Task<Async::Result<QList<SensorInfo>>>> requests;
+    for (const Station *station : std::as_const(m_stations)) {
+        const int stationId = station->stationId();
+        if (m_sensorCatalog.hasStation(stationId)) {
+            continue;
+        }
+        stationIds.append(stationId);
+        requests.push_back(Async::sensors(m_providers, stationId, token));
+    }
+    const QList<Async::Result<QList<SensorInfo>>> results = co_await Async::whenAll(std::move(requests));
+    if (token.isCancelled()) {
+        co_return;
+    }
+    for (qsizetype i = 0; i < results.size(); ++i) {
+        if (results[i].ok()) {
+            updateSensorCatalog(stationIds[i], results[i].value);
+        }
+    }
+}
+
+/**
+ * @brief Searches for stations in many cities at once.
+ * @param cities City names.
+ *
+ * Results are grouped by city in batchSearch(); the list of searched
+ * stations is not changed.
+ */
+void MainWindow::searchCities(const QStringList &cities)
+{
+    m_batchSearch->search(cities, m_searchRadius);
+    if (m_batchSearch->pending() > 0) {
+        m_status = QString("Wyszukiwanie %1 miast, oczekuje na geokodowanie: %2...").arg(m_batchSearch->count()).arg(m_batchSearch->pending());
+        emit statusChanged();
+    }
+}
+
+/**
+ * @brief Fetches sensors for a station.
+ * @param stationId Station ID.
+ *
+ * Asks the provider of the station for its sensors.
+ */
+void MainWindow::fetchSensors(int stationId)
+{
+    // Czujniki poprzednio klikniętej stacji nie zastąpią już listy bieżącej
+    m_stationToken.cancel();
+    m_stationToken = Async::CancelToken();
+    Async::start(sensorsPipeline(stationId, m_stationToken));
+}
+
+/**
+ * @brief Fetches the sensors of the selected station.
+ * @param stationId Station ID.
+ * @param token Cancelled when another station is selected.
+ * @return Task of the request.
+ */
+Async::Task<> MainWindow::sensorsPipeline(int stationId, Async::CancelToken token)
+{
+    const Async::Result<QList<SensorInfo>> sensors = co_await Async::sensors(m_providers, stationId, token);
+    if (!token.isCancelled()) {
+        onSensorsFetched(stationId, sensors.value, sensors.error);
+    }
+}
+
+/**
+ * @brief Fetches data for a sensor.
+ * @param sensorId Sensor ID.
+ *
+ * Asks the provider of the sensor for its recent series.
+ */
+void MainWindow::fetchSensorData(int sensorId)
+{
+    m_providers->fetchSeries(sensorId, [this, sensorId](const Series &series, const QString &error) {
+        onSensorDataFetched(sensorId, series, error);
+    });
+}
+
+/**
+ * @brief Gets all sensors of a parameter from the global catalog.
+ * @param param Parameter code or formula, e.g. "PM2.5".
+ * @return List of sensor maps.
+ */
+QVariantList MainWindow::sensorsForParam(const QString &param) const
+{
+    QVariantList result;
+    const QList<int> sensorIds = m_sensorCatalog.sensorsForParam(param);
+    for (int sensorId : sensorIds) {
+        result.append(m_sensorCatalog.sensor(sensorId).toVariantMap());
+    }
+    return result;
+}
+
+/**
+ * @brief Adds a derived series computed from sensor series.
+ * @param expression Expression text, e.g. "s101 / s102".
+ * @return Key of the derived series in sensorData, empty on error.
+ */
+QString MainWindow::addDerivedSeries(const QString &expression)
+{
+    QString error;
+    const Expression compiled = Expression::parse(expression, &error);
+    if (!compiled.isValid()) {
+        m_status = "Błąd wyrażenia: " + error;
+        emit statusChanged();
+        return QString();
+    }
+
+    const QString key = "=" + compiled.text();
+    m_derivedSeries.insert(key, compiled);
+
+    for (int sensorId : compiled.sensorIds()) {
+        if (!m_seriesStore.contains(sensorId)) {
+            fetchSensorData(sensorId);
+        }
+    }
+
+    if (refreshDerivedSeries(compiled.sensorIds().first())) {
+        emit sensorDataChanged();
+    }
+    return key;
+}
+
+/**
+ * @brief Removes a derived series.
+ * @param key Key returned by addDerivedSeries().
+ *
+ * The cached result of the expression is dropped with it.
+ */
+void MainWindow::removeDerivedSeries(const QString &key)
+{
+    const auto it = m_derivedSeries.constFind(key);
+    if (it != m_derivedSeries.cend()) {
+        m_derivedEngine.invalidate(it.value().text());
+        m_derivedSeries.erase(it);
+    }
+    if (m_sensorData.remove(key) > 0) {
+        emit sensorDataChanged();
+    }
+}
+
+/**
+ * @brief Validates an expression without adding it.
+ * @param expression Expression text.
+ * @return Error message, empty if the expression is valid.
+ */
+QString MainWindow::expressionError(const QString &expression) const
+{
+    QString error;
+    Expression::parse(expression, &error);
+    return error;
+}
+
+/**
+ * @brief Discovers sensors of stations missing from the global catalog.
+ * @param providerIndex Only stations of this provider, -1 for all.
+ *
+ * Asks the providers for the sensors of every station that has not been
+ * discovered yet and is not being discovered. The network manager queues
+ * the requests, so at most a few run at a time. Stations loaded after the
+ * first call are discovered when they arrive.
+ */
+void MainWindow::buildSensorCatalog(int providerIndex)
+{
+    m_catalogWanted = true;
+    for (Station *station : m_allStations) {
+        const int stationId = station->stationId();
+        if (m_sensorCatalog.hasStation(stationId) || m_catalogPending.contains(stationId)
+            || (providerIndex >= 0 && DataProvider::providerIndex(stationId) != providerIndex)) {
+            continue;
+        }
+        m_catalogPending.insert(stationId);
+        m_providers->fetchSensors(stationId, [this, stationId](const QList<SensorInfo> &sensors, const QString &error) {
+            onCatalogSensorsFetched(stationId, sensors, error);
+        });
+    }
+}
+
+/**
+ * @brief Fetches the latest value of a parameter for every station.
+ * @param param Parameter code or formula, e.g. "PM2.5".
+ *
+ * Requests the series of every sensor in the parameter index of the catalog.
+ */
+void MainWindow::fetchLatestForParam(const QString &param)
+{
+    const QString key = SensorCatalog::paramKey(param);
+    if (key != m_latestParam) {
+        m_latestParam = key;
+        m_latestValues.clear();
+        m_stationModel->clearLatestValues();
+        emit latestValuesChanged();
+    }
+
+    const QList<int> sensorIds = m_sensorCatalog.sensorsForParam(key);
+    if (sensorIds.isEmpty()) {
+        m_status = "Brak czujników parametru " + param + " w katalogu.";
+        emit statusChanged();
+        return;
+    }
+
+    for (int sensorId : sensorIds) {
+        m_providers->fetchSeries(sensorId, [this, sensorId](const Series &series, const QString &error) {
+            onLatestValueFetched(sensorId, series, error);
+        });
+    }
+}
+
+/**
+ * @brief Computes the cross-station correlation matrix of a parameter.
+ * @param param Parameter code or formula, e.g. "PM10".
+ * @param hours Length of the time window ending now.
+ * @param spearman True for Spearman rank correlation, false for Pearson.
+ *
+ * Window slices are copied on the GUI thread, so the worker threads never
+ * touch the series store.
+ */
+void MainWindow::computeCorrelation(const QString &param, int hours, bool spearman)
+{
+    if (m_correlationWatcher.isRunning()) {
+        return;
+    }
+
+    const qint64 to = QDateTime::currentMSecsSinceEpoch();
+    const qint64 from = to - qint64(hours) * 3600 * 1000;
+
+    QStringList labels;
+    QList<Series> inputs;
+    for (int sensorId : m_sensorCatalog.sensorsForParam(param)) {
+        const Series *series = m_seriesStore.find(sensorId);
+        if (!series) {
+            continue;
+        }
+        Series window = SeriesStore::slice(*series, from, to);
+        if (window.size() < 2) {
+            continue;
+        }
+        const int stationId = m_sensorCatalog.sensor(sensorId).stationId;
+        Station *station = stationById(stationId);
+        labels.append(station ? station->cityName() + ", " + station->stationName() : QString::number(stationId));
+        inputs.append(std::move(window));
+    }
+
+    if (inputs.size() < 2) {
+        // Brak serii w magazynie - pobierz je i poproś o ponowienie
+        m_status = "Za mało serii parametru " + param + " do obliczenia korelacji. Pobieranie danych, spróbuj ponownie za chwilę.";
+        emit statusChanged();
+        fetchLatestForParam(param);
+        return;
+    }
+
+    m_status = QString("Obliczanie korelacji dla %1 stacji...").arg(inputs.size());
+    emit statusChanged();
+
+    m_correlationLabels = labels;
+    const Correlation::Method method = spearman ? Correlation::Spearman : Correlation::Pearson;
+    m_correlationCancelled = false;
+    m_correlationWatcher.setFuture(TaskPool::instance().run([inputs, method, cancelled = &m_correlationCancelled]() {
+        QList<const Series *> pointers;
+        for (const Series &series : inputs) {
+            pointers.append(&series);
+        }
+        return Correlation::compute(SeriesStore::timeJoin(pointers).columns, method, cancelled);
+    }, TaskPool::High));
+    emit correlationBusyChanged();
+}
+
+/**
+ * @brief Prepares the time-lapse of a parameter over all stations.
+ * @param param Parameter code or formula, e.g. "PM10".
+ *
+ * Frames are built from the series store right away. Sensors without a
+ * series are fetched and the frames are rebuilt as their data arrives.
+ */
+void MainWindow::preparePlayback(const QString &param)
+{
+    m_playbackParam = SensorCatalog::paramKey(param);
+    rebuildPlayback();
+
+    const QList<int> sensorIds = m_sensorCatalog.sensorsForParam(m_playbackParam);
+    const bool complete = std::all_of(sensorIds.cbegin(), sensorIds.cend(), [this](int sensorId) {
+        return m_seriesStore.contains(sensorId);
     });
+    if (!complete) {
+        fetchLatestForParam(param);
+    }
+}
+
+/**
+ * @brief Selects the parameter of the station list sparklines.
+ * @param param Parameter code or formula, empty to hide the sparklines.
+ *
+ * Sensors of the parameter without a series are fetched.
+ */
+void MainWindow::setSparklineParam(const QString &param)
+{
+    const QString key = SensorCatalog::paramKey(param);
+    QHash<int, int> sensorByStation;
+    bool complete = true;
+    const QList<int> sensorIds = key.isEmpty() ? QList<int>() : m_sensorCatalog.sensorsForParam(key);
+    for (int sensorId : sensorIds) {
+        sensorByStation.insert(m_sensorCatalog.sensor(sensorId).stationId, sensorId);
+        complete = complete && m_seriesStore.contains(sensorId);
+    }
+    m_sparklines->setParam(key, sensorByStation);
+    if (!complete) {
+        fetchLatestForParam(param);
+    }
+}
+
+/**
+ * @brief Adds a station to the dashboard or removes it.
+ * @param stationId Station ID.
+ */
+void MainWindow::toggleWatch(int stationId)
+{
+    if (m_watchList->remove(stationId)) {
+        return;
+    }
+    if (m_watchList->param().isEmpty()) {
+        m_watchList->setParam(SensorCatalog::paramKey("PM10"));
+    }
+    const Station *station = stationById(stationId);
+    const QString title = station ? station->stationName() : QString("Stacja nr %1").arg(stationId);
+    const int sensorId = sensorForStation(stationId, m_watchList->param());
+    if (!m_watchList->add(stationId, sensorId, title)) {
+        m_status = QString("Panel może obserwować najwyżej %1 stacji.").arg(WatchList::MaxTiles);
+        emit statusChanged();
+        return;
+    }
+    // Pozostałe kafelki odświeża zegar, wystarczy pobrać nowy czujnik
+    fetchWatchSensors(sensorId >= 0 ? QList<int>{sensorId} : QList<int>());
+}
+
+/**
+ * @brief Selects the parameter shown on the dashboard.
+ * @param param Parameter code or formula, e.g. "PM10".
+ */
+void MainWindow::setWatchParam(const QString &param)
+{
+    const QString key = SensorCatalog::paramKey(param);
+    m_watchList->setParam(key);
+    for (const WatchTile &tile : m_watchList->tiles()) {
+        m_watchList->setSensor(tile.stationId, sensorForStation(tile.stationId, key));
+    }
+    m_watchList->save(m_watchListPath);
+    refreshWatchList();
+}
+
+/**
+ * @brief Fetches the series of all watched sensors as one refresh cycle.
+ */
+void MainWindow::refreshWatchList()
+{
+    fetchWatchSensors(m_watchList->sensorIds());
+}
+
+/**
+ * @brief Fetches the series of watched sensors within a refresh cycle.
+ * @param sensorIds Sensors to fetch.
+ *
+ * Replies only feed the series store; the watch list publishes all tiles
+ * together when the last reply of the cycle arrives. Sensors the running
+ * cycle already awaits are not requested again.
+ */
+void MainWindow::fetchWatchSensors(const QList<int> &sensorIds)
+{
+    const QList<int> requested = m_watchList->beginRefresh(sensorIds);
+    const int cycle = m_watchList->cycle();
+    for (int sensorId : requested) {
+        m_providers->fetchSeries(sensorId, [this, cycle, sensorId](const Series &series, const QString &error) {
+            if (error.isEmpty()) {
+                m_seriesStore.merge(sensorId, series);
+                scheduleArchive(sensorId);
+                m_sparklines->sensorUpdated(sensorId);
+            }
+            m_watchList->sensorRefreshed(cycle, sensorId);
+        });
+    }
+}
+
+/**
+ * @brief Updates the search status of a station.
+ * @param stationId Station ID.
+ * @param isSearched New search status.
+ *
+ * Updates the isSearched property for the specified station.
+ */
+void MainWindow::updateStationSearchStatus(int stationId, bool isSearched)
+{
+    for (Station *station : m_allStations) {
+        if (station->stationId() == stationId) {
+            station->setIsSearched(isSearched);
+        }
+    }
+    emit allStationsChanged();
+}
+
+/**
+ * @brief Removes data for a sensor.
+ * @param sensorId Sensor ID.
+ *
+ * Removes the data associated with the specified sensor ID.
+ */
+void MainWindow::removeSensorData(int sensorId)
+{
+    m_sensorData.remove(QString::number(sensorId));
+    m_sensorData.remove("f" + QString::number(sensorId));
+    m_forecastEngine->remove(sensorId);
+    emit sensorDataChanged();
+}
+
+/**
+ * @brief Enables or disables forecasts of watched sensors.
+ * @param enabled New state.
+ */
+void MainWindow::setForecastEnabled(bool enabled)
+{
+    if (m_forecastEnabled == enabled) {
+        return;
+    }
+    m_forecastEnabled = enabled;
+    emit forecastEnabledChanged();
+
+    if (enabled) {
+        scheduleForecasts();
+        return;
+    }
+
+    // Usuń opublikowane prognozy
+    for (auto it = m_sensorData.begin(); it != m_sensorData.end();) {
+        if (it.key().startsWith('f')) {
+            it = m_sensorData.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    emit sensorDataChanged();
+}
+
+/**
+ * @brief Sets the search radius.
+ * @param radius Radius in km, 0 to list the stations of the searched city.
+ *
+ * The station list of the last search is rebuilt immediately.
+ */
+void MainWindow::setSearchRadius(double radius)
+{
+    radius = std::max(0.0, radius);
+    if (radius == m_searchRadius) {
+        return;
+    }
+    m_searchRadius = radius;
+    emit searchRadiusChanged();
+
+    if (m_searchPoint.isValid()) {
+        selectSearchedStations();
+    }
+}
+
+/**
+ * @brief Schedules forecasts of all watched sensors.
+ *
+ * All watched sensors go to the forecast engine as one batch.
+ */
+void MainWindow::scheduleForecasts()
+{
+    QHash<int, Series> inputs;
+    for (auto it = m_sensorData.cbegin(); it != m_sensorData.cend(); ++it) {
+        bool ok = false;
+        const int sensorId = it.key().toInt(&ok);
+        const Series *series = ok ? m_seriesStore.find(sensorId) : nullptr;
+        if (series) {
+            inputs.insert(sensorId, *series);
+        }
+    }
+    if (!inputs.isEmpty()) {
+        m_forecastEngine->schedule(inputs);
+    }
+}
+
+/**
+ * @brief Publishes finished forecasts in sensorData.
+ * @param sensorIds Sensors with a new forecast.
+ */
+void MainWindow::onForecastsUpdated(const QList<int> &sensorIds)
+{
+    if (!m_forecastEnabled) {
+        return;
+    }
+    for (int sensorId : sensorIds) {
+        // Prognozy tylko dla czujników nadal widocznych na wykresie
+        if (m_sensorData.contains(QString::number(sensorId))) {
+            m_sensorData["f" + QString::number(sensorId)] = m_forecastEngine->forecast(sensorId).toVariantList();
+        }
+    }
+    emit sensorDataChanged();
+}
+
+/**
+ * @brief Rebuilds the time-lapse frames from the series store.
+ *
+ * Frames point into the store only while being built; the engine keeps its
+ * own copy of the values.
+ */
+void MainWindow::rebuildPlayback()
+{
+    QList<PlaybackStation> inputs;
+    for (int sensorId : m_sensorCatalog.sensorsForParam(m_playbackParam)) {
+        const Series *series = m_seriesStore.find(sensorId);
+        Station *station = stationById(m_sensorCatalog.sensor(sensorId).stationId);
+        if (!series || !station) {
+            continue;
+        }
+        inputs.append({station->stationId(), station->lat(), station->lon(), series});
+    }
+    m_playback->build(m_playbackParam, inputs);
+}
+
+/**
+ * @brief Reads the archived series of a sensor for a chart.
+ * @param sensorId Sensor ID.
+ * @param hours Length of the time window ending now.
+ * @param pixels Width of the chart in pixels.
+ * @return List of maps with "date", "value", "min", "max" and "count",
+ *         newest first.
+ *
+ * A one-year window on a chart a few hundred pixels wide reads the daily
+ * rollups, so only a few hundred aggregates are loaded.
+ */
+QVariantList MainWindow::archivedSeries(int sensorId, int hours, int pixels)
+{
+    const QDateTime to = QDateTime::currentDateTime();
+    return archiveSeries(sensorId, to.addSecs(-qint64(hours) * 3600), to, -1, pixels);
+}
+
+/**
+ * @brief Reads an arbitrary time window of an archived sensor.
+ * @param sensorId Sensor ID.
+ * @param from Window start.
+ * @param to Window end.
+ * @param resolution LocalArchive::Resolution (0 hourly, 1 daily,
+ *        2 monthly), or -1 to pick it for the chart width.
+ * @param pixels Width of the chart in pixels, used when resolution is -1.
+ * @return List of maps with "date", "value", "min", "max" and "count",
+ *         newest first.
+ *
+ * The window start is moved back to the start of its bucket, so the first
+ * day or month of the window is not cut off.
+ */
+QVariantList MainWindow::archiveSeries(int sensorId, const QDateTime &from, const QDateTime &to, int resolution, int pixels)
+{
+    // Dane czekające na zapis mają być widoczne od razu
+    if (m_archivePending.contains(sensorId)) {
+        flushArchive();
+    }
+    const qint64 start = from.toMSecsSinceEpoch();
+    const qint64 end = to.toMSecsSinceEpoch();
+    const LocalArchive::Resolution chosen = resolution >= LocalArchive::Hourly && resolution <= LocalArchive::Monthly
+                                                ? LocalArchive::Resolution(resolution)
+                                                : LocalArchive::chooseResolution(start, end, pixels);
+    return m_archive.read(sensorId, LocalArchive::bucketStart(start, chosen), end, chosen).toVariantList();
+}
+
+/**
+ * @brief Lists the sensors present in the local archive.
+ * @return List of maps with "sensorId", "stationId", "paramCode",
+ *         "stationName" and "cityName"; unknown fields are empty.
+ */
+QVariantList MainWindow::archivedSensors() const
+{
+    QVariantList list;
+    for (int sensorId : m_archive.sensorIds()) {
+        const SensorInfo info = m_sensorCatalog.sensor(sensorId);
+        const Station *station = info.stationId > 0 ? stationById(info.stationId) : nullptr;
+        QVariantMap entry;
+        entry["sensorId"] = sensorId;
+        entry["stationId"] = info.stationId;
+        entry["paramCode"] = info.paramCode;
+        entry["stationName"] = station ? station->stationName() : QString();
+        entry["cityName"] = station ? station->cityName() : QString();
+        list.append(entry);
+    }
+    return list;
+}
+
+/**
+ * @brief Lists the saved snapshots of a station.
+ * @param stationId Station ID.
+ * @return List of maps with "path" and "saveDate", newest first.
+ */
+QVariantList MainWindow::stationSnapshots(int stationId) const
+{
+    QVariantList list;
+    const QString prefix = QString("station_%1_").arg(stationId);
+    const QFileInfoList files = QDir::current().entryInfoList(QStringList() << prefix + "*.json", QDir::Files, QDir::Name | QDir::Reversed);
+    for (const QFileInfo &file : files) {
+        // Nazwa pliku zawiera czas zapisu w formacie yyyyMMdd_HHmmss
+        const QDateTime saved = QDateTime::fromString(file.completeBaseName().mid(prefix.size()), "yyyyMMdd_HHmmss");
+        if (!saved.isValid()) {
+            continue;
+        }
+        QVariantMap snapshot;
+        snapshot["path"] = file.absoluteFilePath();
+        snapshot["saveDate"] = saved.toString("yyyy-MM-dd HH:mm:ss");
+        list.append(snapshot);
+    }
+    return list;
+}
+
+/**
+ * @brief Compares a saved snapshot of a sensor with its live series.
+ * @param path Snapshot file from stationSnapshots().
+ * @param sensorId Sensor ID.
+ * @return Map with "samples" (see SeriesDiff::toVariantList()) and the
+ *         "changed", "added", "removed" and "unchanged" counts; empty if
+ *         the snapshot cannot be read or the sensor has no live data.
+ */
+QVariantMap MainWindow::snapshotDiff(const QString &path, int sensorId) const
+{
+    QVariantMap result;
+    bool ok = false;
+    const QHash<int, Series> snapshot = ArchiveMaintenance::readSnapshot(path, &ok);
+    const Series *live = m_seriesStore.find(sensorId);
+    if (!ok || !live) {
+        return result;
+    }
+
+    const SeriesDiff diff = SeriesDiff::compute(snapshot.value(sensorId), *live);
+    result["samples"] = diff.toVariantList();
+    result["changed"] = diff.changed;
+    result["added"] = diff.added;
+    result["removed"] = diff.removed;
+    result["unchanged"] = diff.unchanged;
+    return result;
+}
+
+/**
+ * @brief Starts archive maintenance in the background.
+ *
+ * Legacy snapshots are looked up in the working directory, where
+ * saveStationData() writes them.
+ */
+void MainWindow::runArchiveMaintenance()
+{
+    m_archiveMaintenance->start(QDir::currentPath());
+}
+
+/**
+ * @brief Reports the result of archive maintenance.
+ * @param report Report of the run.
+ *
+ * Runs that changed nothing leave the status message alone.
+ */
+void MainWindow::onArchiveMaintenanceFinished(const MaintenanceReport &report)
+{
+    if (report.filesImported == 0 && report.filesFailed == 0 && report.segmentsCompacted == 0
+        && report.rowsExpired == 0 && !report.interrupted) {
+        return;
+    }
+    m_status = QString("Archiwum: zaimportowano %1 plików (%2 pomiarów), spakowano %3 segmentów, usunięto %4 starych wierszy.")
+                   .arg(report.filesImported).arg(report.samplesImported)
+                   .arg(report.segmentsCompacted).arg(report.rowsExpired);
+    if (report.filesFailed > 0) {
+        m_status += QString(" Nieczytelne pliki: %1.").arg(report.filesFailed);
+    }
+    if (report.interrupted) {
+        m_status += " Konserwacja przerwana, zostanie wznowiona przy następnym uruchomieniu.";
+    }
+    emit statusChanged();
+}
+
+/**
+ * @brief Starts importing a directory of GIOŚ data bank files.
+ * @param directory Directory or file URL with the yearly files saved as
+ *        CSV and the station metadata file.
+ *
+ * The API does not report station codes, so every code of the metadata file
+ * is assigned to the nearest GIOŚ station within 0.5 km of its coordinates.
+ * Stations closed before the current list was published stay unmapped.
+ */
+void MainWindow::importDataBank(const QString &directory)
+{
+    if (m_dataBankImporter->isRunning()) {
+        m_status = "Import banku danych już trwa.";
+        emit statusChanged();
+        return;
+    }
+    const QUrl url(directory);
+    const QString path = url.isLocalFile() ? url.toLocalFile() : directory;
+
+    QString metadataPath;
+    const QStringList files = DataBankImporter::scanDirectory(path, &metadataPath);
+    bool ok = false;
+    const QList<BankStation> bankStations = metadataPath.isEmpty() ? QList<BankStation>()
+                                                                   : DataBankImporter::readMetadata(metadataPath, &ok);
+    if (!ok || files.isEmpty()) {
+        m_status = QString("Katalog %1 nie zawiera metadanych stacji i plików z pomiarami w formacie CSV.").arg(path);
+        emit statusChanged();
+        return;
+    }
+
+    QHash<QString, int> stationByCode;
+    for (const BankStation &bankStation : bankStations) {
+        const QVector<GeoTable::Hit> hits = m_stationCoordinates.within(bankStation.lat, bankStation.lon, 0.5);
+        for (const GeoTable::Hit &hit : hits) {
+            const int stationId = m_allStations[hit.index]->stationId();
+            // Bank danych obejmuje tylko stacje GIOŚ, czyli pierwszego dostawcy
+            if (DataProvider::providerIndex(stationId) != 0) {
+                continue;
+            }
+            for (const QString &code : bankStation.codes) {
+                stationByCode.insert(code, stationId);
+            }
+            break;
+        }
+    }
+
+    m_dataBankImporter->start(files, stationByCode, m_sensorCatalog);
+    m_status = QString("Import banku danych: %1 plików, rozpoznano %2 kodów stacji...")
+                   .arg(files.size()).arg(stationByCode.size());
+    emit statusChanged();
+}
+
+/**
+ * @brief Reports the result of a data bank import.
+ * @param report Report of the import.
+ */
+void MainWindow::onDataBankImportFinished(const BankImportReport &report)
+{
+    m_status = QString("Bank danych: zaimportowano %1 plików (%2 wierszy, %3 pomiarów z %4 kolumn).")
+                   .arg(report.filesImported).arg(report.rowsParsed)
+                   .arg(report.samplesImported).arg(report.columnsImported);
+    if (report.filesSkipped > 0) {
+        m_status += QString(" Pominięto %1 plików bez danych godzinowych.").arg(report.filesSkipped);
+    }
+    if (report.samplesRolledUp > 0) {
+        m_status += QString(" %1 pomiarów starszych niż okres przechowywania danych godzinowych zapisano tylko jako średnie dzienne i miesięczne.")
+                        .arg(report.samplesRolledUp);
+    }
+    if (report.samplesExpired > 0) {
+        m_status += QString(" Pominięto %1 pomiarów starszych niż okres przechowywania archiwum.").arg(report.samplesExpired);
+    }
+    if (report.filesFailed > 0) {
+        m_status += QString(" Nieczytelne pliki: %1.").arg(report.filesFailed);
+    }
+    if (report.columnsUnmapped > 0) {
+        // Pełna lista bywa długa, pokazujemy początek
+        m_status += QString(" Kolumny bez czujnika: %1 (nieznane stacje: %2).")
+                        .arg(report.columnsUnmapped)
+                        .arg(report.unmappedStations.mid(0, 10).join(", ")
+                             + (report.unmappedStations.size() > 10 ? ", ..." : ""));
+    }
+    if (report.interrupted) {
+        m_status += " Import przerwany.";
+    }
+    emit statusChanged();
+    emit dataBankImportFinished();
+}
+
+/**
+ * @brief Starts writing report files of stations.
+ * @param stationIds Station IDs.
+ * @param directory Output directory or file URL, created if missing.
+ * @param format "png" or "pdf".
+ * @param hours Length of the report window ending now.
+ * @return False if a report is already running or the format is unknown.
+ */
+bool MainWindow::generateReport(const QVariantList &stationIds, const QString &directory, const QString &format, int hours)
+{
+    ReportRenderer::Format parsed = ReportRenderer::Png;
+    if (m_reportRenderer->isRunning() || !ReportRenderer::parseFormat(format, &parsed)) {
+        m_status = m_reportRenderer->isRunning() ? QString("Raport jest już generowany.")
+                                                 : QString("Nieznany format raportu: %1.").arg(format);
+        emit statusChanged();
+        return false;
+    }
+    QList<int> ids;
+    for (const QVariant &id : stationIds) {
+        ids.append(id.toInt());
+    }
+    const QUrl url(directory);
+    const QString path = url.isLocalFile() ? url.toLocalFile() : directory;
+
+    // Dane zbierane w wątku GUI, rysowanie w puli wątków
+    m_reportRenderer->start(reportStations(ids, hours), stationMapPoints(), path, parsed);
+    m_status = QString("Raport: 0 z %1 stacji...").arg(ids.size());
+    emit statusChanged();
+    return true;
 }
 
 /**
- * @brief Searches for stations in a given city.
- * @param city City name to search for.
+ * @brief Collects the data drawn in the reports of stations.
+ * @param stationIds Station IDs.
+ * @param hours Length of the report window ending now.
+ * @return One entry per station, in the order of the IDs.
  *
- * Sends a request to the Nominatim API to geocode the city and updates the map center.
+ * Series kept in memory are used when present, otherwise the hourly
+ * samples of the local archive.
  */
-void MainWindow::searchCity(const QString &city)
+QList<ReportStation> MainWindow::reportStations(const QList<int> &stationIds, int hours)
 {
-    m_status = "Wyszukiwanie: " + city + "...";
-    emit statusChanged();
-
-    QUrlQuery query;
-    query.addQueryItem("q", city);
-    query.addQueryItem("format", "json");
-    query.addQueryItem("limit", "1");
+    const qint64 to = QDateTime::currentMSecsSinceEpoch();
+    const qint64 from = to - qint64(std::max(hours, 1)) * 3600 * 1000;
+    if (!m_archivePending.isEmpty()) {
+        flushArchive();
+    }
 
-    QUrl url("https://nominatim.openstreetmap.org/search");
-    url.setQuery(query);
+    QList<ReportStation> stations;
+    stations.reserve(stationIds.size());
+    for (int stationId : stationIds) {
+        ReportStation report;
+        report.stationId = stationId;
+        report.from = from;
+        report.to = to;
+        if (const Station *station = stationById(stationId)) {
+            report.name = station->stationName();
+            report.city = station->cityName();
+            report.address = station->address();
+            report.lat = station->lat();
+            report.lon = station->lon();
+        } else {
+            report.name = QString("Stacja %1").arg(stationId);
+        }
 
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::UserAgentHeader, "ControlStationsApp/1.0");
-    QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, reply, city]() {
-        onGeocodeReply(reply, city);
-    });
+        for (int sensorId : m_sensorCatalog.sensorsForStation(stationId)) {
+            ReportSeries entry;
+            entry.param = m_sensorCatalog.sensor(sensorId).paramCode;
+            if (const Series *series = m_seriesStore.find(sensorId)) {
+                entry.series = SeriesStore::slice(*series, from, to);
+            }
+            if (entry.series.isEmpty()) {
+                const ArchiveSeries archived = m_archive.read(sensorId, from, to, LocalArchive::Hourly);
+                entry.series.timestamps = archived.timestamps;
+                entry.series.values = archived.mean;
+            }
+            if (!entry.series.isEmpty()) {
+                report.series.append(entry);
+            }
+        }
+        stations.append(report);
+    }
+    return stations;
 }
 
 /**
- * @brief Fetches sensors for a station.
- * @param stationId Station ID.
- *
- * Sends a request to the GIOŚ API to retrieve sensors for the specified station.
+ * @brief Gets the coordinates of all stations for the report map.
+ * @return Longitude (x) and latitude (y) of every station of the list.
  */
-void MainWindow::fetchSensors(int stationId)
+QVector<QPointF> MainWindow::stationMapPoints() const
 {
-    QUrl url(QString("https://api.gios.gov.pl/pjp-api/rest/station/sensors/%1").arg(stationId));
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
-        onSensorsReply(reply);
-    });
+    QVector<QPointF> points;
+    points.reserve(m_allStations.size());
+    for (const Station *station : m_allStations) {
+        points.append(QPointF(station->lon(), station->lat()));
+    }
+    return points;
 }
 
 /**
- * @brief Fetches data for a sensor.
- * @param sensorId Sensor ID.
- *
- * Sends a request to the GIOŚ API to retrieve data for the specified sensor.
+ * @brief Reports the result of a report run.
+ * @param summary Summary of the run.
  */
-void MainWindow::fetchSensorData(int sensorId)
+void MainWindow::onReportFinished(const ReportSummary &summary)
 {
-    QUrl url(QString("https://api.gios.gov.pl/pjp-api/rest/data/getData/%1").arg(sensorId));
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    QNetworkReply *reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, [this, reply, sensorId]() {
-        onSensorDataReply(reply, sensorId);
-    });
+    m_status = QString("Raport: zapisano %1 plików.").arg(summary.written);
+    if (summary.failed > 0) {
+        m_status += QString(" Nie udało się zapisać %1 plików.").arg(summary.failed);
+    }
+    if (summary.interrupted) {
+        m_status += " Raport przerwany.";
+    }
+    emit statusChanged();
+    emit reportFinished();
 }
 
 /**
- * @brief Updates the search status of a station.
- * @param stationId Station ID.
- * @param isSearched New search status.
- *
- * Updates the isSearched property for the specified station.
+ * @brief Schedules archiving of the stored series of a sensor.
+ * @param sensorId Sensor ID.
  */
-void MainWindow::updateStationSearchStatus(int stationId, bool isSearched)
+void MainWindow::scheduleArchive(int sensorId)
 {
-    for (Station *station : m_allStations) {
-        if (station->stationId() == stationId) {
-            station->setIsSearched(isSearched);
-        }
+    m_archivePending.insert(sensorId);
+    if (!m_archiveTimer.isActive()) {
+        m_archiveTimer.start();
     }
-    emit allStationsChanged();
 }
 
 /**
- * @brief Removes data for a sensor.
- * @param sensorId Sensor ID.
+ * @brief Archives the series of all scheduled sensors.
  *
- * Removes the data associated with the specified sensor ID.
+ * Months whose samples are already archived are not rewritten, so archiving
+ * the whole stored series of a sensor is cheap.
  */
-void MainWindow::removeSensorData(int sensorId)
+void MainWindow::flushArchive()
 {
-    m_sensorData.remove(QString::number(sensorId));
-    emit sensorDataChanged();
+    m_archiveTimer.stop();
+    const QSet<int> pending = std::exchange(m_archivePending, {});
+    for (int sensorId : pending) {
+        const Series *series = m_seriesStore.find(sensorId);
+        if (series && m_archive.append(sensorId, *series) < 0) {
+            m_status = "Błąd zapisu archiwum czujnika " + QString::number(sensorId) + ".";
+            emit statusChanged();
+        }
+    }
 }
 
 /**
@@ -141,13 +1182,7 @@ void MainWindow::removeSensorData(int sensorId)
 void MainWindow::saveStationData(int stationId, const QString &cityName, const QString &address)
 {
     // Find the station in allStations
-    Station *station = nullptr;
-    for (Station *s : m_allStations) {
-        if (s->stationId() == stationId) {
-            station = s;
-            break;
-        }
-    }
+    Station *station = stationById(stationId);
 
     if (!station) {
         m_status = "Błąd: Stacja o ID " + QString::number(stationId) + " nie znaleziona.";
@@ -198,8 +1233,8 @@ void MainWindow::saveStationData(int stationId, const QString &cityName, const Q
     QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss");
     QString filename = QString("station_%1_%2.json").arg(stationId).arg(timestamp);
 
-    // Save to file
-    QFile file(filename);
+    // Zapis do pliku tymczasowego i podmiana, więc przerwany zapis nie zostawia połowy pliku
+    QSaveFile file(filename);
     if (!file.open(QIODevice::WriteOnly)) {
         m_status = "Błąd: Nie można otworzyć pliku do zapisu: " + filename;
         emit statusChanged();
@@ -207,36 +1242,127 @@ void MainWindow::saveStationData(int stationId, const QString &cityName, const Q
     }
 
     file.write(jsonDoc.toJson(QJsonDocument::Indented));
-    file.close();
+    if (!file.commit()) {
+        m_status = "Błąd: Nie można zapisać pliku: " + filename;
+        emit statusChanged();
+        return;
+    }
+
+    // Dane stacji trafiają od razu także do archiwum
+    flushArchive();
 
     m_status = "Dane zapisano do pliku: " + filename;
     emit statusChanged();
 }
 
+/**
+ * @brief Rebuilds the searched stations around the last geocoded point.
+ *
+ * Lists the stations within the search radius sorted by distance or, if
+ * the radius is 0, the stations of the searched city or the nearest one.
+ */
+void MainWindow::selectSearchedStations()
+{
+    // Wyczyść listę wyszukanych stacji; QML może jeszcze trzymać stare obiekty
+    for (Station *station : std::as_const(m_stations)) {
+        station->deleteLater();
+    }
+    m_stations.clear();
+    // Resetuj flagę isSearched dla wszystkich stacji
+    for (Station *station : m_allStations) {
+        station->setIsSearched(false);
+    }
+
+    const auto addSearched = [this](Station *station) {
+        m_stations.append(new Station(
+            station->stationId(),
+            station->stationName(),
+            station->cityName(),
+            station->address(),
+            station->lat(),
+            station->lon(),
+            true,
+            this
+            ));
+        station->setIsSearched(true);
+    };
+
+    if (m_searchRadius > 0.0) {
+        // Wszystkie stacje w promieniu, od najbliższej
+        const QVector<GeoTable::Hit> hits = m_stationCoordinates.within(
+            m_searchPoint.latitude(), m_searchPoint.longitude(), m_searchRadius);
+        for (const GeoTable::Hit &hit : hits) {
+            addSearched(m_allStations[hit.index]);
+        }
+        m_status = hits.isEmpty()
+                       ? QString("Brak stacji w promieniu %1 km od %2.").arg(m_searchRadius).arg(m_searchedCity)
+                       : QString("Znaleziono %1 stacji w promieniu %2 km od %3.").arg(hits.size()).arg(m_searchRadius).arg(m_searchedCity);
+    } else {
+        // Znajdź stacje w dokładnie wyszukanym mieście
+        QString normalizedSearchedCity = m_searchedCity.toLower().simplified();
+        for (Station *station : m_allStations) {
+            QString stationCity = station->cityName().toLower().simplified();
+            if (stationCity == normalizedSearchedCity) {
+                addSearched(station);
+            }
+        }
+
+        if (m_stations.isEmpty()) {
+            // Znajdź najbliższą stację
+            QVector<double> distances(m_stationCoordinates.size());
+            m_stationCoordinates.distances(m_searchPoint.latitude(), m_searchPoint.longitude(), distances.data());
+            const auto closest = std::min_element(distances.cbegin(), distances.cend());
+
+            if (closest != distances.cend()) {
+                Station *closestStation = m_allStations[closest - distances.cbegin()];
+                addSearched(closestStation);
+
+                // Wycentruj mapę na najbliższej stacji
+                m_mapCenter = QGeoCoordinate(closestStation->lat(), closestStation->lon());
+                emit mapCenterChanged();
+
+                m_status = QString("Nie znaleziono stacji w %1. Najbliższa stacja znajduje się w %2.").arg(m_searchedCity, closestStation->cityName());
+            } else {
+                m_status = QString("Nie znaleziono stacji w %1.").arg(m_searchedCity);
+            }
+        } else {
+            m_status = QString("Znaleziono %1 stacji w %2.").arg(m_stations.count()).arg(m_searchedCity);
+        }
+    }
+
+    m_stationModel->setSearchPoint(m_searchPoint);
+    m_stationModel->setStations(m_stations);
+    emit allStationsChanged();
+    emit stationsChanged();
+    emit statusChanged();
+}
+
 /**
  * @brief Handles geocode API reply.
  * @param reply Network reply.
  * @param searchedCity Searched city name.
+ * @return True if the city was found and its stations were selected.
  *
  * Processes the response from the Nominatim API, updates the map center, and finds stations.
  */
-void MainWindow::onGeocodeReply(QNetworkReply *reply, const QString &searchedCity)
+bool MainWindow::onGeocodeReply(QNetworkReply *reply, const QString &searchedCity)
 {
     if (reply->error() != QNetworkReply::NoError) {
         m_status = "Błąd wyszukiwania: " + reply->errorString();
         emit statusChanged();
         reply->deleteLater();
-        return;
+        return false;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+    const PooledBuffer body = m_replyBuffers->take(reply);
+    QJsonDocument doc = QJsonDocument::fromJson(body.data());
     QJsonArray results = doc.array();
 
     if (results.isEmpty()) {
         m_status = "Nie znaleziono miasta.";
         emit statusChanged();
         reply->deleteLater();
-        return;
+        return false;
     }
 
     QJsonObject result = results.first().toObject();
@@ -246,181 +1372,380 @@ void MainWindow::onGeocodeReply(QNetworkReply *reply, const QString &searchedCit
     m_mapCenter = QGeoCoordinate(lat, lon);
     emit mapCenterChanged();
 
-    // Wyczyść listę wyszukanych stacji
-    m_stations.clear();
-    // Resetuj flagę isSearched dla wszystkich stacji
-    for (Station *station : m_allStations) {
-        station->setIsSearched(false);
-    }
-
-    // Znajdź stacje w dokładnie wyszukanym mieście
-    QString normalizedSearchedCity = searchedCity.toLower().simplified();
-    for (Station *station : m_allStations) {
-        QString stationCity = station->cityName().toLower().simplified();
-        if (stationCity == normalizedSearchedCity) {
-            Station *searchedStation = new Station(
-                station->stationId(),
-                station->stationName(),
-                station->cityName(),
-                station->address(),
-                station->lat(),
-                station->lon(),
-                true,
-                this
-                );
-            m_stations.append(searchedStation);
-            updateStationSearchStatus(station->stationId(), true);
-        }
-    }
-
-    if (m_stations.isEmpty()) {
-        // Znajdź najbliższą stację
-        Station *closestStation = nullptr;
-        double minDistance = std::numeric_limits<double>::max();
-        QGeoCoordinate cityCoord(lat, lon);
-
-        for (Station *station : m_allStations) {
-            QGeoCoordinate stationCoord(station->lat(), station->lon());
-            double distance = cityCoord.distanceTo(stationCoord);
-            if (distance < minDistance) {
-                minDistance = distance;
-                closestStation = station;
-            }
-        }
-
-        if (closestStation) {
-            Station *searchedStation = new Station(
-                closestStation->stationId(),
-                closestStation->stationName(),
-                closestStation->cityName(),
-                closestStation->address(),
-                closestStation->lat(),
-                closestStation->lon(),
-                true,
-                this
-                );
-            m_stations.append(searchedStation);
-            updateStationSearchStatus(closestStation->stationId(), true);
-
-            // Wycentruj mapę na najbliższej stacji
-            m_mapCenter = QGeoCoordinate(closestStation->lat(), closestStation->lon());
-            emit mapCenterChanged();
-
-            m_status = QString("Nie znaleziono stacji w %1. Najbliższa stacja znajduje się w %2.").arg(searchedCity, closestStation->cityName());
-        } else {
-            m_status = QString("Nie znaleziono stacji w %1.").arg(searchedCity);
-        }
-    } else {
-        m_status = QString("Znaleziono %1 stacji w %2.").arg(m_stations.count()).arg(searchedCity);
-    }
-
-    emit stationsChanged();
-    emit statusChanged();
+    m_searchPoint = m_mapCenter;
+    m_searchedCity = searchedCity;
+    selectSearchedStations();
     reply->deleteLater();
+    return true;
 }
 
 /**
- * @brief Handles stations API reply.
- * @param reply Network reply.
+ * @brief Replaces the stations of a provider.
+ * @param providerIndex Index of the provider.
+ * @param stations Stations reported by the provider.
+ * @param error Error message, empty on success.
  *
- * Processes the response from the GIOŚ API to populate the list of all stations.
+ * Stations of other providers are kept.
  */
-void MainWindow::onStationsReply(QNetworkReply *reply)
+void MainWindow::onStationsFetched(int providerIndex, const QList<StationRecord> &stations, const QString &error)
 {
-    if (reply->error() != QNetworkReply::NoError) {
-        m_status = "Błąd pobierania stacji: " + reply->errorString();
+    if (!error.isEmpty()) {
+        m_status = "Błąd pobierania stacji: " + error;
         emit statusChanged();
-        reply->deleteLater();
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-    QJsonArray stations = doc.array();
-
-    m_allStations.clear();
-    for (const QJsonValue &value : stations) {
-        QJsonObject obj = value.toObject();
-        int id = obj["id"].toInt();
-        QString name = obj["stationName"].toString();
-        QString city = obj["city"].toObject()["name"].toString();
-        QString address = obj["addressStreet"].toString();
-        double lat = obj["gegrLat"].toString().toDouble();
-        double lon = obj["gegrLon"].toString().toDouble();
-
-        m_allStations.append(new Station(id, name, city, address, lat, lon, false, this));
+    QList<Station*> kept;
+    for (Station *station : std::as_const(m_allStations)) {
+        const int stationId = station->stationId();
+        if (DataProvider::providerIndex(stationId) == providerIndex) {
+            station->deleteLater();
+        } else {
+            kept.append(station);
+        }
+    }
+    m_allStations = kept;
+    for (const StationRecord &record : stations) {
+        m_allStations.append(new Station(record.stationId, record.name, record.city, record.address, record.lat, record.lon, false, this));
     }
 
+    m_stationCoordinates.clear();
+    m_stationCoordinates.reserve(m_allStations.size());
+    for (Station *station : std::as_const(m_allStations)) {
+        m_stationCoordinates.append(station->lat(), station->lon());
+    }
+    m_batchSearch->setStations(m_allStations);
     emit allStationsChanged();
-    reply->deleteLater();
+
+    // Uzupełnij katalog o nowe stacje tylko, jeśli widok poprosił już o cały katalog
+    if (m_catalogWanted) {
+        buildSensorCatalog(providerIndex);
+    }
 }
 
 /**
- * @brief Handles sensors API reply.
- * @param reply Network reply.
+ * @brief Shows the fetched sensors of a station.
+ * @param stationId Station ID.
+ * @param sensors Sensors of the station.
+ * @param error Error message, empty on success.
  *
- * Processes the response from the GIOŚ API to populate the list of sensors.
+ * Populates the list of sensors and records them in the catalog.
  */
-void MainWindow::onSensorsReply(QNetworkReply *reply)
+void MainWindow::onSensorsFetched(int stationId, const QList<SensorInfo> &sensors, const QString &error)
 {
-    if (reply->error() != QNetworkReply::NoError) {
+    if (!error.isEmpty()) {
         m_sensors.clear();
         emit sensorsChanged();
-        reply->deleteLater();
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-    QJsonArray sensors = doc.array();
-
     m_sensors.clear();
-    for (const QJsonValue &sensorValue : sensors) {
-        QJsonObject obj = sensorValue.toObject();
-        QJsonObject param = obj["param"].toObject();
-        QString paramName = param["paramName"].toString();
-        int sensorId = obj["id"].toInt();
-        QVariantMap sensorInfo;
-        sensorInfo["paramName"] = paramName;
-        sensorInfo["sensorId"] = sensorId;
-        m_sensors.append(sensorInfo);
+    for (const SensorInfo &info : sensors) {
+        m_sensors.append(info.toVariantMap());
     }
 
     emit sensorsChanged();
-    reply->deleteLater();
+    updateSensorCatalog(stationId, sensors);
 }
 
 /**
- * @brief Handles sensor data API reply.
- * @param reply Network reply.
- * @param sensorId Sensor ID.
+ * @brief Records sensors fetched for the global catalog.
+ * @param stationId Station ID.
+ * @param sensors Sensors of the station.
+ * @param error Error message, empty on success.
  *
- * Processes the response from the GIOŚ API to store sensor data.
+ * Records the sensors in the catalog without touching the sensors list.
  */
-void MainWindow::onSensorDataReply(QNetworkReply *reply, int sensorId)
+void MainWindow::onCatalogSensorsFetched(int stationId, const QList<SensorInfo> &sensors, const QString &error)
 {
-    if (reply->error() != QNetworkReply::NoError) {
+    m_catalogPending.remove(stationId);
+    if (error.isEmpty()) {
+        updateSensorCatalog(stationId, sensors);
+    }
+}
+
+/**
+ * @brief Stores a series fetched by fetchLatestForParam().
+ * @param sensorId Sensor ID.
+ * @param series Samples of the sensor.
+ * @param error Error message, empty on success.
+ */
+void MainWindow::onLatestValueFetched(int sensorId, const Series &series, const QString &error)
+{
+    if (!error.isEmpty()) {
+        return;
+    }
+
+    const SensorInfo info = m_sensorCatalog.sensor(sensorId);
+    if (SensorCatalog::paramKey(info.paramCode) != m_latestParam
+        && SensorCatalog::paramKey(info.paramFormula) != m_latestParam) {
+        // Odpowiedź dotyczy poprzednio wybranego parametru
+        return;
+    }
+
+    m_seriesStore.merge(sensorId, series);
+    scheduleArchive(sensorId);
+    m_sparklines->sensorUpdated(sensorId);
+    if (!m_playbackParam.isEmpty() && m_latestParam == m_playbackParam) {
+        m_playbackRebuildTimer.start();
+    }
+    showLatestValue(sensorId);
+}
+
+/**
+ * @brief Stores the newest measurement of a sensor under its station.
+ * @param sensorId Sensor ID.
+ */
+void MainWindow::showLatestValue(int sensorId)
+{
+    const Series *series = m_seriesStore.find(sensorId);
+    if (!series) {
+        return;
+    }
+    const int stationId = m_sensorCatalog.sensor(sensorId).stationId;
+    for (qsizetype i = series->size() - 1; i >= 0; --i) {
+        const double value = series->values[i];
+        if (std::isnan(value)) {
+            continue;
+        }
+        QVariantMap latest;
+        latest["sensorId"] = sensorId;
+        latest["value"] = value;
+        latest["date"] = SeriesStore::formatDate(series->timestamps[i]);
+        m_latestValues[QString::number(stationId)] = latest;
+        m_stationModel->setLatestValue(stationId, value, AirQuality::level(m_latestParam, value));
+        emit latestValuesChanged();
+        break;
+    }
+}
+
+/**
+ * @brief Records sensors of a station in the catalog and schedules a save.
+ * @param stationId Station ID.
+ * @param sensors Sensors of the station.
+ */
+void MainWindow::updateSensorCatalog(int stationId, const QList<SensorInfo> &sensors)
+{
+    m_sensorCatalog.replaceStation(stationId, sensors);
+    m_catalogSaveTimer.start();
+    emit sensorCatalogChanged();
+}
+
+/**
+ * @brief Stores a fetched sensor series.
+ * @param sensorId Sensor ID.
+ * @param series Samples of the sensor.
+ * @param error Error message, empty on success.
+ */
+void MainWindow::onSensorDataFetched(int sensorId, const Series &series, const QString &error)
+{
+    if (!error.isEmpty()) {
         m_sensorData.remove(QString::number(sensorId));
         emit sensorDataChanged();
-        reply->deleteLater();
         return;
     }
 
-    QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-    QJsonObject obj = doc.object();
-    QJsonArray values = obj["values"].toArray();
+    QVariantList sensorDataList = SeriesStore::toVariantList(series);
 
-    QVariantList sensorDataList;
-    for (const QJsonValue &value : values) {
-        QJsonObject dataPoint = value.toObject();
-        QString date = dataPoint["date"].toString();
-        QVariant dataValue = dataPoint["value"].toVariant();
-        QVariantMap data;
-        data["date"] = date;
-        data["value"] = dataValue;
-        sensorDataList.append(data);
+    // Gorąca ścieżka: pola budujemy tylko przy włączonym poziomie
+    if (logSensors.isEnabled(LogCategory::Debug)) {
+        Logger::instance().log(logSensors, LogCategory::Debug, "Odebrano dane czujnika",
+                               {{"sensorId", sensorId}, {"points", sensorDataList.size()}});
     }
-
-    qDebug() << "Sensor ID:" << sensorId << "Data points:" << sensorDataList.size();
     m_sensorData[QString::number(sensorId)] = sensorDataList;
+    m_seriesStore.merge(sensorId, series);
+    scheduleArchive(sensorId);
+    m_sparklines->sensorUpdated(sensorId);
+    refreshDerivedSeries(sensorId);
+    if (m_forecastEnabled) {
+        m_forecastEngine->schedule({{sensorId, *m_seriesStore.find(sensorId)}});
+    }
     emit sensorDataChanged();
-    reply->deleteLater();
+}
+
+/**
+ * @brief Formats a station or sensor ID with the name of its source.
+ * @param id Global ID.
+ * @return Qualified ID, e.g. "gios:114" or "local:900001".
+ */
+QString MainWindow::qualifiedId(int id) const
+{
+    return m_providers->qualifiedId(id);
+}
+
+/**
+ * @brief Finds a station in the list of all stations.
+ * @param stationId Station ID.
+ * @return Station, or nullptr if unknown.
+ */
+Station *MainWindow::stationById(int stationId) const
+{
+    for (Station *station : m_allStations) {
+        if (station->stationId() == stationId) {
+            return station;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Finds the sensor of a parameter at a station.
+ * @param stationId Station ID.
+ * @param param Parameter key.
+ * @return Sensor ID, -1 if the catalog has none.
+ */
+int MainWindow::sensorForStation(int stationId, const QString &param) const
+{
+    for (int sensorId : m_sensorCatalog.sensorsForParam(param)) {
+        if (m_sensorCatalog.sensor(sensorId).stationId == stationId) {
+            return sensorId;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Adds the declared stations and sensors of the line ingest.
+ *
+ * Declarations are collected by a timer, so a gateway declaring hundreds
+ * of sensors rebuilds the map once.
+ */
+void MainWindow::applyIngestDeclarations()
+{
+    if (!m_ingestSensorsPending.isEmpty()) {
+        for (const SensorInfo &sensor : std::exchange(m_ingestSensorsPending, {})) {
+            m_sensorCatalog.insert(sensor);
+        }
+        m_catalogSaveTimer.start();
+        emit sensorCatalogChanged();
+    }
+    if (std::exchange(m_ingestStationsChanged, false)) {
+        const int index = m_ingest->index();
+        m_ingest->fetchStations([this, index](const QList<StationRecord> &stations, const QString &error) {
+            onStationsFetched(index, stations, error);
+        });
+    }
+}
+
+/**
+ * @brief Registers the values read by the metrics endpoint.
+ */
+void MainWindow::registerMetrics()
+{
+    Metrics &metrics = Metrics::instance();
+    metrics.callback("airapi_series", "Sensors with a series in memory.", Metrics::GaugeType,
+                     [this]() { return double(m_seriesStore.sensorIds().size()); }, QByteArray(), this);
+    metrics.callback("airapi_series_samples", "Samples of all series in memory.", Metrics::GaugeType,
+                     [this]() { return double(m_seriesStore.sampleCount()); }, QByteArray(), this);
+    metrics.callback("airapi_resident_bytes", "Resident memory of the process.", Metrics::GaugeType,
+                     []() { return double(Metrics::residentBytes()); }, QByteArray(), this);
+
+    // Kolejki: czujniki do archiwizacji, punkty odbioru i miasta do geokodowania
+    metrics.callback("airapi_queue_depth", "Items waiting in an internal queue.", Metrics::GaugeType,
+                     [this]() { return double(m_archivePending.size()); }, "queue=\"archive\"", this);
+    metrics.callback("airapi_queue_depth", "Items waiting in an internal queue.", Metrics::GaugeType,
+                     [this]() { return double(m_ingest->pendingPoints()); }, "queue=\"ingest\"", this);
+    metrics.callback("airapi_queue_depth", "Items waiting in an internal queue.", Metrics::GaugeType,
+                     [this]() { return double(m_batchSearch->pending()); }, "queue=\"geocode\"", this);
+    metrics.callback("airapi_queue_depth", "Items waiting in an internal queue.", Metrics::GaugeType,
+                     []() { return double(TaskPool::instance().stats().queued); }, "queue=\"task_pool\"", this);
+    metrics.callback("airapi_task_pool_steals_total", "Tasks taken from the deque of another pool thread.", Metrics::CounterType,
+                     []() { return double(TaskPool::instance().stats().stolen); }, QByteArray(), this);
+
+    // Bufor z puli to trafienie, nowa alokacja to chybienie
+    metrics.callback("airapi_cache_hits_total", "Lookups answered from a cache.", Metrics::CounterType,
+                     [this]() { return double(m_replyBuffers->stats().reuses); }, "cache=\"reply_buffer\"", this);
+    metrics.callback("airapi_cache_misses_total", "Lookups a cache could not answer.", Metrics::CounterType,
+                     [this]() { return double(m_replyBuffers->stats().allocations); }, "cache=\"reply_buffer\"", this);
+    // Pamięć podsystemów liczona przy odczycie z pojemności kontenerów
+    for (const QByteArray &subsystem : memorySubsystems()) {
+        const QByteArray labels = "subsystem=\"" + subsystem + '"';
+        metrics.callback("airapi_memory_bytes", "Live heap bytes of a subsystem.", Metrics::GaugeType,
+                         [this, subsystem]() { return double(memoryUsage(subsystem).bytes); }, labels, this);
+        metrics.callback("airapi_memory_objects", "Live objects of a subsystem.", Metrics::GaugeType,
+                         [this, subsystem]() { return double(memoryUsage(subsystem).objects); }, labels, this);
+    }
+}
+
+/**
+ * @brief Gets the names of the subsystems with memory accounting.
+ * @return Names in report order.
+ */
+QList<QByteArray> MainWindow::memorySubsystems()
+{
+    return {"stations", "station_coordinates", "series", "sensor_data", "sparklines", "tiles",
+            "geocode_cache", "reply_buffers"};
+}
+
+/**
+ * @brief Gets the memory held by one subsystem.
+ * @param subsystem Name from memorySubsystems().
+ * @return Bytes and objects, zero for an unknown name.
+ */
+MemoryAccounting::Usage MainWindow::memoryUsage(const QByteArray &subsystem) const
+{
+    MemoryAccounting::Usage usage;
+    if (subsystem == "stations") {
+        // Wyszukane stacje to osobne obiekty, nie kopie z listy wszystkich
+        for (const QList<Station *> *list : {&m_allStations, &m_stations}) {
+            usage.objects += list->size();
+            usage.bytes += MemoryAccounting::arrayBytes(list->capacity(), sizeof(Station *));
+            for (const Station *station : *list) {
+                usage.bytes += station->memoryBytes();
+            }
+        }
+    } else if (subsystem == "station_coordinates") {
+        usage = m_stationCoordinates.memoryUsage();
+    } else if (subsystem == "series") {
+        usage = m_seriesStore.memoryUsage();
+    } else if (subsystem == "sensor_data") {
+        usage.objects = m_sensorData.size();
+        usage.bytes = MemoryAccounting::bytes(m_sensorData);
+    } else if (subsystem == "sparklines") {
+        usage = m_sparklines->memoryUsage();
+    } else if (subsystem == "tiles") {
+        usage = m_watchList->memoryUsage();
+    } else if (subsystem == "geocode_cache") {
+        usage = m_batchSearch->memoryUsage();
+    } else if (subsystem == "reply_buffers") {
+        usage = m_replyBuffers->memoryUsage();
+    }
+    return usage;
+}
+
+/**
+ * @brief Gets the memory held by each subsystem.
+ * @return Map from subsystem name to a map with "bytes" and "objects".
+ */
+QVariantMap MainWindow::memoryUsage() const
+{
+    QVariantMap result;
+    for (const QByteArray &subsystem : memorySubsystems()) {
+        const MemoryAccounting::Usage usage = memoryUsage(subsystem);
+        result.insert(QString::fromLatin1(subsystem), QVariantMap{{"bytes", usage.bytes}, {"objects", usage.objects}});
+    }
+    return result;
+}
+
+/**
+ * @brief Recomputes derived series depending on a sensor.
+ * @param sensorId Changed sensor ID.
+ * @return True if sensorData was modified.
+ *
+ * Unchanged inputs are served from the cache of the derived series engine.
+ */
+bool MainWindow::refreshDerivedSeries(int sensorId)
+{
+    bool changed = false;
+    for (auto it = m_derivedSeries.cbegin(); it != m_derivedSeries.cend(); ++it) {
+        if (!it.value().sensorIds().contains(sensorId)) {
+            continue;
+        }
+        Series result;
+        if (m_derivedEngine.evaluate(it.value(), &result)) {
+            m_sensorData[it.key()] = SeriesStore::toVariantList(result);
+            changed = true;
+        }
+    }
+    return changed;
 }
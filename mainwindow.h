@@ -17,7 +17,32 @@
 #include <QNetworkReply>
 #include <QFile>
 #include <QJsonDocument>
+#include <QJsonArray>
 #include <QDateTime>
+#include <QTimer>
+#include <QSet>
+#include "sensorcatalog.h"
+#include "seriesstore.h"
+#include "expression.h"
+#include "correlation.h"
+#include "forecast.h"
+#include "playback.h"
+#include "localarchive.h"
+#include "archivemaintenance.h"
+#include "databankimporter.h"
+#include "reportrenderer.h"
+#include "stationsortfiltermodel.h"
+#include "geotable.h"
+#include "batchsearch.h"
+#include "sparkline.h"
+#include "watchlist.h"
+#include "lineingest.h"
+#include "dataprovider.h"
+#include "replybufferpool.h"
+#include "metricsexporter.h"
+#include "async.h"
+#include <QFutureWatcher>
+#include <atomic>
 
 /**
  * @class Station
@@ -103,6 +128,17 @@ public:
         }
     }
 
+    /**
+     * @brief Gets the memory held by the station.
+     * @return Bytes of the object and its strings, without the private data
+     *         of QObject.
+     */
+    qint64 memoryBytes() const
+    {
+        return qint64(sizeof(Station)) + MemoryAccounting::bytes(m_stationName)
+               + MemoryAccounting::bytes(m_cityName) + MemoryAccounting::bytes(m_address);
+    }
+
 signals:
     /**
      * @brief Emitted when the search status changes.
@@ -133,6 +169,18 @@ class MainWindow : public QObject {
     Q_PROPERTY(QQmlListProperty<Station> allStations READ allStations NOTIFY allStationsChanged)
     Q_PROPERTY(QVariantList sensors READ sensors NOTIFY sensorsChanged)
     Q_PROPERTY(QVariantMap sensorData READ sensorData WRITE setSensorData NOTIFY sensorDataChanged)
+    Q_PROPERTY(int catalogSensorCount READ catalogSensorCount NOTIFY sensorCatalogChanged)
+    Q_PROPERTY(QStringList catalogParams READ catalogParams NOTIFY sensorCatalogChanged)
+    Q_PROPERTY(QVariantMap latestValues READ latestValues NOTIFY latestValuesChanged)
+    Q_PROPERTY(CorrelationModel *correlationModel READ correlationModel CONSTANT)
+    Q_PROPERTY(bool correlationBusy READ correlationBusy NOTIFY correlationBusyChanged)
+    Q_PROPERTY(bool forecastEnabled READ forecastEnabled WRITE setForecastEnabled NOTIFY forecastEnabledChanged)
+    Q_PROPERTY(PlaybackEngine *playback READ playback CONSTANT)
+    Q_PROPERTY(StationSortFilterModel *stationModel READ stationModel CONSTANT)
+    Q_PROPERTY(BatchSearchModel *batchSearch READ batchSearch CONSTANT)
+    Q_PROPERTY(SparklineCache *sparklines READ sparklines CONSTANT)
+    Q_PROPERTY(WatchList *watchList READ watchList CONSTANT)
+    Q_PROPERTY(double searchRadius READ searchRadius WRITE setSearchRadius NOTIFY searchRadiusChanged)
 
 public:
     /**
@@ -141,6 +189,11 @@ public:
      */
     explicit MainWindow(QObject *parent = nullptr);
 
+    /**
+     * @brief Destroys the MainWindow object, saving pending catalog changes.
+     */
+    ~MainWindow() override;
+
     /**
      * @brief Gets the current map center.
      * @return Map center coordinates.
@@ -188,6 +241,263 @@ public:
         }
     }
 
+    /**
+     * @brief Gets the global sensor catalog.
+     * @return Sensor catalog.
+     */
+    const SensorCatalog &sensorCatalog() const { return m_sensorCatalog; }
+
+    /**
+     * @brief Gets the number of sensors in the global catalog.
+     * @return Sensor count.
+     */
+    int catalogSensorCount() const { return m_sensorCatalog.count(); }
+
+    /**
+     * @brief Gets the parameter codes present in the global catalog.
+     * @return List of parameter codes.
+     */
+    QStringList catalogParams() const { return m_sensorCatalog.paramCodes(); }
+
+    /**
+     * @brief Gets the latest values fetched by fetchLatestForParam().
+     * @return Map of station ID to a map with sensorId, value and date.
+     */
+    QVariantMap latestValues() const { return m_latestValues; }
+
+    /**
+     * @brief Gets all sensors of a parameter from the global catalog.
+     * @param param Parameter code or formula, e.g. "PM2.5".
+     * @return List of sensor maps (sensorId, stationId, paramCode, paramFormula, paramName).
+     */
+    Q_INVOKABLE QVariantList sensorsForParam(const QString &param) const;
+
+    /**
+     * @brief Gets the columnar series store.
+     * @return Series store.
+     */
+    const SeriesStore &seriesStore() const { return m_seriesStore; }
+
+    /**
+     * @brief Adds a derived series computed from sensor series.
+     * @param expression Expression text, e.g. "s101 / s102".
+     * @return Key of the derived series in sensorData, empty on error.
+     *
+     * Missing inputs are fetched; the series appears in sensorData once all
+     * inputs are available and is recomputed whenever an input changes.
+     */
+    Q_INVOKABLE QString addDerivedSeries(const QString &expression);
+
+    /**
+     * @brief Removes a derived series.
+     * @param key Key returned by addDerivedSeries().
+     */
+    Q_INVOKABLE void removeDerivedSeries(const QString &key);
+
+    /**
+     * @brief Validates an expression without adding it.
+     * @param expression Expression text.
+     * @return Error message, empty if the expression is valid.
+     */
+    Q_INVOKABLE QString expressionError(const QString &expression) const;
+
+    /**
+     * @brief Formats a station or sensor ID with the name of its source.
+     * @param id Global ID.
+     * @return Qualified ID, e.g. "gios:114" or "local:900001".
+     */
+    Q_INVOKABLE QString qualifiedId(int id) const;
+
+    /**
+     * @brief Gets the counters of the pooled reply buffers.
+     * @return See ReplyBufferPool::statsMap().
+     */
+    Q_INVOKABLE QVariantMap networkBufferStats() const { return m_replyBuffers->statsMap(); }
+
+    /**
+     * @brief Gets the memory held by each subsystem.
+     * @return Map from subsystem name, see memorySubsystems(), to a map with
+     *         "bytes" and "objects".
+     */
+    Q_INVOKABLE QVariantMap memoryUsage() const;
+
+    /**
+     * @brief Gets the memory held by one subsystem.
+     * @param subsystem Name from memorySubsystems().
+     * @return Bytes and objects, zero for an unknown name.
+     */
+    MemoryAccounting::Usage memoryUsage(const QByteArray &subsystem) const;
+
+    /**
+     * @brief Gets the names of the subsystems with memory accounting.
+     * @return Names in report order.
+     */
+    static QList<QByteArray> memorySubsystems();
+
+    /**
+     * @brief Gets the model of the last computed correlation matrix.
+     * @return Correlation model.
+     */
+    CorrelationModel *correlationModel() const { return m_correlationModel; }
+
+    /**
+     * @brief Checks whether a correlation matrix is being computed.
+     * @return True while computing.
+     */
+    bool correlationBusy() const { return m_correlationWatcher.isRunning(); }
+
+    /**
+     * @brief Checks whether 24h forecasts of watched sensors are computed.
+     * @return True if forecasting is enabled.
+     */
+    bool forecastEnabled() const { return m_forecastEnabled; }
+
+    /**
+     * @brief Enables or disables forecasts of watched sensors.
+     * @param enabled New state.
+     *
+     * Forecasts are published in sensorData under the key "f<sensorId>",
+     * with "lower" and "upper" confidence band values in every point.
+     */
+    void setForecastEnabled(bool enabled);
+
+    /**
+     * @brief Gets the search radius.
+     * @return Radius in km, 0 to list the stations of the searched city.
+     */
+    double searchRadius() const { return m_searchRadius; }
+
+    /**
+     * @brief Sets the search radius.
+     * @param radius Radius in km, 0 to list the stations of the searched city.
+     *
+     * The station list of the last search is rebuilt immediately.
+     */
+    void setSearchRadius(double radius);
+
+    /**
+     * @brief Gets the nationwide time-lapse engine.
+     * @return Playback engine.
+     */
+    PlaybackEngine *playback() const { return m_playback; }
+
+    /**
+     * @brief Gets the sorted and filtered list of searched stations.
+     * @return Station list model.
+     */
+    StationSortFilterModel *stationModel() const { return m_stationModel; }
+
+    /**
+     * @brief Gets the results of the last multi-city search.
+     * @return Batch search model.
+     */
+    BatchSearchModel *batchSearch() const { return m_batchSearch; }
+
+    /**
+     * @brief Gets the sparklines of the station list.
+     * @return Sparkline cache.
+     */
+    SparklineCache *sparklines() const { return m_sparklines; }
+
+    /**
+     * @brief Gets the watched stations of the dashboard.
+     * @return Watch list.
+     */
+    WatchList *watchList() const { return m_watchList; }
+
+    /**
+     * @brief Gets the local measurement archive.
+     * @return Archive.
+     */
+    const LocalArchive &archive() const { return m_archive; }
+
+    /**
+     * @brief Reads the archived series of a sensor for a chart.
+     * @param sensorId Sensor ID.
+     * @param hours Length of the time window ending now.
+     * @param pixels Width of the chart in pixels.
+     * @return List of maps with "date", "value", "min", "max" and "count",
+     *         newest first; daily or monthly aggregates when the window has
+     *         more hours than the chart has pixels.
+     */
+    Q_INVOKABLE QVariantList archivedSeries(int sensorId, int hours, int pixels);
+
+    /**
+     * @brief Reads an arbitrary time window of an archived sensor.
+     * @param sensorId Sensor ID.
+     * @param from Window start.
+     * @param to Window end.
+     * @param resolution LocalArchive::Resolution (0 hourly, 1 daily,
+     *        2 monthly), or -1 to pick it for the chart width.
+     * @param pixels Width of the chart in pixels, used when resolution is -1.
+     * @return List of maps with "date", "value", "min", "max" and "count",
+     *         newest first.
+     */
+    Q_INVOKABLE QVariantList archiveSeries(int sensorId, const QDateTime &from, const QDateTime &to,
+                                           int resolution = -1, int pixels = 600);
+
+    /**
+     * @brief Lists the sensors present in the local archive.
+     * @return List of maps with "sensorId", "stationId", "paramCode",
+     *         "stationName" and "cityName"; unknown fields are empty.
+     */
+    Q_INVOKABLE QVariantList archivedSensors() const;
+
+    /**
+     * @brief Lists the saved snapshots of a station.
+     * @param stationId Station ID.
+     * @return List of maps with "path" and "saveDate", newest first.
+     */
+    Q_INVOKABLE QVariantList stationSnapshots(int stationId) const;
+
+    /**
+     * @brief Compares a saved snapshot of a sensor with its live series.
+     * @param path Snapshot file from stationSnapshots().
+     * @param sensorId Sensor ID.
+     * @return Map with "samples" (see SeriesDiff::toVariantList()) and the
+     *         "changed", "added", "removed" and "unchanged" counts; empty if
+     *         the snapshot cannot be read or the sensor has no live data.
+     */
+    Q_INVOKABLE QVariantMap snapshotDiff(const QString &path, int sensorId) const;
+
+    /**
+     * @brief Starts importing a directory of GIOŚ data bank files.
+     * @param directory Directory or file URL with the yearly files saved as
+     *        CSV and the station metadata file.
+     *
+     * Station codes are matched to the stations of the list by the
+     * coordinates in the metadata file.
+     */
+    Q_INVOKABLE void importDataBank(const QString &directory);
+
+    /**
+     * @brief Starts writing report files of stations.
+     * @param stationIds Station IDs.
+     * @param directory Output directory or file URL, created if missing.
+     * @param format "png" or "pdf".
+     * @param hours Length of the report window ending now.
+     * @return False if a report is already running or the format is unknown.
+     */
+    Q_INVOKABLE bool generateReport(const QVariantList &stationIds, const QString &directory,
+                                    const QString &format, int hours);
+
+    /**
+     * @brief Collects the data drawn in the reports of stations.
+     * @param stationIds Station IDs.
+     * @param hours Length of the report window ending now.
+     * @return One entry per station, in the order of the IDs.
+     *
+     * Series kept in memory are used when present, otherwise the hourly
+     * samples of the local archive.
+     */
+    QList<ReportStation> reportStations(const QList<int> &stationIds, int hours);
+
+    /**
+     * @brief Gets the coordinates of all stations for the report map.
+     * @return Longitude (x) and latitude (y) of every station of the list.
+     */
+    QVector<QPointF> stationMapPoints() const;
+
 public slots:
     /**
      * @brief Searches for stations in a given city.
@@ -195,6 +505,15 @@ public slots:
      */
     void searchCity(const QString &city);
 
+    /**
+     * @brief Searches for stations in many cities at once.
+     * @param cities City names.
+     *
+     * Results are grouped by city in batchSearch(); the list of searched
+     * stations is not changed.
+     */
+    void searchCities(const QStringList &cities);
+
     /**
      * @brief Fetches sensors for a station.
      * @param stationId Station ID.
@@ -228,6 +547,79 @@ public slots:
      */
     void saveStationData(int stationId, const QString &cityName, const QString &address);
 
+    /**
+     * @brief Discovers sensors of stations missing from the global catalog.
+     * @param providerIndex Only stations of this provider, -1 for all.
+     *
+     * Called by the views listing the parameters of all stations when they
+     * are opened, not at startup. Sensors are recorded in the catalog only;
+     * the sensors list shown in the station dialog is not changed.
+     */
+    void buildSensorCatalog(int providerIndex = -1);
+
+    /**
+     * @brief Fetches the latest value of a parameter for every station.
+     * @param param Parameter code or formula, e.g. "PM2.5".
+     *
+     * Uses the parameter index of the global catalog, so no station needs
+     * per-station sensor discovery first.
+     */
+    void fetchLatestForParam(const QString &param);
+
+    /**
+     * @brief Computes the cross-station correlation matrix of a parameter.
+     * @param param Parameter code or formula, e.g. "PM10".
+     * @param hours Length of the time window ending now.
+     * @param spearman True for Spearman rank correlation, false for Pearson.
+     *
+     * Uses the series of all catalog sensors of the parameter present in the
+     * series store. The matrix is computed on worker threads and published in
+     * correlationModel.
+     */
+    void computeCorrelation(const QString &param, int hours, bool spearman);
+
+    /**
+     * @brief Prepares the time-lapse of a parameter over all stations.
+     * @param param Parameter code or formula, e.g. "PM10".
+     *
+     * Frames are built from the series store right away. Sensors without a
+     * series are fetched and the frames are rebuilt as their data arrives.
+     */
+    void preparePlayback(const QString &param);
+
+    /**
+     * @brief Selects the parameter of the station list sparklines.
+     * @param param Parameter code or formula, empty to hide the sparklines.
+     *
+     * Sensors of the parameter without a series are fetched.
+     */
+    void setSparklineParam(const QString &param);
+
+    /**
+     * @brief Adds a station to the dashboard or removes it.
+     * @param stationId Station ID.
+     */
+    void toggleWatch(int stationId);
+
+    /**
+     * @brief Selects the parameter shown on the dashboard.
+     * @param param Parameter code or formula, e.g. "PM10".
+     */
+    void setWatchParam(const QString &param);
+
+    /**
+     * @brief Fetches the series of all watched sensors as one refresh cycle.
+     */
+    void refreshWatchList();
+
+    /**
+     * @brief Starts archive maintenance in the background.
+     *
+     * Imports legacy station_<id>_<timestamp>.json files from the working
+     * directory, packs small segments and applies the retention policy.
+     */
+    void runArchiveMaintenance();
+
 signals:
     /**
      * @brief Emitted when the map center changes.
@@ -259,41 +651,269 @@ signals:
      */
     void sensorDataChanged();
 
+    /**
+     * @brief Emitted when the global sensor catalog changes.
+     */
+    void sensorCatalogChanged();
+
+    /**
+     * @brief Emitted when the latest values of a parameter change.
+     */
+    void latestValuesChanged();
+
+    /**
+     * @brief Emitted when a correlation computation starts or finishes.
+     */
+    void correlationBusyChanged();
+
+    /**
+     * @brief Emitted when forecasting is enabled or disabled.
+     */
+    void forecastEnabledChanged();
+
+    /**
+     * @brief Emitted when the search radius changes.
+     */
+    void searchRadiusChanged();
+
+    /**
+     * @brief Emitted when a data bank import finishes.
+     */
+    void dataBankImportFinished();
+
+    /**
+     * @brief Emitted when a report started by generateReport() finishes.
+     */
+    void reportFinished();
+
 private slots:
     /**
      * @brief Handles geocode API reply.
      * @param reply Network reply.
      * @param searchedCity Searched city name.
+     * @return True if the city was found and its stations were selected.
      */
-    void onGeocodeReply(QNetworkReply *reply, const QString &searchedCity);
+    bool onGeocodeReply(QNetworkReply *reply, const QString &searchedCity);
 
     /**
-     * @brief Handles stations API reply.
-     * @param reply Network reply.
+     * @brief Replaces the stations of a provider.
+     * @param providerIndex Index of the provider.
+     * @param stations Stations reported by the provider.
+     * @param error Error message, empty on success.
      */
-    void onStationsReply(QNetworkReply *reply);
+    void onStationsFetched(int providerIndex, const QList<StationRecord> &stations, const QString &error);
 
     /**
-     * @brief Handles sensors API reply.
-     * @param reply Network reply.
+     * @brief Shows the fetched sensors of a station.
+     * @param stationId Station ID.
+     * @param sensors Sensors of the station.
+     * @param error Error message, empty on success.
      */
-    void onSensorsReply(QNetworkReply *reply);
+    void onSensorsFetched(int stationId, const QList<SensorInfo> &sensors, const QString &error);
 
     /**
-     * @brief Handles sensor data API reply.
-     * @param reply Network reply.
+     * @brief Records sensors fetched for the global catalog.
+     * @param stationId Station ID.
+     * @param sensors Sensors of the station.
+     * @param error Error message, empty on success.
+     */
+    void onCatalogSensorsFetched(int stationId, const QList<SensorInfo> &sensors, const QString &error);
+
+    /**
+     * @brief Stores a series fetched by fetchLatestForParam().
      * @param sensorId Sensor ID.
+     * @param series Samples of the sensor.
+     * @param error Error message, empty on success.
      */
-    void onSensorDataReply(QNetworkReply *reply, int sensorId);
+    void onLatestValueFetched(int sensorId, const Series &series, const QString &error);
+
+    /**
+     * @brief Stores a fetched sensor series.
+     * @param sensorId Sensor ID.
+     * @param series Samples of the sensor.
+     * @param error Error message, empty on success.
+     */
+    void onSensorDataFetched(int sensorId, const Series &series, const QString &error);
 
 private:
+    /**
+     * @brief Fetches the series of watched sensors within a refresh cycle.
+     * @param sensorIds Sensors to fetch.
+     */
+    void fetchWatchSensors(const QList<int> &sensorIds);
+
+    /**
+     * @brief Stores the newest measurement of a sensor under its station.
+     * @param sensorId Sensor ID.
+     */
+    void showLatestValue(int sensorId);
+
+    /**
+     * @brief Records sensors of a station in the catalog and schedules a save.
+     * @param stationId Station ID.
+     * @param sensors Sensors of the station.
+     */
+    void updateSensorCatalog(int stationId, const QList<SensorInfo> &sensors);
+
+    /**
+     * @brief Recomputes derived series depending on a sensor.
+     * @param sensorId Changed sensor ID.
+     * @return True if sensorData was modified.
+     */
+    bool refreshDerivedSeries(int sensorId);
+
+    /**
+     * @brief Finds a station in the list of all stations.
+     * @param stationId Station ID.
+     * @return Station, or nullptr if unknown.
+     */
+    Station *stationById(int stationId) const;
+
+    /**
+     * @brief Schedules forecasts of all watched sensors.
+     *
+     * Watched sensors are the sensors whose data is currently in sensorData.
+     */
+    void scheduleForecasts();
+
+    /**
+     * @brief Publishes finished forecasts in sensorData.
+     * @param sensorIds Sensors with a new forecast.
+     */
+    void onForecastsUpdated(const QList<int> &sensorIds);
+
+    /**
+     * @brief Rebuilds the time-lapse frames from the series store.
+     */
+    void rebuildPlayback();
+
+    /**
+     * @brief Schedules archiving of the stored series of a sensor.
+     * @param sensorId Sensor ID.
+     */
+    void scheduleArchive(int sensorId);
+
+    /**
+     * @brief Archives the series of all scheduled sensors.
+     */
+    void flushArchive();
+
+    /**
+     * @brief Reports the result of archive maintenance.
+     * @param report Report of the run.
+     */
+    void onArchiveMaintenanceFinished(const MaintenanceReport &report);
+
+    /**
+     * @brief Reports the result of a data bank import.
+     * @param report Report of the import.
+     */
+    void onDataBankImportFinished(const BankImportReport &report);
+
+    /**
+     * @brief Reports the result of a report run.
+     * @param summary Summary of the run.
+     */
+    void onReportFinished(const ReportSummary &summary);
+
+    /**
+     * @brief Geocodes a city, selects its stations and prefetches their sensors.
+     * @param city City name.
+     * @param token Cancelled by the next search.
+     * @return Task of the pipeline.
+     */
+    Async::Task<> searchPipeline(QString city, Async::CancelToken token);
+
+    /**
+     * @brief Fetches the sensors of the selected station.
+     * @param stationId Station ID.
+     * @param token Cancelled when another station is selected.
+     * @return Task of the request.
+     */
+    Async::Task<> sensorsPipeline(int stationId, Async::CancelToken token);
+
+    /**
+     * @brief Rebuilds the searched stations around the last geocoded point.
+     *
+     * Lists the stations within the search radius sorted by distance or, if
+     * the radius is 0, the stations of the searched city or the nearest one.
+     */
+    void selectSearchedStations();
+
+    /**
+     * @brief Finds the sensor of a parameter at a station.
+     * @param stationId Station ID.
+     * @param param Parameter key.
+     * @return Sensor ID, -1 if the catalog has none.
+     */
+    int sensorForStation(int stationId, const QString &param) const;
+
+    /**
+     * @brief Adds the declared stations and sensors of the line ingest.
+     *
+     * Declarations are collected by a timer, so a gateway declaring hundreds
+     * of sensors rebuilds the map once.
+     */
+    void applyIngestDeclarations();
+
+    /**
+     * @brief Registers the values read by the metrics endpoint.
+     *
+     * Sizes of the stores and queues are read at scrape time on the GUI
+     * thread, so the data path does not update anything for them.
+     */
+    void registerMetrics();
+
     QGeoCoordinate m_mapCenter;         ///< Current map center
     QString m_status;                   ///< Current status message
+    Async::CancelToken m_searchToken;   ///< Cancels the running city search
+    Async::CancelToken m_stationToken;  ///< Cancels the sensors request of the previous station
     QList<Station*> m_stations;         ///< List of searched stations
     QList<Station*> m_allStations;      ///< List of all stations
     QVariantList m_sensors;             ///< List of sensors
     QVariantMap m_sensorData;           ///< Sensor data
     QNetworkAccessManager *m_networkManager; ///< Network manager for API requests
+    ReplyBufferPool *m_replyBuffers;    ///< Pooled bodies of all network replies
+    SensorCatalog m_sensorCatalog;      ///< Global sensor catalog
+    QString m_catalogPath;              ///< Path of the persisted sensor catalog
+    QTimer m_catalogSaveTimer;          ///< Coalesces catalog saves
+    QSet<int> m_catalogPending;         ///< Stations whose sensors are being discovered
+    bool m_catalogWanted = false;       ///< True once a view asked for the whole catalog
+    QVariantMap m_latestValues;         ///< Latest values by station ID
+    QString m_latestParam;              ///< Parameter of m_latestValues
+    SeriesStore m_seriesStore;          ///< Columnar series of fetched sensors
+    DerivedSeriesEngine m_derivedEngine{&m_seriesStore}; ///< Derived series evaluator
+    QHash<QString, Expression> m_derivedSeries; ///< Active derived series by key
+    CorrelationModel *m_correlationModel; ///< Last correlation matrix
+    QStringList m_correlationLabels;    ///< Labels of the matrix being computed
+    QFutureWatcher<QVector<float>> m_correlationWatcher; ///< Background correlation job
+    std::atomic_bool m_correlationCancelled{false}; ///< Set on destruction, stops the correlation job
+    ForecastEngine *m_forecastEngine;   ///< Batch forecaster of watched sensors
+    bool m_forecastEnabled = false;     ///< True if forecasts are computed
+    PlaybackEngine *m_playback;         ///< Nationwide time-lapse
+    QString m_playbackParam;            ///< Parameter of the time-lapse
+    QTimer m_playbackRebuildTimer;      ///< Coalesces rebuilds while data arrives
+    LocalArchive m_archive;             ///< On-disk measurement archive
+    QSet<int> m_archivePending;         ///< Sensors waiting to be archived
+    QTimer m_archiveTimer;              ///< Coalesces archive writes
+    ArchiveMaintenance *m_archiveMaintenance; ///< Legacy import, compaction and retention
+    DataBankImporter *m_dataBankImporter; ///< Import of GIOŚ data bank files
+    ReportRenderer *m_reportRenderer;   ///< Offscreen station reports
+    StationSortFilterModel *m_stationModel; ///< Sorted and filtered searched stations
+    GeoTable m_stationCoordinates;      ///< Coordinates of m_allStations
+    QGeoCoordinate m_searchPoint;       ///< Last geocoded point
+    QString m_searchedCity;             ///< Last searched city
+    double m_searchRadius = 0.0;        ///< Search radius in km, 0 for city search
+    BatchSearchModel *m_batchSearch;    ///< Results of the multi-city search
+    SparklineCache *m_sparklines;       ///< Sparklines of the station list
+    WatchList *m_watchList;             ///< Stations of the dashboard
+    QString m_watchListPath;            ///< Path of the persisted watch list
+    LineIngest *m_ingest;               ///< Endpoint and provider of our own sensors
+    bool m_ingestStationsChanged = false; ///< Declared stations not yet listed
+    QList<SensorInfo> m_ingestSensorsPending; ///< Declared sensors not yet in the catalog
+    QTimer m_ingestDeclarationTimer;    ///< Coalesces declarations of the line ingest
+    ProviderRegistry *m_providers;      ///< Sources of stations, sensors and series
+    MetricsExporter *m_metricsExporter; ///< Local Prometheus endpoint
 };
 
 #endif // MAINWINDOW_H
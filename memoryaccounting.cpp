@@ -0,0 +1,97 @@
+/**
+ * @file memoryaccounting.cpp
+ * @brief Implementation of the memory accounting helpers.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the estimates of the heap memory held by strings and
+ * variant trees.
+ */
+
+#include "memoryaccounting.h"
+#include <QByteArray>
+#include <QMap>
+#include <map>
+
+namespace MemoryAccounting {
+
+namespace {
+
+/**
+ * @brief Bytes of a red-black tree node besides its value.
+ */
+constexpr qint64 MapNodeOverhead = 4 * qint64(sizeof(void *));
+
+/**
+ * @brief Bytes of the shared data of a QMap.
+ */
+constexpr qint64 MapDataBytes = qint64(sizeof(quintptr) + sizeof(std::map<QString, QVariant>));
+
+/**
+ * @brief Largest type a QVariant stores without a heap allocation.
+ */
+constexpr qsizetype VariantInlineSize = qsizetype(sizeof(QVariant) - sizeof(quintptr));
+
+} // namespace
+
+/**
+ * @brief Heap bytes of a string.
+ * @param string String.
+ * @return Bytes, 0 for a string without an allocation.
+ */
+qint64 bytes(const QString &string)
+{
+    // Pojemność nie obejmuje kończącego znaku zerowego
+    return string.capacity() > 0 ? arrayBytes(string.capacity() + 1, sizeof(QChar)) : 0;
+}
+
+/**
+ * @brief Heap bytes of a variant and everything it contains.
+ * @param variant Variant; lists and maps are followed recursively.
+ * @return Bytes beyond sizeof(QVariant).
+ */
+qint64 bytes(const QVariant &variant)
+{
+    switch (variant.typeId()) {
+    case QMetaType::QString:
+        return bytes(*static_cast<const QString *>(variant.constData()));
+    case QMetaType::QByteArray: {
+        const QByteArray &array = *static_cast<const QByteArray *>(variant.constData());
+        return array.capacity() > 0 ? arrayBytes(array.capacity() + 1, 1) : 0;
+    }
+    case QMetaType::QVariantList: {
+        const QVariantList &list = *static_cast<const QVariantList *>(variant.constData());
+        qint64 total = arrayBytes(list.capacity(), sizeof(QVariant));
+        for (const QVariant &item : list) {
+            total += bytes(item);
+        }
+        return total;
+    }
+    case QMetaType::QVariantMap:
+        return bytes(*static_cast<const QVariantMap *>(variant.constData()));
+    default:
+        // Typy większe od bufora wariantu leżą na stercie razem z licznikiem
+        return variant.metaType().sizeOf() > VariantInlineSize
+                   ? qint64(sizeof(quintptr)) + variant.metaType().sizeOf() : 0;
+    }
+}
+
+/**
+ * @brief Heap bytes of a variant map and everything it contains.
+ * @param map Map.
+ * @return Bytes of the tree nodes, keys and values.
+ */
+qint64 bytes(const QVariantMap &map)
+{
+    if (map.isEmpty()) {
+        return 0;
+    }
+    qint64 total = MapDataBytes;
+    for (auto it = map.cbegin(); it != map.cend(); ++it) {
+        total += MapNodeOverhead + qint64(sizeof(QString) + sizeof(QVariant));
+        total += bytes(it.key()) + bytes(it.value());
+    }
+    return total;
+}
+
+} // namespace MemoryAccounting
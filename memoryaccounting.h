@@ -0,0 +1,114 @@
+/**
+ * @file memoryaccounting.h
+ * @brief Header file for the memory accounting helpers.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the memory usage of a subsystem and the estimates of
+ * the heap memory held by Qt containers, strings and variants.
+ */
+
+#ifndef MEMORYACCOUNTING_H
+#define MEMORYACCOUNTING_H
+
+#include <QArrayData>
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <utility>
+
+/**
+ * @namespace MemoryAccounting
+ * @brief Live bytes and object counts of the subsystems.
+ *
+ * Subsystems report their usage on demand from the capacities of their
+ * containers, so accounting costs nothing until someone asks. The numbers
+ * are estimates of the heap blocks the containers own: allocator overhead
+ * and the private data of QObject are not included, and implicitly shared
+ * data is counted once per owner. The memory benchmark compares them with
+ * the resident size of the process.
+ */
+namespace MemoryAccounting {
+
+/**
+ * @struct Usage
+ * @brief Memory held by a subsystem.
+ */
+struct Usage {
+    qint64 bytes = 0;       ///< Live bytes
+    qint64 objects = 0;     ///< Live objects, e.g. stations or series
+
+    /**
+     * @brief Adds another usage.
+     * @param other Usage to add.
+     * @return This usage.
+     */
+    Usage &operator+=(const Usage &other)
+    {
+        bytes += other.bytes;
+        objects += other.objects;
+        return *this;
+    }
+};
+
+/**
+ * @brief Heap bytes of an array-backed container.
+ * @param capacity Reserved elements.
+ * @param elementSize Size of one element.
+ * @return Header and elements, 0 without an allocation.
+ */
+inline qint64 arrayBytes(qsizetype capacity, size_t elementSize)
+{
+    return capacity > 0 ? qint64(sizeof(QArrayData)) + qint64(capacity) * qint64(elementSize) : 0;
+}
+
+/**
+ * @brief Heap bytes of a vector, without the elements' own allocations.
+ * @param vector Vector.
+ * @return Bytes.
+ */
+template<typename T>
+qint64 bytes(const QVector<T> &vector)
+{
+    return arrayBytes(vector.capacity(), sizeof(T));
+}
+
+/**
+ * @brief Heap bytes of a hash, without the elements' own allocations.
+ * @param hash Hash.
+ * @return Bytes of the span offsets and the entries.
+ *
+ * A Qt 6 hash keeps one offset byte per bucket and allocates the entries
+ * of each span of 128 buckets in one block.
+ */
+template<typename K, typename V>
+qint64 bytes(const QHash<K, V> &hash)
+{
+    return qint64(hash.capacity()) + qint64(hash.size()) * qint64(sizeof(std::pair<K, V>));
+}
+
+/**
+ * @brief Heap bytes of a string.
+ * @param string String.
+ * @return Bytes, 0 for a string without an allocation.
+ */
+qint64 bytes(const QString &string);
+
+/**
+ * @brief Heap bytes of a variant and everything it contains.
+ * @param variant Variant; lists and maps are followed recursively.
+ * @return Bytes beyond sizeof(QVariant).
+ */
+qint64 bytes(const QVariant &variant);
+
+/**
+ * @brief Heap bytes of a variant map and everything it contains.
+ * @param map Map.
+ * @return Bytes of the tree nodes, keys and values.
+ */
+qint64 bytes(const QVariantMap &map);
+
+} // namespace MemoryAccounting
+
+#endif // MEMORYACCOUNTING_H
@@ -0,0 +1,145 @@
+/**
+ * @file memorybenchmark.cpp
+ * @brief Implementation of the MemoryBenchmark class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the generation of the synthetic data set, the report
+ * and the command line of the memory benchmark.
+ */
+
+#include "memorybenchmark.h"
+#include "mainwindow.h"
+#include "metrics.h"
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+/**
+ * @brief Runs the benchmark.
+ * @param stations Number of stations, each with one series.
+ * @param samplesPerSeries Samples of each series.
+ * @return Measured memory.
+ *
+ * Stations get distinct names and addresses like the GIOŚ list, and the
+ * series hourly samples, so the containers grow the way real data does.
+ */
+MemoryBenchmarkResult MemoryBenchmark::run(int stations, int samplesPerSeries)
+{
+    MemoryBenchmarkResult result;
+    result.stations = std::max(stations, 0);
+    result.samplesPerSeries = std::max(samplesPerSeries, 0);
+
+    // Stacje rozrzucone po prostokącie obejmującym Polskę
+    qint64 resident = Metrics::residentBytes();
+    auto parent = std::make_unique<QObject>();
+    QList<Station *> list;
+    GeoTable coordinates;
+    coordinates.reserve(result.stations);
+    for (int i = 0; i < result.stations; ++i) {
+        const double lat = 49.0 + 5.8 * std::fmod(i * 0.618034, 1.0);
+        const double lon = 14.1 + 10.0 * std::fmod(i * 0.414214, 1.0);
+        list.append(new Station(i + 1, QString("Stacja pomiarowa %1").arg(i + 1), QString("Miasto %1").arg(i % 500),
+                                QString("ul. Testowa %1").arg(i % 200 + 1), lat, lon, false, parent.get()));
+        coordinates.append(lat, lon);
+    }
+    result.stationResident = Metrics::residentBytes() - resident;
+    result.stationUsage.objects = list.size();
+    result.stationUsage.bytes = MemoryAccounting::arrayBytes(list.capacity(), sizeof(Station *))
+                                + coordinates.memoryUsage().bytes;
+    for (const Station *station : list) {
+        result.stationUsage.bytes += station->memoryBytes();
+    }
+
+    // Szeregi godzinowe, dopisywane porcjami jak dane z API
+    resident = Metrics::residentBytes();
+    SeriesStore store;
+    const qint64 start = 1767222000000;     // 2026-01-01 00:00 CET
+    const qint64 hour = 3600 * 1000;
+    const int batch = 24;
+    for (int i = 0; i < result.stations; ++i) {
+        for (int first = 0; first < result.samplesPerSeries; first += batch) {
+            Series series;
+            for (int k = first; k < std::min(first + batch, result.samplesPerSeries); ++k) {
+                series.timestamps.append(start + k * hour);
+                series.values.append(20.0 + 10.0 * std::sin(k * 0.26 + i));
+            }
+            store.merge(i + 1, series);
+        }
+    }
+    result.seriesResident = Metrics::residentBytes() - resident;
+    result.seriesUsage = store.memoryUsage();
+
+    // Te same próbki w postaci list wariantów, jak w danych czujników dla QML
+    QVariantMap sensorData;
+    result.variantSeries = std::min(result.stations, MaxVariantSeries);
+    for (int i = 0; i < result.variantSeries; ++i) {
+        sensorData.insert(QString::number(i + 1), SeriesStore::toVariantList(*store.find(i + 1)));
+    }
+    result.variantUsage.objects = sensorData.size();
+    result.variantUsage.bytes = MemoryAccounting::bytes(sensorData);
+    return result;
+}
+
+/**
+ * @brief Formats a result as a text table.
+ * @param result Result.
+ * @return Report with one line per subsystem.
+ */
+QString MemoryBenchmark::report(const MemoryBenchmarkResult &result)
+{
+    const qint64 samples = qint64(result.stations) * result.samplesPerSeries;
+    QString text;
+    QTextStream out(&text);
+    out << QString("Stacje: %1, próbki na szereg: %2, próbki razem: %3\n")
+               .arg(result.stations).arg(result.samplesPerSeries).arg(samples);
+    out << QString("stations     %1 B  %2 B/stację  (przyrost RSS %3 B/stację)\n")
+               .arg(result.stationUsage.bytes, 12)
+               .arg(result.bytesPerStation(), 8, 'f', 1)
+               .arg(result.stations > 0 ? double(result.stationResident) / result.stations : 0.0, 8, 'f', 1);
+    out << QString("series       %1 B  %2 B/próbkę  (przyrost RSS %3 B/próbkę)\n")
+               .arg(result.seriesUsage.bytes, 12)
+               .arg(result.bytesPerSample(), 8, 'f', 2)
+               .arg(samples > 0 ? double(result.seriesResident) / samples : 0.0, 8, 'f', 2);
+    out << QString("sensor_data  %1 B  %2 B/próbkę  (%3 szeregów jako QVariant)\n")
+               .arg(result.variantUsage.bytes, 12)
+               .arg(result.variantBytesPerSample(), 8, 'f', 2)
+               .arg(result.variantSeries);
+    return text;
+}
+
+/**
+ * @brief Runs the benchmark from the command line.
+ * @param arguments Application arguments, see the --help output.
+ * @return 0, or 1 if a --max-bytes-per-* limit was exceeded.
+ */
+int MemoryBenchmark::main(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Pomiar pamięci syntetycznych stacji i szeregów.");
+    parser.addHelpOption();
+    const QCommandLineOption benchOption("bench-memory", "Uruchamia pomiar pamięci.");
+    const QCommandLineOption stationsOption("stations", "Liczba stacji.", "n", QString::number(DefaultStations));
+    const QCommandLineOption samplesOption("samples", "Liczba próbek każdego szeregu.", "n", QString::number(DefaultSamples));
+    const QCommandLineOption maxStationOption("max-bytes-per-station", "Próg bajtów na stację; przekroczenie kończy się kodem 1.", "bytes");
+    const QCommandLineOption maxSampleOption("max-bytes-per-sample", "Próg bajtów na próbkę; przekroczenie kończy się kodem 1.", "bytes");
+    parser.addOptions({benchOption, stationsOption, samplesOption, maxStationOption, maxSampleOption});
+    parser.process(arguments);
+
+    const MemoryBenchmarkResult result = run(parser.value(stationsOption).toInt(), parser.value(samplesOption).toInt());
+    QTextStream out(stdout);
+    out << report(result);
+
+    int exitCode = 0;
+    if (parser.isSet(maxStationOption) && result.bytesPerStation() > parser.value(maxStationOption).toDouble()) {
+        out << "Przekroczony próg bajtów na stację.\n";
+        exitCode = 1;
+    }
+    if (parser.isSet(maxSampleOption) && result.bytesPerSample() > parser.value(maxSampleOption).toDouble()) {
+        out << "Przekroczony próg bajtów na próbkę.\n";
+        exitCode = 1;
+    }
+    return exitCode;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file memorybenchmark.h
+ * @brief Header file for the MemoryBenchmark class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the benchmark measuring the memory of synthetic
+ * stations and series, run with the --bench-memory option.
+ */
+
+#ifndef MEMORYBENCHMARK_H
+#define MEMORYBENCHMARK_H
+
+#include <QString>
+#include <QStringList>
+#include "memoryaccounting.h"
+
+/**
+ * @struct MemoryBenchmarkResult
+ * @brief Memory of the synthetic data set.
+ */
+struct MemoryBenchmarkResult {
+    int stations = 0;                       ///< Stations created
+    int samplesPerSeries = 0;               ///< Samples of each series
+    int variantSeries = 0;                  ///< Series also converted to QVariant
+    MemoryAccounting::Usage stationUsage;   ///< Station objects and coordinate columns
+    MemoryAccounting::Usage seriesUsage;    ///< Series store
+    MemoryAccounting::Usage variantUsage;   ///< Series in the sensor data format
+    qint64 stationResident = 0;             ///< Growth of the resident size by the stations
+    qint64 seriesResident = 0;              ///< Growth of the resident size by the series
+
+    /**
+     * @brief Gets the accounted bytes per station.
+     * @return Bytes.
+     */
+    double bytesPerStation() const { return stations > 0 ? double(stationUsage.bytes) / stations : 0.0; }
+
+    /**
+     * @brief Gets the accounted bytes per stored sample.
+     * @return Bytes.
+     */
+    double bytesPerSample() const
+    {
+        const qint64 samples = qint64(stations) * samplesPerSeries;
+        return samples > 0 ? double(seriesUsage.bytes) / samples : 0.0;
+    }
+
+    /**
+     * @brief Gets the accounted bytes per sample in the sensor data format.
+     * @return Bytes.
+     */
+    double variantBytesPerSample() const
+    {
+        const qint64 samples = qint64(variantSeries) * samplesPerSeries;
+        return samples > 0 ? double(variantUsage.bytes) / samples : 0.0;
+    }
+};
+
+/**
+ * @class MemoryBenchmark
+ * @brief Loads synthetic stations and series and reports their memory.
+ *
+ * The accounted bytes come from MemoryAccounting; the growth of the resident
+ * size shows what the allocator and QObject add on top of them.
+ */
+class MemoryBenchmark {
+public:
+    static constexpr int DefaultStations = 10000;       ///< Stations without --stations
+    static constexpr int DefaultSamples = 720;          ///< Hourly samples of 30 days
+    static constexpr int MaxVariantSeries = 100;        ///< Series converted to QVariant
+
+    /**
+     * @brief Runs the benchmark.
+     * @param stations Number of stations, each with one series.
+     * @param samplesPerSeries Samples of each series.
+     * @return Measured memory.
+     */
+    static MemoryBenchmarkResult run(int stations, int samplesPerSeries);
+
+    /**
+     * @brief Formats a result as a text table.
+     * @param result Result.
+     * @return Report with one line per subsystem.
+     */
+    static QString report(const MemoryBenchmarkResult &result);
+
+    /**
+     * @brief Runs the benchmark from the command line.
+     * @param arguments Application arguments, see the --help output.
+     * @return 0, or 1 if a --max-bytes-per-* limit was exceeded.
+     */
+    static int main(const QStringList &arguments);
+};
+
+#endif // MEMORYBENCHMARK_H
@@ -0,0 +1,383 @@
+/**
+ * @file metrics.cpp
+ * @brief Implementation of the Counter, Histogram, Metrics and related classes.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the sharded counters and histograms, the registry and
+ * the rendering of the Prometheus text format.
+ */
+
+#include "metrics.h"
+#include <QFile>
+#include <QNetworkReply>
+#include <QObject>
+#include <algorithm>
+#include <cmath>
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Formats a sample value.
+ * @param value Value.
+ * @return Shortest text that reads back as the value.
+ */
+QByteArray formatValue(double value)
+{
+    if (std::isinf(value)) {
+        return value > 0 ? "+Inf" : "-Inf";
+    }
+    if (std::isnan(value)) {
+        return "NaN";
+    }
+    return QByteArray::number(value, 'g', 15);
+}
+
+/**
+ * @brief Writes one sample line.
+ * @param out Output.
+ * @param name Sample name.
+ * @param labels Label pairs without braces.
+ * @param extra Additional label pair, e.g. le="0.1".
+ * @param value Formatted value.
+ */
+void writeSample(QByteArray &out, const QByteArray &name, const QByteArray &labels,
+                 const QByteArray &extra, const QByteArray &value)
+{
+    out += name;
+    if (!labels.isEmpty() || !extra.isEmpty()) {
+        out += '{';
+        out += labels;
+        if (!labels.isEmpty() && !extra.isEmpty()) {
+            out += ',';
+        }
+        out += extra;
+        out += '}';
+    }
+    out += ' ';
+    out += value;
+    out += '\n';
+}
+
+} // namespace
+
+/**
+ * @brief Gets the current value.
+ * @return Sum of all shards.
+ */
+qint64 Counter::value() const
+{
+    qint64 sum = 0;
+    for (const Shard &shard : m_shards) {
+        sum += shard.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+/**
+ * @brief Gets the shard of the calling thread.
+ * @return Shard index, assigned on the first call of the thread.
+ */
+int Counter::shard()
+{
+    static std::atomic<int> next{0};
+    thread_local const int index = next.fetch_add(1, std::memory_order_relaxed) % Shards;
+    return index;
+}
+
+/**
+ * @brief Constructs an empty histogram.
+ * @param bounds Ascending upper bounds; only the first MaxBuckets are used.
+ */
+Histogram::Histogram(const QVector<double> &bounds)
+    : m_bounds(bounds.mid(0, MaxBuckets))
+{
+}
+
+/**
+ * @brief Records a value.
+ * @param value Value, e.g. a duration in seconds.
+ */
+void Histogram::observe(double value)
+{
+    // Kilkanaście granic: przeszukanie liniowe jest szybsze od binarnego
+    int bucket = 0;
+    while (bucket < m_bounds.size() && value > m_bounds[bucket]) {
+        ++bucket;
+    }
+    Shard &shard = m_shards[Counter::shard()];
+    shard.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    shard.sumMicros.fetch_add(qint64(std::llround(value * 1e6)), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Reads the histogram.
+ * @return Sum of all shards.
+ *
+ * Shards are read one by one while other threads keep observing, so the
+ * count and the sum may differ by the values recorded during the read.
+ */
+Histogram::Snapshot Histogram::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.bounds = m_bounds;
+    snapshot.cumulative.fill(0, m_bounds.size() + 1);
+    qint64 sumMicros = 0;
+    for (const Shard &shard : m_shards) {
+        for (int i = 0; i <= m_bounds.size(); ++i) {
+            snapshot.cumulative[i] += shard.counts[i].load(std::memory_order_relaxed);
+        }
+        sumMicros += shard.sumMicros.load(std::memory_order_relaxed);
+    }
+    for (int i = 1; i < snapshot.cumulative.size(); ++i) {
+        snapshot.cumulative[i] += snapshot.cumulative[i - 1];
+    }
+    snapshot.count = snapshot.cumulative.last();
+    snapshot.sum = sumMicros / 1e6;
+    return snapshot;
+}
+
+/**
+ * @brief Gets the default bounds of durations.
+ * @return Bounds in seconds from 1 ms to 10 s.
+ */
+const QVector<double> &Histogram::secondsBuckets()
+{
+    static const QVector<double> bounds{0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1,
+                                        0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+    return bounds;
+}
+
+/**
+ * @brief Gets the bounds of frame and paint times.
+ * @return Bounds in seconds from 1 ms to 250 ms, around the 16.7 ms frame.
+ */
+const QVector<double> &Histogram::frameBuckets()
+{
+    static const QVector<double> bounds{0.001, 0.002, 0.004, 0.008, 0.0125, 0.0167, 0.025,
+                                        0.0333, 0.05, 0.1, 0.25};
+    return bounds;
+}
+
+/**
+ * @brief Gets the application registry.
+ * @return Registry served by the metrics endpoint.
+ */
+Metrics &Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+/**
+ * @brief Gets or creates a counter.
+ * @param name Family name.
+ * @param help Description of the family.
+ * @param labels Label pairs without braces.
+ * @return Counter living as long as the registry.
+ */
+Counter *Metrics::counter(const QByteArray &name, const QByteArray &help, const QByteArray &labels)
+{
+    QMutexLocker locker(&m_mutex);
+    std::unique_ptr<Counter> &counter = family(name, help, CounterType).counters[labels];
+    if (!counter) {
+        counter = std::make_unique<Counter>();
+    }
+    return counter.get();
+}
+
+/**
+ * @brief Gets or creates a histogram.
+ * @param name Family name.
+ * @param help Description of the family.
+ * @param bounds Bucket bounds, used when the histogram is created.
+ * @param labels Label pairs without braces.
+ * @return Histogram living as long as the registry.
+ */
+Histogram *Metrics::histogram(const QByteArray &name, const QByteArray &help,
+                              const QVector<double> &bounds, const QByteArray &labels)
+{
+    QMutexLocker locker(&m_mutex);
+    std::unique_ptr<Histogram> &histogram = family(name, help, HistogramType).histograms[labels];
+    if (!histogram) {
+        histogram = std::make_unique<Histogram>(bounds);
+    }
+    return histogram.get();
+}
+
+/**
+ * @brief Registers a value read at scrape time.
+ * @param name Family name.
+ * @param help Description of the family.
+ * @param type CounterType or GaugeType.
+ * @param read Returns the current value.
+ * @param labels Label pairs without braces.
+ * @param owner Object whose destruction removes the callback; may be nullptr.
+ */
+void Metrics::callback(const QByteArray &name, const QByteArray &help, Type type,
+                       std::function<double()> read, const QByteArray &labels, QObject *owner)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        family(name, help, type).callbacks.push_back({labels, std::move(read), owner});
+    }
+    if (owner) {
+        QObject::connect(owner, &QObject::destroyed, [this, owner]() {
+            removeCallbacks(owner);
+        });
+    }
+}
+
+/**
+ * @brief Removes the callbacks of an owner.
+ * @param owner Owner passed to callback().
+ */
+void Metrics::removeCallbacks(QObject *owner)
+{
+    QMutexLocker locker(&m_mutex);
+    for (auto &entry : m_families) {
+        std::vector<Callback> &callbacks = entry.second.callbacks;
+        callbacks.erase(std::remove_if(callbacks.begin(), callbacks.end(),
+                                       [owner](const Callback &callback) { return callback.owner == owner; }),
+                        callbacks.end());
+    }
+}
+
+/**
+ * @brief Renders all metrics.
+ * @return Text exposition format 0.0.4, families sorted by name.
+ *
+ * The callbacks run without the lock, so they may take their own locks or
+ * register metrics. Callbacks added meanwhile appear in the next scrape.
+ */
+QByteArray Metrics::exposition() const
+{
+    static const char *const typeNames[] = {"counter", "gauge", "histogram"};
+
+    // Kopie funkcji pod blokadą, odczyt wartości już bez niej
+    std::map<QByteArray, std::vector<Callback>> callbacks;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const auto &entry : m_families) {
+            if (!entry.second.callbacks.empty()) {
+                callbacks.emplace(entry.first, entry.second.callbacks);
+            }
+        }
+    }
+    std::map<QByteArray, std::vector<std::pair<QByteArray, double>>> values;
+    for (const auto &entry : callbacks) {
+        std::vector<std::pair<QByteArray, double>> &read = values[entry.first];
+        read.reserve(entry.second.size());
+        for (const Callback &callback : entry.second) {
+            read.emplace_back(callback.labels, callback.read());
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    QByteArray out;
+    for (const auto &entry : m_families) {
+        const QByteArray &name = entry.first;
+        const Family &family = entry.second;
+        const auto read = values.find(name);
+        if (family.counters.empty() && family.histograms.empty() && read == values.end()) {
+            continue;
+        }
+        out += "# HELP " + name + ' ' + family.help + '\n';
+        out += "# TYPE " + name + ' ' + typeNames[family.type] + '\n';
+
+        for (const auto &counter : family.counters) {
+            writeSample(out, name, counter.first, QByteArray(), QByteArray::number(counter.second->value()));
+        }
+        if (read != values.end()) {
+            for (const auto &value : read->second) {
+                writeSample(out, name, value.first, QByteArray(), formatValue(value.second));
+            }
+        }
+        for (const auto &histogram : family.histograms) {
+            const Histogram::Snapshot snapshot = histogram.second->snapshot();
+            for (int i = 0; i < snapshot.bounds.size(); ++i) {
+                writeSample(out, name + "_bucket", histogram.first, "le=\"" + formatValue(snapshot.bounds[i]) + '"',
+                            QByteArray::number(snapshot.cumulative[i]));
+            }
+            writeSample(out, name + "_bucket", histogram.first, "le=\"+Inf\"", QByteArray::number(snapshot.count));
+            writeSample(out, name + "_sum", histogram.first, QByteArray(), formatValue(snapshot.sum));
+            writeSample(out, name + "_count", histogram.first, QByteArray(), QByteArray::number(snapshot.count));
+        }
+    }
+    return out;
+}
+
+/**
+ * @brief Gets the resident memory of the process.
+ * @return Bytes, 0 where /proc is not available.
+ */
+qint64 Metrics::residentBytes()
+{
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    // Drugie pole to liczba stron w pamięci fizycznej
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    return fields.size() > 1 ? fields[1].toLongLong() * sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Gets or creates a family; the caller holds the lock.
+ * @param name Family name.
+ * @param help Description.
+ * @param type Kind; a family keeps the kind it was created with.
+ * @return Family.
+ */
+Metrics::Family &Metrics::family(const QByteArray &name, const QByteArray &help, Type type)
+{
+    Family &family = m_families[name];
+    if (family.help.isEmpty()) {
+        family.help = help;
+        family.type = type;
+    }
+    return family;
+}
+
+/**
+ * @brief Creates the metrics of an endpoint.
+ * @param endpoint Value of the "endpoint" label.
+ * @param registry Registry.
+ */
+RequestMetrics::RequestMetrics(const char *endpoint, Metrics &registry)
+{
+    const QByteArray labels = QByteArray("endpoint=\"") + endpoint + '"';
+    requests = registry.counter("airapi_http_requests_total", "Finished API requests.", labels);
+    errors = registry.counter("airapi_http_request_errors_total", "API requests that failed.", labels);
+    latency = registry.histogram("airapi_http_request_duration_seconds", "Time from sending a request to its finished reply.",
+                                 Histogram::secondsBuckets(), labels);
+    parse = registry.histogram("airapi_parse_duration_seconds", "Time spent parsing API replies.",
+                               Histogram::secondsBuckets(), labels);
+}
+
+/**
+ * @brief Counts a reply and records its latency when it finishes.
+ * @param reply Reply, tracked right after the request was sent.
+ *
+ * Connected before the handlers of the caller, so the latency does not
+ * include their work.
+ */
+void RequestMetrics::track(QNetworkReply *reply) const
+{
+    QElapsedTimer timer;
+    timer.start();
+    QObject::connect(reply, &QNetworkReply::finished, reply, [this, reply, timer]() {
+        requests->add();
+        if (reply->error() != QNetworkReply::NoError) {
+            errors->add();
+        }
+        latency->observe(timer.nsecsElapsed() / 1e9);
+    });
+}
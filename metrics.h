@@ -0,0 +1,318 @@
+/**
+ * @file metrics.h
+ * @brief Header file for the Counter, Histogram, Metrics and related classes.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the application metrics: counters and histograms with
+ * one shard per thread, values read on demand and their rendering in the
+ * Prometheus text format.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+class QNetworkReply;
+class QObject;
+
+/**
+ * @class Counter
+ * @brief Monotonic counter without contention between threads.
+ *
+ * Every thread gets its own shard on its first update, so add() is an
+ * uncontended relaxed increment on a cache line no other thread writes.
+ * Threads beyond the number of shards share them round robin. value() sums
+ * the shards and is meant for the rare scrape.
+ */
+class Counter {
+public:
+    static constexpr int Shards = 16;   ///< Shards, one per thread up to this count
+
+    /**
+     * @brief Adds to the counter.
+     * @param amount Non-negative amount.
+     */
+    void add(qint64 amount = 1) { m_shards[shard()].value.fetch_add(amount, std::memory_order_relaxed); }
+
+    /**
+     * @brief Gets the current value.
+     * @return Sum of all shards.
+     */
+    qint64 value() const;
+
+    /**
+     * @brief Gets the shard of the calling thread.
+     * @return Shard index, assigned on the first call of the thread.
+     */
+    static int shard();
+
+private:
+    /**
+     * @struct Shard
+     * @brief Counter value of one thread on its own cache line.
+     */
+    struct alignas(64) Shard {
+        std::atomic<qint64> value{0};   ///< Partial value
+    };
+
+    Shard m_shards[Shards];             ///< Partial values
+};
+
+/**
+ * @class Histogram
+ * @brief Distribution of observed values in fixed buckets.
+ *
+ * Sharded like Counter. The sum is kept in millionths of the unit, which is
+ * exact to a microsecond for durations in seconds.
+ */
+class Histogram {
+public:
+    static constexpr int MaxBuckets = 15;   ///< Upper bounds, without +Inf
+
+    /**
+     * @struct Snapshot
+     * @brief Values of a histogram at one moment.
+     */
+    struct Snapshot {
+        QVector<double> bounds;     ///< Upper bounds
+        QVector<qint64> cumulative; ///< Values up to each bound, then +Inf
+        qint64 count = 0;           ///< Observed values
+        double sum = 0.0;           ///< Sum of the observed values
+    };
+
+    /**
+     * @brief Constructs an empty histogram.
+     * @param bounds Ascending upper bounds; only the first MaxBuckets are used.
+     */
+    explicit Histogram(const QVector<double> &bounds);
+
+    /**
+     * @brief Records a value.
+     * @param value Value, e.g. a duration in seconds.
+     */
+    void observe(double value);
+
+    /**
+     * @brief Reads the histogram.
+     * @return Sum of all shards.
+     */
+    Snapshot snapshot() const;
+
+    /**
+     * @brief Gets the default bounds of durations.
+     * @return Bounds in seconds from 1 ms to 10 s.
+     */
+    static const QVector<double> &secondsBuckets();
+
+    /**
+     * @brief Gets the bounds of frame and paint times.
+     * @return Bounds in seconds from 1 ms to 250 ms, around the 16.7 ms frame.
+     */
+    static const QVector<double> &frameBuckets();
+
+private:
+    /**
+     * @struct Shard
+     * @brief Bucket counts of one thread.
+     */
+    struct alignas(64) Shard {
+        std::atomic<qint64> counts[MaxBuckets + 1] = {};    ///< Per bucket, last is +Inf
+        std::atomic<qint64> sumMicros{0};                   ///< Sum in millionths
+    };
+
+    QVector<double> m_bounds;               ///< Upper bounds
+    Shard m_shards[Counter::Shards];        ///< Partial distributions
+};
+
+/**
+ * @class HistogramTimer
+ * @brief Records the lifetime of a scope in a histogram, in seconds.
+ */
+class HistogramTimer {
+public:
+    /**
+     * @brief Starts timing.
+     * @param histogram Histogram; nullptr disables the timer.
+     */
+    explicit HistogramTimer(Histogram *histogram) : m_histogram(histogram) { m_timer.start(); }
+
+    /**
+     * @brief Records the elapsed time.
+     */
+    ~HistogramTimer()
+    {
+        if (m_histogram) {
+            m_histogram->observe(m_timer.nsecsElapsed() / 1e9);
+        }
+    }
+
+    HistogramTimer(const HistogramTimer &) = delete;
+    HistogramTimer &operator=(const HistogramTimer &) = delete;
+
+private:
+    Histogram *m_histogram;     ///< Target histogram
+    QElapsedTimer m_timer;      ///< Started on construction
+};
+
+/**
+ * @class Metrics
+ * @brief Registry of named metrics rendered in the Prometheus text format.
+ *
+ * Metrics are created once, usually into function-static pointers, and live
+ * as long as the registry; the registry lock is taken only on creation and
+ * on scrape. Values owned by other objects, such as queue lengths, are
+ * registered as callbacks, called by exposition() on the calling thread and
+ * removed when their owner is destroyed.
+ */
+class Metrics {
+public:
+    /**
+     * @enum Type
+     * @brief Kind of a metric family.
+     */
+    enum Type {
+        CounterType,    ///< Monotonic value
+        GaugeType,      ///< Value that goes up and down
+        HistogramType   ///< Bucketed distribution
+    };
+
+    /**
+     * @brief Constructs an empty registry.
+     */
+    Metrics() = default;
+
+    Metrics(const Metrics &) = delete;
+    Metrics &operator=(const Metrics &) = delete;
+
+    /**
+     * @brief Gets the application registry.
+     * @return Registry served by the metrics endpoint.
+     */
+    static Metrics &instance();
+
+    /**
+     * @brief Gets or creates a counter.
+     * @param name Family name, e.g. "airapi_http_requests_total".
+     * @param help Description of the family.
+     * @param labels Label pairs without braces, e.g. "endpoint=\"data\"".
+     * @return Counter living as long as the registry.
+     */
+    Counter *counter(const QByteArray &name, const QByteArray &help, const QByteArray &labels = QByteArray());
+
+    /**
+     * @brief Gets or creates a histogram.
+     * @param name Family name.
+     * @param help Description of the family.
+     * @param bounds Bucket bounds, used when the histogram is created.
+     * @param labels Label pairs without braces.
+     * @return Histogram living as long as the registry.
+     */
+    Histogram *histogram(const QByteArray &name, const QByteArray &help,
+                         const QVector<double> &bounds = Histogram::secondsBuckets(),
+                         const QByteArray &labels = QByteArray());
+
+    /**
+     * @brief Registers a value read at scrape time.
+     * @param name Family name.
+     * @param help Description of the family.
+     * @param type CounterType or GaugeType.
+     * @param read Returns the current value.
+     * @param labels Label pairs without braces.
+     * @param owner Object whose destruction removes the callback; may be nullptr.
+     */
+    void callback(const QByteArray &name, const QByteArray &help, Type type,
+                  std::function<double()> read, const QByteArray &labels = QByteArray(),
+                  QObject *owner = nullptr);
+
+    /**
+     * @brief Removes the callbacks of an owner.
+     * @param owner Owner passed to callback().
+     */
+    void removeCallbacks(QObject *owner);
+
+    /**
+     * @brief Renders all metrics.
+     * @return Text exposition format 0.0.4, families sorted by name.
+     */
+    QByteArray exposition() const;
+
+    /**
+     * @brief Gets the resident memory of the process.
+     * @return Bytes, 0 where /proc is not available.
+     */
+    static qint64 residentBytes();
+
+private:
+    /**
+     * @struct Callback
+     * @brief Value read at scrape time.
+     */
+    struct Callback {
+        QByteArray labels;              ///< Label pairs
+        std::function<double()> read;   ///< Reads the value
+        QObject *owner = nullptr;       ///< Removes the callback when destroyed
+    };
+
+    /**
+     * @struct Family
+     * @brief Metrics sharing a name, told apart by labels.
+     */
+    struct Family {
+        Type type = CounterType;                                        ///< Kind
+        QByteArray help;                                                ///< Description
+        std::map<QByteArray, std::unique_ptr<Counter>> counters;        ///< Counters by labels
+        std::map<QByteArray, std::unique_ptr<Histogram>> histograms;    ///< Histograms by labels
+        std::vector<Callback> callbacks;                                ///< Values read on scrape
+    };
+
+    /**
+     * @brief Gets or creates a family; the caller holds the lock.
+     * @param name Family name.
+     * @param help Description.
+     * @param type Kind; a family keeps the kind it was created with.
+     * @return Family.
+     */
+    Family &family(const QByteArray &name, const QByteArray &help, Type type);
+
+    mutable QMutex m_mutex;                     ///< Guards the families
+    std::map<QByteArray, Family> m_families;    ///< Families by name
+};
+
+/**
+ * @struct RequestMetrics
+ * @brief Request count, errors, latency and parse time of one API endpoint.
+ *
+ * Meant as a function-static object per endpoint, so the metrics are looked
+ * up once and not on every request.
+ */
+struct RequestMetrics {
+    Counter *requests;      ///< Finished requests
+    Counter *errors;        ///< Requests that failed
+    Histogram *latency;     ///< Time from sending to the finished reply
+    Histogram *parse;       ///< Time spent parsing the replies
+
+    /**
+     * @brief Creates the metrics of an endpoint.
+     * @param endpoint Value of the "endpoint" label.
+     * @param registry Registry.
+     */
+    explicit RequestMetrics(const char *endpoint, Metrics &registry = Metrics::instance());
+
+    /**
+     * @brief Counts a reply and records its latency when it finishes.
+     * @param reply Reply, tracked right after the request was sent.
+     */
+    void track(QNetworkReply *reply) const;
+};
+
+#endif // METRICS_H
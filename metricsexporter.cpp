@@ -0,0 +1,154 @@
+/**
+ * @file metricsexporter.cpp
+ * @brief Implementation of the MetricsExporter class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the connection handling and the HTTP responses of the
+ * metrics endpoint.
+ */
+
+#include "metricsexporter.h"
+#include "metrics.h"
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace {
+
+/**
+ * @brief Builds an HTTP response.
+ * @param status Status line after the version, e.g. "200 OK".
+ * @param contentType Value of the Content-Type header.
+ * @param body Body; omitted for HEAD requests by the caller.
+ * @param contentLength Length announced in the headers.
+ * @return Response.
+ */
+QByteArray httpResponse(const QByteArray &status, const QByteArray &contentType,
+                        const QByteArray &body, qsizetype contentLength)
+{
+    return "HTTP/1.1 " + status + "\r\n"
+           "Content-Type: " + contentType + "\r\n"
+           "Content-Length: " + QByteArray::number(contentLength) + "\r\n"
+           "Connection: close\r\n\r\n" + body;
+}
+
+} // namespace
+
+/**
+ * @brief Constructs a stopped exporter.
+ * @param metrics Registry to serve.
+ * @param parent Parent QObject.
+ */
+MetricsExporter::MetricsExporter(Metrics *metrics, QObject *parent)
+    : QObject(parent),
+    m_metrics(metrics),
+    m_scrapes(metrics->counter("airapi_metrics_scrapes_total", "Requests served by the metrics endpoint."))
+{
+}
+
+/**
+ * @brief Starts listening on the loopback interface.
+ * @param port TCP port, 0 for any free port.
+ * @return True on success.
+ *
+ * The metrics reveal what the user is looking at, so only local processes
+ * can read them; a remote Prometheus scrapes through its own tunnel.
+ */
+bool MetricsExporter::listen(quint16 port)
+{
+    if (!m_server) {
+        m_server = new QTcpServer(this);
+        connect(m_server, &QTcpServer::newConnection, this, &MetricsExporter::onNewConnection);
+    }
+    m_server->close();
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        m_errorString = m_server->errorString();
+        return false;
+    }
+    m_errorString.clear();
+    return true;
+}
+
+/**
+ * @brief Gets the listening port.
+ * @return Port, 0 if not listening.
+ */
+quint16 MetricsExporter::serverPort() const
+{
+    return m_server && m_server->isListening() ? m_server->serverPort() : 0;
+}
+
+/**
+ * @brief Builds the response to a request head.
+ * @param head Request line and headers.
+ * @return Complete HTTP response.
+ */
+QByteArray MetricsExporter::respond(const QByteArray &head) const
+{
+    static const QByteArray text = "text/plain; charset=utf-8";
+
+    const QList<QByteArray> request = head.left(head.indexOf("\r\n")).split(' ');
+    if (request.size() != 3 || !request[2].startsWith("HTTP/1.")) {
+        const QByteArray body = "Bad Request\n";
+        return httpResponse("400 Bad Request", text, body, body.size());
+    }
+    const QByteArray &method = request[0];
+    const QByteArray path = request[1].left(request[1].indexOf('?'));
+    if (path != "/metrics") {
+        const QByteArray body = "Not Found\n";
+        return httpResponse("404 Not Found", text, body, body.size());
+    }
+    if (method != "GET" && method != "HEAD") {
+        const QByteArray body = "Method Not Allowed\n";
+        return httpResponse("405 Method Not Allowed", text, body, body.size());
+    }
+
+    m_scrapes->add();
+    const QByteArray body = m_metrics->exposition();
+    return httpResponse("200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                        method == "HEAD" ? QByteArray() : body, body.size());
+}
+
+/**
+ * @brief Accepts new connections.
+ */
+void MetricsExporter::onNewConnection()
+{
+    while (QTcpSocket *socket = m_server->nextPendingConnection()) {
+        m_requests.insert(socket, QByteArray());
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { readRequest(socket); });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_requests.remove(socket);
+            socket->deleteLater();
+        });
+        // Klient, który nie wysyła żądania, nie blokuje gniazda na zawsze
+        QTimer::singleShot(RequestTimeoutMs, socket, [socket]() { socket->abort(); });
+    }
+}
+
+/**
+ * @brief Reads a request and answers it once the head is complete.
+ * @param socket Connection.
+ */
+void MetricsExporter::readRequest(QTcpSocket *socket)
+{
+    const auto it = m_requests.find(socket);
+    if (it == m_requests.end()) {
+        return;
+    }
+    QByteArray &head = it.value();
+    head.append(socket->read(MaxRequestSize + 4 - head.size()));
+    if (!head.contains("\r\n\r\n")) {
+        if (head.size() > MaxRequestSize) {
+            const QByteArray body = "Request Header Fields Too Large\n";
+            socket->write(httpResponse("431 Request Header Fields Too Large", "text/plain; charset=utf-8", body, body.size()));
+            m_requests.erase(it);
+            socket->disconnectFromHost();
+        }
+        return;
+    }
+    socket->write(respond(head));
+    m_requests.erase(it);
+    socket->disconnectFromHost();
+}
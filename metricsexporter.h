@@ -0,0 +1,91 @@
+/**
+ * @file metricsexporter.h
+ * @brief Header file for the MetricsExporter class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the local HTTP endpoint serving the application metrics
+ * to a Prometheus scraper.
+ */
+
+#ifndef METRICSEXPORTER_H
+#define METRICSEXPORTER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+class Counter;
+class Metrics;
+class QTcpServer;
+class QTcpSocket;
+
+/**
+ * @class MetricsExporter
+ * @brief Serves GET /metrics in the Prometheus text format on 127.0.0.1.
+ *
+ * A deliberately small HTTP/1.x server: every connection sends one request
+ * and is closed after the response. Callbacks of the registry are read on
+ * the thread of the exporter, normally the GUI thread that owns their data.
+ */
+class MetricsExporter : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int MaxRequestSize = 8 * 1024;     ///< Longest request head accepted
+    static constexpr int RequestTimeoutMs = 5000;       ///< Time to send the request
+
+    /**
+     * @brief Constructs a stopped exporter.
+     * @param metrics Registry to serve.
+     * @param parent Parent QObject.
+     */
+    explicit MetricsExporter(Metrics *metrics, QObject *parent = nullptr);
+
+    /**
+     * @brief Starts listening on the loopback interface.
+     * @param port TCP port, 0 for any free port.
+     * @return True on success.
+     */
+    bool listen(quint16 port);
+
+    /**
+     * @brief Gets the listening port.
+     * @return Port, 0 if not listening.
+     */
+    quint16 serverPort() const;
+
+    /**
+     * @brief Gets the last error.
+     * @return Description of the last listen() failure.
+     */
+    QString errorString() const { return m_errorString; }
+
+    /**
+     * @brief Builds the response to a request head.
+     * @param head Request line and headers.
+     * @return Complete HTTP response.
+     */
+    QByteArray respond(const QByteArray &head) const;
+
+private:
+    /**
+     * @brief Accepts new connections.
+     */
+    void onNewConnection();
+
+    /**
+     * @brief Reads a request and answers it once the head is complete.
+     * @param socket Connection.
+     */
+    void readRequest(QTcpSocket *socket);
+
+    Metrics *m_metrics;                         ///< Served registry
+    Counter *m_scrapes;                         ///< Served scrapes
+    QTcpServer *m_server = nullptr;             ///< Listening socket
+    QHash<QTcpSocket *, QByteArray> m_requests; ///< Request heads being received
+    QString m_errorString;                      ///< Last listen() error
+};
+
+#endif // METRICSEXPORTER_H
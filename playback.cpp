@@ -0,0 +1,228 @@
+/**
+ * @file playback.cpp
+ * @brief Implementation of the PlaybackEngine class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the materialization of the time-lapse frames and the
+ * timer-driven stepping through them.
+ */
+
+#include "playback.h"
+#include "airquality.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Constructs an empty engine.
+ * @param parent Parent QObject.
+ */
+PlaybackEngine::PlaybackEngine(QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(FrameIntervalMs);
+    connect(&m_timer, &QTimer::timeout, this, &PlaybackEngine::onTick);
+}
+
+/**
+ * @brief Materializes the frames of a parameter.
+ * @param param Parameter code, used for the index colors.
+ * @param stations Stations with their series.
+ * @param endTime Time of the last frame in ms since epoch; -1 for the
+ *        newest sample of all series.
+ *
+ * Every station is a single linear walk over its window of the series. A
+ * missing hour shows the previous value for at most MaxGapHours.
+ */
+void PlaybackEngine::build(const QString &param, const QList<PlaybackStation> &stations, qint64 endTime)
+{
+    if (endTime < 0) {
+        for (const PlaybackStation &station : stations) {
+            if (station.series && !station.series->isEmpty()) {
+                endTime = std::max(endTime, station.series->timestamps.last());
+            }
+        }
+    }
+
+    m_param = param;
+    m_stationIds.clear();
+    m_latitudes.clear();
+    m_longitudes.clear();
+    m_colors.clear();
+    m_values.clear();
+    m_currentColors = nullptr;
+    m_currentValues = nullptr;
+
+    if (endTime < 0 || stations.isEmpty()) {
+        setPlaying(false);
+        emit framesChanged();
+        emit frameChanged();
+        return;
+    }
+
+    // Klatki wyrównane do pełnych godzin
+    endTime -= endTime % HourMs;
+    m_startTime = endTime - (Hours - 1) * HourMs;
+
+    const qsizetype n = stations.size();
+    m_stationIds.reserve(n);
+    m_latitudes.reserve(n);
+    m_longitudes.reserve(n);
+    m_colors.resize(n * Hours);
+    m_values.resize(n * Hours);
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (qsizetype s = 0; s < n; ++s) {
+        const PlaybackStation &station = stations[s];
+        m_stationIds.append(station.stationId);
+        m_latitudes.append(station.lat);
+        m_longitudes.append(station.lon);
+
+        const Series empty;
+        const Series &series = station.series ? *station.series : empty;
+        const qint64 from = m_startTime - MaxGapHours * HourMs;
+        qsizetype i = std::lower_bound(series.timestamps.cbegin(), series.timestamps.cend(), from)
+                      - series.timestamps.cbegin();
+
+        double held = std::numeric_limits<double>::quiet_NaN();
+        qint64 heldTime = 0;
+        for (int f = 0; f < Hours; ++f) {
+            const qint64 t = frameTimestamp(f);
+            while (i < series.size() && series.timestamps[i] <= t) {
+                if (!std::isnan(series.values[i])) {
+                    held = series.values[i];
+                    heldTime = series.timestamps[i];
+                }
+                ++i;
+            }
+            const bool valid = !std::isnan(held) && t - heldTime <= MaxGapHours * HourMs;
+            const double value = valid ? held : std::numeric_limits<double>::quiet_NaN();
+            m_values[f * n + s] = valid ? float(value) : nan;
+            m_colors[f * n + s] = AirQuality::color(AirQuality::level(param, value));
+        }
+    }
+
+    m_frame = std::clamp(m_frame, 0, Hours - 1);
+    if (int(m_position) != m_frame) {
+        m_position = m_frame;
+    }
+    showFrame(m_frame);
+    emit framesChanged();
+    emit frameChanged();
+}
+
+/**
+ * @brief Moves to a frame.
+ * @param frame Frame index, clamped to the valid range.
+ *
+ * Used for scrubbing; a running playback continues from the new frame.
+ */
+void PlaybackEngine::setFrame(int frame)
+{
+    if (frameCount() == 0) {
+        return;
+    }
+    frame = std::clamp(frame, 0, Hours - 1);
+    m_position = frame;
+    if (frame != m_frame) {
+        showFrame(frame);
+        emit frameChanged();
+    }
+}
+
+/**
+ * @brief Gets the time of the current frame.
+ * @return Date in "yyyy-MM-dd HH:mm:ss" format, empty if nothing was built.
+ */
+QString PlaybackEngine::frameTime() const
+{
+    return frameCount() == 0 ? QString() : SeriesStore::formatDate(frameTimestamp(m_frame));
+}
+
+/**
+ * @brief Starts or stops playback.
+ * @param playing New state.
+ */
+void PlaybackEngine::setPlaying(bool playing)
+{
+    playing = playing && frameCount() > 0;
+    if (playing == m_timer.isActive()) {
+        return;
+    }
+    if (playing) {
+        // Start od początku po dojściu do końca
+        if (m_frame == Hours - 1) {
+            setFrame(0);
+        }
+        m_clock.start();
+        m_timer.start();
+    } else {
+        m_timer.stop();
+    }
+    emit playingChanged();
+}
+
+/**
+ * @brief Sets the playback speed.
+ * @param speed Hours of data per second, greater than zero.
+ */
+void PlaybackEngine::setSpeed(double speed)
+{
+    if (speed <= 0.0 || qFuzzyCompare(speed, m_speed)) {
+        return;
+    }
+    m_speed = speed;
+    emit speedChanged();
+}
+
+/**
+ * @brief Gets the value of a station in the current frame.
+ * @param stationId Station ID.
+ * @return Value, NaN if unknown.
+ */
+double PlaybackEngine::valueOf(int stationId) const
+{
+    const qsizetype index = m_stationIds.indexOf(stationId);
+    if (index < 0 || !m_currentValues) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    return m_currentValues[index];
+}
+
+/**
+ * @brief Advances the position by the elapsed time.
+ *
+ * The position follows the wall clock, so a late tick skips frames instead of
+ * slowing the playback down. frameChanged is emitted only when the hour
+ * changes.
+ */
+void PlaybackEngine::onTick()
+{
+    m_position += m_speed * double(m_clock.restart()) / 1000.0;
+    if (m_position >= Hours) {
+        m_position = Hours - 1;
+        showFrame(Hours - 1);
+        emit frameChanged();
+        setPlaying(false);
+        return;
+    }
+    const int frame = int(m_position);
+    if (frame != m_frame) {
+        showFrame(frame);
+        emit frameChanged();
+    }
+}
+
+/**
+ * @brief Points the current frame pointers at a frame.
+ * @param frame Frame index.
+ */
+void PlaybackEngine::showFrame(int frame)
+{
+    m_frame = frame;
+    const qsizetype offset = qsizetype(frame) * m_stationIds.size();
+    m_currentColors = m_colors.constData() + offset;
+    m_currentValues = m_values.constData() + offset;
+}
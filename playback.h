@@ -0,0 +1,230 @@
+/**
+ * @file playback.h
+ * @brief Header file for the PlaybackEngine class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the nationwide time-lapse of a parameter: hourly frames of
+ * station values and index colors, pre-materialized from the series store and
+ * stepped by a timer.
+ */
+
+#ifndef PLAYBACK_H
+#define PLAYBACK_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QRgb>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include "seriesstore.h"
+
+/**
+ * @struct PlaybackStation
+ * @brief Input of one station for PlaybackEngine::build().
+ */
+struct PlaybackStation {
+    int stationId = 0;                  ///< Station ID
+    double lat = 0.0;                   ///< Latitude
+    double lon = 0.0;                   ///< Longitude
+    const Series *series = nullptr;     ///< Series of the station sensor
+};
+
+/**
+ * @class PlaybackEngine
+ * @brief Time-lapse of the last hours of a parameter over all stations.
+ *
+ * All frames live in one frame-major array, so moving to another frame only
+ * swaps the pointer returned by currentColors(); nothing is allocated while
+ * playing.
+ */
+class PlaybackEngine : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(QString param READ param NOTIFY framesChanged)
+    Q_PROPERTY(int frameCount READ frameCount NOTIFY framesChanged)
+    Q_PROPERTY(int stationCount READ stationCount NOTIFY framesChanged)
+    Q_PROPERTY(int frame READ frame WRITE setFrame NOTIFY frameChanged)
+    Q_PROPERTY(QString frameTime READ frameTime NOTIFY frameChanged)
+    Q_PROPERTY(bool playing READ isPlaying WRITE setPlaying NOTIFY playingChanged)
+    Q_PROPERTY(double speed READ speed WRITE setSpeed NOTIFY speedChanged)
+
+public:
+    static constexpr int Hours = 72;                ///< Length of the time-lapse in hours
+    static constexpr int MaxGapHours = 2;           ///< Hours a value is held over missing samples
+    static constexpr int FrameIntervalMs = 33;      ///< Timer interval, about 30 fps
+    static constexpr qint64 HourMs = 3600 * 1000;   ///< One hour in milliseconds
+
+    /**
+     * @brief Constructs an empty engine.
+     * @param parent Parent QObject.
+     */
+    explicit PlaybackEngine(QObject *parent = nullptr);
+
+    /**
+     * @brief Materializes the frames of a parameter.
+     * @param param Parameter code, used for the index colors.
+     * @param stations Stations with their series.
+     * @param endTime Time of the last frame in ms since epoch; -1 for the
+     *        newest sample of all series.
+     *
+     * The current frame is kept, so data arriving during playback does not
+     * restart it.
+     */
+    void build(const QString &param, const QList<PlaybackStation> &stations, qint64 endTime = -1);
+
+    /**
+     * @brief Gets the parameter of the frames.
+     * @return Parameter code.
+     */
+    QString param() const { return m_param; }
+
+    /**
+     * @brief Gets the number of frames.
+     * @return Hours, or 0 if nothing was built.
+     */
+    int frameCount() const { return m_stationIds.isEmpty() ? 0 : Hours; }
+
+    /**
+     * @brief Gets the number of stations in every frame.
+     * @return Station count.
+     */
+    int stationCount() const { return int(m_stationIds.size()); }
+
+    /**
+     * @brief Gets the current frame.
+     * @return Frame index, 0 is the oldest hour.
+     */
+    int frame() const { return m_frame; }
+
+    /**
+     * @brief Moves to a frame.
+     * @param frame Frame index, clamped to the valid range.
+     */
+    void setFrame(int frame);
+
+    /**
+     * @brief Gets the time of the current frame.
+     * @return Date in "yyyy-MM-dd HH:mm:ss" format, empty if nothing was built.
+     */
+    QString frameTime() const;
+
+    /**
+     * @brief Gets the time of a frame.
+     * @param frame Frame index.
+     * @return Milliseconds since epoch.
+     */
+    qint64 frameTimestamp(int frame) const { return m_startTime + frame * HourMs; }
+
+    /**
+     * @brief Checks whether the time-lapse is playing.
+     * @return True while playing.
+     */
+    bool isPlaying() const { return m_timer.isActive(); }
+
+    /**
+     * @brief Starts or stops playback.
+     * @param playing New state.
+     */
+    void setPlaying(bool playing);
+
+    /**
+     * @brief Gets the playback speed.
+     * @return Hours of data per second.
+     */
+    double speed() const { return m_speed; }
+
+    /**
+     * @brief Sets the playback speed.
+     * @param speed Hours of data per second, greater than zero.
+     */
+    void setSpeed(double speed);
+
+    /**
+     * @brief Gets the station IDs in frame order.
+     * @return Station IDs.
+     */
+    const QVector<int> &stationIds() const { return m_stationIds; }
+
+    /**
+     * @brief Gets the station latitudes in frame order.
+     * @return Latitudes.
+     */
+    const QVector<double> &latitudes() const { return m_latitudes; }
+
+    /**
+     * @brief Gets the station longitudes in frame order.
+     * @return Longitudes.
+     */
+    const QVector<double> &longitudes() const { return m_longitudes; }
+
+    /**
+     * @brief Gets the colors of the current frame.
+     * @return stationCount() colors, nullptr if nothing was built.
+     */
+    const QRgb *currentColors() const { return m_currentColors; }
+
+    /**
+     * @brief Gets the values of the current frame.
+     * @return stationCount() values, NaN for no data; nullptr if nothing was built.
+     */
+    const float *currentValues() const { return m_currentValues; }
+
+    /**
+     * @brief Gets the value of a station in the current frame.
+     * @param stationId Station ID.
+     * @return Value, NaN if unknown.
+     */
+    Q_INVOKABLE double valueOf(int stationId) const;
+
+signals:
+    /**
+     * @brief Emitted when the frames are rebuilt.
+     */
+    void framesChanged();
+
+    /**
+     * @brief Emitted when the current frame changes.
+     */
+    void frameChanged();
+
+    /**
+     * @brief Emitted when playback starts or stops.
+     */
+    void playingChanged();
+
+    /**
+     * @brief Emitted when the speed changes.
+     */
+    void speedChanged();
+
+private:
+    /**
+     * @brief Advances the position by the elapsed time.
+     */
+    void onTick();
+
+    /**
+     * @brief Points the current frame pointers at a frame.
+     * @param frame Frame index.
+     */
+    void showFrame(int frame);
+
+    QString m_param;                    ///< Parameter of the frames
+    qint64 m_startTime = 0;             ///< Time of frame 0
+    QVector<int> m_stationIds;          ///< Station IDs in frame order
+    QVector<double> m_latitudes;        ///< Latitudes in frame order
+    QVector<double> m_longitudes;       ///< Longitudes in frame order
+    QVector<QRgb> m_colors;             ///< Frame-major index colors
+    QVector<float> m_values;            ///< Frame-major values, NaN for no data
+    const QRgb *m_currentColors = nullptr; ///< Colors of the current frame
+    const float *m_currentValues = nullptr; ///< Values of the current frame
+    int m_frame = 0;                    ///< Current frame
+    double m_position = 0.0;            ///< Fractional position in hours
+    double m_speed = 4.0;               ///< Hours per second
+    QTimer m_timer;                     ///< Frame timer
+    QElapsedTimer m_clock;              ///< Time since the last tick
+};
+
+#endif // PLAYBACK_H
@@ -0,0 +1,212 @@
+/**
+ * @file playbacklayer.cpp
+ * @brief Implementation of the PlaybackLayer class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the projection of stations to the map and the scene
+ * graph node of the time-lapse overlay.
+ */
+
+#include "playbacklayer.h"
+#include <QSGGeometryNode>
+#include <QSGVertexColorMaterial>
+#include <QtMath>
+#include <cmath>
+
+namespace {
+
+constexpr int VerticesPerDot = 6;   ///< Two triangles per dot
+
+} // namespace
+
+/**
+ * @brief Constructs the layer.
+ * @param parent Parent item.
+ */
+PlaybackLayer::PlaybackLayer(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents, true);
+}
+
+/**
+ * @brief Sets the drawn engine.
+ * @param engine Playback engine.
+ */
+void PlaybackLayer::setEngine(PlaybackEngine *engine)
+{
+    if (m_engine == engine) {
+        return;
+    }
+    if (m_engine) {
+        disconnect(m_engine, nullptr, this, nullptr);
+    }
+    m_engine = engine;
+    if (m_engine) {
+        connect(m_engine, &PlaybackEngine::framesChanged, this, &PlaybackLayer::invalidatePositions);
+        connect(m_engine, &PlaybackEngine::frameChanged, this, [this]() { update(); });
+    }
+    emit engineChanged();
+    invalidatePositions();
+}
+
+/**
+ * @brief Sets the map center.
+ * @param center Center coordinate, bound to Map.center.
+ */
+void PlaybackLayer::setCenter(const QGeoCoordinate &center)
+{
+    if (m_center == center) {
+        return;
+    }
+    m_center = center;
+    emit centerChanged();
+    invalidatePositions();
+}
+
+/**
+ * @brief Sets the map zoom level.
+ * @param zoomLevel Zoom level, bound to Map.zoomLevel.
+ */
+void PlaybackLayer::setZoomLevel(qreal zoomLevel)
+{
+    if (qFuzzyCompare(m_zoomLevel, zoomLevel)) {
+        return;
+    }
+    m_zoomLevel = zoomLevel;
+    emit zoomLevelChanged();
+    invalidatePositions();
+}
+
+/**
+ * @brief Sets the dot size.
+ * @param dotSize Dot side in pixels.
+ */
+void PlaybackLayer::setDotSize(qreal dotSize)
+{
+    if (qFuzzyCompare(m_dotSize, dotSize)) {
+        return;
+    }
+    m_dotSize = dotSize;
+    emit dotSizeChanged();
+    invalidatePositions();
+}
+
+/**
+ * @brief Projects a coordinate to Web Mercator world pixels.
+ * @param lat Latitude in degrees.
+ * @param lon Longitude in degrees.
+ * @param zoomLevel Zoom level.
+ * @return Position in a world of TileSize·2^zoomLevel pixels.
+ */
+QPointF PlaybackLayer::project(double lat, double lon, double zoomLevel)
+{
+    const double world = TileSize * std::pow(2.0, zoomLevel);
+    const double sinLat = std::sin(qDegreesToRadians(lat));
+    const double x = (lon + 180.0) / 360.0;
+    const double y = 0.5 - std::log((1.0 + sinLat) / (1.0 - sinLat)) / (4.0 * M_PI);
+    return QPointF(x * world, y * world);
+}
+
+/**
+ * @brief Marks positions dirty when the item is resized.
+ * @param newGeometry New geometry.
+ * @param oldGeometry Old geometry.
+ */
+void PlaybackLayer::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        invalidatePositions();
+    }
+}
+
+/**
+ * @brief Schedules recomputation of the vertex positions.
+ */
+void PlaybackLayer::invalidatePositions()
+{
+    m_positionsDirty = true;
+    update();
+}
+
+/**
+ * @brief Updates the geometry node.
+ * @param oldNode Node of the previous update.
+ * @param data Update data.
+ * @return Geometry node, nullptr if there is nothing to draw.
+ *
+ * Runs on the render thread while the GUI thread is blocked, so the frame
+ * pointer of the engine can be read directly.
+ */
+QSGNode *PlaybackLayer::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+    auto *node = static_cast<QSGGeometryNode *>(oldNode);
+    const int count = m_engine ? m_engine->stationCount() : 0;
+    if (count == 0 || !m_engine->currentColors() || !m_center.isValid()) {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node) {
+        node = new QSGGeometryNode;
+        auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_ColoredPoint2D(), 0);
+        geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+        node->setGeometry(geometry);
+        node->setFlag(QSGNode::OwnsGeometry);
+        node->setMaterial(new QSGVertexColorMaterial);
+        node->setFlag(QSGNode::OwnsMaterial);
+        m_positionsDirty = true;
+    }
+
+    QSGGeometry *geometry = node->geometry();
+    if (geometry->vertexCount() != count * VerticesPerDot) {
+        geometry->allocate(count * VerticesPerDot);
+        m_positionsDirty = true;
+    }
+    QSGGeometry::ColoredPoint2D *vertices = geometry->vertexDataAsColoredPoint2D();
+
+    if (m_positionsDirty) {
+        const QPointF origin = project(m_center.latitude(), m_center.longitude(), m_zoomLevel)
+                               - QPointF(width() / 2.0, height() / 2.0);
+        const float half = float(m_dotSize / 2.0);
+        const QVector<double> &lats = m_engine->latitudes();
+        const QVector<double> &lons = m_engine->longitudes();
+        for (int s = 0; s < count; ++s) {
+            const QPointF p = project(lats[s], lons[s], m_zoomLevel) - origin;
+            const float x0 = float(p.x()) - half;
+            const float y0 = float(p.y()) - half;
+            const float x1 = float(p.x()) + half;
+            const float y1 = float(p.y()) + half;
+            QSGGeometry::ColoredPoint2D *v = vertices + s * VerticesPerDot;
+            v[0].x = x0; v[0].y = y0;
+            v[1].x = x1; v[1].y = y0;
+            v[2].x = x0; v[2].y = y1;
+            v[3].x = x1; v[3].y = y0;
+            v[4].x = x1; v[4].y = y1;
+            v[5].x = x0; v[5].y = y1;
+        }
+        m_positionsDirty = false;
+    }
+
+    // Kolory bieżącej klatki, zapis w miejscu
+    const QRgb *colors = m_engine->currentColors();
+    for (int s = 0; s < count; ++s) {
+        const QRgb c = colors[s];
+        const uchar r = uchar(qRed(c));
+        const uchar g = uchar(qGreen(c));
+        const uchar b = uchar(qBlue(c));
+        QSGGeometry::ColoredPoint2D *v = vertices + s * VerticesPerDot;
+        for (int k = 0; k < VerticesPerDot; ++k) {
+            v[k].r = r;
+            v[k].g = g;
+            v[k].b = b;
+            v[k].a = 255;
+        }
+    }
+
+    node->markDirty(QSGNode::DirtyGeometry);
+    return node;
+}
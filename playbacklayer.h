@@ -0,0 +1,153 @@
+/**
+ * @file playbacklayer.h
+ * @brief Header file for the PlaybackLayer class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the map overlay drawing the current time-lapse frame as
+ * colored station dots.
+ */
+
+#ifndef PLAYBACKLAYER_H
+#define PLAYBACKLAYER_H
+
+#include <QQuickItem>
+#include <QGeoCoordinate>
+#include <QPointer>
+#include <QPointF>
+#include "playback.h"
+
+/**
+ * @class PlaybackLayer
+ * @brief Scene graph overlay of a PlaybackEngine placed over the map.
+ *
+ * All stations are one geometry node. Vertex positions are recomputed only
+ * when the map center, zoom or size changes; a frame change rewrites the
+ * vertex colors in place, so playback allocates nothing and runs no QML.
+ * Positions use the Web Mercator projection of the map, which must not be
+ * rotated or tilted.
+ */
+class PlaybackLayer : public QQuickItem {
+    Q_OBJECT
+    Q_PROPERTY(PlaybackEngine *engine READ engine WRITE setEngine NOTIFY engineChanged)
+    Q_PROPERTY(QGeoCoordinate center READ center WRITE setCenter NOTIFY centerChanged)
+    Q_PROPERTY(qreal zoomLevel READ zoomLevel WRITE setZoomLevel NOTIFY zoomLevelChanged)
+    Q_PROPERTY(qreal dotSize READ dotSize WRITE setDotSize NOTIFY dotSizeChanged)
+
+public:
+    static constexpr double TileSize = 256.0;   ///< World size at zoom level 0 in pixels
+
+    /**
+     * @brief Constructs the layer.
+     * @param parent Parent item.
+     */
+    explicit PlaybackLayer(QQuickItem *parent = nullptr);
+
+    /**
+     * @brief Gets the drawn engine.
+     * @return Playback engine.
+     */
+    PlaybackEngine *engine() const { return m_engine; }
+
+    /**
+     * @brief Sets the drawn engine.
+     * @param engine Playback engine.
+     */
+    void setEngine(PlaybackEngine *engine);
+
+    /**
+     * @brief Gets the map center.
+     * @return Center coordinate.
+     */
+    QGeoCoordinate center() const { return m_center; }
+
+    /**
+     * @brief Sets the map center.
+     * @param center Center coordinate, bound to Map.center.
+     */
+    void setCenter(const QGeoCoordinate &center);
+
+    /**
+     * @brief Gets the map zoom level.
+     * @return Zoom level.
+     */
+    qreal zoomLevel() const { return m_zoomLevel; }
+
+    /**
+     * @brief Sets the map zoom level.
+     * @param zoomLevel Zoom level, bound to Map.zoomLevel.
+     */
+    void setZoomLevel(qreal zoomLevel);
+
+    /**
+     * @brief Gets the dot size.
+     * @return Dot side in pixels.
+     */
+    qreal dotSize() const { return m_dotSize; }
+
+    /**
+     * @brief Sets the dot size.
+     * @param dotSize Dot side in pixels.
+     */
+    void setDotSize(qreal dotSize);
+
+    /**
+     * @brief Projects a coordinate to Web Mercator world pixels.
+     * @param lat Latitude in degrees.
+     * @param lon Longitude in degrees.
+     * @param zoomLevel Zoom level.
+     * @return Position in a world of TileSize·2^zoomLevel pixels.
+     */
+    static QPointF project(double lat, double lon, double zoomLevel);
+
+signals:
+    /**
+     * @brief Emitted when the engine changes.
+     */
+    void engineChanged();
+
+    /**
+     * @brief Emitted when the map center changes.
+     */
+    void centerChanged();
+
+    /**
+     * @brief Emitted when the zoom level changes.
+     */
+    void zoomLevelChanged();
+
+    /**
+     * @brief Emitted when the dot size changes.
+     */
+    void dotSizeChanged();
+
+protected:
+    /**
+     * @brief Updates the geometry node.
+     * @param oldNode Node of the previous update.
+     * @param data Update data.
+     * @return Geometry node, nullptr if there is nothing to draw.
+     */
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+
+    /**
+     * @brief Marks positions dirty when the item is resized.
+     * @param newGeometry New geometry.
+     * @param oldGeometry Old geometry.
+     */
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private:
+    /**
+     * @brief Schedules recomputation of the vertex positions.
+     */
+    void invalidatePositions();
+
+    QPointer<PlaybackEngine> m_engine;  ///< Drawn engine
+    QGeoCoordinate m_center;            ///< Map center
+    qreal m_zoomLevel = 8.0;            ///< Map zoom level
+    qreal m_dotSize = 10.0;             ///< Dot side in pixels
+    bool m_positionsDirty = true;       ///< Vertex positions need recomputation
+};
+
+#endif // PLAYBACKLAYER_H
@@ -0,0 +1,257 @@
+/**
+ * @file poolbenchmark.cpp
+ * @brief Implementation of the PoolBenchmark class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the synthetic jobs, their timing on both schedulers
+ * and the command line of the pool benchmark.
+ */
+
+#include "poolbenchmark.h"
+#include "correlation.h"
+#include "forecast.h"
+#include "taskpool.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+/**
+ * @brief Parallel loop of a scheduler: calls a body for indices 0 to count - 1.
+ */
+using ForEach = std::function<void(qsizetype count, const std::function<void(qsizetype)> &body)>;
+
+/**
+ * @struct Job
+ * @brief Named job returning a checksum of its results.
+ */
+struct Job {
+    QString name;                                   ///< Job name
+    int items = 0;                                  ///< Parallel items
+    std::function<double(const ForEach &)> run;     ///< Runs the job on a scheduler
+};
+
+/**
+ * @brief Parallel loop on the global QThreadPool.
+ * @param count Number of indices.
+ * @param body Body called with every index.
+ */
+void qtConcurrentFor(qsizetype count, const std::function<void(qsizetype)> &body)
+{
+    QVector<qsizetype> indices(count);
+    std::iota(indices.begin(), indices.end(), 0);
+    QtConcurrent::blockingMap(indices, [&body](qsizetype i) { body(i); });
+}
+
+/**
+ * @brief Parallel loop on the shared TaskPool.
+ * @param count Number of indices.
+ * @param body Body called with every index.
+ */
+void taskPoolFor(qsizetype count, const std::function<void(qsizetype)> &body)
+{
+    TaskPool::instance().blockingFor(count, body);
+}
+
+/**
+ * @brief Builds a synthetic hourly series with gaps.
+ * @param seed Series number.
+ * @param samples Number of samples.
+ * @return Series starting on 2026-01-01.
+ */
+Series syntheticSeries(int seed, int samples)
+{
+    Series series;
+    series.timestamps.reserve(samples);
+    series.values.reserve(samples);
+    const qint64 start = 1767222000000;     // 2026-01-01 00:00 CET
+    for (int k = 0; k < samples; ++k) {
+        series.timestamps.append(start + k * HoltWinters::HourMs);
+        // Co 37. próbka brakuje, jak w danych GIOŚ
+        series.values.append((k + seed) % 37 == 0 ? NAN
+                                                   : 30.0 + 12.0 * std::sin(k * 0.2618 + seed) + 4.0 * std::sin(k * 0.031 * (seed % 7 + 1)));
+    }
+    return series;
+}
+
+/**
+ * @brief Builds the jobs.
+ * @param scale Multiplier of the number of items.
+ * @return Jobs.
+ */
+QList<Job> jobs(int scale)
+{
+    QList<Job> list;
+
+    // Prognozy: jeden model na szereg z 30 dni danych godzinowych
+    auto forecastSeries = std::make_shared<QList<Series>>();
+    for (int i = 0; i < 400 * scale; ++i) {
+        forecastSeries->append(syntheticSeries(i, 720));
+    }
+    list.append({"forecast", int(forecastSeries->size()), [forecastSeries](const ForEach &forEach) {
+        QVector<double> sums(forecastSeries->size(), 0.0);
+        forEach(forecastSeries->size(), [&](qsizetype i) {
+            HoltWinters model;
+            model.update(forecastSeries->at(i));
+            for (double value : model.forecast(ForecastEngine::Horizon).mean.values) {
+                sums[i] += value;
+            }
+        });
+        return std::accumulate(sums.cbegin(), sums.cend(), 0.0);
+    }});
+
+    // Rangi Spearmana: sortowanie roku danych godzinowych na kolumnę
+    auto rankColumns = std::make_shared<QList<QVector<double>>>();
+    for (int i = 0; i < 100 * scale; ++i) {
+        rankColumns->append(syntheticSeries(i, 8760).values);
+    }
+    list.append({"rank", int(rankColumns->size()), [rankColumns](const ForEach &forEach) {
+        QVector<double> sums(rankColumns->size(), 0.0);
+        forEach(rankColumns->size(), [&](qsizetype i) {
+            QVector<double> column = rankColumns->at(i);
+            Correlation::rankTransform(column);
+            sums[i] = column[qsizetype(i) % column.size()];
+        });
+        return std::accumulate(sums.cbegin(), sums.cend(), 0.0);
+    }});
+
+    // Koszt elementów rośnie kwadratowo, więc równe porcje się nie wyrównują
+    const int unevenItems = 2000 * scale;
+    list.append({"uneven", unevenItems, [unevenItems](const ForEach &forEach) {
+        QVector<double> sums(unevenItems, 0.0);
+        forEach(unevenItems, [&](qsizetype i) {
+            const qsizetype cost = (i % 97) * (i % 97) * 8;
+            double sum = 0.0;
+            for (qsizetype k = 0; k < cost; ++k) {
+                sum += std::sin(double(k + i));
+            }
+            sums[i] = sum;
+        });
+        return std::accumulate(sums.cbegin(), sums.cend(), 0.0);
+    }});
+
+    // Pętla równoległa wewnątrz równoległej, jak korelacja w trakcie prognoz
+    const int outer = 16 * scale;
+    list.append({"nested", outer * 64, [outer](const ForEach &forEach) {
+        QVector<double> sums(outer * 64, 0.0);
+        forEach(outer, [&](qsizetype o) {
+            forEach(64, [&](qsizetype i) {
+                QVector<double> column = syntheticSeries(int(o * 64 + i), 512).values;
+                Correlation::rankTransform(column);
+                sums[o * 64 + i] = column.first() + column.last();
+            });
+        });
+        return std::accumulate(sums.cbegin(), sums.cend(), 0.0);
+    }});
+    return list;
+}
+
+/**
+ * @brief Times a job on a scheduler.
+ * @param job Job.
+ * @param forEach Parallel loop of the scheduler.
+ * @param repeat Repetitions.
+ * @param checksum Checksum of the last repetition.
+ * @return Best time in milliseconds.
+ */
+double bestTime(const Job &job, const ForEach &forEach, int repeat, double *checksum)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int r = 0; r < repeat; ++r) {
+        QElapsedTimer timer;
+        timer.start();
+        *checksum = job.run(forEach);
+        best = std::min(best, timer.nsecsElapsed() / 1e6);
+    }
+    return best;
+}
+
+} // namespace
+
+/**
+ * @brief Runs the benchmark.
+ * @param scale Multiplier of the number of items of every job.
+ * @param repeat Repetitions; the best time is reported.
+ * @return One result per job.
+ */
+QList<PoolBenchmarkResult> PoolBenchmark::run(int scale, int repeat)
+{
+    QList<PoolBenchmarkResult> results;
+    const int runs = std::max(repeat, 1);
+    for (const Job &job : jobs(std::max(scale, 1))) {
+        PoolBenchmarkResult result;
+        result.job = job.name;
+        result.items = job.items;
+        double qtSum = 0.0;
+        double poolSum = 0.0;
+        result.qtConcurrentMs = bestTime(job, qtConcurrentFor, runs, &qtSum);
+        result.taskPoolMs = bestTime(job, taskPoolFor, runs, &poolSum);
+        // Kolejność sumowania jest stała, więc wyniki muszą być identyczne
+        result.matches = qtSum == poolSum || (std::isnan(qtSum) && std::isnan(poolSum));
+        results.append(result);
+    }
+    return results;
+}
+
+/**
+ * @brief Formats results as a text table.
+ * @param results Results.
+ * @return Report with one line per job.
+ */
+QString PoolBenchmark::report(const QList<PoolBenchmarkResult> &results)
+{
+    QString text;
+    QTextStream out(&text);
+    out << QString("Wątki: QThreadPool %1, TaskPool %2\n")
+               .arg(QThreadPool::globalInstance()->maxThreadCount()).arg(TaskPool::instance().threadCount());
+    out << QString("%1 %2 %3 %4 %5\n").arg("zadanie", -10).arg("elementy", 9).arg("QtConcurrent", 14)
+               .arg("TaskPool", 12).arg("przyspieszenie", 15);
+    for (const PoolBenchmarkResult &result : results) {
+        out << QString("%1 %2 %3 ms %4 ms %5x%6\n")
+                   .arg(result.job, -10)
+                   .arg(result.items, 9)
+                   .arg(result.qtConcurrentMs, 11, 'f', 1)
+                   .arg(result.taskPoolMs, 9, 'f', 1)
+                   .arg(result.speedup(), 14, 'f', 2)
+                   .arg(result.matches ? QString() : QString("  RÓŻNE WYNIKI"));
+    }
+    const TaskPool::Stats stats = TaskPool::instance().stats();
+    out << QString("TaskPool: %1 zadań, %2 podkradzionych\n").arg(stats.executed).arg(stats.stolen);
+    return text;
+}
+
+/**
+ * @brief Runs the benchmark from the command line.
+ * @param arguments Application arguments, see the --help output.
+ * @return 0, or 1 if the schedulers computed different results.
+ */
+int PoolBenchmark::main(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Porównanie TaskPool z QtConcurrent na tych samych zadaniach.");
+    parser.addHelpOption();
+    const QCommandLineOption benchOption("bench-pool", "Uruchamia porównanie pul wątków.");
+    const QCommandLineOption scaleOption("scale", "Mnożnik liczby elementów zadań.", "n", QString::number(DefaultScale));
+    const QCommandLineOption repeatOption("repeat", "Liczba powtórzeń; liczy się najlepszy czas.", "n", QString::number(DefaultRepeat));
+    parser.addOptions({benchOption, scaleOption, repeatOption});
+    parser.process(arguments);
+
+    const QList<PoolBenchmarkResult> results = run(parser.value(scaleOption).toInt(), parser.value(repeatOption).toInt());
+    QTextStream out(stdout);
+    out << report(results);
+    for (const PoolBenchmarkResult &result : results) {
+        if (!result.matches) {
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file poolbenchmark.h
+ * @brief Header file for the PoolBenchmark class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the benchmark comparing TaskPool with QtConcurrent on
+ * the same jobs, run with the --bench-pool option.
+ */
+
+#ifndef POOLBENCHMARK_H
+#define POOLBENCHMARK_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+/**
+ * @struct PoolBenchmarkResult
+ * @brief Times of one job on both schedulers.
+ */
+struct PoolBenchmarkResult {
+    QString job;                    ///< Job name
+    int items = 0;                  ///< Parallel items of the job
+    double qtConcurrentMs = 0.0;    ///< Best time with QtConcurrent
+    double taskPoolMs = 0.0;        ///< Best time with TaskPool
+    bool matches = true;            ///< True if both computed the same checksum
+
+    /**
+     * @brief Gets how many times faster TaskPool was.
+     * @return Ratio of the times.
+     */
+    double speedup() const { return taskPoolMs > 0.0 ? qtConcurrentMs / taskPoolMs : 0.0; }
+};
+
+/**
+ * @class PoolBenchmark
+ * @brief Runs the analytics jobs of the application on both schedulers.
+ *
+ * The jobs are Holt-Winters forecasts, Spearman rank transforms, items of
+ * very uneven cost and a parallel loop nested in another one. Every job
+ * runs the same code on both schedulers and is timed as the best of
+ * several repetitions.
+ */
+class PoolBenchmark {
+public:
+    static constexpr int DefaultScale = 1;      ///< Job size without --scale
+    static constexpr int DefaultRepeat = 5;     ///< Repetitions without --repeat
+
+    /**
+     * @brief Runs the benchmark.
+     * @param scale Multiplier of the number of items of every job.
+     * @param repeat Repetitions; the best time is reported.
+     * @return One result per job.
+     */
+    static QList<PoolBenchmarkResult> run(int scale, int repeat);
+
+    /**
+     * @brief Formats results as a text table.
+     * @param results Results.
+     * @return Report with one line per job.
+     */
+    static QString report(const QList<PoolBenchmarkResult> &results);
+
+    /**
+     * @brief Runs the benchmark from the command line.
+     * @param arguments Application arguments, see the --help output.
+     * @return 0, or 1 if the schedulers computed different results.
+     */
+    static int main(const QStringList &arguments);
+};
+
+#endif // POOLBENCHMARK_H
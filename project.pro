@@ -1,20 +1,92 @@
-QT += core gui network qml quick positioning location testlib
-CONFIG += c++17
+QT += core gui network qml quick positioning location concurrent testlib
+CONFIG += c++20
 
 TARGET = stacje_pomiarowe
 
 SOURCES += \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    sensorcatalog.cpp \
+    seriesstore.cpp \
+    expression.cpp \
+    correlation.cpp \
+    heatmapitem.cpp \
+    forecast.cpp \
+    airquality.cpp \
+    playback.cpp \
+    playbacklayer.cpp \
+    localarchive.cpp \
+    archivemaintenance.cpp \
+    databankimporter.cpp \
+    writeaheadlog.cpp \
+    seriesdiff.cpp \
+    stationsortfiltermodel.cpp \
+    geotable.cpp \
+    batchsearch.cpp \
+    sparkline.cpp \
+    sparklinelayer.cpp \
+    watchlist.cpp \
+    dashboarditem.cpp \
+    lineingest.cpp \
+    dataprovider.cpp \
+    giosprovider.cpp \
+    replybufferpool.cpp \
+    logger.cpp \
+    metrics.cpp \
+    metricsexporter.cpp \
+    memoryaccounting.cpp \
+    memorybenchmark.cpp \
+    reportrenderer.cpp \
+    async.cpp \
+    taskpool.cpp \
+    poolbenchmark.cpp
 
 HEADERS += \
-    mainwindow.h
+    mainwindow.h \
+    sensorcatalog.h \
+    seriesstore.h \
+    expression.h \
+    correlation.h \
+    heatmapitem.h \
+    forecast.h \
+    airquality.h \
+    playback.h \
+    playbacklayer.h \
+    localarchive.h \
+    archivemaintenance.h \
+    databankimporter.h \
+    writeaheadlog.h \
+    seriesdiff.h \
+    stationsortfiltermodel.h \
+    geotable.h \
+    batchsearch.h \
+    sparkline.h \
+    sparklinelayer.h \
+    watchlist.h \
+    dashboarditem.h \
+    lineingest.h \
+    dataprovider.h \
+    giosprovider.h \
+    replybufferpool.h \
+    logger.h \
+    metrics.h \
+    metricsexporter.h \
+    memoryaccounting.h \
+    memorybenchmark.h \
+    reportrenderer.h \
+    async.h \
+    taskpool.h \
+    poolbenchmark.h
 
 RESOURCES += \
     qml.qrc
 
 DISTFILES += \
     StationDialog.qml \
+    CorrelationDialog.qml \
+    ArchivedDataDialog.qml \
+    BatchSearchDialog.qml \
+    DashboardDialog.qml \
     main.qml \
     project.pro.user
 
@@ -0,0 +1,244 @@
+/**
+ * @file replybufferpool.cpp
+ * @brief Implementation of the ReplyBufferPool and PooledBuffer classes.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the size classes, the streaming of reply bodies and the
+ * counters of the buffer pool.
+ */
+
+#include "replybufferpool.h"
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <algorithm>
+
+/**
+ * @brief Moves a buffer, releasing the current one.
+ * @param other Buffer left empty.
+ * @return This buffer.
+ */
+PooledBuffer &PooledBuffer::operator=(PooledBuffer &&other) noexcept
+{
+    if (this != &other) {
+        if (m_pool) {
+            m_pool->release(std::move(m_data));
+        }
+        m_pool = std::exchange(other.m_pool, nullptr);
+        m_data = std::move(other.m_data);
+    }
+    return *this;
+}
+
+/**
+ * @brief Returns the buffer to its pool.
+ */
+PooledBuffer::~PooledBuffer()
+{
+    if (m_pool) {
+        m_pool->release(std::move(m_data));
+    }
+}
+
+/**
+ * @brief Constructs an empty pool.
+ * @param parent Parent QObject.
+ */
+ReplyBufferPool::ReplyBufferPool(QObject *parent)
+    : QObject(parent),
+    m_idle(sizeClass(MaxClassSize) + 1)
+{
+}
+
+/**
+ * @brief Gets the pool shared by the replies of a network manager.
+ * @param manager Network manager.
+ * @return Pool, created on the first call.
+ */
+ReplyBufferPool *ReplyBufferPool::of(QNetworkAccessManager *manager)
+{
+    ReplyBufferPool *pool = manager->findChild<ReplyBufferPool *>(QString(), Qt::FindDirectChildrenOnly);
+    return pool ? pool : new ReplyBufferPool(manager);
+}
+
+/**
+ * @brief Starts streaming the body of a reply into a pooled buffer.
+ * @param reply Reply, attached right after the request was sent.
+ *
+ * A reply deleted without take(), e.g. after an error, gives its buffer
+ * back when destroyed.
+ */
+void ReplyBufferPool::attach(QNetworkReply *reply)
+{
+    m_streams.insert(reply, QByteArray());
+    connect(reply, &QNetworkReply::readyRead, this, [this, reply]() {
+        const auto it = m_streams.find(reply);
+        if (it != m_streams.end()) {
+            drain(reply, it.value());
+        }
+    });
+    connect(reply, &QObject::destroyed, this, [this, reply]() {
+        const auto it = m_streams.find(reply);
+        if (it != m_streams.end()) {
+            release(std::move(it.value()));
+            m_streams.erase(it);
+        }
+    });
+}
+
+/**
+ * @brief Takes the body of a finished reply.
+ * @param reply Reply; does not need to be attached.
+ * @return Complete body.
+ */
+PooledBuffer ReplyBufferPool::take(QNetworkReply *reply)
+{
+    QByteArray buffer = m_streams.take(reply);
+    drain(reply, buffer);
+    ++m_stats.requests;
+    return PooledBuffer(this, std::move(buffer));
+}
+
+/**
+ * @brief Gets an empty buffer with at least the given capacity.
+ * @param size Expected size in bytes.
+ * @return Buffer of size 0.
+ */
+QByteArray ReplyBufferPool::acquire(qsizetype size)
+{
+    const int index = sizeClass(size);
+    if (index >= 0 && !m_idle[index].isEmpty()) {
+        ++m_stats.reuses;
+        QByteArray buffer = m_idle[index].takeLast();
+        m_stats.bytesIdle -= buffer.capacity();
+        return buffer;
+    }
+    ++m_stats.allocations;
+    QByteArray buffer;
+    buffer.reserve(index >= 0 ? MinClassSize << index : size);
+    return buffer;
+}
+
+/**
+ * @brief Returns a buffer for reuse.
+ * @param buffer Buffer; dropped if shared, unpooled or the class is full.
+ */
+void ReplyBufferPool::release(QByteArray &&buffer)
+{
+    const qsizetype capacity = buffer.capacity();
+    // Klasa o rozmiarze nie większym niż pojemność, bo acquire() jej ufa
+    int index = sizeClass(capacity);
+    if (index > 0 && (MinClassSize << index) > capacity) {
+        --index;
+    }
+    // Współdzielony bufor wciąż czyta ktoś inny; bufor spoza klas nie wraca
+    if (index < 0 || capacity < MinClassSize || !buffer.isDetached()
+        || m_idle[index].size() >= MaxIdlePerClass) {
+        return;
+    }
+    buffer.resize(0);
+    m_stats.bytesIdle += capacity;
+    m_idle[index].append(std::move(buffer));
+}
+
+/**
+ * @brief Gets the counters.
+ * @return Counters since creation.
+ */
+ReplyBufferStats ReplyBufferPool::stats() const
+{
+    return m_stats;
+}
+
+/**
+ * @brief Gets the counters for QML and the metrics endpoint.
+ * @return Map with the ReplyBufferStats fields and the per-request averages.
+ */
+QVariantMap ReplyBufferPool::statsMap() const
+{
+    const double requests = std::max<qint64>(m_stats.requests, 1);
+    QVariantMap map;
+    map["requests"] = m_stats.requests;
+    map["allocations"] = m_stats.allocations;
+    map["reuses"] = m_stats.reuses;
+    map["bytesCopied"] = m_stats.bytesCopied;
+    map["bytesIdle"] = m_stats.bytesIdle;
+    map["allocationsPerRequest"] = m_stats.allocations / requests;
+    map["bytesCopiedPerRequest"] = m_stats.bytesCopied / requests;
+    return map;
+}
+
+/**
+ * @brief Gets the memory held by the idle and receiving buffers.
+ * @return Capacity and number of buffers; bodies already taken are held by
+ *         their readers.
+ */
+MemoryAccounting::Usage ReplyBufferPool::memoryUsage() const
+{
+    MemoryAccounting::Usage usage;
+    for (const QList<QByteArray> &idle : m_idle) {
+        for (const QByteArray &buffer : idle) {
+            usage.bytes += MemoryAccounting::arrayBytes(buffer.capacity() + 1, 1);
+            ++usage.objects;
+        }
+    }
+    for (const QByteArray &buffer : m_streams) {
+        if (buffer.capacity() > 0) {
+            usage.bytes += MemoryAccounting::arrayBytes(buffer.capacity() + 1, 1);
+            ++usage.objects;
+        }
+    }
+    usage.bytes += MemoryAccounting::bytes(m_streams);
+    return usage;
+}
+
+/**
+ * @brief Gets the size class of a size.
+ * @param size Size in bytes.
+ * @return Class index, -1 if larger than MaxClassSize.
+ */
+int ReplyBufferPool::sizeClass(qsizetype size)
+{
+    int index = 0;
+    while ((MinClassSize << index) < size) {
+        if ((MinClassSize << index) >= MaxClassSize) {
+            return -1;
+        }
+        ++index;
+    }
+    return index;
+}
+
+/**
+ * @brief Appends the available data of a reply to a buffer.
+ * @param reply Reply.
+ * @param buffer Buffer, moved to a larger class if needed.
+ *
+ * The first call sizes the buffer by the Content-Length header, so a body
+ * of known length is copied exactly once, from the reply into the buffer.
+ */
+void ReplyBufferPool::drain(QNetworkReply *reply, QByteArray &buffer)
+{
+    const qint64 available = reply->bytesAvailable();
+    if (buffer.capacity() == 0) {
+        const qint64 announced = reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+        buffer = acquire(qsizetype(std::max(announced, available)));
+    }
+    if (available <= 0) {
+        return;
+    }
+
+    const qsizetype used = buffer.size();
+    if (used + available > buffer.capacity()) {
+        // Za mały bufor: przenosimy zawartość do następnej klasy
+        QByteArray larger = acquire(qsizetype(std::max<qint64>(used + available, buffer.capacity() * 2)));
+        larger.append(buffer.constData(), used);
+        m_stats.bytesCopied += used;
+        release(std::move(buffer));
+        buffer = std::move(larger);
+    }
+    buffer.resize(used + available);
+    const qint64 read = reply->read(buffer.data() + used, available);
+    buffer.resize(used + std::max<qint64>(read, 0));
+    m_stats.bytesCopied += std::max<qint64>(read, 0);
+}
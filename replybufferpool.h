@@ -0,0 +1,194 @@
+/**
+ * @file replybufferpool.h
+ * @brief Header file for the ReplyBufferPool and PooledBuffer classes.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the recycled, size-classed buffers receiving the bodies
+ * of network replies.
+ */
+
+#ifndef REPLYBUFFERPOOL_H
+#define REPLYBUFFERPOOL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QVariantMap>
+#include <QVector>
+#include "memoryaccounting.h"
+#include <utility>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+class ReplyBufferPool;
+
+/**
+ * @struct ReplyBufferStats
+ * @brief Counters of a buffer pool since its creation.
+ */
+struct ReplyBufferStats {
+    qint64 requests = 0;        ///< Reply bodies taken from the pool
+    qint64 allocations = 0;     ///< Buffers allocated because none was idle
+    qint64 reuses = 0;          ///< Buffers served from the idle lists
+    qint64 bytesCopied = 0;     ///< Bytes copied out of replies and on growth
+    qint64 bytesIdle = 0;       ///< Capacity of the idle buffers
+};
+
+/**
+ * @class PooledBuffer
+ * @brief Reply body that goes back to its pool when destroyed.
+ *
+ * Move-only. Copies of data() taken by the caller keep the memory alive
+ * through implicit sharing; such a buffer is not recycled.
+ */
+class PooledBuffer {
+public:
+    /**
+     * @brief Constructs an empty buffer.
+     */
+    PooledBuffer() = default;
+
+    /**
+     * @brief Constructs a buffer owned by a pool.
+     * @param pool Pool the buffer returns to.
+     * @param data Buffer.
+     */
+    PooledBuffer(ReplyBufferPool *pool, QByteArray &&data) : m_pool(pool), m_data(std::move(data)) {}
+
+    /**
+     * @brief Moves a buffer.
+     * @param other Buffer left empty.
+     */
+    PooledBuffer(PooledBuffer &&other) noexcept
+        : m_pool(std::exchange(other.m_pool, nullptr)), m_data(std::move(other.m_data)) {}
+
+    /**
+     * @brief Moves a buffer, releasing the current one.
+     * @param other Buffer left empty.
+     * @return This buffer.
+     */
+    PooledBuffer &operator=(PooledBuffer &&other) noexcept;
+
+    PooledBuffer(const PooledBuffer &) = delete;
+    PooledBuffer &operator=(const PooledBuffer &) = delete;
+
+    /**
+     * @brief Returns the buffer to its pool.
+     */
+    ~PooledBuffer();
+
+    /**
+     * @brief Gets the contents.
+     * @return Reply body; parsers read it in place.
+     */
+    const QByteArray &data() const { return m_data; }
+
+private:
+    ReplyBufferPool *m_pool = nullptr;  ///< Pool the buffer returns to
+    QByteArray m_data;                  ///< Reply body
+};
+
+/**
+ * @class ReplyBufferPool
+ * @brief Streams reply bodies into recycled buffers of power-of-two sizes.
+ *
+ * QIODevice::readAll() allocates a new array for every reply, sized by
+ * repeated growth when the length is not known in advance. Attached replies
+ * are drained on every readyRead into a buffer of the smallest class that
+ * fits the announced Content-Length, so the network stack never holds the
+ * whole body and finished replies allocate nothing once the pool is warm.
+ * A body larger than the largest class gets an unpooled buffer.
+ *
+ * All replies of a network manager share one pool, created on first use as
+ * a child of the manager. The pool lives in the thread of the manager.
+ */
+class ReplyBufferPool : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr qsizetype MinClassSize = 4 * 1024;         ///< Smallest buffer
+    static constexpr qsizetype MaxClassSize = 4 * 1024 * 1024;  ///< Largest pooled buffer
+    static constexpr int MaxIdlePerClass = 8;                   ///< Idle buffers kept per class
+
+    /**
+     * @brief Constructs an empty pool.
+     * @param parent Parent QObject.
+     */
+    explicit ReplyBufferPool(QObject *parent = nullptr);
+
+    /**
+     * @brief Gets the pool shared by the replies of a network manager.
+     * @param manager Network manager.
+     * @return Pool, created on the first call.
+     */
+    static ReplyBufferPool *of(QNetworkAccessManager *manager);
+
+    /**
+     * @brief Starts streaming the body of a reply into a pooled buffer.
+     * @param reply Reply, attached right after the request was sent.
+     */
+    void attach(QNetworkReply *reply);
+
+    /**
+     * @brief Takes the body of a finished reply.
+     * @param reply Reply; does not need to be attached.
+     * @return Complete body.
+     */
+    PooledBuffer take(QNetworkReply *reply);
+
+    /**
+     * @brief Gets an empty buffer with at least the given capacity.
+     * @param size Expected size in bytes.
+     * @return Buffer of size 0.
+     */
+    QByteArray acquire(qsizetype size);
+
+    /**
+     * @brief Returns a buffer for reuse.
+     * @param buffer Buffer; dropped if shared, unpooled or the class is full.
+     */
+    void release(QByteArray &&buffer);
+
+    /**
+     * @brief Gets the counters.
+     * @return Counters since creation.
+     */
+    ReplyBufferStats stats() const;
+
+    /**
+     * @brief Gets the counters for QML and the metrics endpoint.
+     * @return Map with the ReplyBufferStats fields and the per-request
+     *         "allocationsPerRequest" and "bytesCopiedPerRequest" averages.
+     */
+    QVariantMap statsMap() const;
+
+    /**
+     * @brief Gets the memory held by the idle and receiving buffers.
+     * @return Capacity and number of buffers; bodies already taken
+     *         are held by their readers.
+     */
+    MemoryAccounting::Usage memoryUsage() const;
+
+private:
+    /**
+     * @brief Gets the size class of a size.
+     * @param size Size in bytes.
+     * @return Class index, -1 if larger than MaxClassSize.
+     */
+    static int sizeClass(qsizetype size);
+
+    /**
+     * @brief Appends the available data of a reply to a buffer.
+     * @param reply Reply.
+     * @param buffer Buffer, moved to a larger class if needed.
+     */
+    void drain(QNetworkReply *reply, QByteArray &buffer);
+
+    QHash<QNetworkReply *, QByteArray> m_streams;   ///< Bodies of attached replies
+    QVector<QList<QByteArray>> m_idle;              ///< Idle buffers by class
+    ReplyBufferStats m_stats;                       ///< Counters
+};
+
+#endif // REPLYBUFFERPOOL_H
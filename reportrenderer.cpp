@@ -0,0 +1,565 @@
+/**
+ * @file reportrenderer.cpp
+ * @brief Implementation of the ReportRenderer class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the page layout, the chart, the statistics table and
+ * the map snippet of a station report, and the parallel rendering of many
+ * stations into files.
+ */
+
+#include "reportrenderer.h"
+#include "airquality.h"
+#include "taskpool.h"
+#include <QDateTime>
+#include <QDir>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPdfWriter>
+#include <QtConcurrent>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+/**
+ * @struct Rendered
+ * @brief Result of one station.
+ */
+struct Rendered {
+    QString path;           ///< Written file, empty on failure
+    bool skipped = false;   ///< True if cancelled before rendering
+};
+
+/**
+ * @struct SeriesStats
+ * @brief Statistics of the finite samples of a series.
+ */
+struct SeriesStats {
+    int count = 0;                  ///< Finite samples
+    double min = NAN;               ///< Smallest value
+    double max = NAN;               ///< Largest value
+    double mean = NAN;              ///< Mean value
+    double last = NAN;              ///< Newest value
+    qint64 lastTimestamp = 0;       ///< Time of the newest value
+};
+
+/**
+ * @brief Computes the statistics of a series.
+ * @param series Series.
+ * @return Statistics; NaN fields if there is no finite sample.
+ */
+SeriesStats statistics(const Series &series)
+{
+    SeriesStats stats;
+    double sum = 0.0;
+    for (qsizetype i = 0; i < series.size(); ++i) {
+        const double value = series.values[i];
+        if (!std::isfinite(value)) {
+            continue;
+        }
+        stats.min = stats.count == 0 ? value : std::min(stats.min, value);
+        stats.max = stats.count == 0 ? value : std::max(stats.max, value);
+        stats.last = value;
+        stats.lastTimestamp = series.timestamps[i];
+        sum += value;
+        ++stats.count;
+    }
+    if (stats.count > 0) {
+        stats.mean = sum / stats.count;
+    }
+    return stats;
+}
+
+/**
+ * @brief Gets the color of the n-th series.
+ * @param index Series index.
+ * @return Color of a fixed palette.
+ */
+QColor seriesColor(int index)
+{
+    static const QRgb palette[] = {0x1f77b4, 0xd62728, 0x2ca02c, 0xff7f0e, 0x9467bd, 0x8c564b, 0xe377c2, 0x17becf};
+    return QColor::fromRgb(palette[index % int(std::size(palette))]);
+}
+
+/**
+ * @brief Formats a value for the report.
+ * @param value Value, NaN for none.
+ * @return Text with one decimal, "–" for NaN.
+ */
+QString formatValue(double value)
+{
+    return std::isfinite(value) ? QString::number(value, 'f', 1) : QString("–");
+}
+
+/**
+ * @brief Formats a timestamp for the report.
+ * @param timestamp Milliseconds since epoch.
+ * @return Local date and time.
+ */
+QString formatTime(qint64 timestamp)
+{
+    return QDateTime::fromMSecsSinceEpoch(timestamp).toString("dd.MM.yyyy HH:mm");
+}
+
+} // namespace
+
+/**
+ * @brief Constructs an idle renderer.
+ * @param parent Parent QObject.
+ */
+ReportRenderer::ReportRenderer(QObject *parent)
+    : QObject(parent)
+{
+    // Jeden wątek koordynujący; strony rysuje globalna pula
+    m_pool.setMaxThreadCount(1);
+    connect(&m_watcher, &QFutureWatcher<ReportSummary>::finished, this, [this]() {
+        emit finished(m_watcher.result());
+    });
+}
+
+/**
+ * @brief Destroys the object, cancelling a running report.
+ */
+ReportRenderer::~ReportRenderer()
+{
+    cancel();
+}
+
+/**
+ * @brief Starts rendering on worker threads.
+ * @param stations Stations, one file each.
+ * @param mapPoints Longitude and latitude of all known stations.
+ * @param directory Output directory, created if missing.
+ * @param format File format.
+ */
+void ReportRenderer::start(const QList<ReportStation> &stations, const QVector<QPointF> &mapPoints,
+                           const QString &directory, Format format)
+{
+    if (isRunning()) {
+        return;
+    }
+    m_cancelled = false;
+    m_watcher.setFuture(QtConcurrent::run(&m_pool, [this, stations, mapPoints, directory, format]() {
+        return run(stations, mapPoints, directory, format);
+    }));
+}
+
+/**
+ * @brief Renders on the calling thread, mapping stations over the pool.
+ * @param stations Stations, one file each.
+ * @param mapPoints Longitude and latitude of all known stations.
+ * @param directory Output directory, created if missing.
+ * @param format File format.
+ * @return Summary of the run.
+ */
+ReportSummary ReportRenderer::run(const QList<ReportStation> &stations, const QVector<QPointF> &mapPoints,
+                                  const QString &directory, Format format)
+{
+    ReportSummary summary;
+    const QDir dir(directory);
+    if (!dir.mkpath(".")) {
+        summary.failed = int(stations.size());
+        return summary;
+    }
+
+    const int total = int(stations.size());
+    std::atomic<int> done{0};
+    const QList<Rendered> results = TaskPool::instance().blockingMapped(stations, [&](const ReportStation &station) {
+        Rendered rendered;
+        if (m_cancelled) {
+            rendered.skipped = true;
+            return rendered;
+        }
+        const QString name = QString("station_%1_%2.%3")
+                                 .arg(station.stationId)
+                                 .arg(QDateTime::fromMSecsSinceEpoch(station.to).toString("yyyyMMdd"),
+                                      format == Pdf ? "pdf" : "png");
+        const QString path = dir.absoluteFilePath(name);
+        if (write(station, mapPoints, path, format)) {
+            rendered.path = path;
+        }
+        emit progress(++done, total);
+        return rendered;
+    }, TaskPool::Normal);
+
+    for (const Rendered &rendered : results) {
+        if (rendered.skipped) {
+            summary.interrupted = true;
+        } else if (rendered.path.isEmpty()) {
+            ++summary.failed;
+        } else {
+            ++summary.written;
+            summary.files.append(rendered.path);
+        }
+    }
+    return summary;
+}
+
+/**
+ * @brief Cancels a running report and waits for it to stop.
+ *
+ * Pages already being painted are finished; the remaining ones are skipped.
+ */
+void ReportRenderer::cancel()
+{
+    m_cancelled = true;
+    m_watcher.waitForFinished();
+}
+
+/**
+ * @brief Renders the page of a station into an image.
+ * @param station Station.
+ * @param mapPoints Longitude and latitude of all known stations.
+ * @return Image of PageWidth x PageHeight pixels.
+ */
+QImage ReportRenderer::renderImage(const ReportStation &station, const QVector<QPointF> &mapPoints)
+{
+    QImage image(PageWidth, PageHeight, QImage::Format_RGB32);
+    QPainter painter(&image);
+    paint(&painter, station, mapPoints);
+    painter.end();
+    return image;
+}
+
+/**
+ * @brief Paints the page of a station.
+ * @param painter Painter with a PageWidth x PageHeight logical area.
+ * @param station Station.
+ * @param mapPoints Longitude and latitude of all known stations.
+ *
+ * The layout follows StationDialog: chart on the left, location on the
+ * right and the statistics of every parameter below.
+ */
+void ReportRenderer::paint(QPainter *painter, const ReportStation &station, const QVector<QPointF> &mapPoints)
+{
+    const qreal margin = 48;
+    const qreal mapWidth = 440;
+
+    painter->save();
+    painter->setRenderHint(QPainter::Antialiasing, true);
+    painter->setRenderHint(QPainter::TextAntialiasing, true);
+    painter->fillRect(QRectF(0, 0, PageWidth, PageHeight), Qt::white);
+
+    // Nagłówek: nazwa, położenie i okres raportu
+    QFont font = painter->font();
+    font.setPixelSize(34);
+    font.setBold(true);
+    painter->setFont(font);
+    painter->setPen(QColor(0x20, 0x20, 0x20));
+    const QString title = station.name.isEmpty() ? QString("Stacja %1").arg(station.stationId) : station.name;
+    painter->drawText(QRectF(margin, margin, PageWidth - 2 * margin, 44), Qt::AlignLeft | Qt::AlignVCenter, title);
+
+    QStringList location;
+    if (!station.city.isEmpty()) {
+        location.append(station.city);
+    }
+    if (!station.address.isEmpty()) {
+        location.append(station.address);
+    }
+    location.append(QString("ID %1").arg(station.stationId));
+    font.setPixelSize(20);
+    font.setBold(false);
+    painter->setFont(font);
+    painter->setPen(QColor(0x60, 0x60, 0x60));
+    const QRectF subtitle(margin, margin + 50, PageWidth - 2 * margin, 28);
+    painter->drawText(subtitle, Qt::AlignLeft | Qt::AlignVCenter, location.join(" · "));
+    painter->drawText(subtitle, Qt::AlignRight | Qt::AlignVCenter,
+                      QString("Okres: %1 – %2").arg(formatTime(station.from), formatTime(station.to)));
+
+    const qreal top = margin + 100;
+    const QRectF chart(margin, top, PageWidth - 3 * margin - mapWidth, 560);
+    const QRectF map(chart.right() + margin, top, mapWidth, chart.height());
+    const QRectF stats(margin, chart.bottom() + 32, PageWidth - 2 * margin, PageHeight - chart.bottom() - 32 - margin - 24);
+    paintChart(painter, chart, station);
+    paintMap(painter, map, station, mapPoints);
+    paintStats(painter, stats, station);
+
+    font.setPixelSize(14);
+    painter->setFont(font);
+    painter->setPen(QColor(0x90, 0x90, 0x90));
+    painter->drawText(QRectF(margin, PageHeight - margin, PageWidth - 2 * margin, 20), Qt::AlignRight | Qt::AlignVCenter,
+                      "Wygenerowano: " + QDateTime::currentDateTime().toString("dd.MM.yyyy HH:mm"));
+    painter->restore();
+}
+
+/**
+ * @brief Parses a format name.
+ * @param name "png" or "pdf", case insensitive.
+ * @param format Parsed format.
+ * @return False if the name is unknown.
+ */
+bool ReportRenderer::parseFormat(const QString &name, Format *format)
+{
+    const QString lower = name.trimmed().toLower();
+    if (lower == "png") {
+        *format = Png;
+    } else if (lower == "pdf") {
+        *format = Pdf;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes the file of one station.
+ * @param station Station.
+ * @param mapPoints Longitude and latitude of all known stations.
+ * @param path Output file.
+ * @param format File format.
+ * @return True on success.
+ */
+bool ReportRenderer::write(const ReportStation &station, const QVector<QPointF> &mapPoints,
+                           const QString &path, Format format)
+{
+    if (format == Png) {
+        return renderImage(station, mapPoints).save(path, "PNG");
+    }
+
+    QPdfWriter writer(path);
+    writer.setPageSize(QPageSize(QPageSize::A4));
+    writer.setPageOrientation(QPageLayout::Landscape);
+    writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+    writer.setResolution(150);
+    writer.setCreator("AirApi");
+    writer.setTitle(station.name);
+    QPainter painter;
+    if (!painter.begin(&writer)) {
+        return false;
+    }
+    // Strona logiczna skalowana do rozdzielczości PDF
+    const qreal scale = std::min(writer.width() / qreal(PageWidth), writer.height() / qreal(PageHeight));
+    painter.scale(scale, scale);
+    paint(&painter, station, mapPoints);
+    return painter.end();
+}
+
+/**
+ * @brief Paints the chart of all series.
+ * @param painter Painter.
+ * @param rect Chart area.
+ * @param station Station.
+ */
+void ReportRenderer::paintChart(QPainter *painter, const QRectF &rect, const ReportStation &station)
+{
+    painter->save();
+    painter->setPen(QColor(0xd0, 0xd0, 0xd0));
+    painter->setBrush(Qt::NoBrush);
+    painter->drawRect(rect);
+
+    QFont font = painter->font();
+    font.setPixelSize(15);
+    painter->setFont(font);
+
+    double low = 0.0;
+    double high = 0.0;
+    bool any = false;
+    for (const ReportSeries &entry : station.series) {
+        for (double value : entry.series.values) {
+            if (std::isfinite(value)) {
+                low = std::min(low, value);
+                high = std::max(high, value);
+                any = true;
+            }
+        }
+    }
+    if (!any) {
+        painter->setPen(QColor(0x80, 0x80, 0x80));
+        painter->drawText(rect, Qt::AlignCenter, "Brak danych w wybranym okresie");
+        painter->restore();
+        return;
+    }
+    high = high > low ? high + (high - low) * 0.1 : low + 1.0;
+
+    const QRectF plot = rect.adjusted(70, 24, -24, -48);
+    const qint64 span = std::max<qint64>(station.to - station.from, 1);
+    auto xOf = [&](qint64 timestamp) { return plot.left() + plot.width() * double(timestamp - station.from) / span; };
+    auto yOf = [&](double value) { return plot.bottom() - plot.height() * (value - low) / (high - low); };
+
+    // Siatka z opisem osi
+    const int rows = 5;
+    const int columns = 6;
+    for (int i = 0; i <= rows; ++i) {
+        const double value = low + (high - low) * i / rows;
+        const qreal y = yOf(value);
+        painter->setPen(QColor(0xe8, 0xe8, 0xe8));
+        painter->drawLine(QPointF(plot.left(), y), QPointF(plot.right(), y));
+        painter->setPen(QColor(0x60, 0x60, 0x60));
+        painter->drawText(QRectF(rect.left(), y - 10, 62, 20), Qt::AlignRight | Qt::AlignVCenter,
+                          QString::number(value, 'f', high - low < 10 ? 1 : 0));
+    }
+    for (int i = 0; i <= columns; ++i) {
+        const qint64 timestamp = station.from + span * i / columns;
+        const qreal x = xOf(timestamp);
+        painter->setPen(QColor(0xe8, 0xe8, 0xe8));
+        painter->drawLine(QPointF(x, plot.top()), QPointF(x, plot.bottom()));
+        painter->setPen(QColor(0x60, 0x60, 0x60));
+        painter->drawText(QRectF(x - 60, plot.bottom() + 8, 120, 20), Qt::AlignCenter,
+                          QDateTime::fromMSecsSinceEpoch(timestamp).toString("dd.MM HH:mm"));
+    }
+
+    // Linie przerwane na brakach danych
+    painter->setClipRect(plot.adjusted(-2, -2, 2, 2));
+    for (int s = 0; s < station.series.size(); ++s) {
+        const Series &series = station.series[s].series;
+        QPainterPath path;
+        bool drawing = false;
+        for (qsizetype i = 0; i < series.size(); ++i) {
+            if (!std::isfinite(series.values[i])) {
+                drawing = false;
+                continue;
+            }
+            const QPointF point(xOf(series.timestamps[i]), yOf(series.values[i]));
+            if (drawing) {
+                path.lineTo(point);
+            } else {
+                path.moveTo(point);
+                drawing = true;
+            }
+        }
+        painter->setPen(QPen(seriesColor(s), 2.5));
+        painter->drawPath(path);
+    }
+    painter->setClipping(false);
+
+    // Legenda w prawym górnym rogu wykresu
+    qreal legendX = plot.right();
+    for (int s = int(station.series.size()) - 1; s >= 0; --s) {
+        const QString label = station.series[s].param;
+        const qreal width = painter->fontMetrics().horizontalAdvance(label) + 26;
+        legendX -= width + 12;
+        painter->fillRect(QRectF(legendX, plot.top() + 4, 16, 16), seriesColor(s));
+        painter->setPen(QColor(0x30, 0x30, 0x30));
+        painter->drawText(QRectF(legendX + 22, plot.top() + 2, width, 20), Qt::AlignLeft | Qt::AlignVCenter, label);
+    }
+    painter->restore();
+}
+
+/**
+ * @brief Paints the statistics table.
+ * @param painter Painter.
+ * @param rect Table area.
+ * @param station Station.
+ */
+void ReportRenderer::paintStats(QPainter *painter, const QRectF &rect, const ReportStation &station)
+{
+    static const QStringList headers{"Parametr", "Ostatnia", "Czas pomiaru", "Min", "Max", "Średnia", "Próbki", "Indeks"};
+    static const double widths[] = {0.12, 0.1, 0.18, 0.09, 0.09, 0.1, 0.09, 0.23};
+    const qreal rowHeight = 34;
+
+    painter->save();
+    QFont font = painter->font();
+    font.setPixelSize(17);
+    font.setBold(true);
+    painter->setFont(font);
+
+    auto drawRow = [&](qreal y, const QStringList &cells) {
+        qreal x = rect.left();
+        for (int c = 0; c < cells.size(); ++c) {
+            const qreal width = rect.width() * widths[c];
+            painter->drawText(QRectF(x + 8, y, width - 16, rowHeight), Qt::AlignLeft | Qt::AlignVCenter, cells[c]);
+            x += width;
+        }
+    };
+
+    painter->fillRect(QRectF(rect.left(), rect.top(), rect.width(), rowHeight), QColor(0xf0, 0xf0, 0xf0));
+    painter->setPen(QColor(0x30, 0x30, 0x30));
+    drawRow(rect.top(), headers);
+
+    font.setBold(false);
+    painter->setFont(font);
+    qreal y = rect.top() + rowHeight;
+    for (int s = 0; s < station.series.size() && y + rowHeight <= rect.bottom(); ++s) {
+        const ReportSeries &entry = station.series[s];
+        const SeriesStats stats = statistics(entry.series);
+        const int level = AirQuality::level(entry.param, stats.last);
+
+        painter->setPen(QColor(0xe0, 0xe0, 0xe0));
+        painter->drawLine(QPointF(rect.left(), y + rowHeight), QPointF(rect.right(), y + rowHeight));
+        painter->fillRect(QRectF(rect.left(), y + 9, 5, rowHeight - 18), seriesColor(s));
+
+        // Kolorowe pole poziomu indeksu w ostatniej kolumnie
+        const qreal indexX = rect.right() - rect.width() * widths[7];
+        painter->fillRect(QRectF(indexX + 8, y + 9, 16, rowHeight - 18), QColor::fromRgb(AirQuality::color(level)));
+
+        painter->setPen(QColor(0x30, 0x30, 0x30));
+        drawRow(y, {entry.param, formatValue(stats.last), stats.count > 0 ? formatTime(stats.lastTimestamp) : QString("–"),
+                    formatValue(stats.min), formatValue(stats.max), formatValue(stats.mean),
+                    QString::number(stats.count), QString()});
+        painter->drawText(QRectF(indexX + 32, y, rect.width() * widths[7] - 40, rowHeight), Qt::AlignLeft | Qt::AlignVCenter,
+                          AirQuality::levelName(level));
+        y += rowHeight;
+    }
+    if (station.series.isEmpty()) {
+        painter->setPen(QColor(0x80, 0x80, 0x80));
+        painter->drawText(QRectF(rect.left(), y, rect.width(), rowHeight), Qt::AlignCenter, "Brak czujników");
+    }
+    painter->restore();
+}
+
+/**
+ * @brief Paints the map snippet.
+ * @param painter Painter.
+ * @param rect Map area.
+ * @param station Station, marked on the map.
+ * @param mapPoints Longitude and latitude of all known stations.
+ *
+ * Map tiles would need the network and a QML scene, so the snippet is a
+ * schematic of the station network in an equirectangular projection with
+ * the longitude scaled by the cosine of the latitude.
+ */
+void ReportRenderer::paintMap(QPainter *painter, const QRectF &rect, const ReportStation &station,
+                              const QVector<QPointF> &mapPoints)
+{
+    // Prostokąt obejmujący Polskę; stacja spoza niego przesuwa środek mapy
+    constexpr double West = 14.0;
+    constexpr double East = 24.2;
+    constexpr double South = 49.0;
+    constexpr double North = 54.9;
+    const bool inside = station.lon >= West && station.lon <= East && station.lat >= South && station.lat <= North;
+    const double centerLon = inside ? (West + East) / 2 : station.lon;
+    const double centerLat = inside ? (South + North) / 2 : station.lat;
+    const double kx = std::cos(centerLat * M_PI / 180.0);
+    const QRectF area = rect.adjusted(16, 44, -16, -40);
+    const double scale = std::min(area.width() / ((East - West) * kx), area.height() / (North - South));
+    auto project = [&](double lon, double lat) {
+        return QPointF(area.center().x() + (lon - centerLon) * kx * scale, area.center().y() - (lat - centerLat) * scale);
+    };
+
+    painter->save();
+    painter->fillRect(rect, QColor(0xee, 0xf3, 0xf7));
+    painter->setPen(QColor(0xd0, 0xd0, 0xd0));
+    painter->setBrush(Qt::NoBrush);
+    painter->drawRect(rect);
+
+    QFont font = painter->font();
+    font.setPixelSize(18);
+    font.setBold(true);
+    painter->setFont(font);
+    painter->setPen(QColor(0x30, 0x30, 0x30));
+    painter->drawText(QRectF(rect.left() + 16, rect.top() + 10, rect.width() - 32, 26), Qt::AlignLeft | Qt::AlignVCenter,
+                      "Lokalizacja");
+
+    painter->setClipRect(area);
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(QColor(0x90, 0xa4, 0xb4));
+    for (const QPointF &point : mapPoints) {
+        painter->drawEllipse(project(point.x(), point.y()), 2.5, 2.5);
+    }
+    const QPointF marker = project(station.lon, station.lat);
+    painter->setPen(QPen(Qt::white, 2));
+    painter->setBrush(QColor(0xd6, 0x27, 0x28));
+    painter->drawEllipse(marker, 8, 8);
+    painter->setClipping(false);
+
+    font.setPixelSize(15);
+    font.setBold(false);
+    painter->setFont(font);
+    painter->setPen(QColor(0x50, 0x50, 0x50));
+    painter->drawText(QRectF(rect.left() + 16, rect.bottom() - 34, rect.width() - 32, 24), Qt::AlignLeft | Qt::AlignVCenter,
+                      QString("%1° N, %2° E").arg(station.lat, 0, 'f', 4).arg(station.lon, 0, 'f', 4));
+    painter->restore();
+}
@@ -0,0 +1,215 @@
+/**
+ * @file reportrenderer.h
+ * @brief Header file for the ReportRenderer class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the offscreen rendering of station reports, with the
+ * chart, statistics and map snippet of each station, into PNG or PDF files.
+ */
+
+#ifndef REPORTRENDERER_H
+#define REPORTRENDERER_H
+
+#include <QFutureWatcher>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include "seriesstore.h"
+
+class QPainter;
+
+/**
+ * @struct ReportSeries
+ * @brief Series of one sensor drawn in a report.
+ */
+struct ReportSeries {
+    QString param;      ///< Parameter code, e.g. "PM10"
+    Series series;      ///< Samples within the report window
+};
+
+/**
+ * @struct ReportStation
+ * @brief Everything drawn on the report page of one station.
+ */
+struct ReportStation {
+    int stationId = 0;              ///< Station ID
+    QString name;                   ///< Station name
+    QString city;                   ///< City name
+    QString address;                ///< Street address
+    double lat = 0.0;               ///< Latitude
+    double lon = 0.0;               ///< Longitude
+    qint64 from = 0;                ///< Window start in ms since epoch
+    qint64 to = 0;                  ///< Window end in ms since epoch
+    QList<ReportSeries> series;     ///< Series of the sensors
+};
+
+/**
+ * @struct ReportSummary
+ * @brief Result of a report run.
+ */
+struct ReportSummary {
+    int written = 0;            ///< Files written
+    int failed = 0;             ///< Stations whose file could not be written
+    QStringList files;          ///< Written files in station order
+    bool interrupted = false;   ///< True if cancelled
+};
+
+/**
+ * @class ReportRenderer
+ * @brief Renders station reports without a window, in parallel.
+ *
+ * Pages are painted with QPainter on a QImage or a QPdfWriter, both of
+ * which work outside the GUI thread, so stations are mapped over the global
+ * thread pool while one coordinating thread collects the results. Nothing
+ * is shown on screen; the command line runs on the offscreen platform.
+ */
+class ReportRenderer : public QObject {
+    Q_OBJECT
+
+public:
+    static constexpr int PageWidth = 1600;      ///< Logical page width
+    static constexpr int PageHeight = 1131;     ///< Logical page height, A4 landscape
+
+    /**
+     * @enum Format
+     * @brief Output file format.
+     */
+    enum Format {
+        Png,    ///< One image per station
+        Pdf     ///< One A4 landscape page per station
+    };
+
+    /**
+     * @brief Constructs an idle renderer.
+     * @param parent Parent QObject.
+     */
+    explicit ReportRenderer(QObject *parent = nullptr);
+
+    /**
+     * @brief Destroys the object, cancelling a running report.
+     */
+    ~ReportRenderer();
+
+    /**
+     * @brief Starts rendering on worker threads.
+     * @param stations Stations, one file each.
+     * @param mapPoints Longitude (x) and latitude (y) of all known stations,
+     *        drawn around the reported one on the map snippet.
+     * @param directory Output directory, created if missing.
+     * @param format File format.
+     */
+    void start(const QList<ReportStation> &stations, const QVector<QPointF> &mapPoints,
+               const QString &directory, Format format);
+
+    /**
+     * @brief Renders on the calling thread, mapping stations over the pool.
+     * @param stations Stations, one file each.
+     * @param mapPoints Longitude and latitude of all known stations.
+     * @param directory Output directory, created if missing.
+     * @param format File format.
+     * @return Summary of the run.
+     */
+    ReportSummary run(const QList<ReportStation> &stations, const QVector<QPointF> &mapPoints,
+                      const QString &directory, Format format);
+
+    /**
+     * @brief Cancels a running report and waits for it to stop.
+     */
+    void cancel();
+
+    /**
+     * @brief Checks whether a report is being rendered.
+     * @return True while running.
+     */
+    bool isRunning() const { return m_watcher.isRunning(); }
+
+    /**
+     * @brief Renders the page of a station into an image.
+     * @param station Station.
+     * @param mapPoints Longitude and latitude of all known stations.
+     * @return Image of PageWidth x PageHeight pixels.
+     */
+    static QImage renderImage(const ReportStation &station, const QVector<QPointF> &mapPoints);
+
+    /**
+     * @brief Paints the page of a station.
+     * @param painter Painter with a PageWidth x PageHeight logical area.
+     * @param station Station.
+     * @param mapPoints Longitude and latitude of all known stations.
+     */
+    static void paint(QPainter *painter, const ReportStation &station, const QVector<QPointF> &mapPoints);
+
+    /**
+     * @brief Parses a format name.
+     * @param name "png" or "pdf", case insensitive.
+     * @param format Parsed format.
+     * @return False if the name is unknown.
+     */
+    static bool parseFormat(const QString &name, Format *format);
+
+signals:
+    /**
+     * @brief Emitted after each station.
+     * @param done Stations rendered so far.
+     * @param total Stations of the run.
+     */
+    void progress(int done, int total);
+
+    /**
+     * @brief Emitted when a started report ends.
+     * @param summary Summary of the run.
+     */
+    void finished(const ReportSummary &summary);
+
+private:
+    /**
+     * @brief Writes the file of one station.
+     * @param station Station.
+     * @param mapPoints Longitude and latitude of all known stations.
+     * @param path Output file.
+     * @param format File format.
+     * @return True on success.
+     */
+    static bool write(const ReportStation &station, const QVector<QPointF> &mapPoints,
+                      const QString &path, Format format);
+
+    /**
+     * @brief Paints the chart of all series.
+     * @param painter Painter.
+     * @param rect Chart area.
+     * @param station Station.
+     */
+    static void paintChart(QPainter *painter, const QRectF &rect, const ReportStation &station);
+
+    /**
+     * @brief Paints the statistics table.
+     * @param painter Painter.
+     * @param rect Table area.
+     * @param station Station.
+     */
+    static void paintStats(QPainter *painter, const QRectF &rect, const ReportStation &station);
+
+    /**
+     * @brief Paints the map snippet.
+     * @param painter Painter.
+     * @param rect Map area.
+     * @param station Station, marked on the map.
+     * @param mapPoints Longitude and latitude of all known stations.
+     */
+    static void paintMap(QPainter *painter, const QRectF &rect, const ReportStation &station,
+                         const QVector<QPointF> &mapPoints);
+
+    QThreadPool m_pool;                         ///< Thread of the running report
+    QFutureWatcher<ReportSummary> m_watcher;    ///< Running report
+    std::atomic_bool m_cancelled{false};        ///< Set by cancel()
+};
+
+#endif // REPORTRENDERER_H
@@ -0,0 +1,215 @@
+/**
+ * @file sensorcatalog.cpp
+ * @brief Implementation of the SensorCatalog class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the implementation of the sensor catalog, its indexes
+ * and JSON persistence.
+ */
+
+#include "sensorcatalog.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+/**
+ * @brief Converts the sensor metadata to a map usable from QML.
+ * @return Map with sensor fields.
+ */
+QVariantMap SensorInfo::toVariantMap() const
+{
+    QVariantMap map;
+    map["sensorId"] = sensorId;
+    map["stationId"] = stationId;
+    map["paramId"] = paramId;
+    map["paramCode"] = paramCode;
+    map["paramFormula"] = paramFormula;
+    map["paramName"] = paramName;
+    return map;
+}
+
+/**
+ * @brief Normalizes a parameter code or formula to an index key.
+ * @param param Parameter code or formula.
+ * @return Normalized key.
+ *
+ * Keys are upper case without whitespace, so "pm2.5" and "PM2.5" match.
+ */
+QString SensorCatalog::paramKey(const QString &param)
+{
+    QString key = param.toUpper();
+    key.remove(QLatin1Char(' '));
+    return key;
+}
+
+/**
+ * @brief Replaces all sensors of a station with a fresh list.
+ * @param stationId Station ID.
+ * @param sensors Sensors currently reported for the station.
+ */
+void SensorCatalog::replaceStation(int stationId, const QList<SensorInfo> &sensors)
+{
+    const QList<int> previous = m_byStation.value(stationId);
+    for (int sensorId : previous) {
+        remove(sensorId);
+    }
+    // Pusta lista też oznacza, że stacja została już sprawdzona
+    m_byStation.insert(stationId, {});
+    for (const SensorInfo &info : sensors) {
+        insert(info);
+    }
+}
+
+/**
+ * @brief Inserts or updates a single sensor.
+ * @param info Sensor metadata.
+ */
+void SensorCatalog::insert(const SensorInfo &info)
+{
+    if (m_sensors.contains(info.sensorId)) {
+        remove(info.sensorId);
+    }
+    m_sensors.insert(info.sensorId, info);
+    m_byStation[info.stationId].append(info.sensorId);
+
+    const QString codeKey = paramKey(info.paramCode);
+    const QString formulaKey = paramKey(info.paramFormula);
+    if (!codeKey.isEmpty()) {
+        m_byParam[codeKey].append(info.sensorId);
+    }
+    if (!formulaKey.isEmpty() && formulaKey != codeKey) {
+        m_byParam[formulaKey].append(info.sensorId);
+    }
+}
+
+/**
+ * @brief Removes a sensor from all indexes.
+ * @param sensorId Sensor ID.
+ */
+void SensorCatalog::remove(int sensorId)
+{
+    auto it = m_sensors.find(sensorId);
+    if (it == m_sensors.end()) {
+        return;
+    }
+
+    const SensorInfo info = it.value();
+    m_sensors.erase(it);
+
+    auto stationIt = m_byStation.find(info.stationId);
+    if (stationIt != m_byStation.end()) {
+        stationIt->removeAll(sensorId);
+    }
+
+    for (const QString &key : {paramKey(info.paramCode), paramKey(info.paramFormula)}) {
+        auto paramIt = m_byParam.find(key);
+        if (paramIt == m_byParam.end()) {
+            continue;
+        }
+        paramIt->removeAll(sensorId);
+        if (paramIt->isEmpty()) {
+            m_byParam.erase(paramIt);
+        }
+    }
+}
+
+/**
+ * @brief Gets all indexed parameter codes.
+ * @return Sorted list of parameter keys.
+ */
+QStringList SensorCatalog::paramCodes() const
+{
+    QStringList codes = m_byParam.keys();
+    codes.sort();
+    return codes;
+}
+
+/**
+ * @brief Removes all sensors.
+ */
+void SensorCatalog::clear()
+{
+    m_sensors.clear();
+    m_byParam.clear();
+    m_byStation.clear();
+}
+
+/**
+ * @brief Loads the catalog from a JSON file.
+ * @param path File path.
+ * @return True on success.
+ *
+ * The file stores the list of discovered stations and a flat list of sensors.
+ */
+bool SensorCatalog::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+
+    clear();
+    QJsonObject root = doc.object();
+    for (const QJsonValue &value : root["stations"].toArray()) {
+        m_byStation.insert(value.toInt(), {});
+    }
+    for (const QJsonValue &value : root["sensors"].toArray()) {
+        QJsonObject obj = value.toObject();
+        SensorInfo info;
+        info.sensorId = obj["sensorId"].toInt();
+        info.stationId = obj["stationId"].toInt();
+        info.paramId = obj["paramId"].toInt();
+        info.paramCode = obj["paramCode"].toString();
+        info.paramFormula = obj["paramFormula"].toString();
+        info.paramName = obj["paramName"].toString();
+        insert(info);
+    }
+    return true;
+}
+
+/**
+ * @brief Saves the catalog to a JSON file.
+ * @param path File path.
+ * @return True on success.
+ *
+ * The file is written atomically, so an interrupted save keeps the old catalog.
+ */
+bool SensorCatalog::save(const QString &path) const
+{
+    QJsonArray stations;
+    for (auto it = m_byStation.cbegin(); it != m_byStation.cend(); ++it) {
+        stations.append(it.key());
+    }
+
+    QJsonArray sensors;
+    for (const SensorInfo &info : m_sensors) {
+        QJsonObject obj;
+        obj["sensorId"] = info.sensorId;
+        obj["stationId"] = info.stationId;
+        obj["paramId"] = info.paramId;
+        obj["paramCode"] = info.paramCode;
+        obj["paramFormula"] = info.paramFormula;
+        obj["paramName"] = info.paramName;
+        sensors.append(obj);
+    }
+
+    QJsonObject root;
+    root["stations"] = stations;
+    root["sensors"] = sensors;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
@@ -0,0 +1,154 @@
+/**
+ * @file sensorcatalog.h
+ * @brief Header file for the SensorCatalog class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the nationwide sensor catalog: every known sensor with its
+ * station and measured parameter, indexed by parameter code.
+ */
+
+#ifndef SENSORCATALOG_H
+#define SENSORCATALOG_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+/**
+ * @struct SensorInfo
+ * @brief Metadata of a single sensor as reported by the station sensors endpoint.
+ */
+struct SensorInfo {
+    int sensorId = 0;           ///< Sensor ID
+    int stationId = 0;          ///< ID of the station the sensor belongs to
+    int paramId = 0;            ///< GIOŚ parameter ID
+    QString paramCode;          ///< Parameter code, e.g. "PM2.5"
+    QString paramFormula;       ///< Parameter formula, e.g. "PM2.5"
+    QString paramName;          ///< Human readable parameter name
+
+    /**
+     * @brief Converts the sensor metadata to a map usable from QML.
+     * @return Map with sensor fields.
+     */
+    QVariantMap toVariantMap() const;
+};
+
+/**
+ * @class SensorCatalog
+ * @brief Global catalog of sensors with a parameter → sensors index.
+ *
+ * The catalog is filled from sensors replies and persisted to a JSON file, so
+ * queries such as "all PM2.5 sensors" do not need per-station discovery.
+ */
+class SensorCatalog {
+public:
+    /**
+     * @brief Normalizes a parameter code or formula to an index key.
+     * @param param Parameter code or formula.
+     * @return Normalized key.
+     */
+    static QString paramKey(const QString &param);
+
+    /**
+     * @brief Replaces all sensors of a station with a fresh list.
+     * @param stationId Station ID.
+     * @param sensors Sensors currently reported for the station.
+     *
+     * Sensors that are no longer reported are removed from the indexes.
+     */
+    void replaceStation(int stationId, const QList<SensorInfo> &sensors);
+
+    /**
+     * @brief Inserts or updates a single sensor.
+     * @param info Sensor metadata.
+     */
+    void insert(const SensorInfo &info);
+
+    /**
+     * @brief Checks whether a sensor is known.
+     * @param sensorId Sensor ID.
+     * @return True if the sensor is in the catalog.
+     */
+    bool contains(int sensorId) const { return m_sensors.contains(sensorId); }
+
+    /**
+     * @brief Checks whether the sensors of a station were already discovered.
+     * @param stationId Station ID.
+     * @return True if the station is in the catalog.
+     */
+    bool hasStation(int stationId) const { return m_byStation.contains(stationId); }
+
+    /**
+     * @brief Gets metadata of a sensor.
+     * @param sensorId Sensor ID.
+     * @return Sensor metadata, default constructed if unknown.
+     */
+    SensorInfo sensor(int sensorId) const { return m_sensors.value(sensorId); }
+
+    /**
+     * @brief Gets all sensors measuring a parameter.
+     * @param param Parameter code or formula, case insensitive.
+     * @return List of sensor IDs.
+     */
+    QList<int> sensorsForParam(const QString &param) const { return m_byParam.value(paramKey(param)); }
+
+    /**
+     * @brief Gets all sensors of a station.
+     * @param stationId Station ID.
+     * @return List of sensor IDs.
+     */
+    QList<int> sensorsForStation(int stationId) const { return m_byStation.value(stationId); }
+
+    /**
+     * @brief Gets all indexed parameter codes.
+     * @return Sorted list of parameter keys.
+     */
+    QStringList paramCodes() const;
+
+    /**
+     * @brief Gets the number of sensors in the catalog.
+     * @return Sensor count.
+     */
+    int count() const { return m_sensors.size(); }
+
+    /**
+     * @brief Gets the number of stations in the catalog.
+     * @return Station count.
+     */
+    int stationCount() const { return m_byStation.size(); }
+
+    /**
+     * @brief Removes all sensors.
+     */
+    void clear();
+
+    /**
+     * @brief Loads the catalog from a JSON file.
+     * @param path File path.
+     * @return True on success.
+     */
+    bool load(const QString &path);
+
+    /**
+     * @brief Saves the catalog to a JSON file.
+     * @param path File path.
+     * @return True on success.
+     */
+    bool save(const QString &path) const;
+
+private:
+    /**
+     * @brief Removes a sensor from all indexes.
+     * @param sensorId Sensor ID.
+     */
+    void remove(int sensorId);
+
+    QHash<int, SensorInfo> m_sensors;           ///< Sensors by ID
+    QHash<QString, QList<int>> m_byParam;       ///< Sensor IDs by parameter key
+    QHash<int, QList<int>> m_byStation;         ///< Sensor IDs by station ID
+};
+
+#endif // SENSORCATALOG_H
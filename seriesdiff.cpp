@@ -0,0 +1,99 @@
+/**
+ * @file seriesdiff.cpp
+ * @brief Implementation of the SeriesDiff structure.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the linear merge of an archived and a live series.
+ */
+
+#include "seriesdiff.h"
+#include <QVariantMap>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Compares an archived series with the live one.
+ * @param archived Series as saved, sorted by timestamp.
+ * @param live Current series, sorted by timestamp.
+ * @param tolerance Largest absolute difference still counted as equal.
+ * @return Differences within the time range covered by both series.
+ *
+ * Both timestamp columns are walked once in step, so the comparison takes
+ * linear time. Samples outside the common range are not revisions: they are
+ * either newer than the snapshot or older than the live window.
+ */
+SeriesDiff SeriesDiff::compute(const Series &archived, const Series &live, double tolerance)
+{
+    SeriesDiff diff;
+    if (archived.isEmpty() || live.isEmpty()) {
+        return diff;
+    }
+    const qint64 from = std::max(archived.timestamps.first(), live.timestamps.first());
+    const qint64 to = std::min(archived.timestamps.last(), live.timestamps.last());
+    if (from > to) {
+        return diff;
+    }
+
+    qsizetype i = std::lower_bound(archived.timestamps.cbegin(), archived.timestamps.cend(), from) - archived.timestamps.cbegin();
+    qsizetype j = std::lower_bound(live.timestamps.cbegin(), live.timestamps.cend(), from) - live.timestamps.cbegin();
+    const qsizetype iEnd = std::upper_bound(archived.timestamps.cbegin(), archived.timestamps.cend(), to) - archived.timestamps.cbegin();
+    const qsizetype jEnd = std::upper_bound(live.timestamps.cbegin(), live.timestamps.cend(), to) - live.timestamps.cbegin();
+
+    const double nan = std::nan("");
+    const auto record = [&diff](qint64 t, double before, double after, Kind kind) {
+        diff.timestamps.append(t);
+        diff.archived.append(before);
+        diff.live.append(after);
+        diff.kinds.append(kind);
+    };
+
+    while (i < iEnd || j < jEnd) {
+        const qint64 ta = i < iEnd ? archived.timestamps[i] : std::numeric_limits<qint64>::max();
+        const qint64 tl = j < jEnd ? live.timestamps[j] : std::numeric_limits<qint64>::max();
+        const qint64 t = std::min(ta, tl);
+        const double before = ta == t ? archived.values[i++] : nan;
+        const double after = tl == t ? live.values[j++] : nan;
+
+        // Brak wartości po obu stronach nie jest różnicą
+        if (std::isnan(before) && std::isnan(after)) {
+            continue;
+        }
+        if (std::isnan(before)) {
+            record(t, before, after, Added);
+            ++diff.added;
+        } else if (std::isnan(after)) {
+            record(t, before, after, Removed);
+            ++diff.removed;
+        } else if (std::abs(before - after) > tolerance) {
+            record(t, before, after, Changed);
+            ++diff.changed;
+        } else {
+            ++diff.unchanged;
+        }
+    }
+    return diff;
+}
+
+/**
+ * @brief Converts the differences to the format used in QML.
+ * @return List of maps with "date", "archived", "live" and "kind"
+ *         ("changed", "added" or "removed"), newest first like the API;
+ *         missing values are null.
+ */
+QVariantList SeriesDiff::toVariantList() const
+{
+    static const char *const kindNames[] = {"changed", "added", "removed"};
+    QVariantList list;
+    list.reserve(size());
+    for (qsizetype i = size() - 1; i >= 0; --i) {
+        QVariantMap sample;
+        sample["date"] = SeriesStore::formatDate(timestamps[i]);
+        sample["archived"] = std::isnan(archived[i]) ? QVariant() : QVariant(archived[i]);
+        sample["live"] = std::isnan(live[i]) ? QVariant() : QVariant(live[i]);
+        sample["kind"] = QString::fromLatin1(kindNames[kinds[i]]);
+        list.append(sample);
+    }
+    return list;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file seriesdiff.h
+ * @brief Header file for the SeriesDiff structure.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the comparison of an archived snapshot of a series with
+ * its current, possibly revised, version.
+ */
+
+#ifndef SERIESDIFF_H
+#define SERIESDIFF_H
+
+#include <QVariantList>
+#include <QVector>
+#include "seriesstore.h"
+
+/**
+ * @struct SeriesDiff
+ * @brief Samples that differ between an archived and a live series.
+ *
+ * Only differing samples are kept, in ascending time order. A missing value
+ * on one side is NaN.
+ */
+struct SeriesDiff {
+    /**
+     * @brief Kind of a difference.
+     */
+    enum Kind : quint8 {
+        Changed,    ///< Both series have the sample with different values
+        Added,      ///< Only the live series has a value
+        Removed     ///< Only the archived series has a value
+    };
+
+    QVector<qint64> timestamps; ///< Timestamps of the differing samples
+    QVector<double> archived;   ///< Archived values, NaN for added samples
+    QVector<double> live;       ///< Live values, NaN for removed samples
+    QVector<Kind> kinds;        ///< Kind of each difference
+    int changed = 0;            ///< Number of changed samples
+    int added = 0;              ///< Number of added samples
+    int removed = 0;            ///< Number of removed samples
+    int unchanged = 0;          ///< Number of compared equal samples
+
+    /**
+     * @brief Gets the number of differing samples.
+     * @return Sample count.
+     */
+    qsizetype size() const { return timestamps.size(); }
+
+    /**
+     * @brief Compares an archived series with the live one.
+     * @param archived Series as saved, sorted by timestamp.
+     * @param live Current series, sorted by timestamp.
+     * @param tolerance Largest absolute difference still counted as equal.
+     * @return Differences within the time range covered by both series.
+     */
+    static SeriesDiff compute(const Series &archived, const Series &live, double tolerance = 1e-9);
+
+    /**
+     * @brief Converts the differences to the format used in QML.
+     * @return List of maps with "date", "archived", "live" and "kind"
+     *         ("changed", "added" or "removed"), newest first like the API;
+     *         missing values are null.
+     */
+    QVariantList toVariantList() const;
+};
+
+#endif // SERIESDIFF_H
@@ -0,0 +1,288 @@
+/**
+ * @file seriesstore.cpp
+ * @brief Implementation of the SeriesStore class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the implementation of the series store, the sorted merge
+ * of new samples and the time-join of several series.
+ */
+
+#include "seriesstore.h"
+#include <QDateTime>
+#include <QVariantMap>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @brief Merges samples into the series of a sensor.
+ * @param sensorId Sensor ID.
+ * @param incoming Samples to merge, sorted by timestamp.
+ * @return New version of the sensor series.
+ *
+ * Both series are sorted, so the merge is a single linear pass. Samples
+ * newer than the whole stored series are appended in place, which is the
+ * common case of live data.
+ */
+quint64 SeriesStore::merge(int sensorId, const Series &incoming)
+{
+    Series &stored = m_series[sensorId];
+    m_sampleCount -= stored.size();
+
+    if (stored.isEmpty()) {
+        stored = incoming;
+    } else if (!incoming.isEmpty() && stored.timestamps.last() < incoming.timestamps.first()) {
+        stored.timestamps.append(incoming.timestamps);
+        stored.values.append(incoming.values);
+    } else if (!incoming.isEmpty()) {
+        Series merged;
+        merged.timestamps.reserve(stored.size() + incoming.size());
+        merged.values.reserve(stored.size() + incoming.size());
+
+        qsizetype i = 0;
+        qsizetype j = 0;
+        while (i < stored.size() || j < incoming.size()) {
+            if (j >= incoming.size() || (i < stored.size() && stored.timestamps[i] < incoming.timestamps[j])) {
+                merged.timestamps.append(stored.timestamps[i]);
+                merged.values.append(stored.values[i]);
+                ++i;
+            } else {
+                // Nowa próbka zastępuje zapisaną o tym samym czasie
+                if (i < stored.size() && stored.timestamps[i] == incoming.timestamps[j]) {
+                    ++i;
+                }
+                merged.timestamps.append(incoming.timestamps[j]);
+                merged.values.append(incoming.values[j]);
+                ++j;
+            }
+        }
+        stored = std::move(merged);
+    }
+
+    m_sampleCount += stored.size();
+    const quint64 version = m_nextVersion++;
+    m_versions[sensorId] = version;
+    return version;
+}
+
+/**
+ * @brief Gets the series of a sensor.
+ * @param sensorId Sensor ID.
+ * @return Pointer to the series, or nullptr if unknown.
+ */
+const Series *SeriesStore::find(int sensorId) const
+{
+    auto it = m_series.constFind(sensorId);
+    return it == m_series.cend() ? nullptr : &it.value();
+}
+
+/**
+ * @brief Removes the series of a sensor.
+ * @param sensorId Sensor ID.
+ */
+void SeriesStore::remove(int sensorId)
+{
+    auto it = m_series.find(sensorId);
+    if (it == m_series.end()) {
+        return;
+    }
+    m_sampleCount -= it->size();
+    m_series.erase(it);
+    m_versions.remove(sensorId);
+}
+
+/**
+ * @brief Gets the memory held by the series.
+ * @return Bytes and number of series.
+ */
+MemoryAccounting::Usage SeriesStore::memoryUsage() const
+{
+    MemoryAccounting::Usage usage;
+    usage.objects = m_series.size();
+    usage.bytes = MemoryAccounting::bytes(m_series) + MemoryAccounting::bytes(m_versions);
+    for (const Series &series : m_series) {
+        usage.bytes += MemoryAccounting::bytes(series.timestamps) + MemoryAccounting::bytes(series.values);
+    }
+    return usage;
+}
+
+/**
+ * @brief Aligns several series on a common time axis.
+ * @param inputs Input series, may contain nullptr for missing inputs.
+ * @param mode Join mode.
+ * @return Aligned series with one column per input.
+ *
+ * The common axis is built once; each column is then filled with a linear
+ * walk over its input.
+ */
+AlignedSeries SeriesStore::timeJoin(const QList<const Series *> &inputs, JoinMode mode)
+{
+    AlignedSeries result;
+
+    qsizetype total = 0;
+    for (const Series *series : inputs) {
+        if (series) {
+            total += series->size();
+        } else if (mode == InnerJoin) {
+            result.columns.resize(inputs.size());
+            return result;
+        }
+    }
+
+    QVector<qint64> &axis = result.timestamps;
+    axis.reserve(total);
+    for (const Series *series : inputs) {
+        if (series) {
+            axis.append(series->timestamps);
+        }
+    }
+    std::sort(axis.begin(), axis.end());
+    axis.erase(std::unique(axis.begin(), axis.end()), axis.end());
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const qsizetype n = axis.size();
+    result.columns.resize(inputs.size());
+    QVector<int> present(n, 0);
+
+    for (qsizetype c = 0; c < inputs.size(); ++c) {
+        QVector<double> &column = result.columns[c];
+        column.fill(nan, n);
+        const Series *series = inputs[c];
+        if (!series) {
+            continue;
+        }
+        qsizetype j = 0;
+        for (qsizetype i = 0; i < series->size(); ++i) {
+            const qint64 t = series->timestamps[i];
+            while (axis[j] < t) {
+                ++j;
+            }
+            column[j] = series->values[i];
+            ++present[j];
+        }
+    }
+
+    if (mode == InnerJoin) {
+        const int required = int(inputs.size());
+        qsizetype out = 0;
+        for (qsizetype i = 0; i < n; ++i) {
+            if (present[i] != required) {
+                continue;
+            }
+            axis[out] = axis[i];
+            for (QVector<double> &column : result.columns) {
+                column[out] = column[i];
+            }
+            ++out;
+        }
+        axis.resize(out);
+        for (QVector<double> &column : result.columns) {
+            column.resize(out);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Cuts a time window out of a series.
+ * @param series Source series.
+ * @param from Window start in ms since epoch, inclusive.
+ * @param to Window end in ms since epoch, inclusive.
+ * @return Samples within the window.
+ *
+ * The window bounds are found by binary search over the sorted timestamps.
+ */
+Series SeriesStore::slice(const Series &series, qint64 from, qint64 to)
+{
+    const auto begin = std::lower_bound(series.timestamps.cbegin(), series.timestamps.cend(), from);
+    const auto end = std::upper_bound(begin, series.timestamps.cend(), to);
+    const qsizetype first = begin - series.timestamps.cbegin();
+    const qsizetype count = end - begin;
+
+    Series window;
+    window.timestamps = series.timestamps.mid(first, count);
+    window.values = series.values.mid(first, count);
+    return window;
+}
+
+/**
+ * @brief Converts API measurements to a series.
+ * @param points List of maps with "date" and "value" keys, in any order.
+ * @return Sorted series.
+ */
+Series SeriesStore::fromVariantList(const QVariantList &points)
+{
+    QVector<QPair<qint64, double>> samples;
+    samples.reserve(points.size());
+    for (const QVariant &point : points) {
+        const QVariantMap map = point.toMap();
+        const qint64 t = parseDate(map["date"].toString());
+        if (t < 0) {
+            continue;
+        }
+        const QVariant value = map["value"];
+        bool ok = false;
+        const double v = value.isNull() ? 0.0 : value.toDouble(&ok);
+        samples.append({t, ok ? v : std::numeric_limits<double>::quiet_NaN()});
+    }
+
+    // API zwraca pomiary od najnowszego
+    std::stable_sort(samples.begin(), samples.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+
+    Series series;
+    series.timestamps.reserve(samples.size());
+    series.values.reserve(samples.size());
+    for (const auto &sample : samples) {
+        if (!series.timestamps.isEmpty() && series.timestamps.last() == sample.first) {
+            series.values.last() = sample.second;
+            continue;
+        }
+        series.timestamps.append(sample.first);
+        series.values.append(sample.second);
+    }
+    return series;
+}
+
+/**
+ * @brief Converts a series to the measurement list format used in QML.
+ * @param series Series to convert.
+ * @return List of maps with "date" and "value", newest first like the API.
+ */
+QVariantList SeriesStore::toVariantList(const Series &series)
+{
+    QVariantList list;
+    list.reserve(series.size());
+    for (qsizetype i = series.size() - 1; i >= 0; --i) {
+        QVariantMap data;
+        data["date"] = formatDate(series.timestamps[i]);
+        const double v = series.values[i];
+        data["value"] = std::isnan(v) ? QVariant::fromValue(nullptr) : QVariant(v);
+        list.append(data);
+    }
+    return list;
+}
+
+/**
+ * @brief Parses an API date string.
+ * @param date Date in "yyyy-MM-dd HH:mm:ss" format.
+ * @return Milliseconds since epoch, or -1 if invalid.
+ */
+qint64 SeriesStore::parseDate(const QString &date)
+{
+    const QDateTime dateTime = QDateTime::fromString(date, "yyyy-MM-dd HH:mm:ss");
+    return dateTime.isValid() ? dateTime.toMSecsSinceEpoch() : -1;
+}
+
+/**
+ * @brief Formats a timestamp like the API does.
+ * @param timestamp Milliseconds since epoch.
+ * @return Date in "yyyy-MM-dd HH:mm:ss" format.
+ */
+QString SeriesStore::formatDate(qint64 timestamp)
+{
+    return QDateTime::fromMSecsSinceEpoch(timestamp).toString("yyyy-MM-dd HH:mm:ss");
+}
@@ -0,0 +1,178 @@
+/**
+ * @file seriesstore.h
+ * @brief Header file for the Series structure and the SeriesStore class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the columnar per-sensor series store and the time-join
+ * used to align several series on a common time axis.
+ */
+
+#ifndef SERIESSTORE_H
+#define SERIESSTORE_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+#include <QString>
+#include <QVariantList>
+#include "memoryaccounting.h"
+
+/**
+ * @struct Series
+ * @brief Columnar time series: sorted timestamps and matching values.
+ *
+ * Timestamps are milliseconds since epoch in ascending order. Missing
+ * measurements are stored as NaN.
+ */
+struct Series {
+    QVector<qint64> timestamps; ///< Timestamps in ms since epoch, ascending
+    QVector<double> values;     ///< Values, NaN for missing measurements
+
+    /**
+     * @brief Gets the number of samples.
+     * @return Sample count.
+     */
+    qsizetype size() const { return timestamps.size(); }
+
+    /**
+     * @brief Checks whether the series has no samples.
+     * @return True if empty.
+     */
+    bool isEmpty() const { return timestamps.isEmpty(); }
+};
+
+/**
+ * @struct AlignedSeries
+ * @brief Several series joined on a common time axis.
+ */
+struct AlignedSeries {
+    QVector<qint64> timestamps;         ///< Common timestamps, ascending
+    QVector<QVector<double>> columns;   ///< One column per input series
+};
+
+/**
+ * @class SeriesStore
+ * @brief In-memory store of sensor series with per-sensor versions.
+ *
+ * Every merge bumps the version of the sensor, so derived results can be
+ * cached against the versions of their inputs.
+ */
+class SeriesStore {
+public:
+    /**
+     * @brief Join mode for timeJoin().
+     */
+    enum JoinMode {
+        OuterJoin,  ///< Union of timestamps, NaN where an input has no sample
+        InnerJoin   ///< Only timestamps present in every input
+    };
+
+    /**
+     * @brief Merges samples into the series of a sensor.
+     * @param sensorId Sensor ID.
+     * @param incoming Samples to merge, sorted by timestamp.
+     * @return New version of the sensor series.
+     *
+     * Samples with an existing timestamp replace the stored value.
+     */
+    quint64 merge(int sensorId, const Series &incoming);
+
+    /**
+     * @brief Checks whether the store has a series for a sensor.
+     * @param sensorId Sensor ID.
+     * @return True if present.
+     */
+    bool contains(int sensorId) const { return m_series.contains(sensorId); }
+
+    /**
+     * @brief Gets the series of a sensor.
+     * @param sensorId Sensor ID.
+     * @return Pointer to the series, or nullptr if unknown.
+     */
+    const Series *find(int sensorId) const;
+
+    /**
+     * @brief Gets the version of a sensor series.
+     * @param sensorId Sensor ID.
+     * @return Version, 0 if the sensor is unknown.
+     */
+    quint64 version(int sensorId) const { return m_versions.value(sensorId); }
+
+    /**
+     * @brief Removes the series of a sensor.
+     * @param sensorId Sensor ID.
+     */
+    void remove(int sensorId);
+
+    /**
+     * @brief Gets the IDs of all stored sensors.
+     * @return List of sensor IDs.
+     */
+    QList<int> sensorIds() const { return m_series.keys(); }
+
+    /**
+     * @brief Gets the total number of stored samples.
+     * @return Sample count.
+     */
+    qsizetype sampleCount() const { return m_sampleCount; }
+
+    /**
+     * @brief Gets the memory held by the series.
+     * @return Bytes and number of series.
+     */
+    MemoryAccounting::Usage memoryUsage() const;
+
+    /**
+     * @brief Aligns several series on a common time axis.
+     * @param inputs Input series, may contain nullptr for missing inputs.
+     * @param mode Join mode.
+     * @return Aligned series with one column per input.
+     */
+    static AlignedSeries timeJoin(const QList<const Series *> &inputs, JoinMode mode = OuterJoin);
+
+    /**
+     * @brief Cuts a time window out of a series.
+     * @param series Source series.
+     * @param from Window start in ms since epoch, inclusive.
+     * @param to Window end in ms since epoch, inclusive.
+     * @return Samples within the window.
+     */
+    static Series slice(const Series &series, qint64 from, qint64 to);
+
+    /**
+     * @brief Converts API measurements to a series.
+     * @param points List of maps with "date" and "value" keys, in any order.
+     * @return Sorted series.
+     */
+    static Series fromVariantList(const QVariantList &points);
+
+    /**
+     * @brief Converts a series to the measurement list format used in QML.
+     * @param series Series to convert.
+     * @return List of maps with "date" and "value", newest first like the API.
+     */
+    static QVariantList toVariantList(const Series &series);
+
+    /**
+     * @brief Parses an API date string.
+     * @param date Date in "yyyy-MM-dd HH:mm:ss" format.
+     * @return Milliseconds since epoch, or -1 if invalid.
+     */
+    static qint64 parseDate(const QString &date);
+
+    /**
+     * @brief Formats a timestamp like the API does.
+     * @param timestamp Milliseconds since epoch.
+     * @return Date in "yyyy-MM-dd HH:mm:ss" format.
+     */
+    static QString formatDate(qint64 timestamp);
+
+private:
+    QHash<int, Series> m_series;        ///< Series by sensor ID
+    QHash<int, quint64> m_versions;     ///< Series versions by sensor ID
+    quint64 m_nextVersion = 1;          ///< Next version number
+    qsizetype m_sampleCount = 0;        ///< Total stored samples
+};
+
+#endif // SERIESSTORE_H
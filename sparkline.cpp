@@ -0,0 +1,205 @@
+/**
+ * @file sparkline.cpp
+ * @brief Implementation of the SparklineCache class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the min–max downsampling and the version-checked cache
+ * of the station sparklines.
+ */
+
+#include "sparkline.h"
+#include "metrics.h"
+#include <QDateTime>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Constructs an empty cache.
+ * @param store Series store the sparklines are computed from.
+ * @param parent Parent QObject.
+ */
+SparklineCache::SparklineCache(const SeriesStore *store, QObject *parent)
+    : QObject(parent),
+    m_store(store)
+{
+}
+
+/**
+ * @brief Selects the parameter drawn.
+ * @param param Parameter key, empty to draw nothing.
+ * @param sensorByStation Sensor of the parameter at each station.
+ */
+void SparklineCache::setParam(const QString &param, const QHash<int, int> &sensorByStation)
+{
+    m_sensorByStation = sensorByStation;
+    m_stationBySensor.clear();
+    for (auto it = sensorByStation.cbegin(); it != sensorByStation.cend(); ++it) {
+        m_stationBySensor.insert(it.value(), it.key());
+    }
+    m_entries.clear();
+    if (param != m_param) {
+        m_param = param;
+        emit paramChanged();
+    }
+    emit changed();
+}
+
+/**
+ * @brief Sets the end of the drawn window.
+ * @param endTime End in ms since epoch, -1 for the current time.
+ */
+void SparklineCache::setWindowEnd(qint64 endTime)
+{
+    if (endTime == m_windowEnd) {
+        return;
+    }
+    m_windowEnd = endTime;
+    emit changed();
+}
+
+/**
+ * @brief Reports that the series of a sensor changed.
+ * @param sensorId Sensor ID.
+ *
+ * The cached sparkline is recomputed on its next draw, so a sensor of an
+ * off-screen row costs nothing.
+ */
+void SparklineCache::sensorUpdated(int sensorId)
+{
+    if (m_stationBySensor.contains(sensorId)) {
+        emit changed();
+    }
+}
+
+/**
+ * @brief Gets the sparkline of a station.
+ * @param stationId Station ID.
+ * @param buckets Horizontal resolution, usually the width in pixels.
+ * @return Points with x and y in [0, 1], y growing upwards; empty if the
+ *         station has no data in the window.
+ */
+const QVector<QPointF> &SparklineCache::points(int stationId, int buckets)
+{
+    static const QVector<QPointF> none;
+    const auto sensor = m_sensorByStation.constFind(stationId);
+    if (sensor == m_sensorByStation.cend() || buckets <= 0) {
+        return none;
+    }
+    const Series *series = m_store->find(sensor.value());
+    if (!series) {
+        return none;
+    }
+
+    // Bieżący czas zaokrąglony do pełnej godziny, aby wpisy nie starzały się co klatkę
+    qint64 end = m_windowEnd;
+    if (end < 0) {
+        end = (QDateTime::currentMSecsSinceEpoch() / HourMs + 1) * HourMs;
+    }
+    const quint64 version = m_store->version(sensor.value());
+
+    static Counter *hits = Metrics::instance().counter("airapi_cache_hits_total", "Lookups answered from a cache.",
+                                                       "cache=\"sparkline\"");
+    static Counter *misses = Metrics::instance().counter("airapi_cache_misses_total", "Lookups a cache could not answer.",
+                                                         "cache=\"sparkline\"");
+    Entry &entry = m_entries[stationId];
+    if (entry.version != version || entry.windowEnd != end || entry.buckets != buckets) {
+        misses->add();
+        entry.version = version;
+        entry.windowEnd = end;
+        entry.buckets = buckets;
+        entry.points = downsample(*series, end - Hours * HourMs, end, buckets);
+        ++m_computeCount;
+    } else {
+        hits->add();
+    }
+    return entry.points;
+}
+
+/**
+ * @brief Gets the memory held by the cached sparklines.
+ * @return Bytes and number of cached sparklines.
+ */
+MemoryAccounting::Usage SparklineCache::memoryUsage() const
+{
+    MemoryAccounting::Usage usage;
+    usage.objects = m_entries.size();
+    usage.bytes = MemoryAccounting::bytes(m_entries) + MemoryAccounting::bytes(m_sensorByStation)
+                  + MemoryAccounting::bytes(m_stationBySensor);
+    for (const Entry &entry : m_entries) {
+        usage.bytes += MemoryAccounting::bytes(entry.points);
+    }
+    return usage;
+}
+
+/**
+ * @brief Downsamples a series window to normalized points.
+ * @param series Source series.
+ * @param from Window start in ms since epoch.
+ * @param to Window end in ms since epoch.
+ * @param buckets Number of time buckets; each keeps its minimum and
+ *                maximum in time order.
+ * @return Points with x and y in [0, 1], y growing upwards.
+ */
+QVector<QPointF> SparklineCache::downsample(const Series &series, qint64 from, qint64 to, int buckets)
+{
+    QVector<QPointF> points;
+    if (to <= from || buckets <= 0) {
+        return points;
+    }
+    const auto first = std::lower_bound(series.timestamps.cbegin(), series.timestamps.cend(), from);
+    const auto last = std::upper_bound(first, series.timestamps.cend(), to);
+    const qsizetype begin = first - series.timestamps.cbegin();
+    const qsizetype end = last - series.timestamps.cbegin();
+    const double span = double(to - from);
+
+    double low = INFINITY;
+    double high = -INFINITY;
+    if (end - begin <= 2 * buckets) {
+        for (qsizetype i = begin; i < end; ++i) {
+            const double v = series.values[i];
+            if (!std::isnan(v)) {
+                points.append(QPointF((series.timestamps[i] - from) / span, v));
+                low = std::min(low, v);
+                high = std::max(high, v);
+            }
+        }
+    } else {
+        // Minimum i maksimum każdego przedziału, w kolejności wystąpienia
+        qsizetype i = begin;
+        for (int b = 0; b < buckets; ++b) {
+            const qint64 bucketEnd = from + qint64(span * (b + 1) / buckets);
+            qsizetype minIndex = -1;
+            qsizetype maxIndex = -1;
+            for (; i < end && (series.timestamps[i] <= bucketEnd || b == buckets - 1); ++i) {
+                const double v = series.values[i];
+                if (std::isnan(v)) {
+                    continue;
+                }
+                if (minIndex < 0 || v < series.values[minIndex]) {
+                    minIndex = i;
+                }
+                if (maxIndex < 0 || v > series.values[maxIndex]) {
+                    maxIndex = i;
+                }
+            }
+            if (minIndex < 0) {
+                continue;
+            }
+            const qsizetype a = std::min(minIndex, maxIndex);
+            const qsizetype c = std::max(minIndex, maxIndex);
+            points.append(QPointF((series.timestamps[a] - from) / span, series.values[a]));
+            if (c != a) {
+                points.append(QPointF((series.timestamps[c] - from) / span, series.values[c]));
+            }
+            low = std::min(low, series.values[minIndex]);
+            high = std::max(high, series.values[maxIndex]);
+        }
+    }
+
+    const double range = high - low;
+    for (QPointF &p : points) {
+        p.setY(range > 0.0 ? (p.y() - low) / range : 0.5);
+    }
+    return points;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file sparkline.h
+ * @brief Header file for the SparklineCache class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the downsampled per-station series drawn as sparklines
+ * in the station list.
+ */
+
+#ifndef SPARKLINE_H
+#define SPARKLINE_H
+
+#include <QHash>
+#include <QObject>
+#include <QPointF>
+#include <QString>
+#include <QVector>
+#include "memoryaccounting.h"
+#include "seriesstore.h"
+
+/**
+ * @class SparklineCache
+ * @brief Lazily computed sparklines of the last hours of a parameter.
+ *
+ * A sparkline is computed only when a visible row asks for it and is kept
+ * until the series of its sensor changes in the store, which is detected by
+ * the series version.
+ */
+class SparklineCache : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(QString param READ param NOTIFY paramChanged)
+
+public:
+    static constexpr int Hours = 72;                ///< Length of a sparkline in hours
+    static constexpr qint64 HourMs = 3600 * 1000;   ///< One hour in milliseconds
+
+    /**
+     * @brief Constructs an empty cache.
+     * @param store Series store the sparklines are computed from.
+     * @param parent Parent QObject.
+     */
+    explicit SparklineCache(const SeriesStore *store, QObject *parent = nullptr);
+
+    /**
+     * @brief Selects the parameter drawn.
+     * @param param Parameter key, empty to draw nothing.
+     * @param sensorByStation Sensor of the parameter at each station.
+     */
+    void setParam(const QString &param, const QHash<int, int> &sensorByStation);
+
+    /**
+     * @brief Gets the parameter drawn.
+     * @return Parameter key.
+     */
+    QString param() const { return m_param; }
+
+    /**
+     * @brief Sets the end of the drawn window.
+     * @param endTime End in ms since epoch, -1 for the current time.
+     */
+    void setWindowEnd(qint64 endTime);
+
+    /**
+     * @brief Reports that the series of a sensor changed.
+     * @param sensorId Sensor ID.
+     */
+    void sensorUpdated(int sensorId);
+
+    /**
+     * @brief Gets the sparkline of a station.
+     * @param stationId Station ID.
+     * @param buckets Horizontal resolution, usually the width in pixels.
+     * @return Points with x and y in [0, 1], y growing upwards; empty if the
+     *         station has no data in the window.
+     */
+    const QVector<QPointF> &points(int stationId, int buckets);
+
+    /**
+     * @brief Gets the number of sparklines computed so far.
+     * @return Computation count.
+     */
+    int computeCount() const { return m_computeCount; }
+
+    /**
+     * @brief Gets the memory held by the cached sparklines.
+     * @return Bytes and number of cached sparklines.
+     */
+    MemoryAccounting::Usage memoryUsage() const;
+
+    /**
+     * @brief Downsamples a series window to normalized points.
+     * @param series Source series.
+     * @param from Window start in ms since epoch.
+     * @param to Window end in ms since epoch.
+     * @param buckets Number of time buckets; each keeps its minimum and
+     *                maximum in time order.
+     * @return Points with x and y in [0, 1], y growing upwards.
+     */
+    static QVector<QPointF> downsample(const Series &series, qint64 from, qint64 to, int buckets);
+
+signals:
+    /**
+     * @brief Emitted when drawn sparklines may have changed.
+     */
+    void changed();
+
+    /**
+     * @brief Emitted when the parameter changes.
+     */
+    void paramChanged();
+
+private:
+    /**
+     * @struct Entry
+     * @brief Cached sparkline of a station.
+     */
+    struct Entry {
+        quint64 version = 0;        ///< Series version it was computed from
+        qint64 windowEnd = 0;       ///< Window end it was computed for
+        int buckets = 0;            ///< Resolution it was computed for
+        QVector<QPointF> points;    ///< Normalized points
+    };
+
+    const SeriesStore *m_store;             ///< Source of the series
+    QString m_param;                        ///< Parameter drawn
+    QHash<int, int> m_sensorByStation;      ///< Sensor of each station
+    QHash<int, int> m_stationBySensor;      ///< Station of each sensor
+    QHash<int, Entry> m_entries;            ///< Sparklines by station ID
+    qint64 m_windowEnd = -1;                ///< Window end, -1 for the current time
+    int m_computeCount = 0;                 ///< Number of computed sparklines
+};
+
+#endif // SPARKLINE_H
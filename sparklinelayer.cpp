@@ -0,0 +1,239 @@
+/**
+ * @file sparklinelayer.cpp
+ * @brief Implementation of the SparklineLayer class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the visible-row culling and the scene graph node of the
+ * station list sparklines.
+ */
+
+#include "sparklinelayer.h"
+#include <QSGFlatColorMaterial>
+#include <QSGGeometryNode>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/**
+ * @brief Constructs the layer.
+ * @param parent Parent item.
+ */
+SparklineLayer::SparklineLayer(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents, true);
+}
+
+/**
+ * @brief Sets the sparkline source.
+ * @param cache Sparkline cache.
+ */
+void SparklineLayer::setCache(SparklineCache *cache)
+{
+    if (m_cache == cache) {
+        return;
+    }
+    if (m_cache) {
+        disconnect(m_cache, nullptr, this, nullptr);
+    }
+    m_cache = cache;
+    if (m_cache) {
+        connect(m_cache, &SparklineCache::changed, this, [this]() { polish(); });
+    }
+    emit cacheChanged();
+    polish();
+}
+
+/**
+ * @brief Sets the model of the view.
+ * @param model List model with a "stationId" role.
+ */
+void SparklineLayer::setModel(QAbstractItemModel *model)
+{
+    if (m_model == model) {
+        return;
+    }
+    if (m_model) {
+        disconnect(m_model, nullptr, this, nullptr);
+    }
+    m_model = model;
+    m_stationIdRole = m_model ? m_model->roleNames().key("stationId", -1) : -1;
+    if (m_model) {
+        const auto relayout = [this]() { polish(); };
+        connect(m_model, &QAbstractItemModel::modelReset, this, relayout);
+        connect(m_model, &QAbstractItemModel::layoutChanged, this, relayout);
+        connect(m_model, &QAbstractItemModel::rowsInserted, this, relayout);
+        connect(m_model, &QAbstractItemModel::rowsRemoved, this, relayout);
+        connect(m_model, &QAbstractItemModel::rowsMoved, this, relayout);
+    }
+    emit modelChanged();
+    polish();
+}
+
+/**
+ * @brief Sets the scroll position of the view.
+ * @param contentY Content position of the top edge, relative to originY.
+ */
+void SparklineLayer::setContentY(qreal contentY)
+{
+    if (qFuzzyCompare(m_contentY, contentY)) {
+        return;
+    }
+    m_contentY = contentY;
+    emit contentYChanged();
+    polish();
+}
+
+/**
+ * @brief Sets the row height.
+ * @param rowHeight Height of a delegate.
+ */
+void SparklineLayer::setRowHeight(qreal rowHeight)
+{
+    if (qFuzzyCompare(m_rowHeight, rowHeight)) {
+        return;
+    }
+    m_rowHeight = rowHeight;
+    emit rowLayoutChanged();
+    polish();
+}
+
+/**
+ * @brief Sets the spacing between rows.
+ * @param rowSpacing Spacing of the view.
+ */
+void SparklineLayer::setRowSpacing(qreal rowSpacing)
+{
+    if (qFuzzyCompare(m_rowSpacing, rowSpacing)) {
+        return;
+    }
+    m_rowSpacing = rowSpacing;
+    emit rowLayoutChanged();
+    polish();
+}
+
+/**
+ * @brief Sets the sparkline rectangle within a row.
+ * @param lineRect Rectangle relative to the top-left corner of the row.
+ */
+void SparklineLayer::setLineRect(const QRectF &lineRect)
+{
+    if (m_lineRect == lineRect) {
+        return;
+    }
+    m_lineRect = lineRect;
+    emit rowLayoutChanged();
+    polish();
+}
+
+/**
+ * @brief Sets the line color.
+ * @param color Color.
+ */
+void SparklineLayer::setColor(const QColor &color)
+{
+    if (m_color == color) {
+        return;
+    }
+    m_color = color;
+    emit colorChanged();
+    update();
+}
+
+/**
+ * @brief Schedules a new layout when the item is resized.
+ * @param newGeometry New geometry.
+ * @param oldGeometry Old geometry.
+ */
+void SparklineLayer::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size()) {
+        polish();
+    }
+}
+
+/**
+ * @brief Collects the line segments of the visible rows.
+ *
+ * Runs on the GUI thread before the scene graph is synchronized, at most once
+ * per frame however many changes were reported.
+ */
+void SparklineLayer::updatePolish()
+{
+    m_segments.clear();
+    m_drawnRows = 0;
+    const qreal stride = m_rowHeight + m_rowSpacing;
+    const int rows = m_model ? m_model->rowCount() : 0;
+    if (!m_cache || m_stationIdRole < 0 || rows == 0 || stride <= 0.0 || m_lineRect.isEmpty()) {
+        update();
+        return;
+    }
+
+    // Tylko wiersze, których wykres przecina widoczny obszar
+    const int first = std::max(0, int(std::floor((m_contentY - m_lineRect.bottom()) / stride)) + 1);
+    const int last = std::min(rows - 1, int(std::floor((m_contentY + height() - m_lineRect.top()) / stride)));
+    const int buckets = std::max(1, int(m_lineRect.width() / 2.0));
+    for (int row = first; row <= last; ++row) {
+        const int stationId = m_model->data(m_model->index(row, 0), m_stationIdRole).toInt();
+        const QVector<QPointF> &points = m_cache->points(stationId, buckets);
+        ++m_drawnRows;
+        if (points.size() < 2) {
+            continue;
+        }
+        const qreal left = m_lineRect.left();
+        const qreal top = row * stride - m_contentY + m_lineRect.top();
+        const auto vertex = [&](const QPointF &p) {
+            m_segments.append(float(left + p.x() * m_lineRect.width()));
+            m_segments.append(float(top + (1.0 - p.y()) * m_lineRect.height()));
+        };
+        for (qsizetype i = 1; i < points.size(); ++i) {
+            vertex(points[i - 1]);
+            vertex(points[i]);
+        }
+    }
+    update();
+}
+
+/**
+ * @brief Updates the geometry node.
+ * @param oldNode Node of the previous update.
+ * @param data Update data.
+ * @return Geometry node, nullptr if there is nothing to draw.
+ */
+QSGNode *SparklineLayer::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+    auto *node = static_cast<QSGGeometryNode *>(oldNode);
+    const int count = int(m_segments.size() / 2);
+    if (count == 0) {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node) {
+        node = new QSGGeometryNode;
+        auto *geometry = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 0);
+        geometry->setDrawingMode(QSGGeometry::DrawLines);
+        geometry->setLineWidth(1.5f);
+        node->setGeometry(geometry);
+        node->setFlag(QSGNode::OwnsGeometry);
+        node->setMaterial(new QSGFlatColorMaterial);
+        node->setFlag(QSGNode::OwnsMaterial);
+    }
+
+    auto *material = static_cast<QSGFlatColorMaterial *>(node->material());
+    if (material->color() != m_color) {
+        material->setColor(m_color);
+        node->markDirty(QSGNode::DirtyMaterial);
+    }
+
+    QSGGeometry *geometry = node->geometry();
+    if (geometry->vertexCount() != count) {
+        geometry->allocate(count);
+    }
+    std::memcpy(geometry->vertexDataAsPoint2D(), m_segments.constData(), size_t(count) * sizeof(QSGGeometry::Point2D));
+    node->markDirty(QSGNode::DirtyGeometry);
+    return node;
+}
@@ -0,0 +1,198 @@
+/**
+ * @file sparklinelayer.h
+ * @brief Header file for the SparklineLayer class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the overlay drawing the sparklines of all visible rows of
+ * the station list.
+ */
+
+#ifndef SPARKLINELAYER_H
+#define SPARKLINELAYER_H
+
+#include <QAbstractItemModel>
+#include <QColor>
+#include <QPointer>
+#include <QQuickItem>
+#include <QRectF>
+#include <QVector>
+#include "sparkline.h"
+
+/**
+ * @class SparklineLayer
+ * @brief Scene graph overlay of a ListView drawing one sparkline per row.
+ *
+ * The sparklines of all rows are line segments of one geometry node. Only
+ * rows intersecting the item are looked up, so an off-screen row neither
+ * computes nor draws its sparkline. The rows must have a fixed height and
+ * the item must cover the view, with contentY bound to the view.
+ */
+class SparklineLayer : public QQuickItem {
+    Q_OBJECT
+    Q_PROPERTY(SparklineCache *cache READ cache WRITE setCache NOTIFY cacheChanged)
+    Q_PROPERTY(QAbstractItemModel *model READ model WRITE setModel NOTIFY modelChanged)
+    Q_PROPERTY(qreal contentY READ contentY WRITE setContentY NOTIFY contentYChanged)
+    Q_PROPERTY(qreal rowHeight READ rowHeight WRITE setRowHeight NOTIFY rowLayoutChanged)
+    Q_PROPERTY(qreal rowSpacing READ rowSpacing WRITE setRowSpacing NOTIFY rowLayoutChanged)
+    Q_PROPERTY(QRectF lineRect READ lineRect WRITE setLineRect NOTIFY rowLayoutChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+
+public:
+    /**
+     * @brief Constructs the layer.
+     * @param parent Parent item.
+     */
+    explicit SparklineLayer(QQuickItem *parent = nullptr);
+
+    /**
+     * @brief Gets the sparkline source.
+     * @return Sparkline cache.
+     */
+    SparklineCache *cache() const { return m_cache; }
+
+    /**
+     * @brief Sets the sparkline source.
+     * @param cache Sparkline cache.
+     */
+    void setCache(SparklineCache *cache);
+
+    /**
+     * @brief Gets the model of the view.
+     * @return List model with a "stationId" role.
+     */
+    QAbstractItemModel *model() const { return m_model; }
+
+    /**
+     * @brief Sets the model of the view.
+     * @param model List model with a "stationId" role.
+     */
+    void setModel(QAbstractItemModel *model);
+
+    /**
+     * @brief Gets the scroll position of the view.
+     * @return Content position of the top edge.
+     */
+    qreal contentY() const { return m_contentY; }
+
+    /**
+     * @brief Sets the scroll position of the view.
+     * @param contentY Content position of the top edge, relative to originY.
+     */
+    void setContentY(qreal contentY);
+
+    /**
+     * @brief Gets the row height.
+     * @return Height of a delegate.
+     */
+    qreal rowHeight() const { return m_rowHeight; }
+
+    /**
+     * @brief Sets the row height.
+     * @param rowHeight Height of a delegate.
+     */
+    void setRowHeight(qreal rowHeight);
+
+    /**
+     * @brief Gets the spacing between rows.
+     * @return Spacing of the view.
+     */
+    qreal rowSpacing() const { return m_rowSpacing; }
+
+    /**
+     * @brief Sets the spacing between rows.
+     * @param rowSpacing Spacing of the view.
+     */
+    void setRowSpacing(qreal rowSpacing);
+
+    /**
+     * @brief Gets the sparkline rectangle within a row.
+     * @return Rectangle relative to the top-left corner of the row.
+     */
+    QRectF lineRect() const { return m_lineRect; }
+
+    /**
+     * @brief Sets the sparkline rectangle within a row.
+     * @param lineRect Rectangle relative to the top-left corner of the row.
+     */
+    void setLineRect(const QRectF &lineRect);
+
+    /**
+     * @brief Gets the line color.
+     * @return Color.
+     */
+    QColor color() const { return m_color; }
+
+    /**
+     * @brief Sets the line color.
+     * @param color Color.
+     */
+    void setColor(const QColor &color);
+
+    /**
+     * @brief Gets the number of rows drawn by the last update.
+     * @return Visible row count.
+     */
+    int drawnRows() const { return m_drawnRows; }
+
+signals:
+    /**
+     * @brief Emitted when the cache changes.
+     */
+    void cacheChanged();
+
+    /**
+     * @brief Emitted when the model changes.
+     */
+    void modelChanged();
+
+    /**
+     * @brief Emitted when the scroll position changes.
+     */
+    void contentYChanged();
+
+    /**
+     * @brief Emitted when the row height, spacing or line rectangle changes.
+     */
+    void rowLayoutChanged();
+
+    /**
+     * @brief Emitted when the color changes.
+     */
+    void colorChanged();
+
+protected:
+    /**
+     * @brief Collects the line segments of the visible rows.
+     */
+    void updatePolish() override;
+
+    /**
+     * @brief Updates the geometry node.
+     * @param oldNode Node of the previous update.
+     * @param data Update data.
+     * @return Geometry node, nullptr if there is nothing to draw.
+     */
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+
+    /**
+     * @brief Schedules a new layout when the item is resized.
+     * @param newGeometry New geometry.
+     * @param oldGeometry Old geometry.
+     */
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+
+private:
+    QPointer<SparklineCache> m_cache;       ///< Sparkline source
+    QPointer<QAbstractItemModel> m_model;   ///< Model of the view
+    int m_stationIdRole = -1;               ///< Role of the station ID in the model
+    qreal m_contentY = 0.0;                 ///< Scroll position of the view
+    qreal m_rowHeight = 0.0;                ///< Height of a delegate
+    qreal m_rowSpacing = 0.0;               ///< Spacing between delegates
+    QRectF m_lineRect;                      ///< Sparkline rectangle within a row
+    QColor m_color = QColor("#2196F3");     ///< Line color
+    QVector<float> m_segments;              ///< Line segment endpoints, x and y
+    int m_drawnRows = 0;                    ///< Rows drawn by the last update
+};
+
+#endif // SPARKLINELAYER_H
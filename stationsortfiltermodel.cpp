@@ -0,0 +1,470 @@
+/**
+ * @file stationsortfiltermodel.cpp
+ * @brief Implementation of the StationSortFilterModel class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the cached sort permutations, their incremental update
+ * and the text filter of the station list.
+ */
+
+#include "stationsortfiltermodel.h"
+#include "mainwindow.h"
+#include <QLocale>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+/**
+ * @brief Finds the new index of an element of an otherwise sorted vector.
+ * @param order Vector sorted except for the element at from.
+ * @param from Index of the element.
+ * @param less Strict order of the elements.
+ * @return Index the element must move to.
+ */
+template <typename Less>
+qsizetype sortedIndex(const QVector<int> &order, qsizetype from, Less less)
+{
+    const int value = order[from];
+    if (from > 0 && less(value, order[from - 1])) {
+        return std::upper_bound(order.cbegin(), order.cbegin() + from, value, less) - order.cbegin();
+    }
+    if (from + 1 < order.size() && less(order[from + 1], value)) {
+        return std::lower_bound(order.cbegin() + from + 1, order.cend(), value, less) - order.cbegin() - 1;
+    }
+    return from;
+}
+
+/**
+ * @brief Moves an element of a vector, shifting the elements in between.
+ * @param order Vector.
+ * @param from Current index of the element.
+ * @param to New index of the element.
+ */
+void moveElement(QVector<int> &order, qsizetype from, qsizetype to)
+{
+    if (to < from) {
+        std::rotate(order.begin() + to, order.begin() + from, order.begin() + from + 1);
+    } else if (to > from) {
+        std::rotate(order.begin() + from, order.begin() + from + 1, order.begin() + to + 1);
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Constructs an empty model.
+ * @param parent Parent QObject.
+ */
+StationSortFilterModel::StationSortFilterModel(QObject *parent)
+    : QAbstractListModel(parent),
+    m_collator(QLocale(QLocale::Polish, QLocale::Poland))
+{
+    m_collator.setCaseSensitivity(Qt::CaseInsensitive);
+}
+
+/**
+ * @brief Replaces the stations.
+ * @param stations Stations in source order.
+ *
+ * Latest values of stations still listed are kept.
+ */
+void StationSortFilterModel::setStations(const QList<Station *> &stations)
+{
+    QHash<int, QPair<double, int>> latest;
+    for (const Row &row : std::as_const(m_rows)) {
+        latest.insert(row.stationId, qMakePair(row.value, row.level));
+    }
+
+    m_rows.clear();
+    m_rows.reserve(stations.size());
+    m_rowByStation.clear();
+    for (const Station *station : stations) {
+        Row row;
+        row.stationId = station->stationId();
+        row.name = station->stationName();
+        row.city = station->cityName();
+        row.address = station->address();
+        row.haystack = (row.name + '\n' + row.city + '\n' + row.address).toLower();
+        row.lat = station->lat();
+        row.lon = station->lon();
+        row.distance = m_searchPoint.isValid()
+                           ? m_searchPoint.distanceTo(QGeoCoordinate(row.lat, row.lon)) / 1000.0
+                           : std::numeric_limits<double>::quiet_NaN();
+        const QPair<double, int> value = latest.value(row.stationId, qMakePair(std::numeric_limits<double>::quiet_NaN(), -1));
+        row.value = value.first;
+        row.level = value.second;
+        m_rowByStation.insert(row.stationId, int(m_rows.size()));
+        m_rows.append(row);
+    }
+
+    std::fill(std::begin(m_permutationValid), std::end(m_permutationValid), false);
+    refilter();
+}
+
+/**
+ * @brief Sets the point distances are measured from.
+ * @param point Search point; invalid to clear the distances.
+ */
+void StationSortFilterModel::setSearchPoint(const QGeoCoordinate &point)
+{
+    m_searchPoint = point;
+    for (Row &row : m_rows) {
+        row.distance = point.isValid()
+                           ? point.distanceTo(QGeoCoordinate(row.lat, row.lon)) / 1000.0
+                           : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    // Zmieniły się wszystkie odległości, więc permutację trzeba zbudować od nowa
+    m_permutationValid[Distance] = false;
+    if (m_sortKey == Distance) {
+        refilter();
+    } else if (!m_visible.isEmpty()) {
+        emit dataChanged(index(0), index(int(m_visible.size()) - 1), {DistanceRole});
+    }
+}
+
+/**
+ * @brief Updates the latest value of a station.
+ * @param stationId Station ID.
+ * @param value Latest value, NaN if none.
+ * @param level Index level of the value, -1 if none.
+ *
+ * The station is moved within the cached value and index permutations and
+ * the listed rows, which costs a binary search and a shift of the rows it
+ * passes instead of a sort.
+ */
+void StationSortFilterModel::setLatestValue(int stationId, double value, int level)
+{
+    const auto it = m_rowByStation.constFind(stationId);
+    if (it == m_rowByStation.cend()) {
+        return;
+    }
+    const int row = it.value();
+    Row &data = m_rows[row];
+    const bool same = (data.value == value || (std::isnan(data.value) && std::isnan(value))) && data.level == level;
+    if (same) {
+        return;
+    }
+    data.value = value;
+    data.level = level;
+    reposition(LatestValue, row);
+    reposition(Index, row);
+    rowValueChanged(row, m_sortKey == LatestValue || m_sortKey == Index);
+}
+
+/**
+ * @brief Clears the latest values of all stations.
+ */
+void StationSortFilterModel::clearLatestValues()
+{
+    for (Row &row : m_rows) {
+        row.value = std::numeric_limits<double>::quiet_NaN();
+        row.level = -1;
+    }
+    m_permutationValid[LatestValue] = false;
+    m_permutationValid[Index] = false;
+    if (m_sortKey == LatestValue || m_sortKey == Index) {
+        refilter();
+    } else if (!m_visible.isEmpty()) {
+        emit dataChanged(index(0), index(int(m_visible.size()) - 1), {LatestValueRole, IndexRole});
+    }
+}
+
+/**
+ * @brief Sets the sort key.
+ * @param key Sort key.
+ */
+void StationSortFilterModel::setSortKey(SortKey key)
+{
+    if (key == m_sortKey || key < SourceOrder || key >= SortKeyCount) {
+        return;
+    }
+    m_sortKey = key;
+    refilter();
+    emit sortChanged();
+}
+
+/**
+ * @brief Sets the sort direction.
+ * @param descending True for descending order.
+ */
+void StationSortFilterModel::setDescending(bool descending)
+{
+    if (descending == m_descending) {
+        return;
+    }
+    m_descending = descending;
+    refilter();
+    emit sortChanged();
+}
+
+/**
+ * @brief Sets the filter text.
+ * @param text Text every listed station has in its name, city or address,
+ *             case-insensitive; empty to list all.
+ */
+void StationSortFilterModel::setFilterText(const QString &text)
+{
+    if (text == m_filterText) {
+        return;
+    }
+    m_filterText = text;
+    refilter();
+    emit filterTextChanged();
+}
+
+/**
+ * @brief Gets the station ID of a row.
+ * @param row Row index.
+ * @return Station ID, -1 if out of range.
+ */
+int StationSortFilterModel::stationIdAt(int row) const
+{
+    return row >= 0 && row < m_visible.size() ? m_rows[m_visible[row]].stationId : -1;
+}
+
+int StationSortFilterModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : count();
+}
+
+QVariant StationSortFilterModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_visible.size()) {
+        return QVariant();
+    }
+
+    const Row &row = m_rows[m_visible[index.row()]];
+    switch (role) {
+    case StationIdRole:
+        return row.stationId;
+    case Qt::DisplayRole:
+    case StationNameRole:
+        return row.name;
+    case CityNameRole:
+        return row.city;
+    case AddressRole:
+        return row.address;
+    case LatRole:
+        return row.lat;
+    case LonRole:
+        return row.lon;
+    case DistanceRole:
+        return row.distance;
+    case LatestValueRole:
+        return row.value;
+    case IndexRole:
+        return row.level;
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> StationSortFilterModel::roleNames() const
+{
+    return {
+        {StationIdRole, "stationId"},
+        {StationNameRole, "stationName"},
+        {CityNameRole, "cityName"},
+        {AddressRole, "address"},
+        {LatRole, "lat"},
+        {LonRole, "lon"},
+        {DistanceRole, "distance"},
+        {LatestValueRole, "latestValue"},
+        {IndexRole, "indexLevel"}
+    };
+}
+
+/**
+ * @brief Gets the cached permutation of a key, building it if needed.
+ * @param key Sort key.
+ * @return Source rows in ascending order, rows without a value last.
+ */
+const QVector<int> &StationSortFilterModel::permutation(SortKey key)
+{
+    QVector<int> &order = m_permutations[key];
+    if (m_permutationValid[key]) {
+        return order;
+    }
+
+    order.resize(m_rows.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (key != SourceOrder) {
+        std::sort(order.begin(), order.end(), [this, key](int a, int b) {
+            return lessThan(key, a, b);
+        });
+        ++m_sortCount;
+    }
+    m_permutationValid[key] = true;
+    return order;
+}
+
+/**
+ * @brief Checks whether a row has a value for a key.
+ * @param key Sort key.
+ * @param row Source row.
+ * @return True if the row can be ordered by the key.
+ */
+bool StationSortFilterModel::hasValue(SortKey key, int row) const
+{
+    switch (key) {
+    case Distance:
+        return !std::isnan(m_rows[row].distance);
+    case LatestValue:
+        return !std::isnan(m_rows[row].value);
+    case Index:
+        return m_rows[row].level >= 0;
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief Orders two source rows by a key.
+ * @param key Sort key.
+ * @param a First source row.
+ * @param b Second source row.
+ * @return True if a comes before b in ascending order.
+ *
+ * Ties are broken by the source row, so the order is total and stable.
+ */
+bool StationSortFilterModel::lessThan(SortKey key, int a, int b) const
+{
+    const bool hasA = hasValue(key, a);
+    const bool hasB = hasValue(key, b);
+    if (hasA != hasB) {
+        return hasA;
+    }
+
+    const Row &ra = m_rows[a];
+    const Row &rb = m_rows[b];
+    int order = 0;
+    if (hasA) {
+        switch (key) {
+        case Distance:
+            order = ra.distance < rb.distance ? -1 : (rb.distance < ra.distance ? 1 : 0);
+            break;
+        case City:
+            order = m_collator.compare(ra.city, rb.city);
+            if (order == 0) {
+                order = m_collator.compare(ra.name, rb.name);
+            }
+            break;
+        case Name:
+            order = m_collator.compare(ra.name, rb.name);
+            break;
+        case Index:
+            order = ra.level - rb.level;
+            if (order != 0) {
+                break;
+            }
+            Q_FALLTHROUGH();
+        case LatestValue:
+            order = ra.value < rb.value ? -1 : (rb.value < ra.value ? 1 : 0);
+            break;
+        default:
+            break;
+        }
+    }
+    return order != 0 ? order < 0 : a < b;
+}
+
+/**
+ * @brief Orders two source rows as they are listed.
+ * @param a First source row.
+ * @param b Second source row.
+ * @return True if a is listed before b with the active key and direction.
+ *
+ * A descending order reverses only the rows having a value, like refilter().
+ */
+bool StationSortFilterModel::listedBefore(int a, int b) const
+{
+    if (m_descending && hasValue(m_sortKey, a) && hasValue(m_sortKey, b)) {
+        return lessThan(m_sortKey, b, a);
+    }
+    return lessThan(m_sortKey, a, b);
+}
+
+/**
+ * @brief Moves a row within a cached permutation after its value changed.
+ * @param key Sort key.
+ * @param row Source row.
+ *
+ * The rest of the permutation stays sorted, so the row is moved to its
+ * binary-searched position and only the rows in between are shifted.
+ */
+void StationSortFilterModel::reposition(SortKey key, int row)
+{
+    if (!m_permutationValid[key]) {
+        return;
+    }
+    QVector<int> &order = m_permutations[key];
+    const qsizetype from = order.indexOf(row);
+    moveElement(order, from, sortedIndex(order, from, [this, key](int a, int b) {
+        return lessThan(key, a, b);
+    }));
+}
+
+/**
+ * @brief Rebuilds the listed rows from the active permutation and filter.
+ *
+ * A descending order reverses only the rows having a value, so rows without
+ * one stay at the end.
+ */
+void StationSortFilterModel::refilter()
+{
+    const QVector<int> &order = permutation(m_sortKey);
+    const QString needle = m_filterText.trimmed().toLower();
+
+    qsizetype valued = order.size();
+    while (valued > 0 && !hasValue(m_sortKey, order[valued - 1])) {
+        --valued;
+    }
+
+    const int oldCount = count();
+    beginResetModel();
+    m_visible.clear();
+    m_visible.reserve(order.size());
+    for (qsizetype i = 0; i < order.size(); ++i) {
+        const qsizetype k = m_descending && i < valued ? valued - 1 - i : i;
+        const int row = order[k];
+        if (needle.isEmpty() || m_rows[row].haystack.contains(needle)) {
+            m_visible.append(row);
+        }
+    }
+    endResetModel();
+    if (count() != oldCount) {
+        emit countChanged();
+    }
+}
+
+/**
+ * @brief Moves a listed row after a value change.
+ * @param row Source row whose value changed.
+ * @param affectsOrder True if the value is the active sort key.
+ *
+ * The filter does not depend on values, so the other listed rows keep their
+ * order and the row is moved to its binary-searched position. The move is
+ * announced with beginMoveRows(), which keeps the delegates of the other
+ * rows; an unmoved row only reports its data as changed.
+ */
+void StationSortFilterModel::rowValueChanged(int row, bool affectsOrder)
+{
+    const qsizetype before = m_visible.indexOf(row);
+    if (before < 0) {
+        return;
+    }
+    const qsizetype after = affectsOrder ? sortedIndex(m_visible, before, [this](int a, int b) {
+        return listedBefore(a, b);
+    }) : before;
+    if (after != before) {
+        beginMoveRows(QModelIndex(), int(before), int(before), QModelIndex(), int(after > before ? after + 1 : after));
+        moveElement(m_visible, before, after);
+        endMoveRows();
+    }
+    emit dataChanged(index(int(after)), index(int(after)), {LatestValueRole, IndexRole});
+}
@@ -0,0 +1,265 @@
+/**
+ * @file stationsortfiltermodel.h
+ * @brief Header file for the StationSortFilterModel class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the sorted and filtered station list shown next to the
+ * map, with a cached sort permutation per sort key.
+ */
+
+#ifndef STATIONSORTFILTERMODEL_H
+#define STATIONSORTFILTERMODEL_H
+
+#include <QAbstractListModel>
+#include <QCollator>
+#include <QGeoCoordinate>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+class Station;
+
+/**
+ * @class StationSortFilterModel
+ * @brief List model of stations sorted by a key and filtered by text.
+ *
+ * The model keeps one sort permutation of the stations per key and builds
+ * it only when the key is first used. When a single value changes, the
+ * station is moved within the cached permutations and the listed rows to
+ * its binary-searched position instead of sorting again; a change of every
+ * value (a new search point, a new list) drops the affected permutations. Stations without a value for the key
+ * are listed last in both directions.
+ */
+class StationSortFilterModel : public QAbstractListModel {
+    Q_OBJECT
+    Q_PROPERTY(SortKey sortKey READ sortKey WRITE setSortKey NOTIFY sortChanged)
+    Q_PROPERTY(bool descending READ descending WRITE setDescending NOTIFY sortChanged)
+    Q_PROPERTY(QString filterText READ filterText WRITE setFilterText NOTIFY filterTextChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    /**
+     * @brief Sort keys.
+     */
+    enum SortKey {
+        SourceOrder,    ///< Order of the source list
+        Distance,       ///< Distance to the search point
+        City,           ///< City name
+        Name,           ///< Station name
+        LatestValue,    ///< Latest value of the selected parameter
+        Index,          ///< Air quality index level of the latest value
+        SortKeyCount    ///< Number of sort keys
+    };
+    Q_ENUM(SortKey)
+
+    /**
+     * @brief Custom data roles.
+     */
+    enum Roles {
+        StationIdRole = Qt::UserRole + 1,   ///< Station ID
+        StationNameRole,                    ///< Station name
+        CityNameRole,                       ///< City name
+        AddressRole,                        ///< Address
+        LatRole,                            ///< Latitude
+        LonRole,                            ///< Longitude
+        DistanceRole,                       ///< Distance to the search point in km, NaN if none
+        LatestValueRole,                    ///< Latest value, NaN if none
+        IndexRole                           ///< Index level, -1 if none
+    };
+
+    /**
+     * @brief Constructs an empty model.
+     * @param parent Parent QObject.
+     */
+    explicit StationSortFilterModel(QObject *parent = nullptr);
+
+    /**
+     * @brief Replaces the stations.
+     * @param stations Stations in source order.
+     *
+     * Latest values of stations still listed are kept.
+     */
+    void setStations(const QList<Station *> &stations);
+
+    /**
+     * @brief Sets the point distances are measured from.
+     * @param point Search point; invalid to clear the distances.
+     */
+    void setSearchPoint(const QGeoCoordinate &point);
+
+    /**
+     * @brief Updates the latest value of a station.
+     * @param stationId Station ID.
+     * @param value Latest value, NaN if none.
+     * @param level Index level of the value, -1 if none.
+     */
+    void setLatestValue(int stationId, double value, int level);
+
+    /**
+     * @brief Clears the latest values of all stations.
+     */
+    void clearLatestValues();
+
+    /**
+     * @brief Gets the sort key.
+     * @return Sort key.
+     */
+    SortKey sortKey() const { return m_sortKey; }
+
+    /**
+     * @brief Sets the sort key.
+     * @param key Sort key.
+     */
+    void setSortKey(SortKey key);
+
+    /**
+     * @brief Checks whether the order is descending.
+     * @return True if descending.
+     */
+    bool descending() const { return m_descending; }
+
+    /**
+     * @brief Sets the sort direction.
+     * @param descending True for descending order.
+     */
+    void setDescending(bool descending);
+
+    /**
+     * @brief Gets the filter text.
+     * @return Filter text.
+     */
+    QString filterText() const { return m_filterText; }
+
+    /**
+     * @brief Sets the filter text.
+     * @param text Text every listed station has in its name, city or address,
+     *             case-insensitive; empty to list all.
+     */
+    void setFilterText(const QString &text);
+
+    /**
+     * @brief Gets the number of listed stations.
+     * @return Row count.
+     */
+    int count() const { return int(m_visible.size()); }
+
+    /**
+     * @brief Gets the station ID of a row.
+     * @param row Row index.
+     * @return Station ID, -1 if out of range.
+     */
+    Q_INVOKABLE int stationIdAt(int row) const;
+
+    /**
+     * @brief Gets the number of sorts run so far.
+     * @return Number of full permutation builds.
+     */
+    int sortCount() const { return m_sortCount; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+signals:
+    /**
+     * @brief Emitted when the sort key or direction changes.
+     */
+    void sortChanged();
+
+    /**
+     * @brief Emitted when the filter text changes.
+     */
+    void filterTextChanged();
+
+    /**
+     * @brief Emitted when the number of listed stations changes.
+     */
+    void countChanged();
+
+private:
+    /**
+     * @struct Row
+     * @brief Station data held by the model.
+     */
+    struct Row {
+        int stationId = 0;          ///< Station ID
+        QString name;               ///< Station name
+        QString city;               ///< City name
+        QString address;            ///< Address
+        QString haystack;           ///< Lower-case name, city and address for filtering
+        double lat = 0.0;           ///< Latitude
+        double lon = 0.0;           ///< Longitude
+        double distance = 0.0;      ///< Distance to the search point in km, NaN if none
+        double value = 0.0;         ///< Latest value, NaN if none
+        int level = -1;             ///< Index level, -1 if none
+    };
+
+    /**
+     * @brief Gets the cached permutation of a key, building it if needed.
+     * @param key Sort key.
+     * @return Source rows in ascending order, rows without a value last.
+     */
+    const QVector<int> &permutation(SortKey key);
+
+    /**
+     * @brief Checks whether a row has a value for a key.
+     * @param key Sort key.
+     * @param row Source row.
+     * @return True if the row can be ordered by the key.
+     */
+    bool hasValue(SortKey key, int row) const;
+
+    /**
+     * @brief Orders two source rows by a key.
+     * @param key Sort key.
+     * @param a First source row.
+     * @param b Second source row.
+     * @return True if a comes before b in ascending order.
+     *
+     * Ties are broken by the source row, so the order is total and stable.
+     */
+    bool lessThan(SortKey key, int a, int b) const;
+
+    /**
+     * @brief Orders two source rows as they are listed.
+     * @param a First source row.
+     * @param b Second source row.
+     * @return True if a is listed before b with the active key and direction.
+     */
+    bool listedBefore(int a, int b) const;
+
+    /**
+     * @brief Moves a row within a cached permutation after its value changed.
+     * @param key Sort key.
+     * @param row Source row.
+     */
+    void reposition(SortKey key, int row);
+
+    /**
+     * @brief Rebuilds the listed rows from the active permutation and filter.
+     */
+    void refilter();
+
+    /**
+     * @brief Moves a listed row after a value change.
+     * @param row Source row whose value changed.
+     * @param affectsOrder True if the value is the active sort key.
+     */
+    void rowValueChanged(int row, bool affectsOrder);
+
+    QVector<Row> m_rows;                        ///< Stations in source order
+    QHash<int, int> m_rowByStation;             ///< Source row by station ID
+    QVector<int> m_permutations[SortKeyCount];  ///< Cached permutation per key
+    bool m_permutationValid[SortKeyCount] = {}; ///< Validity of each cached permutation
+    QVector<int> m_visible;                     ///< Source rows of the listed stations
+    QGeoCoordinate m_searchPoint;               ///< Point distances are measured from
+    SortKey m_sortKey = SourceOrder;            ///< Active sort key
+    bool m_descending = false;                  ///< Descending order
+    QString m_filterText;                       ///< Filter text
+    QCollator m_collator;                       ///< Locale-aware text comparison
+    int m_sortCount = 0;                        ///< Number of full permutation builds
+};
+
+#endif // STATIONSORTFILTERMODEL_H
@@ -0,0 +1,299 @@
+/**
+ * @file taskpool.cpp
+ * @brief Implementation of the TaskPool class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the deques, stealing, sleeping and helping of the
+ * work-stealing thread pool.
+ */
+
+#include "taskpool.h"
+#include <QMutexLocker>
+
+namespace {
+
+/**
+ * @struct ThreadState
+ * @brief Pool membership and running task of a thread.
+ */
+struct ThreadState {
+    const TaskPool *pool = nullptr;         ///< Pool owning the thread, nullptr outside pools
+    int index = -1;                         ///< Index of the thread in its pool
+    const void *taskState = nullptr;        ///< State of the running run() task
+    bool (*taskCheck)(const void *) = nullptr;  ///< Cancellation check of that task
+};
+
+thread_local ThreadState currentThread;
+
+} // namespace
+
+/**
+ * @brief Starts the threads.
+ * @param threadCount Number of threads, at least 1.
+ */
+TaskPool::TaskPool(int threadCount)
+{
+    const int count = std::max(threadCount, 1);
+    m_workers.reserve(size_t(count));
+    for (int i = 0; i < count; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    // Wątki startują dopiero po utworzeniu wszystkich kolejek, bo od razu podkradają
+    for (int i = 0; i < count; ++i) {
+        Worker &worker = *m_workers[size_t(i)];
+        worker.thread = QThread::create([this, i]() { work(i); });
+        worker.thread->setObjectName(QString("TaskPool #%1").arg(i));
+        worker.thread->start();
+    }
+}
+
+/**
+ * @brief Runs the queued tasks and stops the threads.
+ */
+TaskPool::~TaskPool()
+{
+    {
+        QMutexLocker locker(&m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wake.wakeAll();
+    for (const std::unique_ptr<Worker> &worker : m_workers) {
+        worker->thread->wait();
+        delete worker->thread;
+    }
+}
+
+/**
+ * @brief Gets the pool shared by the application.
+ * @return Pool with one thread per core.
+ */
+TaskPool &TaskPool::instance()
+{
+    static TaskPool pool;
+    return pool;
+}
+
+/**
+ * @brief Queues a task.
+ * @param task Function run on one of the threads.
+ * @param priority Priority.
+ *
+ * A task queued from a pool thread goes to the deque of that thread.
+ */
+void TaskPool::submit(std::function<void()> task, Priority priority)
+{
+    enqueue({std::move(task), nullptr}, priority);
+}
+
+/**
+ * @brief Queues a task, possibly a chunk of a parallel loop.
+ * @param task Task.
+ * @param priority Priority.
+ */
+void TaskPool::enqueue(Task task, Priority priority)
+{
+    const int self = currentIndex();
+    const size_t target = self >= 0 ? size_t(self) : size_t(m_nextWorker++ % m_workers.size());
+    {
+        Worker &worker = *m_workers[target];
+        QMutexLocker locker(&worker.mutex);
+        worker.queues[priority].push_back(std::move(task));
+        ++m_queuedByPriority[priority];
+        ++m_queued;
+    }
+
+    // Licznik zwiększony przed odczytem śpiących: wątek zasypiający zobaczy zadanie albo zostanie obudzony
+    if (m_sleeping.load() > 0) {
+        QMutexLocker locker(&m_sleepMutex);
+        m_wake.wakeOne();
+    }
+}
+
+/**
+ * @brief Checks whether the future of the running task was cancelled.
+ * @return True if the task started by run() should stop early; false
+ *         outside such a task.
+ */
+bool TaskPool::isCancelled()
+{
+    return currentThread.taskCheck && currentThread.taskCheck(currentThread.taskState);
+}
+
+/**
+ * @brief Gets the counters of the pool.
+ * @return Counters.
+ */
+TaskPool::Stats TaskPool::stats() const
+{
+    Stats stats;
+    stats.executed = m_executed.load();
+    stats.stolen = m_stolen.load();
+    stats.queued = m_queued.load();
+    return stats;
+}
+
+/**
+ * @brief Marks one chunk as finished.
+ *
+ * The count drops under the mutex, so wait() cannot return, and the latch
+ * on the stack of the waiting thread cannot disappear, before the mutex is
+ * released here.
+ */
+void TaskPool::Latch::countDown()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        m_done.wakeAll();
+    }
+}
+
+/**
+ * @brief Blocks until all chunks have finished.
+ */
+void TaskPool::Latch::wait()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_remaining.load(std::memory_order_acquire) > 0) {
+        m_done.wait(&m_mutex);
+    }
+}
+
+/**
+ * @brief Makes a task the current one of the thread.
+ * @param state State passed to the check.
+ * @param check Cancellation check.
+ */
+TaskPool::CurrentTask::CurrentTask(const void *state, Check check)
+    : m_previousState(currentThread.taskState), m_previousCheck(currentThread.taskCheck)
+{
+    currentThread.taskState = state;
+    currentThread.taskCheck = check;
+}
+
+/**
+ * @brief Restores the previous current task.
+ */
+TaskPool::CurrentTask::~CurrentTask()
+{
+    currentThread.taskState = m_previousState;
+    currentThread.taskCheck = m_previousCheck;
+}
+
+/**
+ * @brief Takes the most urgent queued task.
+ * @param self Index of the calling pool thread, -1 for other threads.
+ * @param task Taken task.
+ * @param latch If not nullptr, only chunks of this loop are taken.
+ * @return False if no such task is queued.
+ *
+ * Within a priority the own deque is popped from the back, newest first;
+ * other deques are robbed from the front, oldest first. Without a latch the
+ * first task checked is always taken.
+ */
+bool TaskPool::take(int self, std::function<void()> *task, const Latch *latch)
+{
+    const auto matches = [latch](const Task &queued) {
+        return !latch || queued.latch == latch;
+    };
+    const int count = threadCount();
+    for (int priority = 0; priority < PriorityCount; ++priority) {
+        if (m_queuedByPriority[priority].load() == 0) {
+            continue;
+        }
+        if (self >= 0) {
+            Worker &own = *m_workers[size_t(self)];
+            QMutexLocker locker(&own.mutex);
+            std::deque<Task> &queue = own.queues[priority];
+            const auto it = std::find_if(queue.rbegin(), queue.rend(), matches);
+            if (it != queue.rend()) {
+                *task = std::move(it->function);
+                queue.erase(std::next(it).base());
+                --m_queuedByPriority[priority];
+                --m_queued;
+                return true;
+            }
+        }
+        const int first = self >= 0 ? self + 1 : 0;
+        for (int k = 0; k < count; ++k) {
+            const int victim = (first + k) % count;
+            if (victim == self) {
+                continue;
+            }
+            Worker &other = *m_workers[size_t(victim)];
+            QMutexLocker locker(&other.mutex);
+            std::deque<Task> &queue = other.queues[priority];
+            const auto it = std::find_if(queue.begin(), queue.end(), matches);
+            if (it != queue.end()) {
+                *task = std::move(it->function);
+                queue.erase(it);
+                --m_queuedByPriority[priority];
+                --m_queued;
+                ++m_stolen;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Runs the queued chunks of a loop until its latch opens.
+ * @param latch Latch of a parallel loop.
+ *
+ * The waiting thread sleeps once no chunk of the loop is queued; the rest
+ * are then running on other threads, which finish their own nested loops
+ * the same way. Other tasks are left to the pool, so a coordinator thread
+ * never runs an unrelated job after its loop is done. A helped chunk runs
+ * without the current task, since it belongs to the loop rather than to
+ * the run() task further down the stack.
+ */
+void TaskPool::help(Latch &latch)
+{
+    const int self = currentIndex();
+    std::function<void()> task;
+    while (!latch.isDone() && take(self, &task, &latch)) {
+        const CurrentTask none(nullptr, nullptr);
+        task();
+        task = nullptr;
+        ++m_executed;
+    }
+    latch.wait();
+}
+
+/**
+ * @brief Loop of a pool thread.
+ * @param index Index of the thread.
+ */
+void TaskPool::work(int index)
+{
+    currentThread.pool = this;
+    currentThread.index = index;
+    std::function<void()> task;
+    while (true) {
+        if (take(index, &task)) {
+            task();
+            task = nullptr;
+            ++m_executed;
+            continue;
+        }
+        QMutexLocker locker(&m_sleepMutex);
+        ++m_sleeping;
+        while (!m_stopping && m_queued.load() == 0) {
+            m_wake.wait(&m_sleepMutex);
+        }
+        --m_sleeping;
+        if (m_stopping && m_queued.load() == 0) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Gets the index of the calling thread in this pool.
+ * @return Index, -1 for threads outside the pool.
+ */
+int TaskPool::currentIndex() const
+{
+    return currentThread.pool == this ? currentThread.index : -1;
+}
@@ -0,0 +1,361 @@
+/**
+ * @file taskpool.h
+ * @brief Header file for the TaskPool class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the work-stealing thread pool shared by the analytics,
+ * import and rendering workloads.
+ */
+
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+
+#include <QFuture>
+#include <QList>
+#include <QMutex>
+#include <QPromise>
+#include <QThread>
+#include <QWaitCondition>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @class TaskPool
+ * @brief Thread pool with one deque of tasks per thread and stealing.
+ *
+ * A thread pushes and pops its own tasks at the back of its deque, so the
+ * chunks a task splits off stay hot in its cache, while idle threads steal
+ * the oldest tasks from the front of the others. Every deque holds one
+ * queue per priority; a thread always takes the most urgent task it can
+ * find, so interactive computations overtake running imports.
+ *
+ * A thread waiting in blockingFor() or blockingMapped() runs the queued
+ * chunks of its own loop instead of sleeping, which makes nested parallel
+ * loops safe without letting the waiting thread, possibly one outside the
+ * pool, pick up unrelated work. Results
+ * reach the event loop through the QFuture returned by run(), watched by a
+ * QFutureWatcher or continued with QFuture::then() on a context object.
+ */
+class TaskPool {
+public:
+    /**
+     * @enum Priority
+     * @brief Order in which queued tasks are taken.
+     */
+    enum Priority {
+        High,       ///< Computations the user waits for
+        Normal,     ///< Background work started by the user
+        Low         ///< Imports and maintenance
+    };
+
+    static constexpr int PriorityCount = 3;     ///< Number of priorities
+    static constexpr int ChunksPerThread = 4;   ///< Chunks of a parallel loop per thread
+
+    /**
+     * @struct Stats
+     * @brief Counters of the pool.
+     */
+    struct Stats {
+        qint64 executed = 0;    ///< Tasks run
+        qint64 stolen = 0;      ///< Tasks taken from the deque of another thread
+        qint64 queued = 0;      ///< Tasks waiting
+    };
+
+    /**
+     * @brief Starts the threads.
+     * @param threadCount Number of threads, at least 1.
+     */
+    explicit TaskPool(int threadCount = QThread::idealThreadCount());
+
+    /**
+     * @brief Runs the queued tasks and stops the threads.
+     */
+    ~TaskPool();
+
+    TaskPool(const TaskPool &) = delete;
+    TaskPool &operator=(const TaskPool &) = delete;
+
+    /**
+     * @brief Gets the pool shared by the application.
+     * @return Pool with one thread per core.
+     */
+    static TaskPool &instance();
+
+    /**
+     * @brief Gets the number of threads.
+     * @return Thread count.
+     */
+    int threadCount() const { return int(m_workers.size()); }
+
+    /**
+     * @brief Queues a task.
+     * @param task Function run on one of the threads.
+     * @param priority Priority.
+     *
+     * A task queued from a pool thread goes to the deque of that thread.
+     */
+    void submit(std::function<void()> task, Priority priority = Normal);
+
+    /**
+     * @brief Runs a function on the pool.
+     * @param function Function without arguments; it may poll isCancelled().
+     * @param priority Priority.
+     * @return Future of the returned value; cancelling it skips a function
+     *         that has not started yet.
+     */
+    template<typename Function>
+    auto run(Function function, Priority priority = Normal);
+
+    /**
+     * @brief Checks whether the future of the running task was cancelled.
+     * @return True if the task started by run() should stop early; false
+     *         outside such a task.
+     */
+    static bool isCancelled();
+
+    /**
+     * @brief Calls a function for every index and waits.
+     * @param count Number of indices.
+     * @param function Function called with indices 0 to count - 1 from
+     *        several threads at once.
+     * @param priority Priority of the chunks.
+     * @param cancelled Optional flag; once set, chunks not started yet are
+     *        skipped.
+     */
+    template<typename Function>
+    void blockingFor(qsizetype count, Function function, Priority priority = Normal,
+                     const std::atomic_bool *cancelled = nullptr);
+
+    /**
+     * @brief Calls a function for every element of a container and waits.
+     * @param container Container with random access; elements may be modified.
+     * @param function Function called with a reference to each element.
+     * @param priority Priority of the chunks.
+     * @param cancelled Optional flag; once set, elements not started yet are
+     *        skipped.
+     */
+    template<typename Container, typename Function>
+    void blockingMap(Container &container, Function function, Priority priority = Normal,
+                     const std::atomic_bool *cancelled = nullptr);
+
+    /**
+     * @brief Maps a list in parallel and waits.
+     * @param items Items.
+     * @param function Function of an item.
+     * @param priority Priority of the chunks.
+     * @return Results in the order of the items.
+     */
+    template<typename T, typename Function>
+    auto blockingMapped(const QList<T> &items, Function function, Priority priority = Normal);
+
+    /**
+     * @brief Gets the counters of the pool.
+     * @return Counters.
+     */
+    Stats stats() const;
+
+private:
+    class Latch;
+
+    /**
+     * @struct Task
+     * @brief Queued function and the parallel loop it belongs to.
+     */
+    struct Task {
+        std::function<void()> function;     ///< Function to run
+        const Latch *latch = nullptr;       ///< Latch of the loop of a chunk, nullptr for other tasks
+    };
+
+    /**
+     * @struct Worker
+     * @brief Thread and its deques.
+     */
+    struct Worker {
+        QMutex mutex;                           ///< Guards the deques
+        std::deque<Task> queues[PriorityCount]; ///< Tasks by priority
+        QThread *thread = nullptr;              ///< Thread running work()
+    };
+
+    /**
+     * @class Latch
+     * @brief Counts the chunks of a parallel loop still running.
+     */
+    class Latch {
+    public:
+        /**
+         * @brief Constructs the latch.
+         * @param count Number of chunks.
+         */
+        explicit Latch(qsizetype count) : m_remaining(count) {}
+
+        /**
+         * @brief Marks one chunk as finished.
+         */
+        void countDown();
+
+        /**
+         * @brief Checks whether all chunks have finished.
+         * @return True when the count reached zero.
+         */
+        bool isDone() const { return m_remaining.load(std::memory_order_acquire) == 0; }
+
+        /**
+         * @brief Blocks until all chunks have finished.
+         */
+        void wait();
+
+    private:
+        QMutex m_mutex;                         ///< Orders the last countDown() before wait() returns
+        QWaitCondition m_done;                  ///< Signals the end of the last chunk
+        std::atomic<qsizetype> m_remaining;     ///< Chunks still running
+    };
+
+    /**
+     * @class CurrentTask
+     * @brief Publishes the cancellation check of a running task.
+     */
+    class CurrentTask {
+    public:
+        using Check = bool (*)(const void *state);     ///< Reads the cancellation of a state
+
+        /**
+         * @brief Makes a task the current one of the thread.
+         * @param state State passed to the check.
+         * @param check Cancellation check.
+         */
+        CurrentTask(const void *state, Check check);
+
+        /**
+         * @brief Restores the previous current task.
+         */
+        ~CurrentTask();
+
+    private:
+        const void *m_previousState;    ///< State of the outer task
+        Check m_previousCheck;          ///< Check of the outer task
+    };
+
+    /**
+     * @brief Queues a task, possibly a chunk of a parallel loop.
+     * @param task Task.
+     * @param priority Priority.
+     */
+    void enqueue(Task task, Priority priority);
+
+    /**
+     * @brief Takes the most urgent queued task.
+     * @param self Index of the calling pool thread, -1 for other threads.
+     * @param task Taken task.
+     * @param latch If not nullptr, only chunks of this loop are taken.
+     * @return False if no such task is queued.
+     */
+    bool take(int self, std::function<void()> *task, const Latch *latch = nullptr);
+
+    /**
+     * @brief Runs the queued chunks of a loop until its latch opens.
+     * @param latch Latch of a parallel loop.
+     */
+    void help(Latch &latch);
+
+    /**
+     * @brief Loop of a pool thread.
+     * @param index Index of the thread.
+     */
+    void work(int index);
+
+    /**
+     * @brief Gets the index of the calling thread in this pool.
+     * @return Index, -1 for threads outside the pool.
+     */
+    int currentIndex() const;
+
+    std::vector<std::unique_ptr<Worker>> m_workers;     ///< Threads and their deques
+    QMutex m_sleepMutex;                                ///< Guards sleeping and stopping
+    QWaitCondition m_wake;                              ///< Wakes sleeping threads
+    bool m_stopping = false;                            ///< Set by the destructor
+    std::atomic<int> m_sleeping{0};                     ///< Threads waiting for tasks
+    std::atomic<qint64> m_queued{0};                    ///< Tasks waiting
+    std::atomic<qint64> m_queuedByPriority[PriorityCount] = {};  ///< Tasks waiting by priority
+    std::atomic<qint64> m_executed{0};                  ///< Tasks run
+    std::atomic<qint64> m_stolen{0};                    ///< Tasks stolen
+    std::atomic<unsigned> m_nextWorker{0};              ///< Deque of the next task from outside
+};
+
+template<typename Function>
+auto TaskPool::run(Function function, Priority priority)
+{
+    using Result = std::invoke_result_t<Function>;
+    auto promise = std::make_shared<QPromise<Result>>();
+    QFuture<Result> future = promise->future();
+    promise->start();
+    submit([promise, function]() mutable {
+        if (!promise->isCanceled()) {
+            const CurrentTask current(promise.get(), [](const void *state) {
+                return static_cast<const QPromise<Result> *>(state)->isCanceled();
+            });
+            if constexpr (std::is_void_v<Result>) {
+                function();
+            } else {
+                promise->addResult(function());
+            }
+        }
+        promise->finish();
+    }, priority);
+    return future;
+}
+
+template<typename Function>
+void TaskPool::blockingFor(qsizetype count, Function function, Priority priority, const std::atomic_bool *cancelled)
+{
+    if (count <= 0) {
+        return;
+    }
+    // Kilka porcji na wątek: nierówne porcje wyrównuje podkradanie
+    const qsizetype grain = std::max<qsizetype>(1, count / (qsizetype(m_workers.size()) * ChunksPerThread));
+    const qsizetype chunks = (count + grain - 1) / grain;
+    Latch latch(chunks);
+    for (qsizetype chunk = 0; chunk < chunks; ++chunk) {
+        const qsizetype begin = chunk * grain;
+        const qsizetype end = std::min(count, begin + grain);
+        enqueue({[&function, &latch, begin, end, cancelled]() {
+            for (qsizetype i = begin; i < end && !(cancelled && cancelled->load()); ++i) {
+                function(i);
+            }
+            latch.countDown();
+        }, &latch}, priority);
+    }
+    help(latch);
+}
+
+template<typename Container, typename Function>
+void TaskPool::blockingMap(Container &container, Function function, Priority priority, const std::atomic_bool *cancelled)
+{
+    blockingFor(qsizetype(container.size()), [&container, &function](qsizetype i) {
+        function(container[i]);
+    }, priority, cancelled);
+}
+
+template<typename T, typename Function>
+auto TaskPool::blockingMapped(const QList<T> &items, Function function, Priority priority)
+{
+    using Result = std::decay_t<std::invoke_result_t<Function, const T &>>;
+    std::vector<std::optional<Result>> values(size_t(items.size()));
+    blockingFor(items.size(), [&items, &function, &values](qsizetype i) {
+        values[size_t(i)].emplace(function(items[i]));
+    }, priority);
+    QList<Result> results;
+    results.reserve(items.size());
+    for (std::optional<Result> &value : values) {
+        results.append(std::move(*value));
+    }
+    return results;
+}
+
+#endif // TASKPOOL_H
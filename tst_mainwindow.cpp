@@ -8,7 +8,192 @@
  */
 
 #include <QtTest>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cmath>
+#include <cstring>
 #include "mainwindow.h"
+#include "playbacklayer.h"
+#include "airquality.h"
+#include "seriesdiff.h"
+#include "geotable.h"
+#include "batchsearch.h"
+#include "sparkline.h"
+#include "watchlist.h"
+#include "lineingest.h"
+#include "giosprovider.h"
+#include "databankimporter.h"
+#include "replybufferpool.h"
+#include "logger.h"
+#include "metrics.h"
+#include "metricsexporter.h"
+#include "memorybenchmark.h"
+#include "reportrenderer.h"
+#include "async.h"
+#include "taskpool.h"
+#include "poolbenchmark.h"
+#include <QCollator>
+#include <QtMath>
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimeZone>
+#include <QtConcurrent>
+
+/**
+ * @class FakeProvider
+ * @brief Provider answering synchronously with fixed data.
+ */
+class FakeProvider : public DataProvider
+{
+public:
+    QString name() const override { return "fake"; }
+
+    void fetchStations(StationsCallback done, const AbortHook & = {}) override
+    {
+        StationRecord station;
+        station.stationId = globalId(7);
+        station.name = "Fałszywa";
+        done({station}, QString());
+    }
+
+    void fetchSensors(int stationId, SensorsCallback done, const AbortHook & = {}) override
+    {
+        SensorInfo info;
+        info.sensorId = globalId(114);
+        info.stationId = stationId;
+        done({info}, QString());
+    }
+
+    void fetchSeries(int sensorId, SeriesCallback done, const AbortHook & = {}) override
+    {
+        Series series;
+        series.timestamps = {1000};
+        series.values = {double(localId(sensorId))};
+        done(series, QString());
+    }
+};
+
+/**
+ * @class ScriptedReply
+ * @brief Network reply whose body is fed by the test.
+ */
+class ScriptedReply : public QNetworkReply
+{
+public:
+    explicit ScriptedReply(qint64 contentLength)
+    {
+        setOpenMode(QIODevice::ReadOnly | QIODevice::Unbuffered);
+        if (contentLength >= 0) {
+            setHeader(QNetworkRequest::ContentLengthHeader, contentLength);
+        }
+    }
+
+    void feed(const QByteArray &data)
+    {
+        m_body += data;
+        emit readyRead();
+    }
+
+    void abort() override {}
+
+    qint64 bytesAvailable() const override { return m_body.size() + QNetworkReply::bytesAvailable(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override
+    {
+        const qint64 size = qMin<qint64>(maxSize, m_body.size());
+        std::memcpy(data, m_body.constData(), size_t(size));
+        m_body.remove(0, size);
+        return size;
+    }
+
+private:
+    QByteArray m_body;
+};
+
+/**
+ * @class ReplayServer
+ * @brief HTTP server answering recorded API replies after a delay.
+ */
+class ReplayServer : public QTcpServer
+{
+public:
+    explicit ReplayServer(int delayMs) : m_delay(delayMs)
+    {
+        connect(this, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket *socket = nextPendingConnection()) {
+                connect(socket, &QTcpSocket::readyRead, socket, [this, socket]() { serve(socket); });
+                connect(socket, &QTcpSocket::disconnected, this, [this]() { ++m_disconnects; });
+            }
+        });
+        listen(QHostAddress::LocalHost);
+    }
+
+    void record(const QByteArray &path, const QByteArray &body) { m_replies.insert(path, body); }
+
+    QUrl url() const { return QUrl(QString("http://127.0.0.1:%1/").arg(serverPort())); }
+
+    int maxPending() const { return m_maxPending; }
+
+    int disconnects() const { return m_disconnects; }
+
+private:
+    void serve(QTcpSocket *socket)
+    {
+        QByteArray &head = m_heads[socket];
+        head += socket->readAll();
+        if (!head.contains("\r\n\r\n")) {
+            return;
+        }
+        const QByteArray path = head.split(' ').value(1);
+        head.clear();
+        m_maxPending = std::max(m_maxPending, ++m_pending);
+        QTimer::singleShot(m_delay, socket, [this, socket, path]() {
+            --m_pending;
+            const bool found = m_replies.contains(path);
+            const QByteArray body = m_replies.value(path, "[]");
+            socket->write(QByteArray(found ? "HTTP/1.1 200 OK\r\n" : "HTTP/1.1 404 Not Found\r\n")
+                          + "Content-Type: application/json\r\nContent-Length: " + QByteArray::number(body.size())
+                          + "\r\n\r\n" + body);
+        });
+    }
+
+    int m_delay;
+    int m_pending = 0;
+    int m_maxPending = 0;
+    int m_disconnects = 0;
+    QHash<QByteArray, QByteArray> m_replies;
+    QHash<QTcpSocket *, QByteArray> m_heads;
+};
+
+/**
+ * @brief Fetches the sensors of a station, then all their series at once.
+ */
+static Async::Task<QList<Async::Result<Series>>> fetchStationSeries(ProviderRegistry *providers, int stationId,
+                                                                   Async::CancelToken token)
+{
+    const Async::Result<QList<SensorInfo>> sensors = co_await Async::sensors(providers, stationId, token);
+    std::vector<Async::Task<Async::Result<Series>>> requests;
+    for (const SensorInfo &info : sensors.value) {
+        requests.push_back(Async::series(providers, info.sensorId, token));
+    }
+    co_return co_await Async::whenAll(std::move(requests));
+}
+
+/**
+ * @brief Builds line protocol points spread over 300 sensors.
+ */
+static QByteArray ingestBulk(int points)
+{
+    QByteArray bulk;
+    for (int i = 0; i < points; ++i) {
+        bulk += QByteArray::number(100 + i % 300) + " " + QByteArray::number(i % 97) + ".5 " + QByteArray::number(1000 + i) + "\n";
+    }
+    return bulk;
+}
 
 /**
  * @class TestMainWindow
@@ -69,6 +254,1594 @@ private slots:
         mainWindow.setSensorData(QVariantMap());
         QCOMPARE(mainWindow.sensorData().size(), 0);
     }
+
+    void testSensorCatalog()
+    {
+        SensorCatalog catalog;
+        catalog.replaceStation(10, {
+            SensorInfo{100, 10, 69, "PM2.5", "PM2.5", "pył zawieszony PM2.5"},
+            SensorInfo{101, 10, 3, "PM10", "PM10", "pył zawieszony PM10"}
+        });
+        catalog.replaceStation(11, { SensorInfo{110, 11, 69, "PM2.5", "PM2.5", "pył zawieszony PM2.5"} });
+
+        QCOMPARE(catalog.count(), 3);
+        QCOMPARE(catalog.sensorsForParam("pm2.5").size(), 2);
+        QCOMPARE(catalog.sensor(110).stationId, 11);
+
+        // Stacja przestała raportować PM2.5
+        catalog.replaceStation(10, { SensorInfo{101, 10, 3, "PM10", "PM10", "pył zawieszony PM10"} });
+        QCOMPARE(catalog.sensorsForParam("PM2.5"), QList<int>{110});
+        QVERIFY(catalog.hasStation(10));
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath("catalog.json");
+        QVERIFY(catalog.save(path));
+
+        SensorCatalog loaded;
+        QVERIFY(loaded.load(path));
+        QCOMPARE(loaded.count(), 2);
+        QCOMPARE(loaded.sensorsForParam("PM10"), QList<int>{101});
+        QCOMPARE(loaded.sensor(101).paramName, QString("pył zawieszony PM10"));
+    }
+
+    void testSeriesStoreTimeJoin()
+    {
+        SeriesStore store;
+        store.merge(1, Series{{1000, 2000, 3000}, {1.0, 2.0, 3.0}});
+        const quint64 version = store.merge(1, Series{{3000, 4000}, {30.0, 40.0}});
+        store.merge(2, Series{{2000, 4000, 5000}, {20.0, 40.0, 50.0}});
+
+        QCOMPARE(store.find(1)->timestamps, (QVector<qint64>{1000, 2000, 3000, 4000}));
+        QCOMPARE(store.find(1)->values[2], 30.0);
+        QCOMPARE(store.version(1), version);
+        QCOMPARE(store.sampleCount(), qsizetype(7));
+
+        AlignedSeries outer = SeriesStore::timeJoin({store.find(1), store.find(2)});
+        QCOMPARE(outer.timestamps.size(), qsizetype(5));
+        QVERIFY(std::isnan(outer.columns[1][0]));
+        QVERIFY(std::isnan(outer.columns[0][4]));
+
+        AlignedSeries inner = SeriesStore::timeJoin({store.find(1), store.find(2)}, SeriesStore::InnerJoin);
+        QCOMPARE(inner.timestamps, (QVector<qint64>{2000, 4000}));
+        QCOMPARE(inner.columns[1], (QVector<double>{20.0, 40.0}));
+    }
+
+    void testExpression()
+    {
+        QString error;
+        Expression ratio = Expression::parse("S1 / s2 * (2 + 2)", &error);
+        QVERIFY2(ratio.isValid(), qPrintable(error));
+        QCOMPARE(ratio.text(), QString("(s1 / s2) * (2 + 2)"));
+        QCOMPARE(ratio.sensorIds(), (QList<int>{1, 2}));
+
+        const QVector<double> result = ratio.evaluate({{10.0, 9.0, qQNaN()}, {5.0, 3.0, 1.0}});
+        QCOMPARE(result[0], 8.0);
+        QCOMPARE(result[1], 12.0);
+        QVERIFY(std::isnan(result[2]));
+
+        Expression minimum = Expression::parse("max(s3 - 10, 0)");
+        QCOMPARE(minimum.evaluate({{5.0, 15.0}}), (QVector<double>{0.0, 5.0}));
+
+        QVERIFY(!Expression::parse("s1 +", &error).isValid());
+        QVERIFY(!error.isEmpty());
+        QVERIFY(!Expression::parse("2 * 3").isValid());
+        QVERIFY(!Expression::parse("foo(s1)").isValid());
+
+        SeriesStore store;
+        store.merge(1, Series{{1000, 2000}, {10.0, 20.0}});
+        store.merge(2, Series{{1000, 2000}, {5.0, 4.0}});
+        DerivedSeriesEngine engine(&store);
+        Series derived;
+        QVERIFY(engine.evaluate(ratio, &derived));
+        QCOMPARE(derived.values, (QVector<double>{8.0, 20.0}));
+        QVERIFY(engine.evaluate(ratio, &derived));
+        QCOMPARE(engine.cacheHits(), quint64(1));
+
+        store.merge(2, Series{{2000}, {10.0}});
+        QVERIFY(engine.evaluate(ratio, &derived));
+        QCOMPARE(engine.cacheHits(), quint64(1));
+        QCOMPARE(derived.values[1], 8.0);
+    }
+
+    void testCorrelation()
+    {
+        const QVector<QVector<double>> columns = {
+            {1.0, 2.0, 3.0, 4.0, 5.0},
+            {2.0, 4.0, 6.0, 8.0, 10.0},
+            {5.0, 4.0, 3.0, 2.0, 1.0},
+            {1.0, 4.0, 9.0, 16.0, 25.0},
+            {7.0, 7.0, 7.0, 7.0, 7.0}
+        };
+
+        const QVector<float> pearson = Correlation::compute(columns, Correlation::Pearson);
+        QCOMPARE(pearson.size(), qsizetype(25));
+        QVERIFY(qAbs(pearson[0 * 5 + 1] - 1.0f) < 1e-5f);
+        QVERIFY(qAbs(pearson[2 * 5 + 0] + 1.0f) < 1e-5f);
+        QVERIFY(pearson[0 * 5 + 3] < 0.99f);
+        QVERIFY(std::isnan(pearson[4 * 5 + 0]));
+        QCOMPARE(pearson[1 * 5 + 2], pearson[2 * 5 + 1]);
+
+        // Zależność monotoniczna ma korelację rang równą 1
+        const QVector<float> spearman = Correlation::compute(columns, Correlation::Spearman);
+        QVERIFY(qAbs(spearman[0 * 5 + 3] - 1.0f) < 1e-5f);
+
+        // Ustawiona flaga przerywa obliczenie
+        const std::atomic_bool cancelled{true};
+        QVERIFY(Correlation::compute(columns, Correlation::Pearson, &cancelled).isEmpty());
+
+        CorrelationModel model;
+        model.setMatrix({"a", "b", "c", "d", "e"}, pearson);
+        QCOMPARE(model.rowCount(), 5);
+        QCOMPARE(model.image().size(), QSize(5, 5));
+        QCOMPARE(model.data(model.index(0, 1), CorrelationModel::ColorRole).value<QColor>(), QColor(255, 0, 0));
+    }
+
+    void testHoltWintersForecast()
+    {
+        // Cztery doby z dobowym cyklem
+        Series series;
+        for (int h = 0; h < 96; ++h) {
+            series.timestamps.append(h * HoltWinters::HourMs);
+            series.values.append(50.0 + 10.0 * std::sin(2.0 * M_PI * h / 24.0));
+        }
+
+        HoltWinters full;
+        full.update(series);
+        QVERIFY(full.isFitted());
+        const Forecast forecast = full.forecast(24);
+        QCOMPARE(forecast.mean.size(), qsizetype(24));
+        QCOMPARE(forecast.mean.timestamps.first(), 96 * HoltWinters::HourMs);
+        for (int h = 0; h < 24; ++h) {
+            const double expected = 50.0 + 10.0 * std::sin(2.0 * M_PI * (96 + h) / 24.0);
+            QVERIFY(qAbs(forecast.mean.values[h] - expected) < 3.0);
+            QVERIFY(forecast.lower[h] <= forecast.mean.values[h]);
+            QVERIFY(forecast.upper[h] >= forecast.mean.values[h]);
+        }
+
+        // Dopasowanie przyrostowe daje ten sam model co pełne
+        HoltWinters incremental;
+        incremental.update(SeriesStore::slice(series, 0, 71 * HoltWinters::HourMs));
+        QCOMPARE(incremental.lastTimestamp(), 71 * HoltWinters::HourMs);
+        incremental.update(series);
+        QCOMPARE(incremental.forecast(24).mean.values, forecast.mean.values);
+
+        HoltWinters tooShort;
+        tooShort.update(SeriesStore::slice(series, 0, 30 * HoltWinters::HourMs));
+        QVERIFY(!tooShort.isFitted());
+    }
+
+    void testPlaybackFrames()
+    {
+        const qint64 hour = PlaybackEngine::HourMs;
+        const qint64 end = 1000 * hour;
+
+        // Stacja 1: stała wartość, stacja 2: przerwa dłuższa niż MaxGapHours
+        Series steady;
+        Series gappy;
+        for (int h = 0; h < PlaybackEngine::Hours; ++h) {
+            const qint64 t = end - h * hour;
+            steady.timestamps.prepend(t);
+            steady.values.prepend(10.0);
+            if (h < 5 || h > 20) {
+                gappy.timestamps.prepend(t);
+                gappy.values.prepend(200.0);
+            }
+        }
+
+        PlaybackEngine engine;
+        engine.build("PM10", {{1, 52.0, 21.0, &steady}, {2, 50.0, 19.0, &gappy}});
+        QCOMPARE(engine.frameCount(), PlaybackEngine::Hours);
+        QCOMPARE(engine.stationCount(), 2);
+        QCOMPARE(engine.frameTimestamp(PlaybackEngine::Hours - 1), end);
+
+        engine.setFrame(PlaybackEngine::Hours - 1);
+        QCOMPARE(engine.valueOf(1), 10.0);
+        QCOMPARE(engine.currentColors()[0], AirQuality::color(0));
+        QCOMPARE(engine.currentColors()[1], AirQuality::color(5));
+
+        // Wartość podtrzymana przez dwie godziny, potem brak danych
+        engine.setFrame(PlaybackEngine::Hours - 1 - 22);
+        QCOMPARE(engine.valueOf(2), 200.0);
+        engine.setFrame(PlaybackEngine::Hours - 1 - 10);
+        QVERIFY(std::isnan(engine.valueOf(2)));
+        QCOMPARE(engine.currentColors()[1], AirQuality::color(-1));
+
+        // Przebudowa zachowuje bieżącą klatkę
+        const int frame = engine.frame();
+        engine.build("PM10", {{1, 52.0, 21.0, &steady}});
+        QCOMPARE(engine.frame(), frame);
+        QCOMPARE(engine.stationCount(), 1);
+
+        const QPointF origin = PlaybackLayer::project(0.0, 0.0, 0.0);
+        QCOMPARE(origin, QPointF(128.0, 128.0));
+        QVERIFY(PlaybackLayer::project(52.0, 21.0, 8.0).y() < PlaybackLayer::project(50.0, 21.0, 8.0).y());
+    }
+
+    void testArchiveRollups()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        LocalArchive archive(dir.path());
+
+        // Trzy doby przez granicę miesiąca: 30.01, 31.01 i 01.02
+        const qint64 start = QDate(2026, 1, 30).startOfDay().toMSecsSinceEpoch();
+        const qint64 hour = 3600 * 1000;
+        Series series;
+        for (int d = 0; d < 3; ++d) {
+            for (int h = 0; h < 24; ++h) {
+                series.timestamps.append(start + (d * 24 + h) * hour);
+                series.values.append(d * 10 + h);
+            }
+        }
+        QCOMPARE(archive.append(7, series), 72);
+        QCOMPARE(archive.append(7, series), 0);
+        QCOMPARE(archive.sensorIds(), QList<int>{7});
+
+        const qint64 end = start + 72 * hour;
+        QCOMPARE(archive.read(7, start, end, LocalArchive::Hourly).size(), qsizetype(72));
+
+        const ArchiveSeries daily = archive.read(7, start, end, LocalArchive::Daily);
+        QCOMPARE(daily.size(), qsizetype(3));
+        QCOMPARE(daily.min[1], 10.0);
+        QCOMPARE(daily.max[1], 33.0);
+        QCOMPARE(daily.mean[1], 21.5);
+        QCOMPARE(daily.counts[1], 24);
+
+        const ArchiveSeries monthly = archive.read(7, LocalArchive::bucketStart(start, LocalArchive::Monthly), end, LocalArchive::Monthly);
+        QCOMPARE(monthly.size(), qsizetype(2));
+        QCOMPARE(monthly.counts[0], 48);
+        QCOMPARE(monthly.max[0], 33.0);
+        QCOMPARE(monthly.min[1], 20.0);
+
+        // Poprawka jednej próbki przelicza tylko jej dobę i miesiąc
+        Series revision;
+        revision.timestamps.append(start);
+        revision.values.append(100.0);
+        QCOMPARE(archive.append(7, revision), 1);
+        QCOMPARE(archive.read(7, start, end, LocalArchive::Daily).max[0], 100.0);
+        QCOMPARE(archive.read(7, LocalArchive::bucketStart(start, LocalArchive::Monthly), end, LocalArchive::Monthly).max[0], 100.0);
+
+        QCOMPARE(LocalArchive::chooseResolution(0, 72 * hour, 600), LocalArchive::Hourly);
+        QCOMPARE(LocalArchive::chooseResolution(0, 8760 * hour, 600), LocalArchive::Daily);
+        QCOMPARE(LocalArchive::chooseResolution(0, 10 * 8760 * hour, 600), LocalArchive::Monthly);
+    }
+
+    void testArchiveMaintenance()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        LocalArchive archive(dir.path() + "/archive");
+        ArchiveMaintenance maintenance(&archive);
+
+        // Dwa nakładające się zapisy tej samej stacji i jeden uszkodzony plik
+        auto writeLegacy = [&](const QString &name, const QList<QPair<QString, double>> &points) {
+            QJsonArray measurements;
+            for (const auto &point : points) {
+                QJsonObject measurement;
+                measurement["date"] = point.first;
+                measurement["value"] = point.second;
+                measurements.append(measurement);
+            }
+            QJsonObject sensor;
+            sensor["sensorId"] = 5;
+            sensor["measurements"] = measurements;
+            QJsonObject root;
+            root["sensors"] = QJsonArray{sensor};
+            QFile file(dir.filePath(name));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(QJsonDocument(root).toJson());
+        };
+        writeLegacy("station_114_20260301_120000.json", {{"2026-03-01 10:00:00", 10.0}, {"2026-03-01 11:00:00", 11.0}});
+        writeLegacy("station_114_20260301_130000.json", {{"2026-03-01 11:00:00", 15.0}, {"2026-03-01 12:00:00", 12.0}});
+        QFile broken(dir.filePath("station_114_20260302_080000.json"));
+        QVERIFY(broken.open(QIODevice::WriteOnly));
+        broken.write("{ niepoprawny");
+        broken.close();
+
+        const MaintenanceReport first = maintenance.run(dir.path());
+        QCOMPARE(first.filesImported, 2);
+        QCOMPARE(first.filesFailed, 1);
+        QCOMPARE(first.samplesImported, qint64(3));
+        QVERIFY(!first.interrupted);
+
+        const qint64 day = QDate(2026, 3, 1).startOfDay().toMSecsSinceEpoch();
+        const ArchiveSeries imported = archive.read(5, day, day + 86400000, LocalArchive::Hourly);
+        QCOMPARE(imported.size(), qsizetype(3));
+        QCOMPARE(imported.mean[1], 15.0);
+
+        // Dziennik pomija pliki już przetworzone
+        const MaintenanceReport second = maintenance.run(dir.path());
+        QCOMPARE(second.filesImported, 0);
+        QCOMPARE(second.filesSkipped, 3);
+
+        // Mały miesiąc zamkniętego roku trafia do segmentu rocznego
+        const qint64 old = QDate(2024, 3, 1).startOfDay().toMSecsSinceEpoch();
+        Series series;
+        series.timestamps = {old, old + 3600000, old + 7200000};
+        series.values = {1.0, 2.0, 3.0};
+        QCOMPARE(archive.append(5, series), 3);
+        const qint64 now = QDate(2026, 10, 18).startOfDay().toMSecsSinceEpoch();
+        QCOMPARE(archive.compact(5, now), 1);
+        QCOMPARE(archive.compact(5, now), 0);
+        QCOMPARE(archive.read(5, old, old + 86400000, LocalArchive::Hourly).size(), qsizetype(3));
+
+        // Retencja usuwa surowe dane, agregaty dzienne zostają
+        RetentionPolicy retention;
+        retention.hourlyDays = 365;
+        archive.setRetention(retention);
+        QCOMPARE(archive.applyRetention(5, now), qint64(3));
+        QVERIFY(archive.read(5, old, old + 86400000, LocalArchive::Hourly).isEmpty());
+        QCOMPARE(archive.read(5, old, old + 86400000, LocalArchive::Daily).counts[0], 3);
+        QCOMPARE(archive.read(5, day, day + 86400000, LocalArchive::Hourly).size(), qsizetype(3));
+    }
+
+    void testArchiveQuery()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        LocalArchive archive(dir.path());
+
+        // Dziesięć dni przez granicę miesiąca, wartość równa numerowi godziny
+        const qint64 start = QDate(2026, 4, 25).startOfDay().toMSecsSinceEpoch();
+        const qint64 hour = 3600 * 1000;
+        Series series;
+        for (int h = 0; h < 240; ++h) {
+            series.timestamps.append(start + h * hour);
+            series.values.append(h);
+        }
+        QCOMPARE(archive.append(9, series), 240);
+
+        // Okno wycięte wyszukiwaniem binarnym z dwóch segmentów miesięcznych
+        const ArchiveView view = archive.series(9, start + 100 * hour, start + 199 * hour, LocalArchive::Hourly);
+        QCOMPARE(view.size(), qsizetype(100));
+        QCOMPARE(view.blocks().size(), qsizetype(2));
+        QCOMPARE(view.blocks().first().timestamps[0], start + 100 * hour);
+        QCOMPARE(view.blocks().first().columns[0][0], 100.0);
+        QCOMPARE(view.blocks().last().columns[0][view.blocks().last().size - 1], 199.0);
+#ifndef Q_OS_WIN
+        QCOMPARE(view.mappedBlocks(), 2);
+#endif
+
+        const ArchiveSeries daily = archive.series(9, start, start + 240 * hour, LocalArchive::Daily).toSeries();
+        QCOMPARE(daily.size(), qsizetype(10));
+        QCOMPARE(daily.mean[9], 227.5);
+        QVERIFY(archive.series(9, start + 240 * hour, start + 300 * hour, LocalArchive::Hourly).isEmpty());
+
+        // Widok zachowuje dane sprzed późniejszej poprawki
+        Series revision;
+        revision.timestamps.append(start + 100 * hour);
+        revision.values.append(-1.0);
+        QCOMPARE(archive.append(9, revision), 1);
+        QCOMPARE(view.blocks().first().columns[0][0], 100.0);
+        QCOMPARE(archive.read(9, start + 100 * hour, start + 100 * hour, LocalArchive::Hourly).mean[0], -1.0);
+    }
+
+    void testSeriesDiff()
+    {
+        const double nan = std::nan("");
+        Series archived;
+        archived.timestamps = {1000, 2000, 3000, 4000, 5000};
+        archived.values = {1.0, 2.0, nan, 4.0, 5.0};
+        Series live;
+        live.timestamps = {2000, 3000, 4000, 5000, 6000};
+        live.values = {2.0, 3.5, nan, 5.5, 6.0};
+
+        // Próbki 1000 i 6000 leżą poza wspólnym zakresem i nie są rewizjami
+        const SeriesDiff diff = SeriesDiff::compute(archived, live);
+        QCOMPARE(diff.size(), qsizetype(3));
+        QCOMPARE(diff.unchanged, 1);
+        QCOMPARE(diff.added, 1);
+        QCOMPARE(diff.removed, 1);
+        QCOMPARE(diff.changed, 1);
+        QCOMPARE(diff.timestamps, (QVector<qint64>{3000, 4000, 5000}));
+        QCOMPARE(diff.kinds[0], SeriesDiff::Added);
+        QCOMPARE(diff.kinds[1], SeriesDiff::Removed);
+        QCOMPARE(diff.live[2], 5.5);
+        QCOMPARE(diff.archived[2], 5.0);
+
+        const QVariantList list = diff.toVariantList();
+        QCOMPARE(list.first().toMap()["kind"].toString(), QString("changed"));
+        QVERIFY(list.last().toMap()["archived"].isNull());
+
+        QCOMPARE(SeriesDiff::compute(archived, Series()).size(), qsizetype(0));
+    }
+
+    void testWriteAheadLog()
+    {
+        QCOMPARE(WriteAheadLog::crc32c("123456789", 9), quint32(0xE3069283));
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath("test.wal");
+        {
+            WriteAheadLog log(path);
+            log.setSyncPolicy(WriteAheadLog::SyncAlways);
+            QVERIFY(log.append("pierwszy"));
+            QVERIFY(log.append("drugi"));
+        }
+        const qint64 intact = QFileInfo(path).size();
+
+        // Urwany nagłówek i ładunek na końcu, jak po awarii zasilania
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::Append));
+        file.write(QByteArray("\x20\x00\x00\x00\x01\x02\x03\x04torn", 12));
+        file.close();
+
+        WriteAheadLog log(path);
+        qint64 truncated = 0;
+        bool ok = false;
+        QCOMPARE(log.recover(&truncated, &ok), (QList<QByteArray>{"pierwszy", "drugi"}));
+        QVERIFY(ok);
+        QCOMPARE(truncated, qint64(12));
+        QCOMPARE(QFileInfo(path).size(), intact);
+
+        // Przekłamany bajt odrzuca rekord i wszystkie następne
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        file.seek(WriteAheadLog::HeaderSize + 1);
+        file.write("X");
+        file.close();
+        QVERIFY(log.recover(&truncated, &ok).isEmpty());
+        QCOMPARE(QFileInfo(path).size(), qint64(0));
+
+        WriteAheadLog::SyncPolicy policy = WriteAheadLog::SyncNever;
+        int interval = 1000;
+        QVERIFY(WriteAheadLog::parseSyncPolicy("periodic:250", &policy, &interval));
+        QCOMPARE(policy, WriteAheadLog::SyncPeriodic);
+        QCOMPARE(interval, 250);
+        QVERIFY(!WriteAheadLog::parseSyncPolicy("czasami", &policy, &interval));
+
+        // Archiwum odtwarza z dziennika miesiąc, którego segmenty zginęły
+        const qint64 start = QDate(2026, 5, 1).startOfDay().toMSecsSinceEpoch();
+        Series series;
+        series.timestamps = {start, start + 3600000};
+        series.values = {4.0, 6.0};
+        {
+            LocalArchive archive(dir.filePath("archive"));
+            QCOMPARE(archive.append(3, series), 2);
+        }
+        QVERIFY(QDir(dir.filePath("archive/3")).removeRecursively());
+        LocalArchive archive(dir.filePath("archive"));
+        QCOMPARE(archive.recover(), 1);
+        QCOMPARE(archive.read(3, start, start + 86400000, LocalArchive::Daily).mean[0], 5.0);
+        QCOMPARE(archive.recover(), 0);
+
+        // Awaria po zapisie segmentu surowego, a przed agregatami: odtworzenie je przelicza
+        series.values = {8.0, 10.0};
+        {
+            LocalArchive crashed(dir.filePath("archive"));
+            QCOMPARE(crashed.append(3, series), 2);
+        }
+        const QString dailyPath = dir.filePath("archive/3/daily-2026.seg");
+        const QString monthlyPath = dir.filePath("archive/3/monthly.seg");
+        QVERIFY(QFile::remove(dailyPath));
+        QVERIFY(QFile::remove(monthlyPath));
+        LocalArchive restarted(dir.filePath("archive"));
+        QCOMPARE(restarted.recover(), 1);
+        QCOMPARE(restarted.read(3, start, start + 86400000, LocalArchive::Daily).mean, QVector<double>({9.0}));
+        QCOMPARE(restarted.read(3, start, start + 86400000, LocalArchive::Monthly).max, QVector<double>({10.0}));
+
+        // Punkt kontrolny synchronizuje katalogi segmentów przed wyczyszczeniem dziennika
+        QVERIFY(WriteAheadLog::syncDirectory(dir.filePath("archive/3")));
+        QVERIFY(!WriteAheadLog::syncDirectory(dir.filePath("brak")));
+        {
+            LocalArchive synced(dir.filePath("synced"));
+            synced.setSyncPolicy(WriteAheadLog::SyncAlways);
+            QCOMPARE(synced.append(5, series), 2);
+        }
+        LocalArchive synced(dir.filePath("synced"));
+        synced.setSyncPolicy(WriteAheadLog::SyncAlways);
+        QCOMPARE(synced.recover(), 1);
+        QCOMPARE(synced.recover(), 0);
+    }
+
+    void testStationSortFilter()
+    {
+        Station a(1, "Kraków, Bujaka", "Kraków", "ul. Bujaka", 50.01, 19.93, true, nullptr);
+        Station b(2, "Warszawa, Marszałkowska", "Warszawa", "ul. Marszałkowska", 52.22, 21.01, true, nullptr);
+        Station c(3, "Łódź, Czernika", "Łódź", "ul. Czernika", 51.75, 19.53, true, nullptr);
+        StationSortFilterModel model;
+        model.setSearchPoint(QGeoCoordinate(52.23, 21.01));
+        model.setStations({&a, &b, &c});
+        QCOMPARE(model.count(), 3);
+
+        // Porządek miast jak w QCollator dla polskiego; bez ICU Ł może nie trafić między L a W
+        QCollator polish(QLocale(QLocale::Polish, QLocale::Poland));
+        polish.setCaseSensitivity(Qt::CaseInsensitive);
+        QList<const Station *> byCity = {&a, &b, &c};
+        std::sort(byCity.begin(), byCity.end(), [&polish](const Station *x, const Station *y) {
+            return polish.compare(x->cityName(), y->cityName()) < 0;
+        });
+        model.setSortKey(StationSortFilterModel::City);
+        for (int i = 0; i < byCity.size(); ++i) {
+            QCOMPARE(model.stationIdAt(i), byCity[i]->stationId());
+        }
+
+        model.setSortKey(StationSortFilterModel::Distance);
+        QCOMPARE(model.stationIdAt(0), 2);
+        QCOMPARE(model.stationIdAt(2), 1);
+
+        // Zmiana jednej wartości przesuwa stację bez ponownego sortowania
+        model.setSortKey(StationSortFilterModel::LatestValue);
+        model.setLatestValue(1, 30.0, 2);
+        model.setLatestValue(2, 10.0, 0);
+        const int sorts = model.sortCount();
+        QCOMPARE(model.stationIdAt(0), 2);
+        QCOMPARE(model.stationIdAt(2), 3);
+        QSignalSpy moved(&model, &QAbstractItemModel::rowsMoved);
+        QSignalSpy layout(&model, &QAbstractItemModel::layoutChanged);
+        model.setLatestValue(2, 50.0, 3);
+        QCOMPARE(model.stationIdAt(0), 1);
+        QCOMPARE(model.stationIdAt(1), 2);
+        QCOMPARE(model.sortCount(), sorts);
+        QCOMPARE(moved.count(), 1);
+        QCOMPARE(layout.count(), 0);
+
+        // Stacje bez odczytu zostają na końcu również malejąco
+        model.setDescending(true);
+        QCOMPARE(model.stationIdAt(0), 2);
+        QCOMPARE(model.stationIdAt(2), 3);
+        QCOMPARE(model.sortCount(), sorts);
+
+        model.setFilterText("MARSZ");
+        QCOMPARE(model.count(), 1);
+        QCOMPARE(model.data(model.index(0), StationSortFilterModel::IndexRole).toInt(), 3);
+        model.setFilterText(QString());
+        QCOMPARE(model.count(), 3);
+    }
+
+    void testGeoTableRadius()
+    {
+        GeoTable table;
+        table.append(50.06, 19.94);  // Kraków
+        table.append(52.23, 21.01);  // Warszawa
+        table.append(52.41, 16.93);  // Poznań
+        table.append(52.24, 21.05);  // Warszawa, Targówek
+
+        // Haversine zgadza się z QGeoCoordinate z dokładnością do 0,5%
+        QVector<double> distances(table.size());
+        table.distances(52.23, 21.01, distances.data());
+        const double expected = QGeoCoordinate(52.23, 21.01).distanceTo(QGeoCoordinate(50.06, 19.94)) / 1000.0;
+        QVERIFY(std::abs(distances[0] - expected) < expected * 0.005);
+        QCOMPARE(distances[1], 0.0);
+
+        const QVector<GeoTable::Hit> hits = table.within(52.23, 21.01, 265.0);
+        QCOMPARE(hits.size(), qsizetype(3));
+        QCOMPARE(hits[0].index, 1);
+        QCOMPARE(hits[1].index, 3);
+        QCOMPARE(hits[2].index, 0);
+        QVERIFY(hits[1].distance < 5.0);
+
+        QCOMPARE(table.within(52.23, 21.01, 1.0).size(), qsizetype(1));
+        QCOMPARE(table.within(52.23, 21.01, 50000.0).size(), qsizetype(4));
+    }
+
+    void testBatchSearchLocal()
+    {
+        Station a(1, "Kraków, Bujaka", "Kraków", "", 50.01, 19.93, false, nullptr);
+        Station b(2, "Kraków, Bulwarowa", "Kraków", "", 50.07, 20.05, false, nullptr);
+        Station c(3, "Skawina", "Skawina", "", 49.97, 19.83, false, nullptr);
+        Station d(4, "Warszawa", "Warszawa", "", 52.22, 21.01, false, nullptr);
+        QNetworkAccessManager network;
+        BatchSearchModel model(&network);
+        model.setStations({&a, &b, &c, &d});
+
+        // Miasta ze znanymi stacjami nie wymagają geokodowania
+        QSignalSpy finished(&model, &BatchSearchModel::finished);
+        model.search({"kraków", " ", "Warszawa", "KRAKÓW"});
+        QCOMPARE(finished.count(), 1);
+        QCOMPARE(model.count(), 3);
+        QCOMPARE(model.pending(), 0);
+        QCOMPARE(model.data(model.index(0), BatchSearchModel::StateRole).toInt(), int(BatchSearchModel::Local));
+        QCOMPARE(model.stationIds(0).size(), qsizetype(2));
+        QCOMPARE(model.stationIds(1), QList<int>{4});
+        QCOMPARE(model.stationIds(2), model.stationIds(0));
+        QCOMPARE(model.stationCount(), 5);
+
+        model.search({"Kraków"}, 30.0);
+        QCOMPARE(model.stationIds(0).size(), qsizetype(3));
+        QCOMPARE(model.stationIds(0).last(), 3);
+    }
+
+    void testSparklineCache()
+    {
+        const qint64 hour = SparklineCache::HourMs;
+        const qint64 end = 1000 * hour;
+        Series series;
+        for (int h = 0; h < 100; ++h) {
+            series.timestamps.append(end - (99 - h) * hour);
+            series.values.append(h == 50 ? std::nan("") : double(h % 10));
+        }
+        SeriesStore store;
+        store.merge(7, series);
+
+        // Wykresy liczone są dopiero na żądanie widocznego wiersza
+        SparklineCache cache(&store);
+        cache.setWindowEnd(end);
+        cache.setParam("PM10", {{1, 7}});
+        QCOMPARE(cache.computeCount(), 0);
+        const QVector<QPointF> points = cache.points(1, 200);
+        QCOMPARE(points.size(), qsizetype(SparklineCache::Hours));
+        QCOMPARE(points.last(), QPointF(1.0, 1.0));
+        QVERIFY(cache.points(2, 200).isEmpty());
+        cache.points(1, 200);
+        QCOMPARE(cache.computeCount(), 1);
+
+        QSignalSpy changed(&cache, &SparklineCache::changed);
+        store.merge(7, series);
+        cache.sensorUpdated(7);
+        cache.sensorUpdated(8);
+        QCOMPARE(changed.count(), 1);
+        cache.points(1, 200);
+        QCOMPARE(cache.computeCount(), 2);
+
+        // Zmniejszenie rozdzielczości zachowuje minimum i maksimum przedziałów
+        const QVector<QPointF> reduced = SparklineCache::downsample(series, end - 72 * hour, end, 8);
+        QVERIFY(reduced.size() <= 16);
+        QCOMPARE(std::min_element(reduced.cbegin(), reduced.cend(), [](const QPointF &a, const QPointF &b) { return a.y() < b.y(); })->y(), 0.0);
+        QCOMPARE(std::max_element(reduced.cbegin(), reduced.cend(), [](const QPointF &a, const QPointF &b) { return a.y() < b.y(); })->y(), 1.0);
+    }
+
+    void testWatchListBatch()
+    {
+        const qint64 hour = SparklineCache::HourMs;
+        Series rising;
+        rising.timestamps = {hour, 2 * hour, 3 * hour};
+        rising.values = {10.0, 20.0, 60.0};
+        Series falling;
+        falling.timestamps = {hour, 2 * hour, 3 * hour};
+        falling.values = {200.0, std::nan(""), 100.0};
+        SeriesStore store;
+        store.merge(11, rising);
+
+        WatchList list(&store);
+        list.setParam("PM10");
+        QVERIFY(list.add(1, 11, "Stacja A"));
+        QVERIFY(list.add(2, 22, "Stacja B"));
+        QVERIFY(list.add(3, -1, "Bez czujnika"));
+        QVERIFY(!list.add(1, 11, "Stacja A"));
+        QVERIFY(list.contains(2));
+        QCOMPARE(list.stationIdAt(1), 2);
+        QCOMPARE(list.sensorIds(), QList<int>({11, 22}));
+        QVERIFY(std::isnan(list.tiles()[1].value));
+
+        // Odpowiedzi jednego cyklu publikowane są jednym sygnałem
+        QSignalSpy updated(&list, &WatchList::tilesUpdated);
+        QCOMPARE(list.beginRefresh(list.sensorIds()), QList<int>({11, 22}));
+        const int cycle = list.cycle();
+        store.merge(22, falling);
+        list.sensorRefreshed(cycle, 22);
+        QCOMPARE(updated.count(), 0);
+
+        // Odświeżenie w trakcie cyklu dołącza do niego bez ponownych zapytań
+        QCOMPARE(list.beginRefresh({22, 11}), QList<int>({11}));
+        QCOMPARE(list.cycle(), cycle);
+        list.sensorRefreshed(cycle, 11);
+        QCOMPARE(updated.count(), 1);
+        QCOMPARE(updated.first().first().value<QList<int>>(), QList<int>({0, 1, 2}));
+        QVERIFY(!list.lastRefresh().isEmpty());
+
+        const WatchTile &a = list.tiles()[0];
+        QCOMPARE(a.value, 60.0);
+        QCOMPARE(a.previous, 20.0);
+        QCOMPARE(a.trend, WatchTile::Rising);
+        QCOMPARE(a.level, AirQuality::level("PM10", 60.0));
+        QCOMPARE(a.sparkline.last(), QPointF(1.0, 1.0));
+        const WatchTile &b = list.tiles()[1];
+        QCOMPARE(b.previous, 200.0);
+        QCOMPARE(b.trend, WatchTile::Falling);
+        QCOMPARE(list.tiles()[2].level, -1);
+
+        // Spóźniona odpowiedź poprzedniego cyklu nie zamyka następnego
+        list.sensorRefreshed(cycle, 22);
+        QCOMPARE(updated.count(), 1);
+        QCOMPARE(list.beginRefresh({11, 22}).size(), qsizetype(2));
+        QVERIFY(list.cycle() != cycle);
+        list.sensorRefreshed(cycle, 11);
+        list.sensorRefreshed(cycle, 22);
+        QCOMPARE(updated.count(), 1);
+        list.sensorRefreshed(list.cycle(), 11);
+        list.sensorRefreshed(list.cycle(), 22);
+        QCOMPARE(updated.count(), 2);
+
+        QTemporaryDir dir;
+        const QString path = dir.filePath("watchlist.json");
+        QVERIFY(list.remove(2));
+        QCOMPARE(list.stationIdAt(1), 3);
+        QVERIFY(list.save(path));
+        WatchList loaded(&store);
+        QVERIFY(loaded.load(path));
+        QCOMPARE(loaded.param(), QString("PM10"));
+        QCOMPARE(loaded.count(), 2);
+        QCOMPARE(loaded.tiles()[0].value, 60.0);
+
+        for (int id = 100; loaded.count() < WatchList::MaxTiles; ++id) {
+            QVERIFY(loaded.add(id, -1, QString()));
+        }
+        QVERIFY(!loaded.add(1000, -1, QString()));
+    }
+
+    void testLineIngest()
+    {
+        SeriesStore store;
+        LineIngest ingest(&store);
+        QSignalSpy stations(&ingest, &LineIngest::stationDeclared);
+        QSignalSpy sensors(&ingest, &LineIngest::sensorDeclared);
+        QSignalSpy updated(&ingest, &LineIngest::sensorsUpdated);
+
+        // Ostatni, niepełny wiersz zostaje w buforze
+        const QByteArray data = "station 900001 50.06 19.94 Nowa Huta\n"
+                                "sensor 9000011 900001 PM10\n"
+                                "# komentarz\n"
+                                "9000011 12.5 3000\n"
+                                "9000011 10.0 1000\n"
+                                "9000011 11.0 2000\n"
+                                "9000011 99 2000\n"
+                                "9000011 1,5 5000\n"
+                                "9000011 7.5 4000\r\n"
+                                "9000011 8";
+        QCOMPARE(ingest.parse(data.constData(), data.size()), data.size() - 9);
+        QCOMPARE(stations.count(), 1);
+        QCOMPARE(sensors.count(), 1);
+        QCOMPARE(ingest.stations().value(900001).name, QString("Nowa Huta"));
+        QCOMPARE(ingest.acceptedPoints(), quint64(5));
+        QCOMPARE(ingest.rejectedLines(), quint64(1));
+        QCOMPARE(updated.count(), 0);
+
+        // Punkty jednego czujnika scalane są raz, posortowane i bez powtórzeń
+        ingest.flush();
+        QCOMPARE(updated.count(), 1);
+        const Series *series = store.find(9000011);
+        QVERIFY(series);
+        QCOMPARE(series->timestamps, QVector<qint64>({1000, 2000, 3000, 4000}));
+        QCOMPARE(series->values, QVector<double>({10.0, 99.0, 12.5, 7.5}));
+
+        // Po przekroczeniu limitu czytanie czeka na scalenie
+        ingest.setMaxPendingPoints(2);
+        const QByteArray burst = "7 1 1\n7 2 2\n7 3 3\n";
+        const qsizetype consumed = ingest.parse(burst.constData(), burst.size());
+        QCOMPARE(consumed, qsizetype(12));
+        QVERIFY(ingest.isPaused());
+        ingest.flush();
+        QVERIFY(!ingest.isPaused());
+        ingest.parse(burst.constData() + consumed, burst.size() - consumed);
+        ingest.flush();
+        QCOMPARE(store.find(7)->size(), qsizetype(3));
+
+        // Duża paczka wielu czujników naraz
+        ingest.setMaxPendingPoints(LineIngest::DefaultMaxPendingPoints);
+        const QByteArray bulk = ingestBulk(100000);
+        QCOMPARE(ingest.parse(bulk.constData(), bulk.size()), bulk.size());
+        ingest.flush();
+        QCOMPARE(store.find(100)->size(), qsizetype(334));
+
+        // Ten sam protokół przez gniazdo TCP na localhost
+        QVERIFY(ingest.listen(0));
+        QTcpSocket client;
+        client.connectToHost(QHostAddress::LocalHost, ingest.serverPort());
+        QVERIFY(client.waitForConnected(3000));
+        for (int i = 0; i < 1000; ++i) {
+            client.write("42 " + QByteArray::number(i) + " " + QByteArray::number(1000 + i) + "\n");
+        }
+        client.write("42 5 9999");
+        client.disconnectFromHost();
+        QTRY_VERIFY(store.find(42) && store.find(42)->size() == 1001);
+        QCOMPARE(store.find(42)->values.last(), 5.0);
+
+        // Zarejestrowany po GIOŚ odbiór ma własną przestrzeń identyfikatorów
+        QNetworkAccessManager network;
+        ProviderRegistry registry;
+        registry.add(new GiosProvider(&network));
+        auto *local = new LineIngest(&store);
+        QCOMPARE(registry.add(local), 1);
+        const QByteArray declared = "station 114 50.0 20.0 Ogród\nsensor 92 114 PM10\n92 3.5 1000\n";
+        QCOMPARE(local->parse(declared.constData(), declared.size()), declared.size());
+        local->flush();
+        const int sensorId = local->globalId(92);
+        QCOMPARE(DataProvider::providerIndex(sensorId), 1);
+        QVERIFY(!store.contains(92));
+        QCOMPARE(store.find(sensorId)->values, QVector<double>({3.5}));
+        QCOMPARE(local->stations().value(local->globalId(114)).name, QString("Ogród"));
+        QCOMPARE(local->sensors().value(sensorId).stationId, local->globalId(114));
+        QCOMPARE(registry.qualifiedId(sensorId), QString("local:92"));
+        QCOMPARE(registry.resolve("local:92"), sensorId);
+
+        // Zapytania dostawcy odpowiadają od razu z deklaracji i magazynu
+        Series fetched;
+        registry.fetchSeries(sensorId, [&fetched](const Series &series, const QString &error) {
+            QVERIFY(error.isEmpty());
+            fetched = series;
+        });
+        QCOMPARE(fetched.values, QVector<double>({3.5}));
+        QList<SensorInfo> declaredSensors;
+        registry.fetchSensors(local->globalId(114), [&declaredSensors](const QList<SensorInfo> &sensors, const QString &) {
+            declaredSensors = sensors;
+        });
+        QCOMPARE(declaredSensors.size(), qsizetype(1));
+        QList<StationRecord> declaredStations;
+        local->fetchStations([&declaredStations](const QList<StationRecord> &stations, const QString &) {
+            declaredStations = stations;
+        });
+        QCOMPARE(declaredStations.size(), qsizetype(1));
+        QCOMPARE(declaredStations.first().stationId, local->globalId(114));
+
+        // Identyfikator spoza przestrzeni lokalnej jest odrzucany
+        const quint64 rejected = local->rejectedLines();
+        const QByteArray tooLarge = "16777216 1.0 1000\n";
+        local->parse(tooLarge.constData(), tooLarge.size());
+        QCOMPARE(local->rejectedLines(), rejected + 1);
+    }
+
+    void benchLineIngest()
+    {
+        // Przepustowość parsera i scalania; czas raportuje QBENCHMARK, bez progu
+        const QByteArray bulk = ingestBulk(100000);
+        QBENCHMARK {
+            SeriesStore store;
+            LineIngest ingest(&store);
+            ingest.parse(bulk.constData(), bulk.size());
+            ingest.flush();
+        }
+    }
+
+    void testDataProviders()
+    {
+        QNetworkAccessManager network;
+        ProviderRegistry registry;
+        auto *gios = new GiosProvider(&network);
+        auto *fake = new FakeProvider;
+        QCOMPARE(registry.add(gios), 0);
+        QCOMPARE(registry.add(fake), 1);
+
+        // Pierwszy dostawca zachowuje identyfikatory sieci
+        QCOMPARE(gios->globalId(114), 114);
+        const int fakeId = fake->globalId(114);
+        QCOMPARE(DataProvider::providerIndex(fakeId), 1);
+        QCOMPARE(DataProvider::localId(fakeId), 114);
+        QCOMPARE(registry.providerFor(fakeId), fake);
+        QCOMPARE(registry.qualifiedId(114), QString("gios:114"));
+        QCOMPARE(registry.qualifiedId(fakeId), QString("fake:114"));
+        QCOMPARE(registry.resolve("fake:114"), fakeId);
+        QCOMPARE(registry.resolve("gios:114"), 114);
+        QCOMPARE(registry.resolve("114"), 114);
+        QCOMPARE(registry.resolve("inny:114"), -1);
+        QCOMPARE(registry.resolve("gios:abc"), -1);
+
+        double fetched = 0.0;
+        registry.fetchSeries(fakeId, [&fetched](const Series &series, const QString &error) {
+            QVERIFY(error.isEmpty());
+            fetched = series.values.first();
+        });
+        QCOMPARE(fetched, 114.0);
+        QString error;
+        registry.fetchSensors((5 << DataProvider::LocalIdBits) | 1, [&error](const QList<SensorInfo> &, const QString &message) {
+            error = message;
+        });
+        QVERIFY(!error.isEmpty());
+
+        // Odpowiedzi GIOŚ
+        const QJsonArray stations = QJsonDocument::fromJson(R"([{"id": 114, "stationName": "Kraków, Bujaka",
+            "gegrLat": "50.010", "gegrLon": "19.950", "city": {"name": "Kraków"}, "addressStreet": "ul. Bujaka"}])").array();
+        const QList<StationRecord> parsed = gios->parseStations(stations);
+        QCOMPARE(parsed.size(), qsizetype(1));
+        QCOMPARE(parsed.first().stationId, 114);
+        QCOMPARE(parsed.first().city, QString("Kraków"));
+        QCOMPARE(parsed.first().lat, 50.01);
+
+        const QJsonArray sensors = QJsonDocument::fromJson(R"([{"id": 642, "param": {"idParam": 3,
+            "paramCode": "PM10", "paramFormula": "PM10", "paramName": "pył zawieszony PM10"}}])").array();
+        const QList<SensorInfo> sensorInfos = gios->parseSensors(sensors, 114);
+        QCOMPARE(sensorInfos.first().sensorId, 642);
+        QCOMPARE(sensorInfos.first().stationId, 114);
+        QCOMPARE(sensorInfos.first().paramCode, QString("PM10"));
+
+        // Identyfikator spoza 24 bitów nie jest obcinany do innej stacji
+        QString idError;
+        QVERIFY(gios->parseStations(QJsonDocument::fromJson(R"([{"id": 16777330}])").array(), &idError).isEmpty());
+        QVERIFY(!idError.isEmpty());
+        idError.clear();
+        QVERIFY(gios->parseSensors(QJsonDocument::fromJson(R"([{"id": 642, "stationId": 16777330}])").array(), 114,
+                                   &idError).isEmpty());
+        QVERIFY(idError.contains("16777330"));
+
+        const QJsonArray values = QJsonDocument::fromJson(R"([{"date": "2026-10-18 12:00:00", "value": null},
+            {"date": "2026-10-18 11:00:00", "value": 21.5}])").array();
+        const Series series = GiosProvider::parseSeries(values);
+        QCOMPARE(series.size(), qsizetype(2));
+        QVERIFY(series.timestamps.first() < series.timestamps.last());
+        QCOMPARE(series.values.first(), 21.5);
+        QVERIFY(std::isnan(series.values.last()));
+    }
+
+    void testDataBankImport()
+    {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        auto writeFile = [&](const QString &name, const QByteArray &content) {
+            QFile file(dir.filePath(name));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write(content);
+        };
+        writeFile("Metadane.csv",
+                  "Nr;Kod stacji;Nazwa stacji;Stary Kod stacji;WGS84 \xcf\x86 N;WGS84 \xce\xbb E\n"
+                  "1;MpKrakAlKras;Krak\xc3\xb3w, Al. Krasi\xc5\x84skiego;MpKrakowWIOSAKra6117, MpKrak_Kras;50,057678;19,926189\n");
+
+        // Rok danych godzinowych: stacja pod obecnym i starym kodem oraz stacja nieznana
+        QByteArray hourly = "Nr;1;2;3\n"
+                            "Kod stacji;MpKrakAlKras;MpKrakowWIOSAKra6117;XxNieznana\n"
+                            "Wska\xc5\xbanik;PM10;PM10;PM10\n"
+                            "Czas u\xc5\x9b" "redniania;1g;1g;1g\n"
+                            "Jednostka;ug/m3;ug/m3;ug/m3\n";
+        const QDateTime start = QDate(2019, 1, 1).startOfDay(QTimeZone::fromSecondsAheadOfUtc(3600));
+        QSet<QString> hours;
+        for (int i = 0; i < 8760; ++i) {
+            const QString hour = start.addSecs(3600 * (i + 1)).toString("yyyy-MM-dd HH:mm");
+            hours.insert(hour);
+            // Excel dopisuje separatory pustych kolumn arkusza
+            hourly += hour.toUtf8() + ";" + QByteArray::number(i % 100) + ",5;;7" + QByteArray(40, ';') + "\r\n";
+        }
+        writeFile("2019_PM10_1g.csv", hourly);
+        writeFile("2019_PM10_24g.csv", "Kod stacji;MpKrakAlKras\nCzas u\xc5\x9b" "redniania;24g\n2019-01-01;20,0\n");
+
+        QString metadataPath;
+        const QStringList files = DataBankImporter::scanDirectory(dir.path(), &metadataPath);
+        QCOMPARE(QFileInfo(metadataPath).fileName(), QString("Metadane.csv"));
+        QCOMPARE(files.size(), 2);
+
+        bool ok = false;
+        const QList<BankStation> stations = DataBankImporter::readMetadata(metadataPath, &ok);
+        QVERIFY(ok);
+        QCOMPARE(stations.size(), 1);
+        QCOMPARE(stations[0].codes, QStringList() << "MpKrakAlKras" << "MpKrakowWIOSAKra6117" << "MpKrak_Kras");
+        QCOMPARE(stations[0].lat, 50.057678);
+
+        QHash<QString, int> stationByCode;
+        for (const QString &code : stations[0].codes) {
+            stationByCode.insert(code, 400);
+        }
+        SensorCatalog catalog;
+        SensorInfo sensor;
+        sensor.sensorId = 501;
+        sensor.stationId = 400;
+        sensor.paramCode = "PM10";
+        catalog.insert(sensor);
+
+        // Plik ponad MinChunkSize jest dzielony na kilka fragmentów
+        QVERIFY(hourly.size() > 2 * DataBankImporter::MinChunkSize);
+        LocalArchive archive(dir.path() + "/archive");
+        DataBankImporter importer(&archive);
+        const BankImportReport report = importer.run(files, stationByCode, catalog);
+        QCOMPARE(report.filesImported, 1);
+        QCOMPARE(report.filesSkipped, 1);
+        QCOMPARE(report.filesFailed, 0);
+        QCOMPARE(report.rowsParsed, qint64(8760));
+        QCOMPARE(report.columnsImported, 2);
+        QCOMPARE(report.columnsUnmapped, 1);
+        QCOMPARE(report.unmappedStations, QStringList() << "XxNieznana");
+        QCOMPARE(report.samplesImported, qint64(hours.size()));
+        QVERIFY(!report.interrupted);
+
+        const qint64 from = start.toMSecsSinceEpoch();
+        const ArchiveSeries imported = archive.read(501, from, from + 3 * 3600000, LocalArchive::Hourly);
+        QCOMPARE(imported.size(), qsizetype(3));
+        QCOMPARE(imported.mean[0], 0.5);
+        QCOMPARE(imported.mean[1], 1.5);
+
+        // Ponowny import niczego nie zmienia
+        QCOMPARE(importer.run(files, stationByCode, catalog).samplesImported, qint64(0));
+
+        // Bank danych zapisuje czas zimowy cały rok: zmiana czasu nie skleja dwóch godzin
+        QByteArray autumn = "Kod stacji;MpKrakAlKras\nWska\xc5\xbanik;PM10\nCzas u\xc5\x9b" "redniania;1g\n";
+        for (int h = 1; h <= 25; ++h) {
+            autumn += QString("2019-10-%1 %2:00;%3\n").arg(27 + h / 24).arg(h % 24, 2, 10, QChar('0')).arg(h).toUtf8();
+        }
+        writeFile("zmiana_PM10_1g.csv", autumn);
+        LocalArchive autumnArchive(dir.path() + "/autumn");
+        DataBankImporter autumnImporter(&autumnArchive);
+        QCOMPARE(autumnImporter.run({dir.filePath("zmiana_PM10_1g.csv")}, stationByCode, catalog).samplesImported, qint64(25));
+        const qint64 autumnStart = QDateTime(QDate(2019, 10, 27), QTime(1, 0), QTimeZone::fromSecondsAheadOfUtc(3600)).toMSecsSinceEpoch();
+        const ArchiveSeries autumnHours = autumnArchive.read(501, autumnStart, autumnStart + 24 * 3600000, LocalArchive::Hourly);
+        QCOMPARE(autumnHours.size(), qsizetype(25));
+        QCOMPARE(autumnHours.timestamps.last() - autumnHours.timestamps.first(), qint64(24 * 3600000));
+
+        // Retencja aplikacji: godziny sprzed dwóch lat zostają w agregatach dziennych i miesięcznych
+        const QDate oldDay = QDate::currentDate().addYears(-3);
+        const QDate recentDay = QDate::currentDate().addDays(-30);
+        QByteArray history = "Kod stacji;MpKrakAlKras\nWska\xc5\xbanik;PM10\nCzas u\xc5\x9b" "redniania;1g\n";
+        for (int h = 1; h <= 6; ++h) {
+            history += oldDay.startOfDay().addSecs(3600 * (h + 7)).toString("yyyy-MM-dd HH:mm").toUtf8()
+                       + ";" + QByteArray::number(h) + "\n";
+        }
+        for (int h = 1; h <= 6; ++h) {
+            history += recentDay.startOfDay().addSecs(3600 * (h + 7)).toString("yyyy-MM-dd HH:mm").toUtf8()
+                       + ";" + QByteArray::number(h + 10) + "\n";
+        }
+        writeFile("historia_PM10_1g.csv", history);
+        RetentionPolicy policy;
+        policy.hourlyDays = 2 * 365;
+        policy.dailyDays = 10 * 365;
+        LocalArchive retained(dir.path() + "/retained");
+        retained.setRetention(policy);
+        DataBankImporter historyImporter(&retained);
+        const BankImportReport historyReport = historyImporter.run({dir.filePath("historia_PM10_1g.csv")}, stationByCode, catalog);
+        QCOMPARE(historyReport.samplesImported, qint64(6));
+        QCOMPARE(historyReport.samplesRolledUp, qint64(6));
+        QCOMPARE(historyReport.samplesExpired, qint64(0));
+
+        const qint64 oldStart = oldDay.startOfDay().toMSecsSinceEpoch();
+        const qint64 oldEnd = oldDay.addDays(1).startOfDay().toMSecsSinceEpoch() - 1;
+        QVERIFY(retained.read(501, oldStart, oldEnd, LocalArchive::Hourly).isEmpty());
+        const ArchiveSeries oldDaily = retained.read(501, oldStart, oldEnd, LocalArchive::Daily);
+        QCOMPARE(oldDaily.mean, QVector<double>({3.5}));
+        QCOMPARE(oldDaily.counts, QVector<int>({6}));
+        const qint64 oldMonth = QDate(oldDay.year(), oldDay.month(), 1).startOfDay().toMSecsSinceEpoch();
+        QCOMPARE(retained.read(501, oldMonth, oldMonth, LocalArchive::Monthly).max, QVector<double>({6.0}));
+        const qint64 recentStart = recentDay.startOfDay().toMSecsSinceEpoch();
+        QCOMPARE(retained.read(501, recentStart, recentStart + 86400000 - 1, LocalArchive::Hourly).size(), qsizetype(6));
+
+        // Agregaty starsze niż ich własna retencja nie są zapisywane
+        policy.dailyDays = policy.monthlyDays = 365;
+        LocalArchive strict(dir.path() + "/strict");
+        strict.setRetention(policy);
+        DataBankImporter strictImporter(&strict);
+        const BankImportReport strictReport = strictImporter.run({dir.filePath("historia_PM10_1g.csv")}, stationByCode, catalog);
+        QCOMPARE(strictReport.samplesImported, qint64(6));
+        QCOMPARE(strictReport.samplesRolledUp, qint64(0));
+        QCOMPARE(strictReport.samplesExpired, qint64(6));
+        QVERIFY(strict.read(501, oldStart, oldEnd, LocalArchive::Daily).isEmpty());
+    }
+
+    void testReplyBufferPool()
+    {
+        ReplyBufferPool pool;
+
+        // Treść o znanej długości trafia w całości do jednego bufora
+        {
+            ScriptedReply reply(10000);
+            pool.attach(&reply);
+            reply.feed(QByteArray(6000, 'a'));
+            reply.feed(QByteArray(4000, 'b'));
+            const PooledBuffer body = pool.take(&reply);
+            QCOMPARE(body.data(), QByteArray(6000, 'a') + QByteArray(4000, 'b'));
+        }
+        QCOMPARE(pool.stats().requests, qint64(1));
+        QCOMPARE(pool.stats().allocations, qint64(1));
+        QCOMPARE(pool.stats().bytesCopied, qint64(10000));
+        QVERIFY(pool.stats().bytesIdle >= 16 * 1024);
+
+        // Drugie zapytanie korzysta z oddanego bufora
+        {
+            ScriptedReply reply(12000);
+            pool.attach(&reply);
+            reply.feed(QByteArray(12000, 'c'));
+            QCOMPARE(pool.take(&reply).data().size(), qsizetype(12000));
+        }
+        QCOMPARE(pool.stats().allocations, qint64(1));
+        QCOMPARE(pool.stats().reuses, qint64(1));
+
+        // Bez Content-Length bufor rośnie do następnej klasy
+        {
+            ScriptedReply reply(-1);
+            pool.attach(&reply);
+            reply.feed(QByteArray(3000, 'd'));
+            reply.feed(QByteArray(6000, 'e'));
+            const PooledBuffer body = pool.take(&reply);
+            QCOMPARE(body.data(), QByteArray(3000, 'd') + QByteArray(6000, 'e'));
+        }
+        QCOMPARE(pool.stats().allocations, qint64(2));
+        QCOMPARE(pool.stats().bytesCopied, qint64(10000 + 12000 + 3000 + 6000 + 3000));
+
+        // Bufor współdzielony przez wywołującego nie wraca do puli
+        QByteArray kept;
+        {
+            ScriptedReply reply(10000);
+            pool.attach(&reply);
+            reply.feed(QByteArray(10000, 'f'));
+            const PooledBuffer body = pool.take(&reply);
+            kept = body.data();
+        }
+        QCOMPARE(kept.size(), qsizetype(10000));
+        const qint64 allocations = pool.stats().allocations;
+        pool.acquire(10000);
+        QCOMPARE(pool.stats().allocations, allocations + 1);
+
+        // Odpowiedź usunięta bez odczytu oddaje bufor
+        auto *dropped = new ScriptedReply(100);
+        pool.attach(dropped);
+        dropped->feed(QByteArray(100, 'g'));
+        delete dropped;
+        const qint64 reuses = pool.stats().reuses;
+        QVERIFY(pool.acquire(100).capacity() >= ReplyBufferPool::MinClassSize);
+        QCOMPARE(pool.stats().reuses, reuses + 1);
+        QCOMPARE(pool.statsMap()["requests"].toLongLong(), qint64(4));
+    }
+
+    void testLogger()
+    {
+        QMutex mutex;
+        QByteArray output;
+        auto collect = [&](const QByteArray &lines) {
+            QMutexLocker locker(&mutex);
+            output += lines;
+        };
+        auto takeLines = [&]() {
+            QMutexLocker locker(&mutex);
+            QList<QByteArray> lines = output.split('\n');
+            lines.removeAll(QByteArray());
+            output.clear();
+            return lines;
+        };
+
+        LogCategory category("test.logger");
+        Logger logger(256);
+        logger.setFormat(Logger::Json);
+        logger.setSink(collect);
+
+        // Wyłączony poziom nie trafia do kolejki
+        QVERIFY(!category.isEnabled(LogCategory::Debug));
+        logger.log(category, LogCategory::Debug, "Ukryty");
+        logger.log(category, LogCategory::Info, "Odebrano dane czujnika", {{"sensorId", 5}, {"points", 72}});
+        logger.flush();
+        QList<QByteArray> lines = takeLines();
+        QCOMPARE(lines.size(), 1);
+        const QJsonObject record = QJsonDocument::fromJson(lines[0]).object();
+        QCOMPARE(record["level"].toString(), QString("info"));
+        QCOMPARE(record["category"].toString(), QString("test.logger"));
+        QCOMPARE(record["message"].toString(), QString("Odebrano dane czujnika"));
+        QCOMPARE(record["sensorId"].toInt(), 5);
+        QVERIFY(record.contains("time"));
+
+        // Reguły poziomów
+        QVERIFY(LogCategory::setRules("test.logger=debug"));
+        QVERIFY(category.isEnabled(LogCategory::Debug));
+        QVERIFY(!LogCategory::setRules("test.logger=glosno"));
+        QVERIFY(LogCategory::setRules("test.logger=info"));
+        QVERIFY(!category.isEnabled(LogCategory::Debug));
+
+        // Powtórzenia ponad limit są zliczane w jednym podsumowaniu
+        for (int i = 0; i < 100; ++i) {
+            logger.log(category, LogCategory::Warning, "Powtarzany");
+        }
+        logger.flush();
+        lines = takeLines();
+        QCOMPARE(lines.size(), Logger::MaxRepeats + 1);
+        QCOMPARE(QJsonDocument::fromJson(lines.last()).object()["repeated"].toInt(), 100 - Logger::MaxRepeats);
+
+        logger.setFormat(Logger::Text);
+        logger.log(category, LogCategory::Error, "Tekst", {{"port", 8095}});
+        logger.flush();
+        lines = takeLines();
+        QCOMPARE(lines.size(), 1);
+        QVERIFY(lines[0].endsWith(" error test.logger: Tekst port=8095"));
+
+        // Pełna kolejka nie blokuje wątków; każdy wpis jest zapisany albo policzony
+        Logger small(4);
+        small.setFormat(Logger::Json);
+        small.setSink(collect);
+        QList<int> threads{0, 1, 2, 3};
+        QtConcurrent::blockingMap(threads, [&](int thread) {
+            for (int i = 0; i < 500; ++i) {
+                small.log(category, LogCategory::Info, QString("Wątek %1 wpis %2").arg(thread).arg(i));
+            }
+        });
+        small.flush();
+        qint64 written = 0;
+        qint64 reported = 0;
+        for (const QByteArray &line : takeLines()) {
+            const QJsonObject object = QJsonDocument::fromJson(line).object();
+            if (object["category"].toString() == "log") {
+                reported += object["dropped"].toInteger();
+            } else {
+                ++written;
+            }
+        }
+        QCOMPARE(reported, small.droppedCount());
+        QCOMPARE(written + reported, qint64(2000));
+    }
+
+    void testMetrics()
+    {
+        Metrics metrics;
+        Counter *requests = metrics.counter("test_requests_total", "Requests.", "endpoint=\"data\"");
+        QCOMPARE(metrics.counter("test_requests_total", "Requests.", "endpoint=\"data\""), requests);
+
+        // Każdy wątek dodaje do własnego fragmentu, suma musi się zgadzać
+        const QList<int> workers{0, 1, 2, 3, 4, 5, 6, 7};
+        QtConcurrent::blockingMap(workers, [requests](int) {
+            for (int i = 0; i < 10000; ++i) {
+                requests->add();
+            }
+        });
+        QCOMPARE(requests->value(), qint64(80000));
+
+        Histogram *latency = metrics.histogram("test_latency_seconds", "Latency.", {0.1, 0.5, 1.0});
+        for (double value : {0.05, 0.1, 0.3, 0.7, 2.0}) {
+            latency->observe(value);
+        }
+        const Histogram::Snapshot snapshot = latency->snapshot();
+        QCOMPARE(snapshot.cumulative, (QVector<qint64>{2, 3, 4, 5}));
+        QCOMPARE(snapshot.count, qint64(5));
+        QVERIFY(std::abs(snapshot.sum - 3.15) < 1e-6);
+
+        auto *owner = new QObject;
+        int depth = 7;
+        metrics.callback("test_queue_depth", "Queue.", Metrics::GaugeType, [&depth]() { return double(depth); },
+                         "queue=\"a\"", owner);
+        QByteArray text = metrics.exposition();
+        QVERIFY(text.contains("# TYPE test_requests_total counter\ntest_requests_total{endpoint=\"data\"} 80000\n"));
+        QVERIFY(text.contains("# TYPE test_latency_seconds histogram\n"));
+        QVERIFY(text.contains("test_latency_seconds_bucket{le=\"0.5\"} 3\n"));
+        QVERIFY(text.contains("test_latency_seconds_bucket{le=\"+Inf\"} 5\n"));
+        QVERIFY(text.contains("test_latency_seconds_sum 3.15\n"));
+        QVERIFY(text.contains("test_latency_seconds_count 5\n"));
+        QVERIFY(text.contains("test_queue_depth{queue=\"a\"} 7\n"));
+        delete owner;
+        QVERIFY(!metrics.exposition().contains("test_queue_depth"));
+
+        // Odczyt działa bez blokady rejestru, więc może do niego sięgać
+        metrics.callback("test_requests_seen", "Requests seen.", Metrics::GaugeType, [&metrics]() {
+            return double(metrics.counter("test_requests_total", "Requests.", "endpoint=\"data\"")->value());
+        });
+        QVERIFY(metrics.exposition().contains("test_requests_seen 80000\n"));
+
+        // Zapytania HTTP tylko na interfejsie lokalnym
+        MetricsExporter exporter(&metrics);
+        QVERIFY(exporter.listen(0));
+        auto fetch = [&exporter](const QByteArray &request) {
+            QTcpSocket socket;
+            socket.connectToHost(QHostAddress::LocalHost, exporter.serverPort());
+            if (!socket.waitForConnected(1000)) {
+                return QByteArray();
+            }
+            socket.write(request);
+            QByteArray response;
+            QElapsedTimer timer;
+            timer.start();
+            while (socket.state() != QAbstractSocket::UnconnectedState && timer.elapsed() < 5000) {
+                QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+                response += socket.readAll();
+            }
+            return response + socket.readAll();
+        };
+        const QByteArray response = fetch("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        QVERIFY(response.startsWith("HTTP/1.1 200 OK\r\n"));
+        QVERIFY(response.contains("Content-Type: text/plain; version=0.0.4"));
+        QVERIFY(response.contains("test_requests_total{endpoint=\"data\"} 80000\n"));
+        QVERIFY(response.contains("airapi_metrics_scrapes_total 1\n"));
+        QVERIFY(fetch("GET /other HTTP/1.1\r\n\r\n").startsWith("HTTP/1.1 404"));
+        QVERIFY(fetch("POST /metrics HTTP/1.1\r\n\r\n").startsWith("HTTP/1.1 405"));
+        QVERIFY(fetch("nonsense\r\n\r\n").startsWith("HTTP/1.1 400"));
+
+        // Okno aplikacji rejestruje rozmiary magazynu i kolejek
+        {
+            MainWindow window;
+            const QByteArray text = Metrics::instance().exposition();
+            QVERIFY(text.contains("# TYPE airapi_series gauge\n"));
+            QVERIFY(text.contains("airapi_queue_depth{queue=\"archive\"} 0\n"));
+            QVERIFY(text.contains("airapi_cache_hits_total{cache=\"reply_buffer\"}"));
+        }
+        QVERIFY(!Metrics::instance().exposition().contains("airapi_queue_depth"));
+    }
+
+    void testMemoryAccounting()
+    {
+        QString text;
+        QCOMPARE(MemoryAccounting::bytes(text), qint64(0));
+        text.reserve(100);
+        QVERIFY(MemoryAccounting::bytes(text) >= qint64(200));
+        QCOMPARE(MemoryAccounting::bytes(QVariant(42)), qint64(0));
+
+        // Drzewo wariantów liczone rekurencyjnie
+        const QVariantList points{QVariantMap{{"date", "2026-01-01 00:00:00"}, {"value", 12.5}},
+                                  QVariantMap{{"date", "2026-01-01 01:00:00"}, {"value", 13.0}}};
+        const qint64 one = MemoryAccounting::bytes(QVariant(points.mid(0, 1)));
+        const qint64 two = MemoryAccounting::bytes(QVariant(points));
+        QVERIFY(one > qint64(2 * sizeof(QVariant)));
+        QVERIFY(two > one);
+
+        SeriesStore store;
+        QCOMPARE(store.memoryUsage().objects, qint64(0));
+        Series series;
+        for (int i = 0; i < 1000; ++i) {
+            series.timestamps.append(i * 3600000LL);
+            series.values.append(i);
+        }
+        store.merge(1, series);
+        const MemoryAccounting::Usage usage = store.memoryUsage();
+        QCOMPARE(usage.objects, qint64(1));
+        QVERIFY(usage.bytes >= qint64(1000 * 16));
+        store.remove(1);
+        QVERIFY(store.memoryUsage().bytes < usage.bytes);
+
+        // Progi chroniące przed regresją zużycia pamięci
+        const MemoryBenchmarkResult result = MemoryBenchmark::run(200, 48);
+        QCOMPARE(result.stationUsage.objects, qint64(200));
+        QCOMPARE(result.seriesUsage.objects, qint64(200));
+        QVERIFY(result.bytesPerStation() > double(sizeof(Station)));
+        QVERIFY(result.bytesPerStation() < 1024.0);
+        QVERIFY(result.bytesPerSample() >= 16.0);
+        QVERIFY(result.bytesPerSample() < 40.0);
+        QVERIFY(result.variantBytesPerSample() > result.bytesPerSample());
+        QVERIFY(MemoryBenchmark::report(result).contains("B/próbkę"));
+
+        MainWindow window;
+        const QVariantMap memory = window.memoryUsage();
+        for (const QByteArray &subsystem : MainWindow::memorySubsystems()) {
+            QVERIFY(memory.value(QString::fromLatin1(subsystem)).toMap().contains("bytes"));
+        }
+        QVERIFY(Metrics::instance().exposition().contains("airapi_memory_bytes{subsystem=\"series\"}"));
+    }
+
+    void testReport()
+    {
+        ReportRenderer::Format format = ReportRenderer::Png;
+        QVERIFY(ReportRenderer::parseFormat(" PDF ", &format));
+        QCOMPARE(format, ReportRenderer::Pdf);
+        QVERIFY(!ReportRenderer::parseFormat("svg", &format));
+
+        // Dwie syntetyczne stacje z przerwą w danych
+        const qint64 to = 1767222000000;
+        QList<ReportStation> stations;
+        for (int id : {101, 102}) {
+            ReportStation station;
+            station.stationId = id;
+            station.name = QString("Stacja testowa %1").arg(id);
+            station.city = "Poznań";
+            station.lat = 52.4;
+            station.lon = 16.9 + id % 2;
+            station.from = to - 48 * 3600000LL;
+            station.to = to;
+            ReportSeries pm10{"PM10", {}};
+            for (int i = 0; i < 48; ++i) {
+                pm10.series.timestamps.append(station.from + i * 3600000LL);
+                pm10.series.values.append(i == 20 ? NAN : 30.0 + 10.0 * std::sin(i * 0.3));
+            }
+            station.series.append(pm10);
+            stations.append(station);
+        }
+        const QVector<QPointF> points{{16.9, 52.4}, {21.0, 52.2}, {19.9, 50.1}};
+
+        const QImage image = ReportRenderer::renderImage(stations[0], points);
+        QCOMPARE(image.size(), QSize(ReportRenderer::PageWidth, ReportRenderer::PageHeight));
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        ReportRenderer renderer;
+        const ReportSummary png = renderer.run(stations, points, dir.filePath("png"), ReportRenderer::Png);
+        QCOMPARE(png.written, 2);
+        QCOMPARE(png.failed, 0);
+        QVERIFY(png.files[0].endsWith("station_101_" + QDateTime::fromMSecsSinceEpoch(to).toString("yyyyMMdd") + ".png"));
+        QCOMPARE(QImage(png.files[1]).size(), image.size());
+
+        // Uruchomienie w tle z sygnałem zakończenia
+        QSignalSpy finished(&renderer, &ReportRenderer::finished);
+        // Postęp przychodzi z wątków puli: liczony w tym wątku przez połączenie kolejkowane
+        std::atomic<int> progress{0};
+        connect(&renderer, &ReportRenderer::progress, this, [&progress]() { ++progress; }, Qt::QueuedConnection);
+        renderer.start(stations, points, dir.filePath("pdf"), ReportRenderer::Pdf);
+        QVERIFY(finished.wait(10000));
+        const ReportSummary pdf = finished.first().first().value<ReportSummary>();
+        QCOMPARE(pdf.written, 2);
+        QTRY_COMPARE(progress.load(), 2);
+        QFile file(pdf.files[0]);
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QVERIFY(file.read(5) == "%PDF-");
+    }
+
+    void testAsyncPipeline()
+    {
+        ReplayServer server(50);
+        QVERIFY(server.isListening());
+        server.record("/station/sensors/114",
+                      R"([{"id":1001,"stationId":114,"param":{"paramCode":"PM10","idParam":3}},)"
+                      R"({"id":1002,"stationId":114,"param":{"paramCode":"NO2","idParam":6}}])");
+        server.record("/data/getData/1001",
+                      R"({"values":[{"date":"2026-01-01 01:00:00","value":21.5},{"date":"2026-01-01 00:00:00","value":20.0}]})");
+        server.record("/data/getData/1002", R"({"values":[{"date":"2026-01-01 00:00:00","value":12.0}]})");
+
+        QNetworkAccessManager manager;
+        ProviderRegistry providers;
+        auto *gios = new GiosProvider(&manager);
+        gios->setBaseUrl(server.url());
+        providers.add(gios);
+
+        // Czujniki, potem oba szeregi naraz
+        std::optional<QList<Async::Result<Series>>> results;
+        Async::start(fetchStationSeries(&providers, 114, {}), [&](QList<Async::Result<Series>> value) {
+            results = std::move(value);
+        });
+        QVERIFY(!results);
+        QTRY_VERIFY_WITH_TIMEOUT(results.has_value(), 5000);
+        QCOMPARE(results->size(), 2);
+        QVERIFY(results->at(0).ok());
+        QCOMPARE(results->at(0).value.size(), 2);
+        QCOMPARE(results->at(1).value.values.first(), 12.0);
+        QVERIFY(server.maxPending() >= 2);
+
+        // Błąd HTTP i nieznany dostawca trafiają do wyniku
+        std::optional<Async::Result<Series>> missing;
+        Async::start(Async::series(&providers, 1003), [&](Async::Result<Series> value) { missing = value; });
+        QTRY_VERIFY_WITH_TIMEOUT(missing.has_value(), 5000);
+        QVERIFY(!missing->ok());
+        std::optional<Async::Result<QList<SensorInfo>>> unknown;
+        Async::start(Async::sensors(&providers, (5 << DataProvider::LocalIdBits) | 1), [&](Async::Result<QList<SensorInfo>> value) {
+            unknown = value;
+        });
+        QVERIFY(unknown.has_value());
+        QVERIFY(unknown->error.contains("Nieznany dostawca"));
+
+        // Anulowanie kończy oczekiwanie od razu i przerywa odpowiedź
+        Async::CancelToken token;
+        std::optional<Async::Result<Series>> cancelled;
+        const int disconnects = server.disconnects();
+        Async::start(Async::series(&providers, 1001, token), [&](Async::Result<Series> value) { cancelled = value; });
+        token.cancel();
+        QVERIFY(cancelled.has_value());
+        QCOMPARE(cancelled->error, Async::cancelledError());
+        QTRY_VERIFY_WITH_TIMEOUT(server.disconnects() > disconnects, 5000);
+
+        Async::CancelToken replyToken;
+        QNetworkReply *reply = manager.get(QNetworkRequest(server.url().resolved(QUrl("data/getData/1001"))));
+        QNetworkReply *finished = nullptr;
+        Async::start([](QNetworkReply *reply, Async::CancelToken token) -> Async::Task<QNetworkReply *> {
+            co_return co_await Async::finished(reply, token);
+        }(reply, replyToken), [&](QNetworkReply *value) { finished = value; });
+        replyToken.cancel();
+        QTRY_COMPARE_WITH_TIMEOUT(finished, reply, 5000);
+        QCOMPARE(reply->error(), QNetworkReply::OperationCanceledError);
+        delete reply;
+    }
+
+    void testTaskPool()
+    {
+        TaskPool pool(4);
+        QCOMPARE(pool.threadCount(), 4);
+
+        std::atomic<qint64> sum{0};
+        pool.blockingFor(10000, [&](qsizetype i) { sum += i; });
+        QCOMPARE(sum.load(), qint64(10000) * 9999 / 2);
+
+        // Zagnieżdżone pętle nie blokują wątków puli
+        std::atomic<int> inner{0};
+        pool.blockingFor(16, [&](qsizetype) {
+            pool.blockingFor(100, [&](qsizetype) { ++inner; }, TaskPool::High);
+        });
+        QCOMPARE(inner.load(), 1600);
+
+        const QList<int> squares = pool.blockingMapped(QList<int>{1, 2, 3, 4, 5}, [](int value) { return value * value; });
+        QCOMPARE(squares, QList<int>({1, 4, 9, 16, 25}));
+        QVector<double> values{3.0, 1.0, 2.0};
+        pool.blockingMap(values, [](double &value) { value *= 2.0; }, TaskPool::Low);
+        QCOMPARE(values, QVector<double>({6.0, 2.0, 4.0}));
+
+        // Flaga anulowania pomija nierozpoczęte porcje
+        std::atomic_bool stop{true};
+        std::atomic<int> skipped{0};
+        pool.blockingFor(1000, [&](qsizetype) { ++skipped; }, TaskPool::Normal, &stop);
+        QCOMPARE(skipped.load(), 0);
+
+        // Wynik run() dociera do pętli zdarzeń
+        QFutureWatcher<int> watcher;
+        QSignalSpy finished(&watcher, &QFutureWatcher<int>::finished);
+        watcher.setFuture(pool.run([]() { return 42; }));
+        QVERIFY(finished.wait(5000));
+        QCOMPARE(watcher.result(), 42);
+
+        // Anulowana przyszłość pomija zadanie czekające w kolejce
+        TaskPool single(1);
+        QSemaphore gate;
+        QFuture<void> blocker = single.run([&gate]() { gate.acquire(); });
+        std::atomic_bool ran{false};
+        QFuture<void> queued = single.run([&ran]() { ran = true; });
+        queued.cancel();
+        gate.release();
+        blocker.waitForFinished();
+        queued.waitForFinished();
+        QVERIFY(!ran.load());
+        QVERIFY(queued.isCanceled());
+
+        // Zadanie sprawdza anulowanie samo
+        QVERIFY(!TaskPool::isCancelled());
+        QSemaphore started;
+        QFuture<int> polling = single.run([&started]() {
+            started.release();
+            int rounds = 0;
+            while (!TaskPool::isCancelled()) {
+                QThread::msleep(1);
+                ++rounds;
+            }
+            return rounds;
+        });
+        QVERIFY(started.tryAcquire(1, 5000));
+        polling.cancel();
+        polling.waitForFinished();
+        QTRY_COMPARE(single.stats().executed, qint64(3));
+        QCOMPARE(single.stats().queued, qint64(0));
+
+        // Wątek czekający na pętlę wykonuje tylko jej porcje, nie obce zadania
+        QSemaphore busy;
+        QFuture<void> occupied = single.run([&gate, &busy]() {
+            busy.release();
+            gate.acquire();
+        });
+        QVERIFY(busy.tryAcquire(1, 5000));
+        std::atomic_bool foreignRan{false};
+        QFuture<void> foreign = single.run([&foreignRan]() { foreignRan = true; }, TaskPool::High);
+        std::atomic<int> own{0};
+        single.blockingFor(8, [&own](qsizetype) { ++own; }, TaskPool::Low);
+        QCOMPARE(own.load(), 8);
+        QVERIFY(!foreignRan.load());
+        gate.release();
+        occupied.waitForFinished();
+        foreign.waitForFinished();
+        QVERIFY(foreignRan.load());
+        QVERIFY(pool.stats().executed > 0);
+
+        // Obie pule liczą to samo
+        const QList<PoolBenchmarkResult> results = PoolBenchmark::run(1, 1);
+        QCOMPARE(results.size(), 4);
+        for (const PoolBenchmarkResult &result : results) {
+            QVERIFY2(result.matches, qPrintable(result.job));
+            QVERIFY(result.taskPoolMs > 0.0);
+        }
+        QVERIFY(PoolBenchmark::report(results).contains("przyspieszenie"));
+    }
+
+    void testForecastCancel()
+    {
+        Series series;
+        for (int h = 0; h < 24 * 7; ++h) {
+            series.timestamps.append(h * HoltWinters::HourMs);
+            series.values.append(50.0 + 10.0 * std::sin(2.0 * M_PI * h / 24.0));
+        }
+        QHash<int, Series> inputs;
+        for (int sensorId = 0; sensorId < 200; ++sensorId) {
+            inputs.insert(sensorId, series);
+        }
+
+        // Wszystkie wątki puli są zajęte, więc partia czeka w kolejce
+        TaskPool &pool = TaskPool::instance();
+        const int threads = pool.threadCount();
+        QSemaphore gate;
+        QSemaphore started;
+        QList<QFuture<void>> blockers;
+        for (int t = 0; t < threads; ++t) {
+            blockers.append(pool.run([&gate, &started]() {
+                started.release();
+                gate.acquire();
+            }, TaskPool::High));
+        }
+        QVERIFY(started.tryAcquire(threads, 5000));
+        const qint64 executed = pool.stats().executed;
+
+        ForecastEngine engine;
+        QSignalSpy updated(&engine, &ForecastEngine::forecastsUpdated);
+        engine.schedule(inputs);
+        QVERIFY(engine.isBusy());
+        std::unique_ptr<QThread> release(QThread::create([&gate, threads]() {
+            QThread::msleep(50);
+            gate.release(threads);
+        }));
+        release->start();
+        engine.cancel();
+        release->wait();
+        for (QFuture<void> &blocker : blockers) {
+            blocker.waitForFinished();
+        }
+
+        // Anulowanie wraca bez liczenia modeli: wykonano tylko blokady i koordynatora
+        QVERIFY(!engine.isBusy());
+        QVERIFY(pool.stats().executed - executed <= qint64(threads) + 1);
+        QCoreApplication::processEvents();
+        QCOMPARE(updated.count(), 0);
+        QCOMPARE(engine.forecast(0).mean.size(), qsizetype(0));
+
+        // Następna partia liczy normalnie
+        engine.schedule({{1, series}});
+        QVERIFY(updated.wait(5000));
+        QCOMPARE(updated.first().first().value<QList<int>>(), QList<int>({1}));
+        QCOMPARE(engine.forecast(1).mean.size(), qsizetype(ForecastEngine::Horizon));
+    }
 };
 
 QTEST_MAIN(TestMainWindow)
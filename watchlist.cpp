@@ -0,0 +1,376 @@
+/**
+ * @file watchlist.cpp
+ * @brief Implementation of the WatchList class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the refresh cycle, the tile computation and the
+ * persistence of the watch list.
+ */
+
+#include "watchlist.h"
+#include "airquality.h"
+#include "sparkline.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QTime>
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Constructs an empty watch list.
+ * @param store Series store the tiles are computed from.
+ * @param parent Parent QObject.
+ */
+WatchList::WatchList(const SeriesStore *store, QObject *parent)
+    : QObject(parent),
+    m_store(store)
+{
+    m_refreshTimer.setInterval(m_refreshInterval * 1000);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &WatchList::refreshRequested);
+    m_refreshTimer.start();
+
+    m_flushTimer.setSingleShot(true);
+    m_flushTimer.setInterval(FlushTimeoutMs);
+    connect(&m_flushTimer, &QTimer::timeout, this, &WatchList::flush);
+}
+
+/**
+ * @brief Sets the watched parameter.
+ * @param param Parameter key.
+ *
+ * Sensors of the tiles must then be set again with setSensor().
+ */
+void WatchList::setParam(const QString &param)
+{
+    if (param == m_param) {
+        return;
+    }
+    m_param = param;
+    emit paramChanged();
+}
+
+/**
+ * @brief Sets the refresh interval.
+ * @param seconds Interval in seconds, 0 to turn automatic refresh off.
+ */
+void WatchList::setRefreshInterval(int seconds)
+{
+    seconds = std::max(0, seconds);
+    if (seconds == m_refreshInterval) {
+        return;
+    }
+    m_refreshInterval = seconds;
+    if (seconds > 0) {
+        m_refreshTimer.start(seconds * 1000);
+    } else {
+        m_refreshTimer.stop();
+    }
+    emit refreshIntervalChanged();
+}
+
+/**
+ * @brief Adds a station.
+ * @param stationId Station ID.
+ * @param sensorId Sensor of the parameter, -1 if none.
+ * @param title Station name.
+ * @return False if the station is already watched or the list is full.
+ */
+bool WatchList::add(int stationId, int sensorId, const QString &title)
+{
+    if (m_indexByStation.contains(stationId) || m_tiles.size() >= MaxTiles) {
+        return false;
+    }
+    WatchTile tile;
+    tile.stationId = stationId;
+    tile.sensorId = sensorId;
+    tile.title = title;
+    computeTile(tile);
+    m_indexByStation.insert(stationId, int(m_tiles.size()));
+    m_tiles.append(tile);
+    emit tilesChanged();
+    return true;
+}
+
+/**
+ * @brief Removes a station.
+ * @param stationId Station ID.
+ * @return False if the station is not watched.
+ */
+bool WatchList::remove(int stationId)
+{
+    const auto it = m_indexByStation.constFind(stationId);
+    if (it == m_indexByStation.cend()) {
+        return false;
+    }
+    m_tiles.remove(it.value());
+    m_indexByStation.clear();
+    m_dirty.clear();
+    for (int i = 0; i < m_tiles.size(); ++i) {
+        m_indexByStation.insert(m_tiles[i].stationId, i);
+    }
+    emit tilesChanged();
+    return true;
+}
+
+/**
+ * @brief Checks whether a station is watched.
+ * @param stationId Station ID.
+ * @return True if watched.
+ */
+bool WatchList::contains(int stationId) const
+{
+    return m_indexByStation.contains(stationId);
+}
+
+/**
+ * @brief Gets the memory held by the tiles.
+ * @return Bytes and number of tiles.
+ */
+MemoryAccounting::Usage WatchList::memoryUsage() const
+{
+    MemoryAccounting::Usage usage;
+    usage.objects = m_tiles.size();
+    usage.bytes = MemoryAccounting::bytes(m_tiles) + MemoryAccounting::bytes(m_indexByStation);
+    for (const WatchTile &tile : m_tiles) {
+        usage.bytes += MemoryAccounting::bytes(tile.title) + MemoryAccounting::bytes(tile.sparkline);
+    }
+    return usage;
+}
+
+/**
+ * @brief Gets the station of a tile.
+ * @param index Tile index.
+ * @return Station ID, -1 if out of range.
+ */
+int WatchList::stationIdAt(int index) const
+{
+    return index >= 0 && index < m_tiles.size() ? m_tiles[index].stationId : -1;
+}
+
+/**
+ * @brief Sets the sensor of a watched station.
+ * @param stationId Station ID.
+ * @param sensorId Sensor of the parameter, -1 if none.
+ */
+void WatchList::setSensor(int stationId, int sensorId)
+{
+    const auto it = m_indexByStation.constFind(stationId);
+    if (it == m_indexByStation.cend() || m_tiles[it.value()].sensorId == sensorId) {
+        return;
+    }
+    m_tiles[it.value()].sensorId = sensorId;
+    m_dirty.insert(it.value());
+}
+
+/**
+ * @brief Gets the sensors of all tiles.
+ * @return Sensor IDs, without tiles lacking a sensor.
+ */
+QList<int> WatchList::sensorIds() const
+{
+    QList<int> ids;
+    for (const WatchTile &tile : m_tiles) {
+        if (tile.sensorId >= 0) {
+            ids.append(tile.sensorId);
+        }
+    }
+    return ids;
+}
+
+/**
+ * @brief Starts a refresh cycle or extends the running one.
+ * @param sensorIds Sensors whose replies close the cycle.
+ * @return Sensors not awaited yet, which the caller must request.
+ *
+ * Every tile is recomputed at the end of the cycle, so tiles whose
+ * series is already in the store are shown even if their request fails.
+ * A refresh requested while a cycle is running joins it, so the cycle
+ * closes only when the replies of both are in and never on replies it did
+ * not request.
+ */
+QList<int> WatchList::beginRefresh(const QList<int> &sensorIds)
+{
+    for (int i = 0; i < m_tiles.size(); ++i) {
+        m_dirty.insert(i);
+    }
+    if (m_pending.isEmpty()) {
+        ++m_cycle;
+    }
+    QList<int> requested;
+    for (int sensorId : sensorIds) {
+        if (!m_pending.contains(sensorId)) {
+            m_pending.insert(sensorId);
+            requested.append(sensorId);
+        }
+    }
+    if (m_pending.isEmpty()) {
+        flush();
+    } else if (!requested.isEmpty()) {
+        m_flushTimer.start();
+    }
+    return requested;
+}
+
+/**
+ * @brief Reports a finished request.
+ * @param cycle Cycle the request was made in.
+ * @param sensorId Sensor ID.
+ *
+ * Replies of an earlier cycle, including those arriving after its timeout,
+ * and replies of sensors the cycle does not await are ignored.
+ */
+void WatchList::sensorRefreshed(int cycle, int sensorId)
+{
+    if (cycle != m_cycle || !m_pending.remove(sensorId)) {
+        return;
+    }
+    if (m_pending.isEmpty()) {
+        flush();
+    }
+}
+
+/**
+ * @brief Recomputes the changed tiles and publishes them at once.
+ */
+void WatchList::flush()
+{
+    m_flushTimer.stop();
+    m_pending.clear();
+    if (m_dirty.isEmpty()) {
+        return;
+    }
+
+    QList<int> indexes(m_dirty.cbegin(), m_dirty.cend());
+    std::sort(indexes.begin(), indexes.end());
+    m_dirty.clear();
+    for (int index : indexes) {
+        computeTile(m_tiles[index]);
+    }
+    m_lastRefresh = QTime::currentTime().toString("HH:mm:ss");
+    emit tilesUpdated(indexes);
+}
+
+/**
+ * @brief Recomputes one tile from the series store.
+ * @param tile Tile to update.
+ *
+ * The sparkline covers the hours before the newest sample of the sensor.
+ */
+void WatchList::computeTile(WatchTile &tile) const
+{
+    const double nan = std::nan("");
+    tile.value = nan;
+    tile.previous = nan;
+    tile.timestamp = 0;
+    tile.trend = WatchTile::Steady;
+    tile.level = -1;
+    tile.sparkline.clear();
+
+    const Series *series = tile.sensorId >= 0 ? m_store->find(tile.sensorId) : nullptr;
+    if (!series) {
+        return;
+    }
+    for (qsizetype i = series->size() - 1; i >= 0; --i) {
+        if (std::isnan(series->values[i])) {
+            continue;
+        }
+        if (std::isnan(tile.value)) {
+            tile.value = series->values[i];
+            tile.timestamp = series->timestamps[i];
+        } else {
+            tile.previous = series->values[i];
+            break;
+        }
+    }
+    if (std::isnan(tile.value)) {
+        return;
+    }
+
+    if (!std::isnan(tile.previous)) {
+        const double change = tile.value - tile.previous;
+        const double threshold = std::max(std::abs(tile.previous) * TrendThreshold, 0.5);
+        if (change > threshold) {
+            tile.trend = WatchTile::Rising;
+        } else if (change < -threshold) {
+            tile.trend = WatchTile::Falling;
+        }
+    }
+    tile.level = AirQuality::level(m_param, tile.value);
+    tile.sparkline = SparklineCache::downsample(*series, tile.timestamp - SparklineCache::Hours * SparklineCache::HourMs,
+                                                tile.timestamp, SparklineBuckets);
+}
+
+/**
+ * @brief Loads the watched stations from a JSON file.
+ * @param path File path.
+ * @return True on success.
+ */
+bool WatchList::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+
+    const QJsonObject root = doc.object();
+    m_tiles.clear();
+    m_indexByStation.clear();
+    m_dirty.clear();
+    setParam(root["param"].toString());
+    setRefreshInterval(root["refreshInterval"].toInt(m_refreshInterval));
+    for (const QJsonValue &value : root["stations"].toArray()) {
+        const QJsonObject obj = value.toObject();
+        const int stationId = obj["stationId"].toInt();
+        if (m_indexByStation.contains(stationId) || m_tiles.size() >= MaxTiles) {
+            continue;
+        }
+        WatchTile tile;
+        tile.stationId = stationId;
+        tile.sensorId = obj["sensorId"].toInt(-1);
+        tile.title = obj["title"].toString();
+        computeTile(tile);
+        m_indexByStation.insert(stationId, int(m_tiles.size()));
+        m_tiles.append(tile);
+    }
+    emit tilesChanged();
+    return true;
+}
+
+/**
+ * @brief Saves the watched stations to a JSON file.
+ * @param path File path.
+ * @return True on success.
+ */
+bool WatchList::save(const QString &path) const
+{
+    QJsonArray stations;
+    for (const WatchTile &tile : m_tiles) {
+        QJsonObject obj;
+        obj["stationId"] = tile.stationId;
+        obj["sensorId"] = tile.sensorId;
+        obj["title"] = tile.title;
+        stations.append(obj);
+    }
+
+    QJsonObject root;
+    root["param"] = m_param;
+    root["refreshInterval"] = m_refreshInterval;
+    root["stations"] = stations;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
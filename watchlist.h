@@ -0,0 +1,261 @@
+/**
+ * @file watchlist.h
+ * @brief Header file for the WatchList class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines the watched stations shown as tiles on the dashboard,
+ * refreshed periodically and updated in batches.
+ */
+
+#ifndef WATCHLIST_H
+#define WATCHLIST_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QPointF>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include "memoryaccounting.h"
+#include "seriesstore.h"
+
+/**
+ * @struct WatchTile
+ * @brief Current state of one watched station.
+ */
+struct WatchTile {
+    /**
+     * @brief Direction of the last change.
+     */
+    enum Trend : qint8 {
+        Falling = -1,   ///< Value dropped
+        Steady = 0,     ///< Value kept within the threshold
+        Rising = 1      ///< Value grew
+    };
+
+    int stationId = 0;              ///< Station ID
+    int sensorId = -1;              ///< Sensor of the parameter, -1 if none
+    QString title;                  ///< Station name
+    double value = 0.0;             ///< Newest value, NaN if none
+    double previous = 0.0;          ///< Value before the newest, NaN if none
+    qint64 timestamp = 0;           ///< Time of the newest value in ms since epoch
+    Trend trend = Steady;           ///< Direction of the last change
+    int level = -1;                 ///< Index level of the newest value, -1 if none
+    QVector<QPointF> sparkline;     ///< Normalized points, see SparklineCache::downsample()
+};
+
+/**
+ * @class WatchList
+ * @brief Watched stations of one parameter, refreshed as a whole.
+ *
+ * A refresh cycle collects the sensors whose series arrived and publishes
+ * them once, when the last reply of the cycle is in or a timeout expires,
+ * so the dashboard repaints the wall once per cycle rather than once per
+ * reply.
+ */
+class WatchList : public QObject {
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY tilesChanged)
+    Q_PROPERTY(QString param READ param NOTIFY paramChanged)
+    Q_PROPERTY(int refreshInterval READ refreshInterval WRITE setRefreshInterval NOTIFY refreshIntervalChanged)
+    Q_PROPERTY(QString lastRefresh READ lastRefresh NOTIFY tilesUpdated)
+
+public:
+    static constexpr int MaxTiles = 60;             ///< Largest number of watched stations
+    static constexpr int FlushTimeoutMs = 3000;     ///< Longest wait for the replies of a cycle
+    static constexpr int SparklineBuckets = 48;     ///< Resolution of the tile sparklines
+    static constexpr double TrendThreshold = 0.05;  ///< Relative change shown as a trend
+
+    /**
+     * @brief Constructs an empty watch list.
+     * @param store Series store the tiles are computed from.
+     * @param parent Parent QObject.
+     */
+    explicit WatchList(const SeriesStore *store, QObject *parent = nullptr);
+
+    /**
+     * @brief Gets the number of watched stations.
+     * @return Tile count.
+     */
+    int count() const { return int(m_tiles.size()); }
+
+    /**
+     * @brief Gets the tiles.
+     * @return Tiles in display order.
+     */
+    const QVector<WatchTile> &tiles() const { return m_tiles; }
+
+    /**
+     * @brief Gets the memory held by the tiles.
+     * @return Bytes and number of tiles.
+     */
+    MemoryAccounting::Usage memoryUsage() const;
+
+    /**
+     * @brief Gets the watched parameter.
+     * @return Parameter key.
+     */
+    QString param() const { return m_param; }
+
+    /**
+     * @brief Sets the watched parameter.
+     * @param param Parameter key.
+     *
+     * Sensors of the tiles must then be set again with setSensor().
+     */
+    void setParam(const QString &param);
+
+    /**
+     * @brief Gets the refresh interval.
+     * @return Interval in seconds, 0 if automatic refresh is off.
+     */
+    int refreshInterval() const { return m_refreshInterval; }
+
+    /**
+     * @brief Sets the refresh interval.
+     * @param seconds Interval in seconds, 0 to turn automatic refresh off.
+     */
+    void setRefreshInterval(int seconds);
+
+    /**
+     * @brief Gets the time of the last published refresh.
+     * @return Time as "HH:mm:ss", empty before the first refresh.
+     */
+    QString lastRefresh() const { return m_lastRefresh; }
+
+    /**
+     * @brief Adds a station.
+     * @param stationId Station ID.
+     * @param sensorId Sensor of the parameter, -1 if none.
+     * @param title Station name.
+     * @return False if the station is already watched or the list is full.
+     */
+    bool add(int stationId, int sensorId, const QString &title);
+
+    /**
+     * @brief Removes a station.
+     * @param stationId Station ID.
+     * @return False if the station is not watched.
+     */
+    bool remove(int stationId);
+
+    /**
+     * @brief Checks whether a station is watched.
+     * @param stationId Station ID.
+     * @return True if watched.
+     */
+    Q_INVOKABLE bool contains(int stationId) const;
+
+    /**
+     * @brief Gets the station of a tile.
+     * @param index Tile index.
+     * @return Station ID, -1 if out of range.
+     */
+    Q_INVOKABLE int stationIdAt(int index) const;
+
+    /**
+     * @brief Sets the sensor of a watched station.
+     * @param stationId Station ID.
+     * @param sensorId Sensor of the parameter, -1 if none.
+     */
+    void setSensor(int stationId, int sensorId);
+
+    /**
+     * @brief Gets the sensors of all tiles.
+     * @return Sensor IDs, without tiles lacking a sensor.
+     */
+    QList<int> sensorIds() const;
+
+    /**
+     * @brief Starts a refresh cycle or extends the running one.
+     * @param sensorIds Sensors whose replies close the cycle.
+     * @return Sensors not awaited yet, which the caller must request.
+     *
+     * Every tile is recomputed at the end of the cycle, so tiles whose
+     * series is already in the store are shown even if their request fails.
+     */
+    QList<int> beginRefresh(const QList<int> &sensorIds);
+
+    /**
+     * @brief Gets the current refresh cycle.
+     * @return Cycle number, passed back to sensorRefreshed().
+     */
+    int cycle() const { return m_cycle; }
+
+    /**
+     * @brief Reports a finished request.
+     * @param cycle Cycle the request was made in.
+     * @param sensorId Sensor ID.
+     */
+    void sensorRefreshed(int cycle, int sensorId);
+
+    /**
+     * @brief Recomputes the changed tiles and publishes them at once.
+     */
+    void flush();
+
+    /**
+     * @brief Loads the watched stations from a JSON file.
+     * @param path File path.
+     * @return True on success.
+     */
+    bool load(const QString &path);
+
+    /**
+     * @brief Saves the watched stations to a JSON file.
+     * @param path File path.
+     * @return True on success.
+     */
+    bool save(const QString &path) const;
+
+signals:
+    /**
+     * @brief Emitted when tiles are added, removed or reordered.
+     */
+    void tilesChanged();
+
+    /**
+     * @brief Emitted once per refresh cycle with the recomputed tiles.
+     * @param indexes Indexes of the recomputed tiles.
+     */
+    void tilesUpdated(const QList<int> &indexes);
+
+    /**
+     * @brief Emitted when the automatic refresh is due.
+     */
+    void refreshRequested();
+
+    /**
+     * @brief Emitted when the parameter changes.
+     */
+    void paramChanged();
+
+    /**
+     * @brief Emitted when the refresh interval changes.
+     */
+    void refreshIntervalChanged();
+
+private:
+    /**
+     * @brief Recomputes one tile from the series store.
+     * @param tile Tile to update.
+     */
+    void computeTile(WatchTile &tile) const;
+
+    const SeriesStore *m_store;         ///< Source of the series
+    QVector<WatchTile> m_tiles;         ///< Tiles in display order
+    QHash<int, int> m_indexByStation;   ///< Tile index by station ID
+    QString m_param;                    ///< Watched parameter
+    QSet<int> m_dirty;                  ///< Tiles to recompute at the next flush
+    QSet<int> m_pending;                ///< Sensors still awaited in this cycle
+    int m_cycle = 0;                    ///< Number of the current cycle
+    QTimer m_refreshTimer;              ///< Starts refresh cycles
+    QTimer m_flushTimer;                ///< Ends a cycle whose replies are late
+    int m_refreshInterval = 300;        ///< Refresh interval in seconds
+    QString m_lastRefresh;              ///< Time of the last published refresh
+};
+
+#endif // WATCHLIST_H
@@ -0,0 +1,335 @@
+/**
+ * @file writeaheadlog.cpp
+ * @brief Implementation of the WriteAheadLog class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file contains the record framing, the CRC32C checksum, the recovery
+ * scan and the sync policy.
+ */
+
+#include "writeaheadlog.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QStringList>
+#include <algorithm>
+#include <array>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Builds the lookup table of the reflected CRC32C polynomial.
+ * @return Checksum of every byte value.
+ */
+constexpr std::array<quint32, 256> crc32cTable()
+{
+    std::array<quint32, 256> table{};
+    for (quint32 i = 0; i < 256; ++i) {
+        quint32 crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<quint32, 256> Crc32cTable = crc32cTable();    ///< Byte-wise CRC32C table
+
+/**
+ * @brief Computes the checksum of a record.
+ * @param length Payload length.
+ * @param payload Payload.
+ * @return Checksum covering the length and the payload.
+ */
+quint32 recordChecksum(quint32 length, const char *payload)
+{
+    const quint32 crc = WriteAheadLog::crc32c(reinterpret_cast<const char *>(&length), sizeof(length));
+    return WriteAheadLog::crc32c(payload, length, crc);
+}
+
+} // namespace
+
+/**
+ * @brief Constructs a log stored in a file.
+ * @param path Log file, created on the first append.
+ */
+WriteAheadLog::WriteAheadLog(const QString &path)
+    : m_path(path),
+    m_file(path)
+{
+}
+
+/**
+ * @brief Destroys the log, syncing records written since the last sync.
+ */
+WriteAheadLog::~WriteAheadLog()
+{
+    if (m_dirty && m_policy != SyncNever) {
+        sync();
+    }
+}
+
+/**
+ * @brief Sets when records are forced to disk.
+ * @param policy Sync policy.
+ * @param intervalMs Sync interval of SyncPeriodic in milliseconds.
+ */
+void WriteAheadLog::setSyncPolicy(SyncPolicy policy, int intervalMs)
+{
+    m_policy = policy;
+    m_intervalMs = std::max(0, intervalMs);
+}
+
+/**
+ * @brief Reads the intact records and truncates a damaged tail.
+ * @param truncated Receives the number of bytes cut off, may be null.
+ * @param ok Set to false if the log could not be read or truncated, may
+ *           be null.
+ * @return Payloads of the intact records in write order.
+ *
+ * The log is read once, front to back, so recovery takes time proportional
+ * to its size. Records after a damaged one are dropped with it: they were
+ * written after it and may depend on it.
+ */
+QList<QByteArray> WriteAheadLog::recover(qint64 *truncated, bool *ok)
+{
+    QList<QByteArray> records;
+    if (truncated) {
+        *truncated = 0;
+    }
+    if (ok) {
+        *ok = true;
+    }
+    m_file.close();
+    if (!m_file.exists()) {
+        return records;
+    }
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        if (ok) {
+            *ok = false;
+        }
+        return records;
+    }
+
+    qint64 valid = 0;
+    const qint64 fileSize = m_file.size();
+    while (fileSize - valid >= HeaderSize) {
+        quint32 header[2];
+        if (m_file.read(reinterpret_cast<char *>(header), HeaderSize) != HeaderSize) {
+            break;
+        }
+        const quint32 length = header[0];
+        if (length > MaxRecordSize || length > fileSize - valid - HeaderSize) {
+            break;
+        }
+        const QByteArray payload = m_file.read(length);
+        if (payload.size() != qsizetype(length) || recordChecksum(length, payload.constData()) != header[1]) {
+            break;
+        }
+        records.append(payload);
+        valid += HeaderSize + length;
+    }
+
+    // Uszkodzony koniec pochodzi z przerwanego zapisu
+    if (valid < fileSize) {
+        const bool cut = m_file.resize(valid) && syncFile(m_file);
+        if (truncated) {
+            *truncated = fileSize - valid;
+        }
+        if (!cut && ok) {
+            *ok = false;
+        }
+    }
+    m_file.close();
+    return records;
+}
+
+/**
+ * @brief Appends a record.
+ * @param payload Record payload.
+ * @return True if the record was written (and synced, as the policy says).
+ *
+ * Header and payload are written with one call, so a crash leaves at most
+ * one torn record at the end of the log.
+ */
+bool WriteAheadLog::append(const QByteArray &payload)
+{
+    if (quint32(payload.size()) > MaxRecordSize || !openForAppend()) {
+        return false;
+    }
+
+    const quint32 length = quint32(payload.size());
+    const quint32 header[2] = {length, recordChecksum(length, payload.constData())};
+    QByteArray record;
+    record.reserve(HeaderSize + payload.size());
+    record.append(reinterpret_cast<const char *>(header), HeaderSize);
+    record.append(payload);
+    if (m_file.write(record) != record.size() || !m_file.flush()) {
+        return false;
+    }
+
+    m_dirty = true;
+    switch (m_policy) {
+    case SyncAlways:
+        return sync();
+    case SyncPeriodic:
+        if (!m_sinceSync.isValid() || m_sinceSync.hasExpired(m_intervalMs)) {
+            return sync();
+        }
+        return true;
+    default:
+        return true;
+    }
+}
+
+/**
+ * @brief Forces written records to disk.
+ * @return True on success.
+ */
+bool WriteAheadLog::sync()
+{
+    m_sinceSync.start();
+    if (!m_file.isOpen()) {
+        m_dirty = false;
+        return true;
+    }
+    if (!syncFile(m_file)) {
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+/**
+ * @brief Empties the log once its records are applied.
+ * @return True on success.
+ */
+bool WriteAheadLog::reset()
+{
+    if (!openForAppend() || !m_file.resize(0)) {
+        return false;
+    }
+    return m_policy == SyncNever || sync();
+}
+
+/**
+ * @brief Gets the size of the log.
+ * @return Size in bytes.
+ */
+qint64 WriteAheadLog::size() const
+{
+    return m_file.isOpen() ? m_file.size() : QFileInfo(m_path).size();
+}
+
+/**
+ * @brief Computes the CRC32C (Castagnoli) checksum of data.
+ * @param data Data.
+ * @param size Data size in bytes.
+ * @param crc Checksum of preceding data, to checksum data in parts.
+ * @return Checksum.
+ */
+quint32 WriteAheadLog::crc32c(const char *data, qsizetype size, quint32 crc)
+{
+    crc = ~crc;
+    const auto *bytes = reinterpret_cast<const uchar *>(data);
+    for (qsizetype i = 0; i < size; ++i) {
+        crc = Crc32cTable[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief Forces the written data of a file to disk.
+ * @param file Open file.
+ * @return True on success.
+ */
+bool WriteAheadLog::syncFile(QFileDevice &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+/**
+ * @brief Forces the entries of a directory to disk.
+ * @param path Directory path.
+ * @return True on success.
+ *
+ * A rename is durable only once the directory holding the new name is
+ * synced. NTFS journals directory changes itself, so on Windows only the
+ * existence of the directory is checked.
+ */
+bool WriteAheadLog::syncDirectory(const QString &path)
+{
+#ifdef Q_OS_WIN
+    return QFileInfo(path).isDir();
+#else
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    const bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#endif
+}
+
+/**
+ * @brief Parses a sync policy setting.
+ * @param text "never", "always" or "periodic", optionally followed by
+ *             ":<interval ms>".
+ * @param policy Receives the policy.
+ * @param intervalMs Receives the interval, unchanged if not given.
+ * @return True if the text is valid.
+ */
+bool WriteAheadLog::parseSyncPolicy(const QString &text, SyncPolicy *policy, int *intervalMs)
+{
+    const QStringList parts = text.trimmed().toLower().split(':');
+    const QString name = parts.first();
+    if (name == "never" && parts.size() == 1) {
+        *policy = SyncNever;
+    } else if (name == "always" && parts.size() == 1) {
+        *policy = SyncAlways;
+    } else if (name == "periodic" && parts.size() <= 2) {
+        if (parts.size() == 2) {
+            bool ok = false;
+            const int interval = parts[1].toInt(&ok);
+            if (!ok || interval < 0) {
+                return false;
+            }
+            *intervalMs = interval;
+        }
+        *policy = SyncPeriodic;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Opens the log file for appending if it is not open yet.
+ * @return True if the file is open.
+ */
+bool WriteAheadLog::openForAppend()
+{
+    if (m_file.isOpen()) {
+        return true;
+    }
+    if (!QDir().mkpath(QFileInfo(m_path).absolutePath())) {
+        return false;
+    }
+    return m_file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
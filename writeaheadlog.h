@@ -0,0 +1,156 @@
+/**
+ * @file writeaheadlog.h
+ * @brief Header file for the WriteAheadLog class.
+ * @author Jan Podborowski
+ * @date 2026-10-18
+ *
+ * This file defines an append-only log of checksummed records used to make
+ * multi-file archive updates crash-safe.
+ */
+
+#ifndef WRITEAHEADLOG_H
+#define WRITEAHEADLOG_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+/**
+ * @class WriteAheadLog
+ * @brief Append-only log of records protected by CRC32C.
+ *
+ * Every record is stored as its payload length (quint32), the CRC32C of the
+ * length and payload (quint32) and the payload, in host byte order. A crash
+ * can only damage the records written last, so recover() reads the log
+ * front to back and truncates it at the first record that is cut off or
+ * fails its checksum.
+ */
+class WriteAheadLog {
+public:
+    /**
+     * @brief When appended records are forced to disk.
+     */
+    enum SyncPolicy {
+        SyncNever,      ///< Left to the operating system
+        SyncAlways,     ///< After every record
+        SyncPeriodic    ///< At most once per sync interval
+    };
+
+    static constexpr int HeaderSize = 8;                    ///< Length and checksum
+    static constexpr quint32 MaxRecordSize = 64 << 20;      ///< Longer lengths are treated as damage
+
+    /**
+     * @brief Constructs a log stored in a file.
+     * @param path Log file, created on the first append.
+     */
+    explicit WriteAheadLog(const QString &path);
+
+    /**
+     * @brief Destroys the log, syncing records written since the last sync.
+     */
+    ~WriteAheadLog();
+
+    /**
+     * @brief Gets the log file.
+     * @return File path.
+     */
+    QString path() const { return m_path; }
+
+    /**
+     * @brief Sets when records are forced to disk.
+     * @param policy Sync policy.
+     * @param intervalMs Sync interval of SyncPeriodic in milliseconds.
+     */
+    void setSyncPolicy(SyncPolicy policy, int intervalMs = 1000);
+
+    /**
+     * @brief Gets the sync policy.
+     * @return Sync policy.
+     */
+    SyncPolicy syncPolicy() const { return m_policy; }
+
+    /**
+     * @brief Reads the intact records and truncates a damaged tail.
+     * @param truncated Receives the number of bytes cut off, may be null.
+     * @param ok Set to false if the log could not be read or truncated, may
+     *           be null.
+     * @return Payloads of the intact records in write order.
+     */
+    QList<QByteArray> recover(qint64 *truncated = nullptr, bool *ok = nullptr);
+
+    /**
+     * @brief Appends a record.
+     * @param payload Record payload.
+     * @return True if the record was written (and synced, as the policy says).
+     */
+    bool append(const QByteArray &payload);
+
+    /**
+     * @brief Forces written records to disk.
+     * @return True on success.
+     */
+    bool sync();
+
+    /**
+     * @brief Empties the log once its records are applied.
+     * @return True on success.
+     */
+    bool reset();
+
+    /**
+     * @brief Gets the size of the log.
+     * @return Size in bytes.
+     */
+    qint64 size() const;
+
+    /**
+     * @brief Computes the CRC32C (Castagnoli) checksum of data.
+     * @param data Data.
+     * @param size Data size in bytes.
+     * @param crc Checksum of preceding data, to checksum data in parts.
+     * @return Checksum.
+     */
+    static quint32 crc32c(const char *data, qsizetype size, quint32 crc = 0);
+
+    /**
+     * @brief Forces the written data of a file to disk.
+     * @param file Open file.
+     * @return True on success.
+     */
+    static bool syncFile(QFileDevice &file);
+
+    /**
+     * @brief Forces the entries of a directory to disk.
+     * @param path Directory path.
+     * @return True on success.
+     */
+    static bool syncDirectory(const QString &path);
+
+    /**
+     * @brief Parses a sync policy setting.
+     * @param text "never", "always" or "periodic", optionally followed by
+     *             ":<interval ms>".
+     * @param policy Receives the policy.
+     * @param intervalMs Receives the interval, unchanged if not given.
+     * @return True if the text is valid.
+     */
+    static bool parseSyncPolicy(const QString &text, SyncPolicy *policy, int *intervalMs);
+
+private:
+    /**
+     * @brief Opens the log file for appending if it is not open yet.
+     * @return True if the file is open.
+     */
+    bool openForAppend();
+
+    QString m_path;                 ///< Log file
+    QFile m_file;                   ///< Log file open for appending
+    SyncPolicy m_policy = SyncPeriodic; ///< Sync policy
+    int m_intervalMs = 1000;        ///< Sync interval of SyncPeriodic
+    QElapsedTimer m_sinceSync;      ///< Time since the last sync
+    bool m_dirty = false;           ///< True if records await a sync
+};
+
+#endif // WRITEAHEADLOG_H